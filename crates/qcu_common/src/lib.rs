@@ -43,6 +43,22 @@ pub mod mmio {
     /// must match the Verilog module's MMIO base address.
     pub const ACCELERATOR_BASE: usize = 0x4000_0000;
 
+    /// Base address of the union-find find engine in the simulated SoC.
+    ///
+    /// Control registers occupy the low word offsets (status, find, root,
+    /// cycles, hops, depth, memory latency) and the parent-array BRAM
+    /// starts at word offset 0x8000. Matches `uf_accel.sv` as decoded by
+    /// `top_soc.sv`; the qubit grid occupies 0x4000_0000 in that SoC.
+    pub const UF_ENGINE_BASE: usize = 0x4001_0000;
+
+    /// Base address of the full union-find decode block in the simulated SoC.
+    ///
+    /// Control and counter registers occupy the low word offsets; the
+    /// correction list, odd-root list, syndrome and edge buffers are
+    /// windows at word offsets 0x2000, 0x3000, 0x4000 and 0x8000. Matches
+    /// `uf_decoder.sv` as decoded by `top_soc.sv`.
+    pub const DECODER_BASE: usize = 0x4002_0000;
+
     /// Base address of high RAM region.
     ///
     /// Start of the main system memory region where firmware code, data
@@ -77,4 +77,50 @@ impl BitPack {
             storage[word_idx] &= !(1 << bit_idx);
         }
     }
+    /// Returns the bitwise OR of all words of a packed bit array.
+    ///
+    /// For a bit-transposed shot block (one word per detector, one bit per
+    /// shot) the result marks the shots in which any detector fired. Written
+    /// as a plain fold so the compiler vectorizes it (SSE/AVX on the host,
+    /// scalar on the firmware).
+    ///
+    /// # Arguments
+    ///
+    /// * `storage` - Array of u64 words
+    ///
+    /// # Returns
+    ///
+    /// The OR of every word.
+    #[inline(always)]
+    pub fn or_all(storage: &[u64]) -> u64 {
+        storage.iter().fold(0, |acc, &word| acc | word)
+    }
+
+    /// Transposes a 64 x 64 bit matrix in place.
+    ///
+    /// Bit j of word i moves to bit i of word j. Converts 64 shot-major
+    /// shots into a detector-major block (and back, as the transpose is its
+    /// own inverse) with six rounds of masked block swaps instead of 4096
+    /// single-bit moves.
+    ///
+    /// # Arguments
+    ///
+    /// * `tile` - The matrix, one row per word
+    pub fn transpose64(tile: &mut [u64; 64]) {
+        let mut width = 32;
+        let mut mask: u64 = 0x0000_0000_ffff_ffff;
+        while width != 0 {
+            let mut row = 0;
+            while row < 64 {
+                for i in row..row + width {
+                    let swap = ((tile[i] >> width) ^ tile[i + width]) & mask;
+                    tile[i] ^= swap << width;
+                    tile[i + width] ^= swap;
+                }
+                row += 2 * width;
+            }
+            width /= 2;
+            mask ^= mask << width;
+        }
+    }
 }
@@ -11,8 +11,22 @@ use crate::bit_utils::BitPack;
 use crate::dsu::UnionFind;
 use crate::graph::DecodingGraph;
 use crate::static_vec::StaticVec;
+use alloc::boxed::Box;
 use core::alloc::Allocator;
 
+/// Maximum number of shots in a bit-transposed block for `solve_batch`.
+///
+/// One bit per shot in each detector word.
+pub const BATCH_SHOTS: usize = 64;
+
+/// Adds the edges incident to a newly touched node to a candidate bitset.
+#[inline(always)]
+fn add_candidates<GA: Allocator>(graph: &DecodingGraph<GA>, node: usize, candidates: &mut [u64]) {
+    for &e in graph.incident_edges(node) {
+        BitPack::set(candidates, e as usize, true);
+    }
+}
+
 /// Trait for buffers that accumulate correction operations.
 ///
 /// Abstracts over different buffer types (heap-allocated vectors and
@@ -87,7 +101,11 @@ impl<const N: usize> CorrectionBuffer for StaticVec<(usize, usize), N> {
 /// N must be large enough to accommodate all nodes in the decoding graph.
 ///
 /// All internal buffers are reused across calls to `solve_into`, so the hot
-/// path performs zero heap allocations.
+/// path performs zero heap allocations. The forest is initialized once per
+/// graph size; after each shot only the nodes the shot touched are restored,
+/// so the cleanup between shots costs O(touched) rather than O(N), which
+/// for sparse syndromes on large graphs is most of the per-shot cost.
+/// `BatchDecoder` wraps the decoder for blocks of many shots.
 ///
 /// # Type Parameters
 ///
@@ -124,7 +142,22 @@ where
     /// Marks which nodes have been touched by syndrome bits or correction
     /// operations, allowing the inner loop to skip edges whose both endpoints
     /// are outside the active cluster frontier.
-    touched: StaticVec<usize, N>,
+    touched: StaticVec<u8, N>,
+
+    /// Nodes touched in the current decoding cycle, in touch order.
+    ///
+    /// Exactly the nodes whose parent, rank, parity or touched mark may
+    /// differ from a clean singleton, so restoring them returns the forest
+    /// to its initial state. Each node is listed at most once, so the list
+    /// never exceeds N entries.
+    dirty: StaticVec<u32, N>,
+
+    /// Number of nodes currently initialized as clean singletons.
+    ///
+    /// A shot on a graph of this size skips initialization entirely. Zero
+    /// (the state of a new decoder) forces a full reset, and a failed shot
+    /// sets it back to zero, as it leaves the forest dirty.
+    clean_nodes: usize,
 }
 
 impl<const N: usize> Default for UnionFindDecoder<N>
@@ -151,6 +184,129 @@ where
             rank: StaticVec::new(),
             parity: StaticVec::new(),
             touched: StaticVec::new(),
+            dirty: StaticVec::new(),
+            clean_nodes: 0,
+        }
+    }
+
+    /// Creates a new decoder directly in memory from an allocator.
+    ///
+    /// The decoder is large (about 14 bytes per node of capacity), more
+    /// than a firmware hart's stack holds for large N, and `Box::new_in`
+    /// may build the value on the stack before moving it. This constructor
+    /// instead takes zeroed memory from the allocator, such as the
+    /// firmware's `BumpAllocator`, which already is a valid empty decoder.
+    ///
+    /// # Arguments
+    ///
+    /// * `alloc` - Allocator providing the decoder's memory
+    ///
+    /// # Returns
+    ///
+    /// The boxed decoder, or `QecError::OutOfMemory` if the allocator is
+    /// exhausted.
+    pub fn new_in<A: Allocator>(alloc: A) -> Result<Box<Self, A>, QecError> {
+        let decoder = Box::try_new_zeroed_in(alloc).map_err(|_| QecError::OutOfMemory)?;
+        // Empty static vectors are a zero length over uninitialized storage
+        // and a zero `clean_nodes` requests a full reset, so all-zero bytes
+        // are exactly the state `new` builds.
+        Ok(unsafe { decoder.assume_init() })
+    }
+
+    /// Makes the forest clean for a graph of `num_nodes` nodes.
+    ///
+    /// Reinitializes every node only if the forest was never initialized
+    /// for this size or a failed shot left it dirty; otherwise the previous
+    /// shot's `restore` already returned it to singletons.
+    fn prepare(&mut self, num_nodes: usize) {
+        if self.clean_nodes != num_nodes {
+            self.reset(num_nodes);
+            self.clean_nodes = num_nodes;
+        }
+        self.dirty.clear();
+    }
+
+    /// Returns the nodes the current shot touched to clean singletons.
+    fn restore(&mut self) {
+        let mut dsu = UnionFind::resume(
+            self.parent.as_mut_slice(),
+            self.rank.as_mut_slice(),
+            self.parity.as_mut_slice(),
+        );
+        dsu.reset_nodes(&self.dirty);
+        for &node in self.dirty.iter() {
+            unsafe {
+                *self.touched.get_unchecked_mut(node as usize) = 0;
+            }
+        }
+        self.dirty.clear();
+    }
+
+    /// Resets the forest to `num_nodes` singletons with even parity.
+    fn reset(&mut self, num_nodes: usize) {
+        self.parent.clear();
+        self.rank.clear();
+        self.touched.clear();
+        self.parity.clear();
+
+        for i in 0..num_nodes {
+            let _ = self.parent.push(i);
+            let _ = self.rank.push(0);
+            let _ = self.touched.push(0);
+        }
+
+        let num_u64 = num_nodes.div_ceil(64);
+        for _ in 0..num_u64 {
+            let _ = self.parity.push(0);
+        }
+    }
+
+    /// Grows clusters from the seeded syndrome until no union is possible.
+    ///
+    /// Iterates over the flat edge list. The `touched` guard skips edges
+    /// whose both endpoints are outside the active cluster frontier,
+    /// avoiding redundant find/union calls on irrelevant edges. Newly
+    /// touched nodes are recorded in `dirty`.
+    fn grow<GA: Allocator, CB: CorrectionBuffer>(
+        graph: &DecodingGraph<GA>,
+        dsu: &mut UnionFind,
+        touched: &mut [u8],
+        dirty: &mut StaticVec<u32, N>,
+        out_buffer: &mut CB,
+    ) -> Result<(), QecError> {
+        loop {
+            let mut changed = false;
+            for &(u32_u, u32_v) in &graph.fast_edges {
+                let u = u32_u as usize;
+                let v = u32_v as usize;
+
+                if unsafe { *touched.get_unchecked(u) == 0 && *touched.get_unchecked(v) == 0 } {
+                    continue;
+                }
+
+                let root_u = dsu.find(u);
+                let root_v = dsu.find(v);
+
+                if root_u != root_v {
+                    let u_active = BitPack::get(dsu.parity, root_u);
+                    let v_active = BitPack::get(dsu.parity, root_v);
+
+                    if (u_active || v_active) && dsu.union(u, v) {
+                        out_buffer.push_correction(u, v)?;
+                        changed = true;
+                        for node in [u, v] {
+                            let mark = unsafe { touched.get_unchecked_mut(node) };
+                            if *mark == 0 {
+                                *mark = 1;
+                                let _ = dirty.push(node as u32);
+                            }
+                        }
+                    }
+                }
+            }
+            if !changed {
+                return Ok(());
+            }
         }
     }
 
@@ -186,24 +342,9 @@ where
         out_buffer.clear_buffer();
 
         let num_nodes = graph.num_nodes().min(N);
+        self.prepare(num_nodes);
 
-        self.parent.clear();
-        self.rank.clear();
-        self.touched.clear();
-        self.parity.clear();
-
-        for i in 0..num_nodes {
-            let _ = self.parent.push(i);
-            let _ = self.rank.push(0);
-            let _ = self.touched.push(0);
-        }
-
-        let num_u64 = num_nodes.div_ceil(64);
-        for _ in 0..num_u64 {
-            let _ = self.parity.push(0);
-        }
-
-        let mut dsu = UnionFind::new(
+        let mut dsu = UnionFind::resume(
             self.parent.as_mut_slice(),
             self.rank.as_mut_slice(),
             self.parity.as_mut_slice(),
@@ -212,49 +353,751 @@ where
         for &idx in syndrome_indices {
             if idx < num_nodes {
                 dsu.toggle_parity(idx);
-                unsafe {
-                    *self.touched.get_unchecked_mut(idx) = 1;
+                let mark = unsafe { self.touched.get_unchecked_mut(idx) };
+                if *mark == 0 {
+                    *mark = 1;
+                    let _ = self.dirty.push(idx as u32);
                 }
             }
         }
 
-        // Iterate over the flat edge list. The `touched` guard skips edges
-        // whose both endpoints are outside the active cluster frontier,
-        // avoiding redundant find/union calls on irrelevant edges.
+        let result = Self::grow(
+            graph,
+            &mut dsu,
+            self.touched.as_mut_slice(),
+            &mut self.dirty,
+            out_buffer,
+        );
+        if result.is_ok() {
+            self.restore();
+        } else {
+            self.clean_nodes = 0;
+        }
+        result
+    }
+}
+
+/// Batch front end of the union-find decoder.
+///
+/// Decodes blocks of up to `BATCH_SHOTS` shots per call for offline sweeps
+/// over many shots. Like `UnionFindDecoder::solve_into`, it restores only
+/// the nodes each shot touched, and its cluster growth visits the same edges in the same order as
+/// `solve_into`, which sweeps the entire edge list until a sweep changes
+/// nothing, but keeps the edges incident to touched nodes in a bitset and
+/// sweeps only those, skipping 64 irrelevant edges per zero word; the
+/// corrections are identical to `solve_into`'s. The extra buffers live here
+/// rather than in `UnionFindDecoder`, whose per-shot users (such as the
+/// firmware workers) do not need them.
+///
+/// # Type Parameters
+///
+/// * `N` - Maximum number of nodes, as for `UnionFindDecoder`; the edge
+///   bitset holds up to `4 * N` edges (the budget `DecodingGraph::new_in`
+///   reserves), and larger graphs fall back to full sweeps
+pub struct BatchDecoder<const N: usize>
+where
+    [(); N.div_ceil(64)]:,
+    [(); N.div_ceil(16)]:,
+{
+    /// Underlying decoder whose forest is kept clean between shots.
+    base: UnionFindDecoder<N>,
+
+    /// Fired detectors of a group of shots, shot after shot.
+    fired: StaticVec<u32, N>,
+
+    /// Edges with a touched endpoint, one bit per `fast_edges` index.
+    candidates: StaticVec<u64, { N.div_ceil(16) }>,
+}
+
+impl<const N: usize> Default for BatchDecoder<N>
+where
+    [(); N.div_ceil(64)]:,
+    [(); N.div_ceil(16)]:,
+{
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+impl<const N: usize> BatchDecoder<N>
+where
+    [(); N.div_ceil(64)]:,
+    [(); N.div_ceil(16)]:,
+{
+    /// Creates a new batch decoder with empty internal state.
+    pub fn new() -> Self {
+        let mut candidates = StaticVec::new();
+        for _ in 0..N.div_ceil(16) {
+            let _ = candidates.push(0);
+        }
+        Self {
+            base: UnionFindDecoder::new(),
+            fired: StaticVec::new(),
+            candidates,
+        }
+    }
+
+    /// Decodes a block of up to `BATCH_SHOTS` shots.
+    ///
+    /// The block is bit-transposed: word d holds detector d, with bit s set
+    /// if the detector fired in shot s (Stim's `ptb64` layout, or 64 .b8
+    /// shots passed through `BitPack::transpose64`). An OR over the block
+    /// finds the shots in which nothing fired, which need no decoding at
+    /// all. The fired detectors of the others are unpacked with one
+    /// trailing-zero scan of the block per group of shots that fits the
+    /// decoder's buffer (normally the whole block), and each shot is decoded
+    /// on the clean forest, which is restored afterwards.
+    ///
+    /// # Type Parameters
+    ///
+    /// * `GA` - Allocator type for the decoding graph's edge storage
+    /// * `CB` - Correction buffer type for output
+    /// * `F` - Per-shot result callback
+    ///
+    /// # Arguments
+    ///
+    /// * `graph` - Decoding graph defining the error model topology
+    /// * `block` - Detector words of the block; detectors beyond the graph
+    ///   are ignored
+    /// * `shots` - Number of shots in the block (bits 0..shots of each word)
+    /// * `out_buffer` - Buffer receiving the corrections of one shot at a time
+    /// * `on_shot` - Called with each shot index, in order, and its corrections
+    ///
+    /// # Returns
+    ///
+    /// Ok(()) on success, or the error of the first shot that failed to
+    /// decode; shots after it are not decoded.
+    pub fn solve_batch<GA, CB, F>(
+        &mut self,
+        graph: &DecodingGraph<GA>,
+        block: &[u64],
+        shots: usize,
+        out_buffer: &mut CB,
+        mut on_shot: F,
+    ) -> Result<(), QecError>
+    where
+        GA: Allocator,
+        CB: CorrectionBuffer,
+        F: FnMut(usize, &CB),
+    {
+        let num_nodes = graph.num_nodes().min(N);
+        let shots = shots.min(BATCH_SHOTS);
+        let words = &block[..block.len().min(num_nodes)];
+
+        self.base.prepare(num_nodes);
+
+        let active = BitPack::or_all(words) & Self::lanes(0, shots);
+        let mut counts = [0u32; BATCH_SHOTS];
+        if active != 0 {
+            for &word in words {
+                let mut bits = word & active;
+                while bits != 0 {
+                    counts[bits.trailing_zeros() as usize] += 1;
+                    bits &= bits - 1;
+                }
+            }
+        }
+
+        let mut shot = 0;
+        while shot < shots {
+            // Group the following shots while their fired detectors fit the
+            // buffer; a single shot always fits, as it fires at most N.
+            let first = shot;
+            let mut total = 0;
+            while shot < shots && total + counts[shot] as usize <= N {
+                total += counts[shot] as usize;
+                shot += 1;
+            }
+            let group = active & Self::lanes(first, shot);
+
+            let mut offsets = [0u32; BATCH_SHOTS + 1];
+            for s in first..shot {
+                offsets[s + 1] = offsets[s] + counts[s];
+            }
+            self.fired.clear();
+            if group != 0 {
+                for _ in 0..total {
+                    let _ = self.fired.push(0);
+                }
+                let mut cursor = offsets;
+                for (d, &word) in words.iter().enumerate() {
+                    let mut bits = word & group;
+                    while bits != 0 {
+                        let s = bits.trailing_zeros() as usize;
+                        self.fired[cursor[s] as usize] = d as u32;
+                        cursor[s] += 1;
+                        bits &= bits - 1;
+                    }
+                }
+            }
+
+            for s in first..shot {
+                out_buffer.clear_buffer();
+                if counts[s] != 0 {
+                    if let Err(e) = self.decode_clean(
+                        graph,
+                        offsets[s] as usize..offsets[s + 1] as usize,
+                        out_buffer,
+                    ) {
+                        self.base.clean_nodes = 0;
+                        return Err(e);
+                    }
+                }
+                on_shot(s, out_buffer);
+            }
+        }
+        Ok(())
+    }
+
+    /// Returns the mask of shot lanes `first..last`.
+    #[inline(always)]
+    fn lanes(first: usize, last: usize) -> u64 {
+        let below = |n: usize| {
+            if n >= BATCH_SHOTS {
+                u64::MAX
+            } else {
+                (1u64 << n) - 1
+            }
+        };
+        below(last) & !below(first)
+    }
+
+    /// Decodes one shot on the clean forest and restores it afterwards.
+    ///
+    /// # Arguments
+    ///
+    /// * `graph` - Decoding graph
+    /// * `range` - The shot's fired detectors in `fired`
+    /// * `out_buffer` - Buffer receiving the corrections
+    ///
+    /// # Returns
+    ///
+    /// Ok(()) on success, or the decoding error (the forest is then left
+    /// dirty).
+    fn decode_clean<GA: Allocator, CB: CorrectionBuffer>(
+        &mut self,
+        graph: &DecodingGraph<GA>,
+        range: core::ops::Range<usize>,
+        out_buffer: &mut CB,
+    ) -> Result<(), QecError> {
+        let Self {
+            base,
+            fired,
+            candidates,
+        } = self;
+        let sparse = graph.adj_edges.len() == 2 * graph.fast_edges.len()
+            && graph.fast_edges.len() <= 64 * candidates.len();
+        let mut dsu = UnionFind::resume(
+            base.parent.as_mut_slice(),
+            base.rank.as_mut_slice(),
+            base.parity.as_mut_slice(),
+        );
+
+        base.dirty.clear();
+        for &idx in &fired[range] {
+            dsu.toggle_parity(idx as usize);
+            unsafe {
+                *base.touched.get_unchecked_mut(idx as usize) = 1;
+            }
+            let _ = base.dirty.push(idx);
+            if sparse {
+                add_candidates(graph, idx as usize, candidates);
+            }
+        }
+
+        if sparse {
+            let result = Self::grow_sparse(
+                graph,
+                &mut dsu,
+                base.touched.as_mut_slice(),
+                &mut base.dirty,
+                candidates,
+                out_buffer,
+            );
+            candidates[..graph.fast_edges.len().div_ceil(64)].fill(0);
+            result?;
+        } else {
+            UnionFindDecoder::grow(
+                graph,
+                &mut dsu,
+                base.touched.as_mut_slice(),
+                &mut base.dirty,
+                out_buffer,
+            )?;
+        }
+
+        base.restore();
+        Ok(())
+    }
+
+    /// Grows clusters like `UnionFindDecoder::grow`, visiting only candidate
+    /// edges.
+    ///
+    /// Every sweep walks the candidate bitset in edge order, reloading the
+    /// current word after each edge so that edges made candidates later in
+    /// the same sweep are still visited in it, exactly as the full sweep's
+    /// `touched` guard would let them through.
+    fn grow_sparse<GA: Allocator, CB: CorrectionBuffer>(
+        graph: &DecodingGraph<GA>,
+        dsu: &mut UnionFind,
+        touched: &mut [u8],
+        dirty: &mut StaticVec<u32, N>,
+        candidates: &mut [u64],
+        out_buffer: &mut CB,
+    ) -> Result<(), QecError> {
+        let words = graph.fast_edges.len().div_ceil(64);
         loop {
             let mut changed = false;
-            for &(u32_u, u32_v) in &graph.fast_edges {
-                let u = u32_u as usize;
-                let v = u32_v as usize;
+            for w in 0..words {
+                let mut bits = candidates[w];
+                while bits != 0 {
+                    let bit = bits.trailing_zeros() as usize;
+                    let (u32_u, u32_v) = graph.fast_edges[64 * w + bit];
+                    let u = u32_u as usize;
+                    let v = u32_v as usize;
 
-                if unsafe {
-                    *self.touched.get_unchecked(u) == 0 && *self.touched.get_unchecked(v) == 0
-                } {
-                    continue;
+                    let root_u = dsu.find(u);
+                    let root_v = dsu.find(v);
+                    if root_u != root_v {
+                        let u_active = BitPack::get(dsu.parity, root_u);
+                        let v_active = BitPack::get(dsu.parity, root_v);
+
+                        if (u_active || v_active) && dsu.union(u, v) {
+                            out_buffer.push_correction(u, v)?;
+                            changed = true;
+                            for node in [u, v] {
+                                let mark = unsafe { touched.get_unchecked_mut(node) };
+                                if *mark == 0 {
+                                    *mark = 1;
+                                    let _ = dirty.push(node as u32);
+                                    add_candidates(graph, node, candidates);
+                                }
+                            }
+                        }
+                    }
+                    bits = candidates[w] & (u64::MAX << bit << 1);
                 }
+            }
+            if !changed {
+                return Ok(());
+            }
+        }
+    }
+}
 
-                let root_u = dsu.find(u);
-                let root_v = dsu.find(v);
+/// Weighted-growth front end of the union-find decoder.
+///
+/// Where `UnionFindDecoder::solve_into` merges an odd cluster across any
+/// edge it reaches, the weighted decoder grows clusters into edges in
+/// steps and only merges across an edge once it is fully grown. An edge
+/// takes `DecodingGraph::growth_steps` steps, the .dem weight quantized to
+/// 1..=`MAX_GROWTH_STEPS`, so clusters spread along likely errors first and
+/// unlikely ones last, as in the weighted union-find decoder of Delfosse
+/// and Nickerson. Each round is two sweeps over the edges in edge order: a
+/// growth sweep advances every edge between two different clusters by the
+/// number of odd clusters it touches (capped at its steps), then a fusion
+/// sweep merges the clusters across every fully grown edge and reports the
+/// edge as a correction. Rounds repeat until no edge grows. Both sweeps
+/// only visit edges with a touched endpoint, kept in a bitset as in
+/// `BatchDecoder`, and the full-decode block's weighted mode runs the same
+/// sweeps over the same edge list, so the corrections are identical.
+///
+/// The forest is restored as in `UnionFindDecoder`, and the growth of the
+/// candidate edges is cleared with them, so a shot costs what its clusters
+/// touch and not the size of the graph.
+///
+/// # Type Parameters
+///
+/// * `N` - Maximum number of nodes, as for `UnionFindDecoder`; the growth
+///   state holds up to `4 * N` edges
+pub struct WeightedDecoder<const N: usize>
+where
+    [(); N.div_ceil(64)]:,
+    [(); N.div_ceil(16)]:,
+    [(); 4 * N]:,
+{
+    /// Underlying decoder whose forest is kept clean between shots.
+    base: UnionFindDecoder<N>,
 
-                if root_u != root_v {
-                    let u_active = BitPack::get(dsu.parity, root_u);
-                    let v_active = BitPack::get(dsu.parity, root_v);
+    /// Growth steps each edge has taken, one entry per `fast_edges` index.
+    ///
+    /// Zero for every edge between shots.
+    growth: StaticVec<u8, { 4 * N }>,
 
-                    if (u_active || v_active) && dsu.union(u, v) {
+    /// Edges with a touched endpoint, one bit per `fast_edges` index.
+    ///
+    /// Empty between shots.
+    candidates: StaticVec<u64, { N.div_ceil(16) }>,
+}
+
+impl<const N: usize> Default for WeightedDecoder<N>
+where
+    [(); N.div_ceil(64)]:,
+    [(); N.div_ceil(16)]:,
+    [(); 4 * N]:,
+{
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+impl<const N: usize> WeightedDecoder<N>
+where
+    [(); N.div_ceil(64)]:,
+    [(); N.div_ceil(16)]:,
+    [(); 4 * N]:,
+{
+    /// Creates a new weighted decoder with empty internal state.
+    pub fn new() -> Self {
+        let mut growth = StaticVec::new();
+        for _ in 0..4 * N {
+            let _ = growth.push(0);
+        }
+        let mut candidates = StaticVec::new();
+        for _ in 0..N.div_ceil(16) {
+            let _ = candidates.push(0);
+        }
+        Self {
+            base: UnionFindDecoder::new(),
+            growth,
+            candidates,
+        }
+    }
+
+    /// Solves the decoding problem with weighted cluster growth.
+    ///
+    /// # Type Parameters
+    ///
+    /// * `GA` - Allocator type for the decoding graph's edge storage
+    /// * `CB` - Correction buffer type for output
+    ///
+    /// # Arguments
+    ///
+    /// * `graph` - Decoding graph with quantized weights
+    /// * `syndrome_indices` - List of detector node indices that fired
+    /// * `out_buffer` - Buffer to receive correction edge pairs
+    ///
+    /// # Returns
+    ///
+    /// Ok(()) on success, `QecError::BufferOverflow` if the graph has more
+    /// than `4 * N` edges, or the error of the correction buffer.
+    pub fn solve_into<GA: Allocator, CB: CorrectionBuffer>(
+        &mut self,
+        graph: &DecodingGraph<GA>,
+        syndrome_indices: &[usize],
+        out_buffer: &mut CB,
+    ) -> Result<(), QecError> {
+        out_buffer.clear_buffer();
+
+        let num_edges = graph.fast_edges.len();
+        if num_edges > 4 * N {
+            return Err(QecError::BufferOverflow);
+        }
+        let words = num_edges.div_ceil(64);
+        // Without the CSR edge indices every edge is a candidate, and the
+        // touched guard alone filters the sweeps.
+        let indexed = graph.adj_edges.len() == 2 * num_edges;
+
+        let num_nodes = graph.num_nodes().min(N);
+        let Self {
+            base,
+            growth,
+            candidates,
+        } = self;
+        base.prepare(num_nodes);
+
+        let mut dsu = UnionFind::resume(
+            base.parent.as_mut_slice(),
+            base.rank.as_mut_slice(),
+            base.parity.as_mut_slice(),
+        );
+
+        if !indexed {
+            candidates[..words].fill(u64::MAX);
+        }
+        for &idx in syndrome_indices {
+            if idx < num_nodes {
+                dsu.toggle_parity(idx);
+                let mark = unsafe { base.touched.get_unchecked_mut(idx) };
+                if *mark == 0 {
+                    *mark = 1;
+                    let _ = base.dirty.push(idx as u32);
+                    if indexed {
+                        add_candidates(graph, idx, candidates);
+                    }
+                }
+            }
+        }
+
+        let result = Self::grow(
+            graph,
+            &mut dsu,
+            base.touched.as_mut_slice(),
+            &mut base.dirty,
+            growth,
+            candidates,
+            indexed,
+            out_buffer,
+        );
+
+        for w in 0..words {
+            let mut bits = candidates[w];
+            while bits != 0 {
+                let e = 64 * w + bits.trailing_zeros() as usize;
+                if e < num_edges {
+                    growth[e] = 0;
+                }
+                bits &= bits - 1;
+            }
+            candidates[w] = 0;
+        }
+        if result.is_ok() {
+            base.restore();
+        } else {
+            base.clean_nodes = 0;
+        }
+        result
+    }
+
+    /// Runs growth and fusion rounds until no edge grows.
+    ///
+    /// Edges that a fusion makes candidates have not grown yet, so the
+    /// fusion sweep walks each candidate word as loaded and leaves them to
+    /// the growth sweep of the next round.
+    #[allow(clippy::too_many_arguments)]
+    fn grow<GA: Allocator, CB: CorrectionBuffer>(
+        graph: &DecodingGraph<GA>,
+        dsu: &mut UnionFind,
+        touched: &mut [u8],
+        dirty: &mut StaticVec<u32, N>,
+        growth: &mut [u8],
+        candidates: &mut [u64],
+        indexed: bool,
+        out_buffer: &mut CB,
+    ) -> Result<(), QecError> {
+        let num_edges = graph.fast_edges.len();
+        let words = num_edges.div_ceil(64);
+        loop {
+            let mut grew = false;
+            for w in 0..words {
+                let mut bits = candidates[w];
+                while bits != 0 {
+                    let e = 64 * w + bits.trailing_zeros() as usize;
+                    bits &= bits - 1;
+                    if e >= num_edges {
+                        break;
+                    }
+                    let (u32_u, u32_v) = graph.fast_edges[e];
+                    let u = u32_u as usize;
+                    let v = u32_v as usize;
+
+                    if unsafe { *touched.get_unchecked(u) == 0 && *touched.get_unchecked(v) == 0 } {
+                        continue;
+                    }
+                    let steps = graph.growth_steps(e) as u8;
+                    if growth[e] >= steps {
+                        continue;
+                    }
+
+                    let root_u = dsu.find(u);
+                    let root_v = dsu.find(v);
+                    if root_u != root_v {
+                        let odd = BitPack::get(dsu.parity, root_u) as u8
+                            + BitPack::get(dsu.parity, root_v) as u8;
+                        if odd != 0 {
+                            growth[e] = (growth[e] + odd).min(steps);
+                            grew = true;
+                        }
+                    }
+                }
+            }
+            if !grew {
+                return Ok(());
+            }
+
+            for w in 0..words {
+                let mut bits = candidates[w];
+                while bits != 0 {
+                    let e = 64 * w + bits.trailing_zeros() as usize;
+                    bits &= bits - 1;
+                    if e >= num_edges {
+                        break;
+                    }
+                    let (u32_u, u32_v) = graph.fast_edges[e];
+                    let u = u32_u as usize;
+                    let v = u32_v as usize;
+
+                    let live =
+                        unsafe { *touched.get_unchecked(u) != 0 || *touched.get_unchecked(v) != 0 };
+                    if live && growth[e] >= graph.growth_steps(e) as u8 && dsu.union(u, v) {
                         out_buffer.push_correction(u, v)?;
-                        changed = true;
-                        unsafe {
-                            *self.touched.get_unchecked_mut(u) = 1;
-                            *self.touched.get_unchecked_mut(v) = 1;
+                        for node in [u, v] {
+                            let mark = unsafe { touched.get_unchecked_mut(node) };
+                            if *mark == 0 {
+                                *mark = 1;
+                                let _ = dirty.push(node as u32);
+                                if indexed {
+                                    add_candidates(graph, node, candidates);
+                                }
+                            }
                         }
                     }
                 }
             }
-            if !changed {
-                break;
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use alloc::vec;
+    use alloc::vec::Vec;
+
+    const SIDE: usize = 24;
+    const SHOTS: usize = 200;
+
+    /// Builds a square grid with pseudo-random weights in 1..=8.
+    fn grid(seed: &mut u64) -> DecodingGraph {
+        let mut graph = DecodingGraph::new(4 * SIDE * SIDE);
+        for r in 0..SIDE {
+            for c in 0..SIDE {
+                let node = r * SIDE + c;
+                if c + 1 < SIDE {
+                    let weight = (xorshift(seed) % 8 + 1) as f64;
+                    graph.add_edge(node, node + 1, weight).unwrap();
+                }
+                if r + 1 < SIDE {
+                    let weight = (xorshift(seed) % 8 + 1) as f64;
+                    graph.add_edge(node, node + SIDE, weight).unwrap();
+                }
             }
         }
+        graph.build_adjacency();
+        graph
+    }
 
-        Ok(())
+    fn xorshift(state: &mut u64) -> u64 {
+        *state ^= *state << 13;
+        *state ^= *state >> 7;
+        *state ^= *state << 17;
+        *state
+    }
+
+    /// Draws each detector with probability 1/`one_in`.
+    fn syndrome(seed: &mut u64, one_in: u64) -> Vec<usize> {
+        (0..SIDE * SIDE)
+            .filter(|_| xorshift(seed) % one_in == 0)
+            .collect()
+    }
+
+    /// Bit-transposes shots into a `solve_batch` block.
+    fn transpose(shots: &[Vec<usize>]) -> Vec<u64> {
+        let mut block = vec![0u64; SIDE * SIDE];
+        for (s, shot) in shots.iter().enumerate() {
+            for &d in shot {
+                block[d] |= 1 << s;
+            }
+        }
+        block
+    }
+
+    #[test]
+    fn sparse_sweep_matches_full_sweep() {
+        let mut seed = 0x9E37_79B9_7F4A_7C15;
+        let sparse = grid(&mut seed);
+        let mut full = grid(&mut 0x9E37_79B9_7F4A_7C15);
+        full.adj_edges.clear();
+
+        let mut decoder = WeightedDecoder::<1024>::new();
+        let (mut expected, mut actual) = (Vec::new(), Vec::new());
+        for _ in 0..SHOTS {
+            let shot = syndrome(&mut seed, 32);
+            decoder.solve_into(&full, &shot, &mut expected).unwrap();
+            decoder.solve_into(&sparse, &shot, &mut actual).unwrap();
+            assert_eq!(actual, expected, "syndrome {:?}", shot);
+        }
+    }
+
+    #[test]
+    fn reused_decoder_matches_fresh_decoder() {
+        let mut seed = 0xD1B5_4A32_D192_ED03;
+        let graph = grid(&mut seed);
+
+        let mut reused = WeightedDecoder::<1024>::new();
+        let (mut expected, mut actual) = (Vec::new(), Vec::new());
+        for _ in 0..SHOTS {
+            let shot = syndrome(&mut seed, 32);
+            WeightedDecoder::<1024>::new()
+                .solve_into(&graph, &shot, &mut expected)
+                .unwrap();
+            reused.solve_into(&graph, &shot, &mut actual).unwrap();
+            assert_eq!(actual, expected, "syndrome {:?}", shot);
+        }
+    }
+
+    #[test]
+    fn batch_matches_solve_into() {
+        let mut seed = 0x2545_F491_4F6C_DD1D;
+        let graph = grid(&mut seed);
+
+        let random: Vec<Vec<usize>> = (0..BATCH_SHOTS).map(|_| syndrome(&mut seed, 32)).collect();
+        let mut sparse = random.clone();
+        for shot in sparse.iter_mut().step_by(2) {
+            shot.clear();
+        }
+        let dense: Vec<Vec<usize>> = (0..BATCH_SHOTS).map(|_| syndrome(&mut seed, 2)).collect();
+        // A tail of 37 shots, with the unused lanes holding stale bits.
+        let mut tail = transpose(&random);
+        for word in tail.iter_mut() {
+            *word |= xorshift(&mut seed) & !((1 << 37) - 1);
+        }
+
+        let mut batch = BatchDecoder::<1024>::new();
+        let mut reference = UnionFindDecoder::<1024>::new();
+        let (mut expected, mut actual) = (Vec::new(), Vec::new());
+        for (shots, block, count) in [
+            (&random, transpose(&random), BATCH_SHOTS),
+            (&sparse, transpose(&sparse), BATCH_SHOTS),
+            (&dense, transpose(&dense), BATCH_SHOTS),
+            (&random, tail, 37),
+        ] {
+            let mut decoded = 0;
+            batch
+                .solve_batch(&graph, &block, count, &mut actual, |s, corrections| {
+                    assert_eq!(s, decoded);
+                    reference
+                        .solve_into(&graph, &shots[s], &mut expected)
+                        .unwrap();
+                    assert_eq!(corrections, &expected, "shot {}", s);
+                    decoded += 1;
+                })
+                .unwrap();
+            assert_eq!(decoded, count);
+        }
+    }
+
+    #[test]
+    fn reused_union_find_matches_fresh_decoder() {
+        let mut seed = 0xA076_1D64_78BD_642F;
+        let graph = grid(&mut seed);
+
+        let mut reused = UnionFindDecoder::<1024>::new();
+        let (mut expected, mut actual) = (Vec::new(), Vec::new());
+        for i in 0..SHOTS {
+            // Every 50th shot fires half the detectors and every 100th all
+            // of them, so the next shot starts from a forest that was
+            // touched almost everywhere.
+            let shot = match i % 100 {
+                0 => (0..SIDE * SIDE).collect(),
+                50 => syndrome(&mut seed, 2),
+                _ => syndrome(&mut seed, 32),
+            };
+            UnionFindDecoder::<1024>::new()
+                .solve_into(&graph, &shot, &mut expected)
+                .unwrap();
+            reused.solve_into(&graph, &shot, &mut actual).unwrap();
+            assert_eq!(actual, expected, "shot {}", i);
+        }
     }
 }
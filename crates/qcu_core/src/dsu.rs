@@ -64,6 +64,45 @@ impl<'a> UnionFind<'a> {
         }
     }
 
+    /// Wraps slices that already hold a valid forest, without resetting them.
+    ///
+    /// Used by callers that restore the nodes they modified themselves with
+    /// `reset_nodes`, such as the decoder, so a new decoding cycle does not
+    /// pay for reinitializing the whole graph.
+    ///
+    /// # Arguments
+    ///
+    /// * `parent` - Parent pointers of a valid forest
+    /// * `rank` - Rank values matching the forest
+    /// * `parity` - Parity bits of the forest's roots (u64 words)
+    pub fn resume(parent: &'a mut [usize], rank: &'a mut [u8], parity: &'a mut [u64]) -> Self {
+        Self {
+            parent,
+            rank,
+            parity,
+        }
+    }
+
+    /// Restores the listed nodes to even-parity singletons.
+    ///
+    /// Unions, path compression and parity updates only modify nodes of the
+    /// sets they operate on, so if `nodes` holds every node that joined a
+    /// set or had its parity toggled since the forest was last clean, the
+    /// whole forest is clean again afterwards. The cost is proportional to
+    /// the number of listed nodes rather than to the size of the forest.
+    ///
+    /// # Arguments
+    ///
+    /// * `nodes` - Indices of the nodes to restore
+    pub fn reset_nodes(&mut self, nodes: &[u32]) {
+        for &node in nodes {
+            let node = node as usize;
+            self.parent[node] = node;
+            self.rank[node] = 0;
+            BitPack::set(self.parity, node, false);
+        }
+    }
+
     /// Finds the root of the set containing node i, with path compression.
     ///
     /// Traverses the parent chain to locate the root, simultaneously updating
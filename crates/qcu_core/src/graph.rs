@@ -6,11 +6,27 @@
 //! union-find decoder to find minimum-weight correction paths.
 
 use crate::QecError;
+use crate::graph_image::GraphImage;
 use alloc::alloc::Global;
 use alloc::vec;
 use alloc::vec::Vec;
 use core::alloc::Allocator;
 
+/// Largest quantized growth step count of an edge.
+///
+/// Steps are stored in 4-bit fields, so edge weights are quantized to
+/// 1..=15 growth steps.
+pub const MAX_GROWTH_STEPS: u32 = 15;
+
+/// Growth steps of the most likely error before common factors are removed.
+///
+/// Sets the resolution of the quantization: weights are rounded to
+/// multiples of 1 / `GROWTH_RESOLUTION` of the most likely error's weight.
+pub const GROWTH_RESOLUTION: u32 = 4;
+
+/// Number of 4-bit growth step fields packed into one `edge_steps` word.
+pub const STEPS_PER_WORD: usize = 8;
+
 /// Graph edge representation with target node and weight.
 ///
 /// Stores a connection between two nodes in the decoding graph. The weight
@@ -37,35 +53,71 @@ pub struct Edge {
 ///
 /// Stores the connectivity structure of detector nodes and error locations
 /// for a stabilizer code. The graph is built from error model descriptions
-/// (e.g., .dem files) and used by decoders to find correction paths. Edges
-/// are stored both as a flat (u, v) list for compatibility and as a CSR
-/// adjacency list for O(degree) neighbor iteration during decoding.
+/// (e.g., .dem files) or loaded from a precompiled image (see `graph_image`)
+/// and used by decoders to find correction paths. Edges are stored both as a
+/// flat (u, v) list for compatibility and as a CSR adjacency list for
+/// O(degree) neighbor iteration during decoding, with per-edge weights,
+/// quantized growth steps and observable masks in arrays parallel to the
+/// flat list. `build_adjacency` sorts the flat list by node, so a sweep over
+/// it walks the forest in index order instead of the order of the source
+/// file.
 ///
 /// # Type Parameters
 ///
 /// * `A` - Allocator type for edge storage. Defaults to Global for host-side
-///   usage, but can be customized for firmware environments with custom allocators.
+///   usage, but can be customized for firmware environments with custom
+///   allocators. All edge and adjacency storage comes from this allocator.
 pub struct DecodingGraph<A: Allocator = Global> {
     /// Flat list of graph edges as (u, v) node pairs.
     ///
     /// Stored as u32 pairs to reduce memory footprint compared to usize pairs
     /// on 64-bit systems. Retained for compatibility with existing code paths
-    /// and as the source of truth when building the adjacency list.
+    /// and as the source of truth when building the adjacency list. Sorted
+    /// by lower, then higher endpoint once the adjacency is built.
     pub fast_edges: Vec<(u32, u32), A>,
 
+    /// Weight of each edge, parallel to `fast_edges`.
+    ///
+    /// The negative log probability of the error the edge represents, as
+    /// given to `add_edge`. Decoders use the quantized `edge_steps` instead;
+    /// the weights are kept so compiled images carry the full error model.
+    pub edge_weights: Vec<f32, A>,
+
+    /// Quantized growth steps of each edge, `STEPS_PER_WORD` per word.
+    ///
+    /// Edge e takes bits `4 * (e % 8)..4 * (e % 8) + 4` of word `e / 8`, a
+    /// step count in 1..=`MAX_GROWTH_STEPS` proportional to its weight (see
+    /// `quantize_weights`). This is the layout of the full-decode block's
+    /// weight window, so the weighted software decoder and the accelerator
+    /// are loaded from the same buffer.
+    pub edge_steps: Vec<u32, A>,
+
+    /// Logical observables flipped by each edge, parallel to `fast_edges`.
+    ///
+    /// Bit k is set if the error flips observable L<k> (the edge parity
+    /// with respect to that observable).
+    pub edge_observables: Vec<u32, A>,
+
     /// CSR adjacency offsets into `adj_targets`.
     ///
     /// `adj_offsets[i]..adj_offsets[i+1]` is the range of `adj_targets` that
     /// lists all neighbours of node i. Length is `max_node_id + 1`. Built once
     /// by `build_adjacency` after all edges have been added.
-    pub adj_offsets: Vec<u32>,
+    pub adj_offsets: Vec<u32, A>,
 
     /// Packed neighbour list in CSR order.
     ///
     /// Contains the neighbour node indices for every node, laid out contiguously
     /// in the order defined by `adj_offsets`. Allows O(degree) iteration over
     /// the neighbours of any node without scanning the full edge list.
-    pub adj_targets: Vec<u32>,
+    pub adj_targets: Vec<u32, A>,
+
+    /// Index into `fast_edges` of each `adj_targets` entry.
+    ///
+    /// Lists the edges incident to each node in the same CSR order, so a
+    /// decoder can find the edges a newly touched node makes relevant
+    /// without scanning the full edge list.
+    pub adj_edges: Vec<u32, A>,
 
     /// Estimated capacity for node indices.
     ///
@@ -96,13 +148,43 @@ impl DecodingGraph<Global> {
         Self::new_in(capacity, Global)
     }
 
+    /// Loads a graph from a precompiled image with the global allocator.
+    ///
+    /// # Arguments
+    ///
+    /// * `image` - Validated graph image
+    ///
+    /// # Returns
+    ///
+    /// The graph, or an error if memory allocation fails.
+    pub fn from_image(image: &GraphImage) -> Result<Self, QecError> {
+        Self::from_image_in(image, Global)
+    }
+
     /// Builds the CSR adjacency list from the current edge set.
     ///
     /// Must be called once after all edges have been added via `add_edge`.
-    /// Constructs `adj_offsets` and `adj_targets` for O(degree) neighbour
-    /// access during decoding. Calling this again after further `add_edge`
-    /// calls will rebuild correctly.
+    /// First sorts the edges by their lower, then higher endpoint (keeping
+    /// the weights and observables with them), so the flat list and the CSR
+    /// lists visit nodes in ascending order and a sweep touches the parent
+    /// and parity arrays sequentially rather than in file order. Then
+    /// constructs `adj_offsets`, `adj_targets` and `adj_edges` for O(degree)
+    /// neighbour access during decoding and quantizes the weights. Calling
+    /// this again after further `add_edge` calls will rebuild correctly.
     pub fn build_adjacency(&mut self) {
+        let key = |&(u, v): &(u32, u32)| (u.min(v), u.max(v));
+        let mut order: Vec<u32> = (0..self.fast_edges.len() as u32).collect();
+        order.sort_by_key(|&e| key(&self.fast_edges[e as usize]));
+        self.fast_edges = order.iter().map(|&e| self.fast_edges[e as usize]).collect();
+        self.edge_weights = order
+            .iter()
+            .map(|&e| self.edge_weights[e as usize])
+            .collect();
+        self.edge_observables = order
+            .iter()
+            .map(|&e| self.edge_observables[e as usize])
+            .collect();
+
         let n = self.max_node_id;
         let mut degree = vec![0u32; n];
 
@@ -118,22 +200,27 @@ impl DecodingGraph<Global> {
 
         let total = offsets[n] as usize;
         let mut targets = vec![0u32; total];
+        let mut edges = vec![0u32; total];
         let mut pos = offsets[..n].to_vec();
 
-        for &(u, v) in &self.fast_edges {
+        for (e, &(u, v)) in self.fast_edges.iter().enumerate() {
             targets[pos[u as usize] as usize] = v;
+            edges[pos[u as usize] as usize] = e as u32;
             pos[u as usize] += 1;
             targets[pos[v as usize] as usize] = u;
+            edges[pos[v as usize] as usize] = e as u32;
             pos[v as usize] += 1;
         }
 
         self.adj_offsets = offsets;
         self.adj_targets = targets;
+        self.adj_edges = edges;
+        self.quantize_weights()
+            .expect("Failed to allocate the growth steps");
     }
-
 }
 
-impl<A: Allocator> DecodingGraph<A> {
+impl<A: Allocator + Clone> DecodingGraph<A> {
     /// Creates a new decoding graph with a custom allocator.
     ///
     /// Allows graph construction in firmware environments where custom
@@ -146,14 +233,83 @@ impl<A: Allocator> DecodingGraph<A> {
     /// * `alloc` - Allocator instance for edge storage
     pub fn new_in(capacity: usize, alloc: A) -> Self {
         Self {
-            fast_edges: Vec::with_capacity_in(capacity * 4, alloc),
-            adj_offsets: Vec::new(),
-            adj_targets: Vec::new(),
+            fast_edges: Vec::with_capacity_in(capacity * 4, alloc.clone()),
+            edge_weights: Vec::with_capacity_in(capacity * 4, alloc.clone()),
+            edge_observables: Vec::with_capacity_in(capacity * 4, alloc.clone()),
+            edge_steps: Vec::new_in(alloc.clone()),
+            adj_offsets: Vec::new_in(alloc.clone()),
+            adj_targets: Vec::new_in(alloc.clone()),
+            adj_edges: Vec::new_in(alloc),
             num_nodes_capacity: capacity,
             max_node_id: 0,
         }
     }
 
+    /// Loads a graph from a precompiled image with a custom allocator.
+    ///
+    /// Copies the image sections into exactly sized storage; the image
+    /// already holds the adjacency list, so nothing is parsed or rebuilt.
+    /// This lets the firmware boot from an embedded image without a heap
+    /// beyond its bump allocator.
+    ///
+    /// # Arguments
+    ///
+    /// * `image` - Validated graph image
+    /// * `alloc` - Allocator instance for edge and adjacency storage
+    ///
+    /// # Returns
+    ///
+    /// The graph, or an error if memory allocation fails.
+    pub fn from_image_in(image: &GraphImage, alloc: A) -> Result<Self, QecError> {
+        let num_edges = image.num_edges();
+        let mut graph = Self {
+            fast_edges: Vec::new_in(alloc.clone()),
+            edge_weights: Vec::new_in(alloc.clone()),
+            edge_observables: Vec::new_in(alloc.clone()),
+            edge_steps: Vec::new_in(alloc.clone()),
+            adj_offsets: Vec::new_in(alloc.clone()),
+            adj_targets: Vec::new_in(alloc.clone()),
+            adj_edges: Vec::new_in(alloc),
+            num_nodes_capacity: image.num_nodes(),
+            max_node_id: image.num_nodes(),
+        };
+        graph
+            .fast_edges
+            .try_reserve_exact(num_edges)
+            .and(graph.edge_weights.try_reserve_exact(num_edges))
+            .and(graph.edge_observables.try_reserve_exact(num_edges))
+            .and(graph.edge_steps.try_reserve_exact(image.steps().len()))
+            .and(
+                graph
+                    .adj_offsets
+                    .try_reserve_exact(image.adj_offsets().len()),
+            )
+            .and(
+                graph
+                    .adj_targets
+                    .try_reserve_exact(image.adj_targets().len()),
+            )
+            .and(graph.adj_edges.try_reserve_exact(image.adj_edges().len()))
+            .map_err(|_| QecError::OutOfMemory)?;
+
+        graph
+            .fast_edges
+            .extend(image.edges().chunks_exact(2).map(|e| (e[0], e[1])));
+        graph
+            .edge_weights
+            .extend(image.weights().iter().map(|&w| f32::from_bits(w)));
+        graph
+            .edge_observables
+            .extend_from_slice(image.observables());
+        graph.edge_steps.extend_from_slice(image.steps());
+        graph.adj_offsets.extend_from_slice(image.adj_offsets());
+        graph.adj_targets.extend_from_slice(image.adj_targets());
+        graph.adj_edges.extend_from_slice(image.adj_edges());
+        Ok(graph)
+    }
+}
+
+impl<A: Allocator> DecodingGraph<A> {
     /// Ensures the graph can accommodate nodes up to index n.
     ///
     /// Updates the capacity estimate if n exceeds the current value. This
@@ -171,21 +327,44 @@ impl<A: Allocator> DecodingGraph<A> {
 
     /// Adds an edge between nodes u and v to the graph.
     ///
-    /// Records a connection in the error model topology. The weight parameter
-    /// is currently ignored but stored for future use. Updates the maximum
-    /// node ID to track the graph's actual size. Edges are stored as undirected,
-    /// so (u, v) and (v, u) are equivalent.
+    /// Records a connection in the error model topology. The weight is
+    /// stored and quantized by `build_adjacency`, and the edge flips no
+    /// logical observable. Updates the maximum node ID to track the graph's
+    /// actual size. Edges are stored as undirected, so (u, v) and (v, u) are
+    /// equivalent.
     ///
     /// # Arguments
     ///
     /// * `u` - First node index
     /// * `v` - Second node index
-    /// * `_weight` - Edge weight (currently unused)
+    /// * `weight` - Edge weight (negative log probability)
     ///
     /// # Returns
     ///
     /// Ok(()) on success, or an error if memory allocation fails.
-    pub fn add_edge(&mut self, u: usize, v: usize, _weight: f64) -> Result<(), QecError> {
+    pub fn add_edge(&mut self, u: usize, v: usize, weight: f64) -> Result<(), QecError> {
+        self.add_edge_with_observables(u, v, weight, 0)
+    }
+
+    /// Adds an edge that flips the given logical observables.
+    ///
+    /// # Arguments
+    ///
+    /// * `u` - First node index
+    /// * `v` - Second node index
+    /// * `weight` - Edge weight (negative log probability)
+    /// * `observables` - Mask of the observables the edge flips (bit k for L<k>)
+    ///
+    /// # Returns
+    ///
+    /// Ok(()) on success, or an error if memory allocation fails.
+    pub fn add_edge_with_observables(
+        &mut self,
+        u: usize,
+        v: usize,
+        weight: f64,
+        observables: u32,
+    ) -> Result<(), QecError> {
         let max_idx = if u > v { u } else { v };
         self.ensure_size(max_idx + 1);
 
@@ -194,10 +373,81 @@ impl<A: Allocator> DecodingGraph<A> {
         }
 
         self.fast_edges.push((u as u32, v as u32));
+        self.edge_weights.push(weight as f32);
+        self.edge_observables.push(observables);
+
+        Ok(())
+    }
+
+    /// Quantizes the edge weights into growth steps.
+    ///
+    /// Scales every weight so the smallest positive one (the most likely
+    /// error) takes `GROWTH_RESOLUTION` steps, rounds to the nearest step
+    /// and clamps to 1..=`MAX_GROWTH_STEPS`, so unlikely errors take more
+    /// steps to grow across and no edge is crossed for free. Infinite
+    /// weights (impossible errors) take the maximum. The steps are then
+    /// divided by their greatest common divisor, since a decoding round
+    /// costs a sweep per step whatever the scale: a graph of equal weights
+    /// takes one step per edge. That is still not the unweighted decoder,
+    /// which merges greedily in edge order; each weighted round grows every
+    /// odd cluster across all its boundary edges and only then fuses them,
+    /// so the two generally return different corrections. Called by
+    /// `build_adjacency`; images carry the result.
+    ///
+    /// # Returns
+    ///
+    /// Ok(()) on success, or an error if memory allocation fails.
+    pub fn quantize_weights(&mut self) -> Result<(), QecError> {
+        let min_weight = self
+            .edge_weights
+            .iter()
+            .copied()
+            .filter(|&w| w.is_finite() && w > 0.0)
+            .fold(f32::INFINITY, f32::min);
+        let quantize = |w: f32| {
+            if !w.is_finite() {
+                MAX_GROWTH_STEPS
+            } else if min_weight.is_finite() {
+                ((w * GROWTH_RESOLUTION as f32 / min_weight + 0.5) as u32)
+                    .clamp(1, MAX_GROWTH_STEPS)
+            } else {
+                1
+            }
+        };
+        let mut divisor = 0;
+        for &w in self.edge_weights.iter() {
+            let (mut a, mut b) = (divisor, quantize(w));
+            while b != 0 {
+                (a, b) = (b, a % b);
+            }
+            divisor = a;
+        }
 
+        let words = self.fast_edges.len().div_ceil(STEPS_PER_WORD);
+        self.edge_steps.clear();
+        self.edge_steps
+            .try_reserve_exact(words)
+            .map_err(|_| QecError::OutOfMemory)?;
+        self.edge_steps.resize(words, 0);
+        for (e, &w) in self.edge_weights.iter().enumerate() {
+            let steps = quantize(w) / divisor;
+            self.edge_steps[e / STEPS_PER_WORD] |= steps << (4 * (e % STEPS_PER_WORD));
+        }
         Ok(())
     }
 
+    /// Returns the quantized growth steps of edge `e`.
+    ///
+    /// Requires the weights to have been quantized (`build_adjacency` or an
+    /// image); returns 1, an unweighted edge, otherwise.
+    #[inline(always)]
+    pub fn growth_steps(&self, e: usize) -> u32 {
+        match self.edge_steps.get(e / STEPS_PER_WORD) {
+            Some(&word) => (word >> (4 * (e % STEPS_PER_WORD))) & 0xF,
+            None => 1,
+        }
+    }
+
     /// Returns the number of nodes in the graph.
     ///
     /// Computed as the maximum node ID plus one, since node indices are
@@ -224,4 +474,17 @@ impl<A: Allocator> DecodingGraph<A> {
         let end = self.adj_offsets[i + 1] as usize;
         &self.adj_targets[start..end]
     }
+
+    /// Returns the indices into `fast_edges` of the edges incident to node `i`.
+    ///
+    /// Same order and preconditions as `neighbors`.
+    #[inline(always)]
+    pub fn incident_edges(&self, i: usize) -> &[u32] {
+        if self.adj_offsets.len() <= i + 1 {
+            return &[];
+        }
+        let start = self.adj_offsets[i] as usize;
+        let end = self.adj_offsets[i + 1] as usize;
+        &self.adj_edges[start..end]
+    }
 }
@@ -0,0 +1,350 @@
+//! Precompiled binary image of a decoding graph.
+//!
+//! A graph image holds a `DecodingGraph` in the layout the graph keeps in
+//! memory, so loading one is a handful of bulk copies instead of parsing a
+//! text error model and rebuilding the adjacency lists. The host compiles
+//! images with `qcu_host compile-graph` and the firmware embeds the same
+//! file, so both decode with an identical graph.
+//!
+//! The image is a sequence of little-endian 32-bit words:
+//!
+//! | Words              | Contents                                          |
+//! |--------------------|---------------------------------------------------|
+//! | 0                  | Magic `IMAGE_MAGIC` ("QCUG")                      |
+//! | 1                  | Format version `IMAGE_VERSION`                    |
+//! | 2                  | Nodes N                                           |
+//! | 3                  | Edges E                                           |
+//! | 4                  | Adjacency entries T (2 E)                         |
+//! | 5                  | Reserved, zero                                    |
+//! | 6, 7               | Checksum of the payload (low word first)          |
+//! | 2 E                | Edge endpoints (u, v) in `fast_edges` order       |
+//! | E                  | Edge weights as f32 bit patterns                  |
+//! | E                  | Observable masks of the edges                     |
+//! | E / 8, rounded up  | Growth steps, eight 4-bit fields per word         |
+//! | N + 1              | CSR offsets (`adj_offsets`)                       |
+//! | T                  | CSR neighbours (`adj_targets`)                    |
+//! | T                  | CSR edge indices (`adj_edges`)                    |
+//!
+//! The checksum is a 64-bit FNV-1a hash over the payload words, which
+//! rejects truncated or corrupted images before they reach the decoder.
+
+use crate::QecError;
+use crate::graph::{DecodingGraph, MAX_GROWTH_STEPS, STEPS_PER_WORD};
+use alloc::vec::Vec;
+use core::alloc::Allocator;
+
+/// First word of every graph image ("QCUG" in file byte order).
+pub const IMAGE_MAGIC: u32 = u32::from_le_bytes(*b"QCUG");
+
+/// Format version written to and required in the header.
+pub const IMAGE_VERSION: u32 = 1;
+
+/// Number of header words preceding the payload.
+pub const HEADER_WORDS: usize = 8;
+
+/// FNV-1a 64-bit offset basis.
+const FNV_OFFSET: u64 = 0xcbf2_9ce4_8422_2325;
+
+/// FNV-1a 64-bit prime.
+const FNV_PRIME: u64 = 0x0000_0100_0000_01b3;
+
+/// Computes the image checksum of a payload.
+///
+/// Folds whole 32-bit words rather than bytes into the hash, which keeps
+/// validating a large image cheap compared to copying it.
+///
+/// # Arguments
+///
+/// * `payload` - Payload words following the header
+///
+/// # Returns
+///
+/// The 64-bit FNV-1a hash of the words.
+pub fn checksum(payload: &[u32]) -> u64 {
+    let mut hash = FNV_OFFSET;
+    for &word in payload {
+        hash ^= word as u64;
+        hash = hash.wrapping_mul(FNV_PRIME);
+    }
+    hash
+}
+
+/// Validated view of a graph image.
+///
+/// Borrows the image words and exposes each section as a slice, so the
+/// image itself is never copied; `DecodingGraph::from_image_in` copies the
+/// sections into a graph.
+pub struct GraphImage<'a> {
+    /// Number of detector nodes.
+    num_nodes: usize,
+
+    /// Number of edges.
+    num_edges: usize,
+
+    /// Edge endpoints, two words per edge.
+    edges: &'a [u32],
+
+    /// Edge weights as f32 bit patterns.
+    weights: &'a [u32],
+
+    /// Observable masks, one per edge.
+    observables: &'a [u32],
+
+    /// Packed growth steps, `STEPS_PER_WORD` edges per word.
+    steps: &'a [u32],
+
+    /// CSR offsets, N + 1 entries.
+    adj_offsets: &'a [u32],
+
+    /// CSR neighbour list.
+    adj_targets: &'a [u32],
+
+    /// CSR edge indices.
+    adj_edges: &'a [u32],
+}
+
+impl<'a> GraphImage<'a> {
+    /// Validates an image held as 32-bit words.
+    ///
+    /// Checks the magic, version, section sizes against the image length,
+    /// the checksum, the CSR offsets, the node and edge indices and the
+    /// growth steps (each in 1..=`MAX_GROWTH_STEPS`, unused fields of the
+    /// last word zero), so the accessors, `DecodingGraph::from_image_in`
+    /// and the weighted decoder can rely on a consistent image.
+    ///
+    /// # Arguments
+    ///
+    /// * `words` - The complete image
+    ///
+    /// # Returns
+    ///
+    /// The view, or `QecError::InvalidImage` if the image is malformed.
+    pub fn from_words(words: &'a [u32]) -> Result<Self, QecError> {
+        // Sections are used in place, so only little-endian hosts can read
+        // them; the firmware and every supported host are.
+        if cfg!(target_endian = "big") || words.len() < HEADER_WORDS {
+            return Err(QecError::InvalidImage);
+        }
+        let header = &words[..HEADER_WORDS];
+        if header[0] != IMAGE_MAGIC || header[1] != IMAGE_VERSION {
+            return Err(QecError::InvalidImage);
+        }
+
+        let num_nodes = header[2] as usize;
+        let num_edges = header[3] as usize;
+        let num_targets = header[4] as usize;
+        let num_steps = num_edges.div_ceil(STEPS_PER_WORD);
+        let payload = &words[HEADER_WORDS..];
+        if num_targets != 2 * num_edges
+            || payload.len() != 8 * num_edges + num_steps + num_nodes + 1
+        {
+            return Err(QecError::InvalidImage);
+        }
+        if checksum(payload) != (header[6] as u64 | (header[7] as u64) << 32) {
+            return Err(QecError::InvalidImage);
+        }
+
+        let (edges, rest) = payload.split_at(2 * num_edges);
+        let (weights, rest) = rest.split_at(num_edges);
+        let (observables, rest) = rest.split_at(num_edges);
+        let (steps, rest) = rest.split_at(num_steps);
+        let (adj_offsets, rest) = rest.split_at(num_nodes + 1);
+        let (adj_targets, adj_edges) = rest.split_at(num_targets);
+
+        if adj_offsets[0] != 0
+            || adj_offsets[num_nodes] as usize != num_targets
+            || adj_offsets.windows(2).any(|w| w[0] > w[1])
+            || edges.iter().any(|&n| n as usize >= num_nodes)
+            || adj_targets.iter().any(|&n| n as usize >= num_nodes)
+            || adj_edges.iter().any(|&e| e as usize >= num_edges)
+        {
+            return Err(QecError::InvalidImage);
+        }
+        for (i, &word) in steps.iter().enumerate() {
+            for field in 0..STEPS_PER_WORD {
+                let step = (word >> (4 * field)) & 0xF;
+                let valid = if i * STEPS_PER_WORD + field < num_edges {
+                    (1..=MAX_GROWTH_STEPS).contains(&step)
+                } else {
+                    step == 0
+                };
+                if !valid {
+                    return Err(QecError::InvalidImage);
+                }
+            }
+        }
+
+        Ok(Self {
+            num_nodes,
+            num_edges,
+            edges,
+            weights,
+            observables,
+            steps,
+            adj_offsets,
+            adj_targets,
+            adj_edges,
+        })
+    }
+
+    /// Validates an image held as bytes.
+    ///
+    /// # Arguments
+    ///
+    /// * `bytes` - The complete image, aligned to 4 bytes (as a memory map
+    ///   or an `#[repr(align(4))]` static is)
+    ///
+    /// # Returns
+    ///
+    /// The view, or `QecError::InvalidImage` if the bytes are misaligned,
+    /// not a whole number of words or not a valid image.
+    pub fn from_bytes(bytes: &'a [u8]) -> Result<Self, QecError> {
+        if bytes.as_ptr() as usize % 4 != 0 || bytes.len() % 4 != 0 {
+            return Err(QecError::InvalidImage);
+        }
+        let words =
+            unsafe { core::slice::from_raw_parts(bytes.as_ptr() as *const u32, bytes.len() / 4) };
+        Self::from_words(words)
+    }
+
+    /// Returns the number of detector nodes.
+    pub fn num_nodes(&self) -> usize {
+        self.num_nodes
+    }
+
+    /// Returns the number of edges.
+    pub fn num_edges(&self) -> usize {
+        self.num_edges
+    }
+
+    /// Returns the edge endpoints as consecutive (u, v) words.
+    pub fn edges(&self) -> &'a [u32] {
+        self.edges
+    }
+
+    /// Returns the edge weights as f32 bit patterns.
+    pub fn weights(&self) -> &'a [u32] {
+        self.weights
+    }
+
+    /// Returns the observable masks of the edges.
+    pub fn observables(&self) -> &'a [u32] {
+        self.observables
+    }
+
+    /// Returns the packed growth steps of the edges.
+    pub fn steps(&self) -> &'a [u32] {
+        self.steps
+    }
+
+    /// Returns the CSR offsets.
+    pub fn adj_offsets(&self) -> &'a [u32] {
+        self.adj_offsets
+    }
+
+    /// Returns the CSR neighbour list.
+    pub fn adj_targets(&self) -> &'a [u32] {
+        self.adj_targets
+    }
+
+    /// Returns the CSR edge indices.
+    pub fn adj_edges(&self) -> &'a [u32] {
+        self.adj_edges
+    }
+}
+
+/// Encodes a decoding graph as an image.
+///
+/// # Arguments
+///
+/// * `graph` - Graph to encode; its adjacency must have been built
+///
+/// # Returns
+///
+/// The image words in host byte order (written little-endian by
+/// `qcu_io::parser::save_graph_image`), or `QecError::InvalidImage` if the
+/// adjacency has not been built or the weights not quantized for the
+/// graph's current edges.
+pub fn encode<A: Allocator>(graph: &DecodingGraph<A>) -> Result<Vec<u32>, QecError> {
+    let num_nodes = graph.num_nodes();
+    let num_edges = graph.fast_edges.len();
+    let num_steps = num_edges.div_ceil(STEPS_PER_WORD);
+    if graph.adj_offsets.len() != num_nodes + 1
+        || graph.adj_targets.len() != 2 * num_edges
+        || graph.adj_edges.len() != 2 * num_edges
+        || graph.edge_steps.len() != num_steps
+    {
+        return Err(QecError::InvalidImage);
+    }
+
+    let mut words = Vec::with_capacity(HEADER_WORDS + 8 * num_edges + num_steps + num_nodes + 1);
+    words.extend_from_slice(&[
+        IMAGE_MAGIC,
+        IMAGE_VERSION,
+        num_nodes as u32,
+        num_edges as u32,
+        2 * num_edges as u32,
+        0,
+        0,
+        0,
+    ]);
+    for &(u, v) in graph.fast_edges.iter() {
+        words.push(u);
+        words.push(v);
+    }
+    words.extend(graph.edge_weights.iter().map(|w| w.to_bits()));
+    words.extend_from_slice(&graph.edge_observables);
+    words.extend_from_slice(&graph.edge_steps);
+    words.extend_from_slice(&graph.adj_offsets);
+    words.extend_from_slice(&graph.adj_targets);
+    words.extend_from_slice(&graph.adj_edges);
+
+    let sum = checksum(&words[HEADER_WORDS..]);
+    words[6] = sum as u32;
+    words[7] = (sum >> 32) as u32;
+    Ok(words)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    /// Encodes a path of `edges` edges with weights 1 and 2.
+    fn path_image(edges: usize) -> Vec<u32> {
+        let mut graph = DecodingGraph::new(edges + 1);
+        for e in 0..edges {
+            graph.add_edge(e, e + 1, (e % 2 + 1) as f64).unwrap();
+        }
+        graph.build_adjacency();
+        encode(&graph).unwrap()
+    }
+
+    /// Replaces the packed step word `i` and re-seals the checksum.
+    fn with_steps(mut words: Vec<u32>, i: usize, word: u32) -> Vec<u32> {
+        let base = HEADER_WORDS + 4 * words[3] as usize;
+        words[base + i] = word;
+        let sum = checksum(&words[HEADER_WORDS..]);
+        words[6] = sum as u32;
+        words[7] = (sum >> 32) as u32;
+        words
+    }
+
+    #[test]
+    fn rejects_invalid_growth_steps() {
+        let words = path_image(5);
+        let steps = GraphImage::from_words(&words).unwrap().steps()[0];
+        assert!(GraphImage::from_words(&with_steps(words.clone(), 0, steps)).is_ok());
+
+        let zero = with_steps(words.clone(), 0, steps & !0xF);
+        assert!(matches!(
+            GraphImage::from_words(&zero),
+            Err(QecError::InvalidImage)
+        ));
+
+        let padding = with_steps(words, 0, steps | 1 << (4 * 5));
+        assert!(matches!(
+            GraphImage::from_words(&padding),
+            Err(QecError::InvalidImage)
+        ));
+    }
+}
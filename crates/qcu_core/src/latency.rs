@@ -0,0 +1,353 @@
+//! Lock-free HDR-style latency histograms and their shared export format.
+//!
+//! A `LatencyHistogram` records latencies into log-linear buckets: values
+//! below `SUB_BUCKETS` get one bucket each, and every further power of two
+//! is split into `SUB_BUCKETS` equal buckets, so any recorded value is
+//! known to within 1 / `SUB_BUCKETS` (about 3%) over the whole u64 range
+//! with a fixed `BUCKETS` counters. Every counter is an atomic updated
+//! with relaxed `fetch_add`, so any number of threads or harts can record
+//! into one histogram without locks while another reads or drains it.
+//!
+//! Every layer reports latencies as one `LatencySummary` line:
+//!
+//! ```text
+//! LAT <source> unit=<unit> count=<n> min=<v> mean=<v> p50=<v> p99=<v> p999=<v> max=<v> deadline=<v> misses=<n>
+//! ```
+//!
+//! `source` names the measurement (for example `host.stream.decode`,
+//! `fw.e2e` or `sim.pulse`), `unit` is `ns` for wall time and `cycles`
+//! for simulated clock cycles, percentiles are the highest value of the
+//! bucket holding that rank (clamped to the observed maximum), and
+//! `deadline` is 0 when none is configured. The simulation server
+//! (`qcu_hw/src/sim/latency_hist.h`) uses the same buckets and prints the
+//! same line, so decode, transport and simulation budgets can be compared
+//! directly.
+
+use core::fmt;
+use core::sync::atomic::{AtomicU64, Ordering};
+
+/// Bits of sub-bucket resolution per power of two.
+pub const SUB_BUCKET_BITS: u32 = 5;
+
+/// Buckets per power of two.
+pub const SUB_BUCKETS: usize = 1 << SUB_BUCKET_BITS;
+
+/// Number of buckets needed to cover every u64 value.
+pub const BUCKETS: usize = (65 - SUB_BUCKET_BITS as usize) * SUB_BUCKETS;
+
+/// Returns the bucket a value is recorded in.
+///
+/// # Arguments
+///
+/// * `value` - Recorded value
+///
+/// # Returns
+///
+/// The bucket index, below `BUCKETS`.
+#[inline(always)]
+pub const fn bucket_index(value: u64) -> usize {
+    if value < SUB_BUCKETS as u64 {
+        return value as usize;
+    }
+    let shift = 63 - value.leading_zeros() - SUB_BUCKET_BITS;
+    (shift as usize + 1) * SUB_BUCKETS + ((value >> shift) as usize - SUB_BUCKETS)
+}
+
+/// Returns the highest value recorded in a bucket.
+///
+/// # Arguments
+///
+/// * `index` - Bucket index, below `BUCKETS`
+///
+/// # Returns
+///
+/// The largest value whose `bucket_index` is `index`.
+pub const fn bucket_high(index: usize) -> u64 {
+    if index < SUB_BUCKETS {
+        return index as u64;
+    }
+    let shift = (index / SUB_BUCKETS - 1) as u32;
+    let sub = (index % SUB_BUCKETS + SUB_BUCKETS) as u64;
+    (sub << shift) | ((1u64 << shift) - 1)
+}
+
+/// Summary of a latency distribution in the shared export format.
+#[derive(Debug, Clone, Copy, Default)]
+pub struct LatencySummary {
+    /// Number of recorded values.
+    pub count: u64,
+
+    /// Smallest recorded value (0 without values).
+    pub min: u64,
+
+    /// Mean of the recorded values, rounded down.
+    pub mean: u64,
+
+    /// Median.
+    pub p50: u64,
+
+    /// 99th percentile.
+    pub p99: u64,
+
+    /// 99.9th percentile.
+    pub p999: u64,
+
+    /// Largest recorded value.
+    pub max: u64,
+
+    /// Deadline the values were checked against (0 for none).
+    pub deadline: u64,
+
+    /// Values that exceeded the deadline.
+    pub misses: u64,
+}
+
+impl LatencySummary {
+    /// Formats the summary as an export line.
+    ///
+    /// # Arguments
+    ///
+    /// * `source` - Name of the measurement
+    /// * `unit` - Unit of the values (`ns` or `cycles`)
+    ///
+    /// # Returns
+    ///
+    /// A value whose `Display` output is the line, without a newline.
+    pub fn line<'a>(&'a self, source: &'a str, unit: &'a str) -> SummaryLine<'a> {
+        SummaryLine {
+            summary: self,
+            source,
+            unit,
+        }
+    }
+}
+
+/// Export line of a `LatencySummary`, created by `LatencySummary::line`.
+pub struct SummaryLine<'a> {
+    summary: &'a LatencySummary,
+    source: &'a str,
+    unit: &'a str,
+}
+
+impl fmt::Display for SummaryLine<'_> {
+    /// Writes the line in the format described in the module documentation.
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        let s = self.summary;
+        write!(
+            f,
+            "LAT {} unit={} count={} min={} mean={} p50={} p99={} p999={} max={} deadline={} misses={}",
+            self.source,
+            self.unit,
+            s.count,
+            s.min,
+            s.mean,
+            s.p50,
+            s.p99,
+            s.p999,
+            s.max,
+            s.deadline,
+            s.misses
+        )
+    }
+}
+
+/// Lock-free log-linear latency histogram with deadline accounting.
+///
+/// Statically allocatable (`new` is const), so firmware can keep one in a
+/// `static` shared by all harts. Recording costs a handful of relaxed
+/// atomic operations and never blocks.
+pub struct LatencyHistogram {
+    /// Values recorded per bucket.
+    buckets: [AtomicU64; BUCKETS],
+
+    /// Number of recorded values.
+    count: AtomicU64,
+
+    /// Sum of the recorded values (wrapping).
+    sum: AtomicU64,
+
+    /// Smallest recorded value, u64::MAX without values.
+    min: AtomicU64,
+
+    /// Largest recorded value.
+    max: AtomicU64,
+
+    /// Deadline values are checked against, 0 for none (setting).
+    deadline: AtomicU64,
+
+    /// Values that exceeded the deadline.
+    misses: AtomicU64,
+}
+
+impl Default for LatencyHistogram {
+    /// Creates an empty histogram without a deadline.
+    ///
+    /// Equivalent to calling `new()`, provided for trait compatibility.
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+impl LatencyHistogram {
+    /// Creates an empty histogram without a deadline.
+    pub const fn new() -> Self {
+        Self {
+            buckets: [const { AtomicU64::new(0) }; BUCKETS],
+            count: AtomicU64::new(0),
+            sum: AtomicU64::new(0),
+            min: AtomicU64::new(u64::MAX),
+            max: AtomicU64::new(0),
+            deadline: AtomicU64::new(0),
+            misses: AtomicU64::new(0),
+        }
+    }
+
+    /// Sets the deadline that later values are checked against.
+    ///
+    /// # Arguments
+    ///
+    /// * `deadline` - Largest value that meets the deadline, 0 for none
+    pub fn set_deadline(&self, deadline: u64) {
+        self.deadline.store(deadline, Ordering::Relaxed);
+    }
+
+    /// Returns the configured deadline (0 for none).
+    pub fn deadline(&self) -> u64 {
+        self.deadline.load(Ordering::Relaxed)
+    }
+
+    /// Records one value.
+    ///
+    /// The counters are updated independently, so a `summary` or `drain`
+    /// running concurrently may see a value in some of them only; a value
+    /// split across two drains is still reported exactly once in total.
+    ///
+    /// # Arguments
+    ///
+    /// * `value` - Latency to record
+    #[inline(always)]
+    pub fn record(&self, value: u64) {
+        self.buckets[bucket_index(value)].fetch_add(1, Ordering::Relaxed);
+        self.sum.fetch_add(value, Ordering::Relaxed);
+        self.min.fetch_min(value, Ordering::Relaxed);
+        self.max.fetch_max(value, Ordering::Relaxed);
+        let deadline = self.deadline.load(Ordering::Relaxed);
+        if deadline != 0 && value > deadline {
+            self.misses.fetch_add(1, Ordering::Relaxed);
+        }
+        self.count.fetch_add(1, Ordering::Relaxed);
+    }
+
+    /// Adds every value recorded in another histogram.
+    ///
+    /// Used to combine the histograms of several workers into one report.
+    ///
+    /// # Arguments
+    ///
+    /// * `other` - Histogram to add; left unchanged
+    pub fn merge(&self, other: &Self) {
+        for (bucket, src) in self.buckets.iter().zip(other.buckets.iter()) {
+            let n = src.load(Ordering::Relaxed);
+            if n != 0 {
+                bucket.fetch_add(n, Ordering::Relaxed);
+            }
+        }
+        self.sum
+            .fetch_add(other.sum.load(Ordering::Relaxed), Ordering::Relaxed);
+        self.min
+            .fetch_min(other.min.load(Ordering::Relaxed), Ordering::Relaxed);
+        self.max
+            .fetch_max(other.max.load(Ordering::Relaxed), Ordering::Relaxed);
+        self.misses
+            .fetch_add(other.misses.load(Ordering::Relaxed), Ordering::Relaxed);
+        self.count
+            .fetch_add(other.count.load(Ordering::Relaxed), Ordering::Relaxed);
+    }
+
+    /// Summarizes the values recorded so far.
+    ///
+    /// # Returns
+    ///
+    /// The summary; the histogram is left unchanged.
+    pub fn summary(&self) -> LatencySummary {
+        self.scan(false)
+    }
+
+    /// Summarizes the values recorded so far and clears the histogram.
+    ///
+    /// Every counter is taken with an atomic swap, so values recorded
+    /// concurrently are reported either now or by the next drain, never
+    /// lost. The deadline is a setting and is kept.
+    ///
+    /// # Returns
+    ///
+    /// The summary of the drained values.
+    pub fn drain(&self) -> LatencySummary {
+        self.scan(true)
+    }
+
+    /// Reads (or swaps out) the counters and computes the summary.
+    ///
+    /// The count is taken first and the percentiles located in a single
+    /// pass over the buckets, so no bucket copy is needed; a rank that is
+    /// not reached because of values recorded mid-scan resolves to the
+    /// maximum.
+    ///
+    /// # Arguments
+    ///
+    /// * `reset` - Swap every counter back to its empty value
+    ///
+    /// # Returns
+    ///
+    /// The summary.
+    fn scan(&self, reset: bool) -> LatencySummary {
+        let take = |counter: &AtomicU64, empty: u64| {
+            if reset {
+                counter.swap(empty, Ordering::Relaxed)
+            } else {
+                counter.load(Ordering::Relaxed)
+            }
+        };
+
+        let count = take(&self.count, 0);
+        let sum = take(&self.sum, 0);
+        let min = take(&self.min, u64::MAX);
+        let max = take(&self.max, 0);
+        let misses = take(&self.misses, 0);
+
+        // Ranks (1-based) of the reported percentiles, in per mille.
+        let ranks = [500, 990, 999].map(|per_mille| (count * per_mille).div_ceil(1000).max(1));
+        let mut values = [max; 3];
+        let mut next = 0;
+        let mut seen = 0;
+        for (index, bucket) in self.buckets.iter().enumerate() {
+            let n = take(bucket, 0);
+            if n == 0 || next == ranks.len() {
+                continue;
+            }
+            seen += n;
+            while next < ranks.len() && seen >= ranks[next] {
+                values[next] = bucket_high(index).min(max);
+                next += 1;
+            }
+        }
+
+        if count == 0 {
+            return LatencySummary {
+                deadline: self.deadline(),
+                ..LatencySummary::default()
+            };
+        }
+        LatencySummary {
+            count,
+            min: min.min(max),
+            mean: sum / count,
+            p50: values[0],
+            p99: values[1],
+            p999: values[2],
+            max,
+            deadline: self.deadline(),
+            misses,
+        }
+    }
+}
@@ -49,6 +49,20 @@ pub mod dsu;
 /// determine correction operations from syndrome measurements.
 pub mod graph;
 
+/// Precompiled binary images of decoding graphs.
+///
+/// Stores a decoding graph's edges, weights, observable masks and CSR
+/// adjacency in the in-memory layout, so host and firmware load the same
+/// artifact with bulk copies instead of parsing a detector error model.
+pub mod graph_image;
+
+/// Lock-free latency histograms with deadline accounting.
+///
+/// Records latencies into log-linear buckets shared by host, firmware and
+/// simulator, and reports them as one export line with percentiles and
+/// deadline misses, so every layer's latency budget reads the same way.
+pub mod latency;
+
 /// Pauli frame tracking for quantum state updates.
 ///
 /// Maintains a representation of accumulated Pauli corrections applied to
@@ -121,4 +135,11 @@ pub enum QecError {
     /// additional elements. The caller must either use a larger buffer or
     /// implement overflow handling logic.
     BufferOverflow,
+
+    /// A precompiled graph image is malformed.
+    ///
+    /// The image has the wrong magic or version, inconsistent section sizes,
+    /// a checksum mismatch or out-of-range node indices, typically because it
+    /// was truncated or produced by an incompatible converter.
+    InvalidImage,
 }
@@ -4,6 +4,8 @@
 //! consumer threads concurrently. Uses compare-and-swap operations on the tail
 //! pointer to handle concurrent consumers safely. The buffer is statically
 //! allocated at compile time, making it suitable for no_std firmware environments.
+//! Consumers can claim several consecutive items with one compare-and-swap,
+//! which the firmware uses for batched pops and for work stealing.
 
 use core::cell::UnsafeCell;
 use core::mem::MaybeUninit;
@@ -95,40 +97,103 @@ impl<T: Copy, const N: usize> StaticQueue<T, N> {
         Ok(())
     }
 
+    /// Returns the number of items currently in the queue.
+    ///
+    /// The producer and the consumers move head and tail concurrently, so
+    /// the value is a snapshot that may already be stale when it returns.
+    /// Meant for load balancing and monitoring, not for deciding whether a
+    /// pop will succeed.
+    #[inline(always)]
+    pub fn len(&self) -> usize {
+        let tail = self.tail.load(Ordering::Acquire);
+        let head = self.head.load(Ordering::Acquire);
+        head.wrapping_sub(tail).min(N)
+    }
+
+    /// Returns whether the queue currently holds no items.
+    #[inline(always)]
+    pub fn is_empty(&self) -> bool {
+        self.len() == 0
+    }
+
     /// Pops an item from the queue (consumer operation).
     ///
-    /// Attempts to claim and read an item from the current tail position using
-    /// compare-and-swap to handle concurrent consumers. Returns None if the
-    /// buffer is empty (tail has caught up to head). The compare-and-swap loop
-    /// retries if another consumer claimed the slot first, ensuring each item
-    /// is consumed exactly once.
+    /// Equivalent to `pop_batch` with room for a single item.
     ///
     /// # Returns
     ///
     /// Some(item) if an item was dequeued, None if the buffer is empty.
     #[inline(always)]
     pub fn pop(&self) -> Option<T> {
+        let mut item = [MaybeUninit::uninit()];
+        if self.claim(&mut item) == 0 {
+            return None;
+        }
+        Some(unsafe { item[0].assume_init() })
+    }
+
+    /// Pops up to `out.len()` consecutive items (consumer operation).
+    ///
+    /// Claims the whole run with a single compare-and-swap on tail, so a
+    /// consumer taking several items at once pays for one contended atomic
+    /// instead of one per item, and a thief can take half of another
+    /// consumer's backlog in one step. Items are returned oldest first.
+    ///
+    /// # Arguments
+    ///
+    /// * `out` - Receives the dequeued items in its leading slots
+    ///
+    /// # Returns
+    ///
+    /// The number of items dequeued, 0 if the buffer is empty.
+    #[inline(always)]
+    pub fn pop_batch(&self, out: &mut [T]) -> usize {
+        // `T: Copy`, so viewing initialized slots as `MaybeUninit` is sound
+        // and the claimed items are plain copies.
+        let out = unsafe { &mut *(out as *mut [T] as *mut [MaybeUninit<T>]) };
+        self.claim(out)
+    }
+
+    /// Copies out and claims up to `out.len()` items from the tail.
+    ///
+    /// The items are read before the compare-and-swap that claims them:
+    /// once tail has moved past a slot the producer may overwrite it, so
+    /// reading afterwards could return the next lap's item. A stale read is
+    /// harmless because the compare-and-swap then fails and the loop reads
+    /// again from the updated tail. The compare-and-swap retries if another
+    /// consumer claimed the slots first, ensuring each item is consumed
+    /// exactly once.
+    ///
+    /// # Arguments
+    ///
+    /// * `out` - Receives the claimed items in its leading slots
+    ///
+    /// # Returns
+    ///
+    /// The number of items claimed; only that many slots of `out` are
+    /// initialized.
+    #[inline(always)]
+    fn claim(&self, out: &mut [MaybeUninit<T>]) -> usize {
         let mut tail = self.tail.load(Ordering::Relaxed);
         loop {
             let head = self.head.load(Ordering::Acquire);
+            let count = head.wrapping_sub(tail).min(N).min(out.len());
+
+            if count == 0 {
+                return 0;
+            }
 
-            if tail == head {
-                return None;
+            for (i, slot) in out[..count].iter_mut().enumerate() {
+                *slot = unsafe { self.buffer[tail.wrapping_add(i) & (N - 1)].get().read() };
             }
 
             match self.tail.compare_exchange_weak(
                 tail,
-                tail.wrapping_add(1),
-                Ordering::Acquire,
+                tail.wrapping_add(count),
+                Ordering::AcqRel,
                 Ordering::Relaxed,
             ) {
-                Ok(_) => {
-                    let item = unsafe {
-                        let slot = self.buffer[tail & (N - 1)].get();
-                        (*slot).assume_init()
-                    };
-                    return Some(item);
-                }
+                Ok(_) => return count,
                 Err(actual_tail) => {
                     tail = actual_tail;
                 }
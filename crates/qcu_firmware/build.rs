@@ -4,6 +4,8 @@
 /// data from .b8 and .dem files. Converts binary measurement data into a
 /// Rust array of u64 words for efficient firmware access. If benchmark data
 /// files are missing, generates empty dummy data to allow compilation.
+/// `QCU_DEADLINE_NS` sets the per-shot latency deadline (default 100000,
+/// 0 for none).
 use std::env;
 use std::fs;
 use std::io::Write;
@@ -24,6 +26,16 @@ fn main() {
     println!("cargo:rerun-if-changed=memory.x");
     println!("cargo:rustc-link-arg=-Tmemory.x");
 
+    println!("cargo:rerun-if-env-changed=QCU_DEADLINE_NS");
+    let deadline_ns = match env::var("QCU_DEADLINE_NS") {
+        Ok(n) => n
+            .parse::<u64>()
+            .expect("QCU_DEADLINE_NS must be a nanosecond count"),
+        Err(_) => 100_000,
+    };
+    fs::write(out_dir.join("deadline_ns.rs"), format!("{}", deadline_ns))
+        .expect("failed to write deadline_ns.rs");
+
     let dest_path = out_dir.join("bench_data.rs");
     let manifest_dir = env::var("CARGO_MANIFEST_DIR").unwrap();
     let output_dir = Path::new(&manifest_dir).join("../../output");
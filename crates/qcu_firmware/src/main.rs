@@ -4,7 +4,10 @@
 //! correction system. The firmware runs on multiple RISC-V hardware threads
 //! (harts), with hart 0 acting as the primary core that loads the decoding
 //! graph and generates syndrome packets, while other harts act as worker
-//! cores that process decoding jobs from a shared queue.
+//! cores that process decoding jobs. Each worker owns a local queue that
+//! hart 0 fills, and a worker whose queue runs dry steals from the others,
+//! so a run of slow syndromes on one hart does not hold back the packets
+//! queued behind it.
 
 #![no_std]
 #![no_main]
@@ -19,6 +22,8 @@ use core::sync::atomic::{AtomicBool, AtomicI64, AtomicU64, Ordering};
 use qcu_core::allocator::BumpAllocator;
 use qcu_core::decoder::UnionFindDecoder;
 use qcu_core::graph::DecodingGraph;
+use qcu_core::graph_image::GraphImage;
+use qcu_core::latency::LatencyHistogram;
 use qcu_core::spmc::StaticQueue;
 use qcu_core::static_vec::StaticVec;
 
@@ -56,11 +61,20 @@ mod bench_data {
     include!(concat!(env!("OUT_DIR"), "/bench_data.rs"));
 }
 
-/// Embedded decoding graph description in DEM format.
+/// Wrapper that aligns embedded data to a word boundary.
 ///
-/// Loaded at compile time from the output directory. Used to initialize
-/// the decoding graph structure during firmware boot.
-static DEM_DATA: &str = include_str!("../../../output/bench.dem");
+/// `include_bytes!` only guarantees byte alignment; graph images are read
+/// in place as 32-bit words.
+#[repr(C, align(8))]
+struct Aligned<T: ?Sized>(T);
+
+/// Embedded precompiled decoding graph image.
+///
+/// Compiled from the output directory's .dem file by `qcu_host
+/// compile-graph`, so the firmware boots from the same artifact the host
+/// tools load. Used to initialize the decoding graph structure during
+/// firmware boot without parsing any text.
+static GRAPH_IMAGE: &Aligned<[u8]> = &Aligned(*include_bytes!("../../../output/bench.qcg"));
 
 use core::alloc::{GlobalAlloc, Layout};
 
@@ -138,20 +152,72 @@ pub struct SyndromePacket {
     pub syndromes: [u64; WORDS_PER_SHOT],
 }
 
-/// Global job queue for distributing decoding work to worker cores.
+/// Maximum number of harts the scheduler serves, including hart 0.
+///
+/// Sizes the per-hart queue and statistics arrays. Harts with a higher ID
+/// stay parked, so booting with more harts than this is safe.
+const MAX_HARTS: usize = 8;
+
+/// Capacity of each worker's local job queue (must be a power of two).
+const LOCAL_QUEUE_SLOTS: usize = 128;
+
+/// Maximum number of packets a worker takes from a queue at once.
+///
+/// A worker pops up to this many packets from its own queue with a single
+/// compare-and-swap, and a thief takes up to this many (half of the
+/// victim's backlog at most) per steal. Set to 1 to disable batching.
+const POP_BATCH: usize = 4;
+
+/// Local job queues of the worker cores, indexed by hart ID.
+///
+/// The primary core (hart 0) pushes each syndrome packet into the queue of
+/// the least loaded online worker. The owner pops from its queue, and idle
+/// workers steal from the tail of the others' queues, so the only
+/// contention on a queue comes from steals. Entry 0 is unused.
+pub static LOCAL_QUEUES: [StaticQueue<SyndromePacket, LOCAL_QUEUE_SLOTS>; MAX_HARTS] =
+    [const { StaticQueue::new() }; MAX_HARTS];
+
+/// Bit mask of the worker harts that are ready to take jobs.
 ///
-/// The primary core (hart 0) pushes syndrome packets into this queue,
-/// and worker cores (hart 1+) pop packets and process them. The queue
-/// uses a single-producer multi-consumer design to handle concurrent
-/// access from multiple worker threads safely.
-pub static JOB_QUEUE: StaticQueue<SyndromePacket, 512> = StaticQueue::new();
+/// Set by each worker once its decoder is allocated. The primary core only
+/// dispatches to, and thieves only steal from, harts in this mask.
+static ONLINE_WORKERS: AtomicU64 = AtomicU64::new(0);
 
-/// Atomic counter tracking the current depth of the job queue.
+/// Per-hart scheduler statistics.
 ///
-/// Maintained by incrementing on push and decrementing on pop. Used for
-/// monitoring queue utilization and detecting backpressure when the queue
-/// approaches capacity. Can go negative temporarily due to race conditions,
-/// but stabilizes over time.
+/// Updated by the owning worker with relaxed atomics and swapped back to
+/// zero by the primary core's statistics loop, like the latency counters.
+struct HartStats {
+    /// Machine timer ticks spent decoding since the last report.
+    busy: AtomicU64,
+
+    /// Packets decoded since the last report.
+    decoded: AtomicU64,
+
+    /// Packets taken from other harts' queues since the last report.
+    stolen: AtomicU64,
+}
+
+impl HartStats {
+    /// Creates zeroed statistics.
+    const fn new() -> Self {
+        Self {
+            busy: AtomicU64::new(0),
+            decoded: AtomicU64::new(0),
+            stolen: AtomicU64::new(0),
+        }
+    }
+}
+
+/// Scheduler statistics of each hart, indexed by hart ID.
+static HART_STATS: [HartStats; MAX_HARTS] = [const { HartStats::new() }; MAX_HARTS];
+
+/// Atomic counter tracking the current depth of the job queues.
+///
+/// Maintained by incrementing on push and decrementing on pop, summed over
+/// all local queues. Used for monitoring queue utilization and detecting
+/// backpressure when the queue approaches capacity. Can go negative
+/// temporarily due to race conditions, but stabilizes over time.
 pub static QUEUE_DEPTH: AtomicI64 = AtomicI64::new(0);
 
 /// Flag indicating that system initialization is complete.
@@ -168,26 +234,24 @@ static SYSTEM_READY: AtomicBool = AtomicBool::new(false);
 /// primary core's statistics loop.
 static TOTAL_PROCESSED: AtomicU64 = AtomicU64::new(0);
 
-/// Sum of all decoding latencies (for average calculation).
-///
-/// Accumulates the latency (in machine timer ticks) for each decoded packet.
-/// Reset periodically by the primary core when computing statistics, then
-/// divided by the number of processed packets to compute average latency.
-static LATENCY_SUM: AtomicU64 = AtomicU64::new(0);
+/// Nanoseconds per machine timer tick (QEMU's 10 MHz mtime).
+const NS_PER_TICK: u64 = 100;
 
-/// Maximum decoding latency observed.
+/// Latency deadline of one shot in nanoseconds (0 for none).
 ///
-/// Tracks the worst-case latency across all decoded packets. Reset periodically
-/// by the primary core when computing statistics. Used to identify performance
-/// outliers and worst-case timing behavior.
-static LATENCY_MAX: AtomicU64 = AtomicU64::new(0);
+/// A shot whose latency from packet creation to decode completion exceeds
+/// this budget counts as a deadline miss. Set at build time through
+/// `QCU_DEADLINE_NS` (default 100000, see `build.rs`) to the coherence-time
+/// budget of the experiment being modelled.
+const DEADLINE_NS: u64 = include!(concat!(env!("OUT_DIR"), "/deadline_ns.rs"));
 
-/// Minimum decoding latency observed.
+/// Latency of each decoded packet, from creation to decode completion.
 ///
-/// Tracks the best-case latency across all decoded packets. Reset periodically
-/// by the primary core when computing statistics. Initialized to u64::MAX
-/// so the first measurement becomes the minimum.
-static LATENCY_MIN: AtomicU64 = AtomicU64::new(u64::MAX);
+/// Recorded in nanoseconds by the worker cores into a lock-free histogram
+/// and drained periodically by the primary core, which prints the interval's
+/// percentiles and deadline misses in the shared `qcu_core::latency` export
+/// format.
+static SHOT_LATENCY: LatencyHistogram = LatencyHistogram::new();
 
 /// Thread-safe wrapper for global mutable state.
 ///
@@ -252,8 +316,9 @@ impl<T> GlobalCell<T> {
 /// Global storage for the bump allocator used for graph allocation.
 ///
 /// Initialized by the primary core during boot to manage memory for the
-/// decoding graph structure. The allocator manages a fixed region of memory
-/// and is never deallocated during firmware execution.
+/// decoding graph structure and the worker cores' decoders. The allocator
+/// manages a fixed region of memory and is never deallocated during firmware
+/// execution.
 static GRAPH_ALLOC: GlobalCell<Option<BumpAllocator>> = GlobalCell::new(None);
 
 /// Global reference to the loaded decoding graph.
@@ -296,10 +361,13 @@ pub extern "C" fn kmain() -> ! {
 /// Primary core main function (hart 0).
 ///
 /// Initializes the system by loading the decoding graph, then enters a loop
-/// that generates syndrome packets from benchmark data and pushes them into
-/// the job queue. Periodically prints statistics about throughput and latency.
-/// This function never returns, running indefinitely to sustain continuous
-/// decoding workload.
+/// that generates syndrome packets from benchmark data and dispatches them
+/// to the workers' local queues. Periodically prints statistics about
+/// throughput and latency (in timer ticks), the interval's latency export
+/// line with percentiles and deadline misses, and each worker's utilization
+/// (share of the interval spent decoding), decode count, steals and queue
+/// depth. This function never returns, running indefinitely to sustain
+/// continuous decoding workload.
 fn primary_main() -> ! {
     console::init();
     console::println!("[BOOT] Core 0 Online");
@@ -308,12 +376,13 @@ fn primary_main() -> ! {
         *GRAPH_ALLOC.get_mut() = Some(BumpAllocator::new(0x8400_0000, 0x400000));
         let alloc_ref = GRAPH_ALLOC.get().as_ref().unwrap();
 
-        let (graph, _) = parse_graph_dem(alloc_ref);
+        let graph = load_graph(alloc_ref);
         let leaked_graph = alloc::boxed::Box::leak(alloc::boxed::Box::new_in(graph, alloc_ref));
 
         *GRAPH_REF.get_mut() = Some(leaked_graph);
     }
 
+    SHOT_LATENCY.set_deadline(DEADLINE_NS);
     SYSTEM_READY.store(true, Ordering::Release);
 
     // Memory-mapped address of the machine timer register.
@@ -362,7 +431,7 @@ fn primary_main() -> ! {
             syndromes,
         };
 
-        if JOB_QUEUE.push(packet).is_ok() {
+        if dispatch(packet).is_ok() {
             QUEUE_DEPTH.fetch_add(1, Ordering::Relaxed);
             data_idx = (data_idx + 1) % bench_data::TOTAL_SHOTS;
         }
@@ -370,22 +439,39 @@ fn primary_main() -> ! {
         if now.wrapping_sub(last_print_time) >= 10_000_000 {
             let total = TOTAL_PROCESSED.load(Ordering::Relaxed);
             let depth = QUEUE_DEPTH.load(Ordering::Relaxed);
-            let sum = LATENCY_SUM.swap(0, Ordering::Relaxed);
-            let max = LATENCY_MAX.swap(0, Ordering::Relaxed);
-            let min = LATENCY_MIN.swap(u64::MAX, Ordering::Relaxed);
+            let latency = SHOT_LATENCY.drain();
 
             let delta = total.wrapping_sub(last_processed);
-            let avg = if delta > 0 { sum / delta } else { 0 };
 
             console::println!(
                 "T={:3}s | Rate: {:6}/s | Lat: {:4}/{:4}/{:4} | Q: {:4}",
                 now / 10_000_000,
                 delta,
-                min,
-                avg,
-                max,
+                latency.min / NS_PER_TICK,
+                latency.mean / NS_PER_TICK,
+                latency.max / NS_PER_TICK,
                 depth
             );
+            console::println!("{}", latency.line("fw.e2e", "ns"));
+
+            let elapsed = now.wrapping_sub(last_print_time).max(1);
+            let mut online = ONLINE_WORKERS.load(Ordering::Relaxed);
+            while online != 0 {
+                let hart = online.trailing_zeros() as usize;
+                online &= online - 1;
+                let stats = &HART_STATS[hart];
+                let busy = stats.busy.swap(0, Ordering::Relaxed);
+                let decoded = stats.decoded.swap(0, Ordering::Relaxed);
+                let stolen = stats.stolen.swap(0, Ordering::Relaxed);
+                console::println!(
+                    "      | Hart {}: {:3}% busy | {:6} decoded | {:5} stolen | Q: {:4}",
+                    hart,
+                    busy * 100 / elapsed,
+                    decoded,
+                    stolen,
+                    LOCAL_QUEUES[hart].len()
+                );
+            }
 
             last_print_time = now;
             last_processed = total;
@@ -393,26 +479,115 @@ fn primary_main() -> ! {
     }
 }
 
+/// Pushes a packet into the local queue of the least loaded online worker.
+///
+/// Picking the shortest queue keeps the backlog even across workers, so
+/// stealing only has to correct for packets that take unusually long.
+///
+/// # Arguments
+///
+/// * `packet` - Packet to enqueue
+///
+/// # Returns
+///
+/// Ok(()) if the packet was enqueued, Err(packet) if no worker is online
+/// or the chosen queue is full.
+fn dispatch(packet: SyndromePacket) -> Result<(), SyndromePacket> {
+    let mut online = ONLINE_WORKERS.load(Ordering::Acquire);
+    let mut target = None;
+    let mut shortest = usize::MAX;
+    while online != 0 {
+        let hart = online.trailing_zeros() as usize;
+        online &= online - 1;
+        let len = LOCAL_QUEUES[hart].len();
+        if len < shortest {
+            shortest = len;
+            target = Some(hart);
+        }
+    }
+    match target {
+        Some(hart) => LOCAL_QUEUES[hart].push(packet),
+        None => Err(packet),
+    }
+}
+
+/// Steals packets from the most loaded other worker.
+///
+/// Takes half of the victim's backlog, at most `out.len()` packets, so a
+/// thief relieves a hart stuck on a long decode without draining its whole
+/// queue and turning it into the next thief.
+///
+/// # Arguments
+///
+/// * `hartid` - Hart ID of the thief
+/// * `out` - Receives the stolen packets in its leading slots
+///
+/// # Returns
+///
+/// The number of packets stolen, 0 if every other queue is empty.
+fn steal(hartid: usize, out: &mut [SyndromePacket]) -> usize {
+    let mut online = ONLINE_WORKERS.load(Ordering::Acquire) & !(1 << hartid);
+    let mut victim = None;
+    let mut longest = 0;
+    while online != 0 {
+        let hart = online.trailing_zeros() as usize;
+        online &= online - 1;
+        let len = LOCAL_QUEUES[hart].len();
+        if len > longest {
+            longest = len;
+            victim = Some(hart);
+        }
+    }
+    match victim {
+        Some(hart) => {
+            let count = longest.div_ceil(2).min(out.len());
+            LOCAL_QUEUES[hart].pop_batch(&mut out[..count])
+        }
+        None => 0,
+    }
+}
+
 /// Worker core main function (hart 1+).
 ///
 /// Waits for system initialization to complete, then enters a loop that pops
-/// syndrome packets from the job queue, unpacks the syndrome bits, runs the
-/// decoder, and records latency statistics. Each worker core operates independently,
-/// processing jobs in parallel to maximize throughput. This function never returns.
+/// batches of syndrome packets from the hart's local queue, or steals them
+/// from another worker when the local queue is empty, unpacks the syndrome
+/// bits, runs the decoder, and records latency and utilization statistics.
+/// Each worker core operates independently, processing jobs in parallel to
+/// maximize throughput. This function never returns.
 ///
 /// # Arguments
 ///
 /// * `hartid` - Hardware thread ID for this worker core
 fn worker_main(hartid: usize) -> ! {
+    if hartid >= MAX_HARTS {
+        loop {
+            unsafe { core::arch::asm!("wfi") };
+        }
+    }
+
     while !SYSTEM_READY.load(Ordering::Acquire) {
         core::hint::spin_loop();
     }
 
     let graph = unsafe { GRAPH_REF.get().as_ref().unwrap() };
 
-    let mut decoder = UnionFindDecoder::<MAX_NODES>::new();
+    // The decoder needs about 14 bytes per node, far more than the 64KB
+    // stack of a hart, so it lives in the bump region next to the graph.
+    let alloc = unsafe { GRAPH_ALLOC.get().as_ref().unwrap() };
+    let mut decoder = UnionFindDecoder::<MAX_NODES>::new_in(alloc)
+        .expect("Bump region too small for the worker decoder");
     let mut syndrome_indices: StaticVec<usize, 1024> = StaticVec::new();
     let mut corrections: StaticVec<(usize, usize), 1024> = StaticVec::new();
+    let mut batch = [SyndromePacket {
+        shot_id: 0,
+        timestamp: 0,
+        syndromes: [0; WORDS_PER_SHOT],
+    }; POP_BATCH];
+
+    let queue = &LOCAL_QUEUES[hartid];
+    let stats = &HART_STATS[hartid];
+    ONLINE_WORKERS.fetch_or(1 << hartid, Ordering::Release);
 
     console::println!("[WORKER] Core {} Ready", hartid);
 
@@ -424,9 +599,19 @@ fn worker_main(hartid: usize) -> ! {
     const MTIME_ADDR: usize = qcu_common::mmio::MTIME_ADDR;
 
     loop {
-        if let Some(packet) = JOB_QUEUE.pop() {
-            QUEUE_DEPTH.fetch_sub(1, Ordering::Relaxed);
+        let mut count = queue.pop_batch(&mut batch);
+        if count == 0 {
+            count = steal(hartid, &mut batch);
+            if count == 0 {
+                core::hint::spin_loop();
+                continue;
+            }
+            stats.stolen.fetch_add(count as u64, Ordering::Relaxed);
+        }
+        QUEUE_DEPTH.fetch_sub(count as i64, Ordering::Relaxed);
 
+        let start = unsafe { (MTIME_ADDR as *const u64).read_volatile() };
+        for packet in &batch[..count] {
             syndrome_indices.clear();
             for (i, &word) in packet.syndromes.iter().enumerate() {
                 let mut w = word;
@@ -450,23 +635,23 @@ fn worker_main(hartid: usize) -> ! {
                     let latency = now.wrapping_sub(packet.timestamp);
 
                     TOTAL_PROCESSED.fetch_add(1, Ordering::Relaxed);
-                    LATENCY_SUM.fetch_add(latency, Ordering::Relaxed);
-                    LATENCY_MAX.fetch_max(latency, Ordering::Relaxed);
-                    LATENCY_MIN.fetch_min(latency, Ordering::Relaxed);
+                    SHOT_LATENCY.record(latency * NS_PER_TICK);
+                    stats.decoded.fetch_add(1, Ordering::Relaxed);
                 }
             }
-        } else {
-            core::hint::spin_loop();
         }
+        let end = unsafe { (MTIME_ADDR as *const u64).read_volatile() };
+        stats
+            .busy
+            .fetch_add(end.wrapping_sub(start), Ordering::Relaxed);
     }
 }
 
-/// Parses a decoding graph from DEM (Detector Error Model) format.
+/// Loads the decoding graph from the embedded graph image.
 ///
-/// Reads the embedded DEM data string and constructs a DecodingGraph by
-/// parsing "error" lines that specify edges between detector nodes. The
-/// format is: "error(probability) D<u> D<v>" where u and v are detector
-/// node indices. Returns the graph and the maximum node ID encountered.
+/// Validates the image (magic, version, section sizes and checksum) and
+/// copies its edge list and CSR adjacency into exactly sized storage from
+/// the bump allocator. A malformed image is unrecoverable and panics.
 ///
 /// # Arguments
 ///
@@ -474,37 +659,21 @@ fn worker_main(hartid: usize) -> ! {
 ///
 /// # Returns
 ///
-/// A tuple containing the constructed graph and the number of nodes (max_id + 1).
-fn parse_graph_dem(alloc: &BumpAllocator) -> (DecodingGraph<&BumpAllocator>, usize) {
-    let mut graph = DecodingGraph::new_in(120_000, alloc);
-    let mut max_node_id = 0;
-
-    for line in DEM_DATA.split('\n') {
-        let trimmed: &str = line.trim();
-        if trimmed.starts_with("error") {
-            let mut parts = trimmed.split_whitespace();
-            parts.next();
-            let mut u = usize::MAX;
-            let mut v = usize::MAX;
-
-            for part in parts {
-                if let Some(Ok(idx)) = part.strip_prefix('D').map(core::str::FromStr::from_str) {
-                    if idx > max_node_id {
-                        max_node_id = idx;
-                    }
-                    if u == usize::MAX {
-                        u = idx;
-                    } else if v == usize::MAX {
-                        v = idx;
-                    }
-                }
-            }
-            if u != usize::MAX && v != usize::MAX {
-                let _ = graph.add_edge(u, v, 1.0);
-            }
+/// The loaded graph.
+fn load_graph(alloc: &BumpAllocator) -> DecodingGraph<&BumpAllocator> {
+    let graph = GraphImage::from_bytes(&GRAPH_IMAGE.0)
+        .and_then(|image| DecodingGraph::from_image_in(&image, alloc));
+    match graph {
+        Ok(graph) => {
+            console::println!(
+                "[BOOT] Graph: {} nodes, {} edges",
+                graph.num_nodes(),
+                graph.fast_edges.len()
+            );
+            graph
         }
+        Err(e) => panic!("embedded graph image: {:?}", e),
     }
-    (graph, max_node_id + 1)
 }
 
 /// Panic handler for firmware error conditions.
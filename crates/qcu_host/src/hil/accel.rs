@@ -0,0 +1,185 @@
+//! Find-latency benchmark for the union-find accelerator in the simulated SoC.
+//!
+//! Builds a parent forest with the software `UnionFind` (random unions with
+//! union by rank and path halving, as the decoder produces them), bulk-loads
+//! it into the accelerator's parent BRAM with one burst write, and issues
+//! the same random finds to the hardware and to the software reference.
+//! The hardware cost is the cycle count measured by the engine itself, so
+//! it reflects the BRAM read latency the simulation was built with rather
+//! than host round trips.
+//!
+//! The same queries are then streamed through the multi-query engine twice,
+//! reporting the achieved finds per cycle; the second pass runs on the
+//! forest the first pass compressed. Afterwards the parent array is read
+//! back to check that compression left every root unchanged.
+
+use super::{
+    ADDR_UF_DEPTH, ADDR_UF_MEM_LATENCY, ADDR_UF_MQ_WALKERS, ADDR_UF_PARENT, HardwareBridge,
+};
+use anyhow::{Result, bail};
+use qcu_core::dsu::UnionFind;
+use std::time::Instant;
+
+/// Runs the accelerator find-latency benchmark against a simulation server.
+///
+/// Every hardware root is checked against a plain walk of the loaded
+/// forest; any mismatch fails the run after the report is printed.
+///
+/// # Arguments
+///
+/// * `addr` - Simulation server address (see `HardwareBridge::connect`)
+/// * `nodes` - Nodes in the forest (defaults to the BRAM depth)
+/// * `unions` - Random unions applied to build the forest
+/// * `finds` - Random find queries issued to hardware and software
+///
+/// # Returns
+///
+/// Ok(()) if every hardware root matched, or an error if the forest does
+/// not fit the BRAM, a find hangs, a root mismatches or I/O fails.
+pub fn run_accel_bench(
+    addr: &str,
+    nodes: Option<usize>,
+    unions: usize,
+    finds: usize,
+) -> Result<()> {
+    let mut hw = HardwareBridge::connect(addr)?;
+    let depth = hw.read(ADDR_UF_DEPTH)? as usize;
+    let mem_latency = hw.read(ADDR_UF_MEM_LATENCY)?;
+    let nodes = nodes.unwrap_or(depth);
+    if nodes == 0 || nodes > depth {
+        bail!(
+            "Forest of {} nodes does not fit the {}-entry parent BRAM",
+            nodes,
+            depth
+        );
+    }
+
+    let mut state: u64 = 0x9E37_79B9_7F4A_7C15;
+    let mut rng = move |bound: usize| {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        (state.wrapping_mul(0x2545F4914F6CDD1D) % bound as u64) as usize
+    };
+
+    let mut parent = vec![0usize; nodes];
+    let mut rank = vec![0u8; nodes];
+    let mut parity = vec![0u64; nodes.div_ceil(64)];
+    let mut uf = UnionFind::new(&mut parent, &mut rank, &mut parity);
+    for _ in 0..unions {
+        uf.union(rng(nodes), rng(nodes));
+    }
+    let forest: Vec<u32> = uf.parent.iter().map(|&p| p as u32).collect();
+
+    println!(
+        "Loading {} parent entries ({} unions) into the accelerator ({}-cycle BRAM)...",
+        nodes, unions, mem_latency
+    );
+    hw.write_burst(ADDR_UF_PARENT, &forest)?;
+
+    let queries: Vec<u32> = (0..finds).map(|_| rng(nodes) as u32).collect();
+    let budget = (nodes as u32 + 1) * (mem_latency + 2) + 16;
+
+    let mut mismatches = 0usize;
+    let mut cycles_sum = 0u64;
+    let mut cycles_min = u32::MAX;
+    let mut cycles_max = 0u32;
+    let mut hops_sum = 0u64;
+    let start = Instant::now();
+    for &node in &queries {
+        let result = hw.accel_find(node, budget)?;
+        let mut root = node;
+        while forest[root as usize] != root {
+            root = forest[root as usize];
+        }
+        if result.root != root {
+            mismatches += 1;
+        }
+        cycles_sum += result.cycles as u64;
+        cycles_min = cycles_min.min(result.cycles);
+        cycles_max = cycles_max.max(result.cycles);
+        hops_sum += result.hops as u64;
+    }
+    let hw_wall = start.elapsed();
+
+    // UnionFind::new resets the forest, so the loaded one is copied in after.
+    let mut sw_parent = vec![0usize; nodes];
+    let mut sw_rank = vec![0u8; nodes];
+    let mut sw_parity = vec![0u64; nodes.div_ceil(64)];
+    let mut sw = UnionFind::new(&mut sw_parent, &mut sw_rank, &mut sw_parity);
+    sw.parent
+        .iter_mut()
+        .zip(&forest)
+        .for_each(|(p, &f)| *p = f as usize);
+    let start = Instant::now();
+    let mut checksum = 0usize;
+    for &node in &queries {
+        checksum = checksum.wrapping_add(sw.find(node as usize));
+    }
+    let sw_wall = start.elapsed();
+    std::hint::black_box(checksum);
+
+    let n = finds.max(1) as f64;
+    println!("Finds:            {}", finds);
+    println!(
+        "Hardware cycles:  mean {:.2}, min {}, max {}",
+        cycles_sum as f64 / n,
+        if finds == 0 { 0 } else { cycles_min },
+        cycles_max
+    );
+    println!("Hardware hops:    mean {:.2}", hops_sum as f64 / n);
+    println!(
+        "Host round trip:  {:.2} us/find",
+        hw_wall.as_secs_f64() * 1e6 / n
+    );
+    println!(
+        "Software find:    {:.1} ns/find (path halving)",
+        sw_wall.as_secs_f64() * 1e9 / n
+    );
+
+    let walkers = hw.read(ADDR_UF_MQ_WALKERS)?;
+    hw.accel_take_counters()?;
+    for pass in 1..=2 {
+        let roots = hw.accel_find_batch(&queries, budget.saturating_mul(256))?;
+        let counters = hw.accel_take_counters()?;
+        for (&node, &hw_root) in queries.iter().zip(&roots) {
+            let mut root = node;
+            while forest[root as usize] != root {
+                root = forest[root as usize];
+            }
+            if hw_root != root {
+                mismatches += 1;
+            }
+        }
+        let cycles = counters.cycles.max(1) as f64;
+        let done = counters.finds.max(1) as f64;
+        println!(
+            "Multi-query #{}:    {:.3} finds/cycle ({} walkers), {:.2} reads/find, {} compression writes",
+            pass,
+            counters.finds as f64 / cycles,
+            walkers,
+            counters.reads as f64 / done,
+            counters.writes
+        );
+    }
+
+    let compressed = hw.read_burst(ADDR_UF_PARENT, nodes as u32)?;
+    let find_root = |tree: &[u32], mut i: u32| {
+        while tree[i as usize] != i {
+            i = tree[i as usize];
+        }
+        i
+    };
+    let moved = (0..nodes as u32)
+        .filter(|&i| find_root(&compressed, i) != find_root(&forest, i))
+        .count();
+    if moved > 0 {
+        bail!("Path compression moved {} nodes to a different root", moved);
+    }
+
+    if mismatches > 0 {
+        bail!("{} hardware roots did not match", mismatches);
+    }
+    println!("All hardware roots matched the software forest.");
+    Ok(())
+}
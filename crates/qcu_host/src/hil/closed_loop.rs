@@ -0,0 +1,456 @@
+//! Closed-loop HIL pipeline through the software Union-Find decoder.
+//!
+//! Unlike the HIL demo, where the simulator pulses the raw syndrome mask
+//! itself, every syndrome read from the simulated SoC here is decoded on
+//! the host by the streaming decoder worker (`stream::spawn_decoder`) and
+//! only the decoder's corrections are written back as pulses. The control
+//! loop runs in fixed syndrome rounds of `round_cycles` cycles, each one a
+//! single batched frame: the pulses of every decode finished since the last
+//! round, the round's cycles and the readout of the error bank. Decoding a
+//! round's syndrome therefore overlaps the simulation of the next round and
+//! its pulses go out with the round after that; a decode still running
+//! when the following round has been simulated means the decoder fell
+//! behind the simulated QPU.
+//!
+//! The simulator flags decayed qubits directly, so the decoding graph gives
+//! each qubit a single error edge to a boundary node of its own and a
+//! correction edge flips the qubit at its end. Qubits whose correction is
+//! in flight are masked out of later syndromes so they are not pulsed
+//! twice.
+
+use super::{
+    ADDR_ENABLE, ADDR_ERRORS, ADDR_PULSE_GO, ADDR_PULSE_STAGE, ADDR_RABI, HardwareBridge,
+    MAX_GRID_DIM, Transaction,
+};
+use crate::stats::LatencyStats;
+use crate::stream::{TaskPacket, spawn_decoder};
+use anyhow::{Result, bail};
+use qcu_core::graph::DecodingGraph;
+use qcu_core::ring_buffer::RingBuffer;
+use std::collections::VecDeque;
+use std::sync::Arc;
+use std::sync::atomic::{AtomicBool, Ordering};
+use std::time::Instant;
+
+/// Pulse words for the largest grid the simulator can be built with.
+const MASK_WORDS: usize = (MAX_GRID_DIM * MAX_GRID_DIM) as usize / 32;
+
+/// Capacity of the syndrome and correction ring buffers.
+const QUEUE_DEPTH: usize = 1024;
+
+/// Correction pulse duration in cycles (a full π rotation at the demo's
+/// Rabi frequency).
+pub(super) const PULSE_CYCLES: u32 = 110;
+
+/// Rabi frequency written before the physics engine is enabled (as in the
+/// HIL demo).
+pub(super) const LOOP_RABI: u32 = 468;
+
+/// Corrections of one decoded syndrome, returned by the decoder worker.
+#[derive(Clone, Copy, Default)]
+pub(super) struct CorrectionPacket {
+    /// Sequence number of the decoded syndrome (see `RoundPipeline::sent`).
+    pub(super) seq: u64,
+
+    /// Qubits to pulse, in the layout of the error bank.
+    pub(super) mask: [u32; MASK_WORDS],
+
+    /// Decode time in nanoseconds.
+    pub(super) decode_ns: u64,
+}
+
+impl CorrectionPacket {
+    /// Converts the decoder's correction edges into a pulse mask.
+    ///
+    /// # Arguments
+    ///
+    /// * `seq` - Sequence number of the decoded syndrome
+    /// * `corrections` - Correction edges from `solve_into`
+    /// * `qubits` - Number of qubits; nodes from `qubits` up are boundary
+    ///   nodes
+    /// * `decode_ns` - Decode time in nanoseconds
+    pub(super) fn new(
+        seq: u64,
+        corrections: &[(usize, usize)],
+        qubits: usize,
+        decode_ns: u64,
+    ) -> Self {
+        let mut packet = Self {
+            seq,
+            decode_ns,
+            ..Default::default()
+        };
+        for &(u, v) in corrections {
+            for node in [u, v] {
+                if node < qubits {
+                    packet.mask[node / 32] ^= 1 << (node % 32);
+                }
+            }
+        }
+        packet
+    }
+}
+
+/// A syndrome handed to the decoder whose corrections are not applied yet.
+pub(super) struct InFlight {
+    /// Sequence number the syndrome was sent with.
+    seq: u64,
+
+    /// Round whose readout produced the syndrome.
+    pub(super) round: u64,
+
+    /// When the readout returned to the host.
+    pub(super) received: Instant,
+
+    /// Qubits included in the syndrome.
+    mask: Vec<u32>,
+}
+
+/// Round bookkeeping of one closed-loop session.
+///
+/// Tracks the syndromes awaiting their corrections and the pulses to issue
+/// with the next round. Syndromes are numbered in the order they are handed
+/// to the decoder, and corrections may come back in any order.
+pub(super) struct RoundPipeline {
+    /// Number of qubits in the grid.
+    qubits: usize,
+
+    /// Syndromes sent to the decoder and not corrected yet, oldest first.
+    pending: VecDeque<InFlight>,
+
+    /// Qubits of all pending syndromes.
+    inflight: Vec<u32>,
+
+    /// Corrections to pulse with the next round.
+    pulse: Vec<u32>,
+
+    /// Sequence number of the next syndrome sent.
+    next_seq: u64,
+}
+
+impl RoundPipeline {
+    /// Creates the bookkeeping for a grid of `qubits` qubits.
+    pub(super) fn new(qubits: usize) -> Self {
+        let words = qubits.div_ceil(32);
+        Self {
+            qubits,
+            pending: VecDeque::new(),
+            inflight: vec![0; words],
+            pulse: vec![0; words],
+            next_seq: 0,
+        }
+    }
+
+    /// Accepts the corrections of a pending syndrome.
+    ///
+    /// # Returns
+    ///
+    /// The syndrome's entry, or an error if it was not pending.
+    pub(super) fn complete(&mut self, done: &CorrectionPacket) -> Result<InFlight> {
+        let Some(entry) = self
+            .pending
+            .iter()
+            .position(|e| e.seq == done.seq)
+            .and_then(|i| self.pending.remove(i))
+        else {
+            bail!(
+                "Decoder returned corrections for unknown syndrome {}",
+                done.seq
+            );
+        };
+        for w in 0..self.pulse.len() {
+            self.pulse[w] |= done.mask[w];
+            self.inflight[w] &= !entry.mask[w];
+        }
+        Ok(entry)
+    }
+
+    /// Counts the pending syndromes read before the previous round.
+    ///
+    /// The previous round's syndrome is decoded while `round` is simulated;
+    /// anything older still pending means decoding is late.
+    pub(super) fn late(&self, round: u64) -> usize {
+        self.pending.iter().filter(|e| e.round + 1 < round).count()
+    }
+
+    /// Builds the frame of one round: the collected pulses, `round_cycles`
+    /// of simulation and the error bank readout.
+    ///
+    /// # Returns
+    ///
+    /// The number of qubits pulsed.
+    pub(super) fn frame(&mut self, txn: &mut Transaction, round_cycles: u32) -> u64 {
+        txn.clear();
+        let pulsed: u64 = self.pulse.iter().map(|w| w.count_ones() as u64).sum();
+        if pulsed != 0 {
+            txn.write_burst(ADDR_PULSE_STAGE, &self.pulse)
+                .write(ADDR_PULSE_GO, PULSE_CYCLES);
+            self.pulse.fill(0);
+        }
+        txn.step(round_cycles)
+            .read_burst(ADDR_ERRORS, self.pulse.len() as u32);
+        pulsed
+    }
+
+    /// Extracts the packet to decode from a round's readout.
+    ///
+    /// Qubits with a correction in flight are left out, as are qubits beyond
+    /// the packet's 64 entries; those stay flagged and are sent with a later
+    /// round.
+    ///
+    /// # Returns
+    ///
+    /// The packet and the mask of the qubits it contains.
+    pub(super) fn syndrome(&self, readout: &[u32]) -> (TaskPacket, Vec<u32>) {
+        let mut packet = TaskPacket::default();
+        let mut mask = vec![0u32; self.inflight.len()];
+        let mut count = 0;
+        for q in 0..self.qubits {
+            let bit = 1 << (q % 32);
+            if readout[q / 32] & !self.inflight[q / 32] & bit != 0 && count < 64 {
+                packet.syndrome_buffer[count] = q as u32;
+                mask[q / 32] |= bit;
+                count += 1;
+            }
+        }
+        packet.syndrome_len = count as u32;
+        (packet, mask)
+    }
+
+    /// Sequence number the next packet handed to the decoder gets.
+    pub(super) fn next_seq(&self) -> u64 {
+        self.next_seq
+    }
+
+    /// Records a packet as handed to the decoder, under `next_seq()`.
+    ///
+    /// # Arguments
+    ///
+    /// * `round` - Round whose readout produced the packet
+    /// * `received` - When the readout returned to the host
+    /// * `mask` - Qubits the packet contains
+    pub(super) fn sent(&mut self, round: u64, received: Instant, mask: Vec<u32>) {
+        for w in 0..self.inflight.len() {
+            self.inflight[w] |= mask[w];
+        }
+        self.pending.push_back(InFlight {
+            seq: self.next_seq,
+            round,
+            received,
+            mask,
+        });
+        self.next_seq += 1;
+    }
+}
+
+/// Builds the decoding graph of the simulated qubit grid.
+///
+/// Qubit q is node q, with one edge to its boundary node `qubits + q`.
+///
+/// # Arguments
+///
+/// * `qubits` - Number of qubits in the grid
+///
+/// # Returns
+///
+/// The graph, with its adjacency list built.
+pub(super) fn qubit_graph(qubits: usize) -> DecodingGraph {
+    let mut graph = DecodingGraph::new(2 * qubits);
+    for q in 0..qubits {
+        let _ = graph.add_edge(q, qubits + q, 1.0);
+    }
+    graph.build_adjacency();
+    graph
+}
+
+/// Runs the closed-loop pipeline against a simulation server.
+///
+/// Enables the physics engine, then runs `rounds` syndrome rounds and
+/// reports the decode time, the end-to-end latency from a syndrome reaching
+/// the host to its correction pulse being issued (in wall time and in
+/// rounds), and how often and how far the decoder fell behind. When the
+/// simulator is paced (`--pace`), decodes slower than a simulated round are
+/// counted as well. Ends with the export lines of the decode time
+/// (`host.decode`), the end-to-end latency (`host.e2e`) and the
+/// simulator's own latencies (CMD_LATENCY), so the three budgets can be
+/// compared directly.
+///
+/// # Arguments
+///
+/// * `addr` - Simulation server address (see `HardwareBridge::connect`)
+/// * `rounds` - Syndrome rounds to run
+/// * `round_cycles` - Cycles simulated per round
+/// * `deadline_ns` - End-to-end latency above which a round counts as a
+///   deadline miss (0 for none)
+///
+/// # Returns
+///
+/// Ok(()) on success, or an error if the round is shorter than a pulse or
+/// a request fails.
+pub fn run_closed_loop(addr: &str, rounds: u64, round_cycles: u32, deadline_ns: u64) -> Result<()> {
+    if round_cycles < PULSE_CYCLES {
+        bail!(
+            "A round of {} cycles is shorter than a correction pulse ({} cycles)",
+            round_cycles,
+            PULSE_CYCLES
+        );
+    }
+
+    let mut hw = HardwareBridge::connect(addr)?;
+    let dim = hw.grid_dim()? as usize;
+    let qubits = dim * dim;
+    let words = qubits.div_ceil(32);
+    let pace_hz = hw.sim_stats(false)?.pace_hz;
+    let round_ns = if pace_hz != 0 {
+        round_cycles as u64 * 1_000_000_000 / pace_hz
+    } else {
+        0
+    };
+
+    let graph = Arc::new(qubit_graph(qubits));
+    let tasks = Arc::new(RingBuffer::<TaskPacket>::new(QUEUE_DEPTH));
+    let decoded = Arc::new(RingBuffer::<CorrectionPacket>::new(QUEUE_DEPTH));
+    let running = Arc::new(AtomicBool::new(true));
+
+    let out = decoded.clone();
+    let r_worker = running.clone();
+    let mut seq = 0;
+    let worker = spawn_decoder(
+        graph.clone(),
+        tasks.clone(),
+        running.clone(),
+        0,
+        Box::new(move |corrections, decode_ns| {
+            // A single worker decodes the packets in the order they were sent.
+            let packet = CorrectionPacket::new(seq, corrections, qubits, decode_ns);
+            seq += 1;
+            while !out.push(packet) && r_worker.load(Ordering::Relaxed) {
+                std::hint::spin_loop();
+            }
+        }),
+    );
+
+    let mut setup = Transaction::new();
+    setup.write(ADDR_ENABLE, 1).write(ADDR_RABI, LOOP_RABI);
+    hw.execute(&setup)?;
+
+    println!(
+        "Closed loop: {} rounds of {} cycles on a {}x{} grid, decoding {} nodes",
+        rounds,
+        round_cycles,
+        dim,
+        dim,
+        graph.num_nodes()
+    );
+
+    let mut txn = Transaction::new();
+    let mut pipeline = RoundPipeline::new(qubits);
+    let mut readout = vec![0u32; words];
+    let mut e2e = LatencyStats::with_deadline(deadline_ns);
+    let mut lag_rounds = [0u64; 4];
+    let mut over_budget = 0u64;
+    let mut behind = 0u64;
+    let mut backlog_max = 0usize;
+    let mut dropped = 0u64;
+    let mut flagged = 0u64;
+    let mut pulsed = 0u64;
+    let start = Instant::now();
+
+    for round in 0..rounds {
+        let mut finished = Vec::new();
+        while let Some(done) = decoded.pop() {
+            if round_ns != 0 && done.decode_ns > round_ns {
+                over_budget += 1;
+            }
+            finished.push(pipeline.complete(&done)?);
+        }
+        let late = pipeline.late(round);
+        if late != 0 {
+            behind += 1;
+            backlog_max = backlog_max.max(late);
+        }
+
+        pulsed += pipeline.frame(&mut txn, round_cycles);
+        let issued = Instant::now();
+        for entry in finished {
+            e2e.update((issued - entry.received).as_nanos() as u64);
+            let lag = (round - entry.round - 1) as usize;
+            lag_rounds[lag.min(lag_rounds.len() - 1)] += 1;
+        }
+
+        readout.copy_from_slice(&hw.execute(&txn)?);
+        let received = Instant::now();
+
+        // A full queue leaves the qubits flagged; they are sent again with
+        // the next round's syndrome.
+        let (packet, mask) = pipeline.syndrome(&readout);
+        if tasks.push(packet) {
+            flagged += packet.syndrome_len as u64;
+            pipeline.sent(round, received, mask);
+        } else {
+            dropped += 1;
+        }
+    }
+
+    let wall = start.elapsed();
+    running.store(false, Ordering::Relaxed);
+    let decode = worker.join().unwrap();
+    hw.write(ADDR_ENABLE, 0)?;
+    let sim_latency = hw.latency_report(false)?;
+    let decode_lat = decode.summary();
+    let e2e_lat = e2e.summary();
+
+    let remaining: u32 = readout.iter().map(|w| w.count_ones()).sum();
+    println!(
+        "   {} flagged qubits decoded, {} pulses issued, {} still flagged at the end",
+        flagged, pulsed, remaining
+    );
+    println!(
+        "   Decode: {} syndromes, mean {:.2} us, min {:.2} us, p99 {:.2} us, max {:.2} us",
+        decode_lat.count,
+        decode_lat.mean as f64 / 1e3,
+        decode_lat.min as f64 / 1e3,
+        decode_lat.p99 as f64 / 1e3,
+        decode_lat.max as f64 / 1e3
+    );
+    println!(
+        "   Syndrome -> pulse: {} rounds, p50 {:.2} us, p99 {:.2} us, p99.9 {:.2} us, max {:.2} us",
+        e2e_lat.count,
+        e2e_lat.p50 as f64 / 1e3,
+        e2e_lat.p99 as f64 / 1e3,
+        e2e_lat.p999 as f64 / 1e3,
+        e2e_lat.max as f64 / 1e3
+    );
+    if deadline_ns != 0 {
+        println!(
+            "   Deadline {:.1} us: {} of {} rounds missed",
+            deadline_ns as f64 / 1e3,
+            e2e_lat.misses,
+            e2e_lat.count
+        );
+    }
+    println!(
+        "   Rounds simulated before the pulse: 0: {}, 1 (overlapped): {}, 2: {}, 3 or more: {}",
+        lag_rounds[0], lag_rounds[1], lag_rounds[2], lag_rounds[3]
+    );
+    println!(
+        "   Decoder behind in {} of {} rounds (backlog max {}), {} syndromes dropped",
+        behind, rounds, backlog_max, dropped
+    );
+    if round_ns != 0 {
+        println!(
+            "   Real-time budget {:.1} us per round: {} decodes over budget",
+            round_ns as f64 / 1e3,
+            over_budget
+        );
+    }
+    println!(
+        "   {:.1} us per round, {:.3} Mcycles/s simulated",
+        wall.as_nanos() as f64 / 1e3 / rounds.max(1) as f64,
+        (rounds * round_cycles as u64) as f64 / wall.as_secs_f64() / 1e6
+    );
+    println!("{}", decode_lat.line("host.decode", "ns"));
+    println!("{}", e2e_lat.line("host.e2e", "ns"));
+    print!("{}", sim_latency);
+    Ok(())
+}
@@ -0,0 +1,159 @@
+//! Full-decode benchmark for the union-find decode block in the simulated SoC.
+//!
+//! Loads a decoding graph into the block once, then decodes recorded shots
+//! in hardware: for every shot the fired detectors are written, the decode
+//! is started, and the simulation runs until the block reports completion.
+//! The correction list of each shot is compared entry by entry with the one
+//! `UnionFindDecoder::solve_into` produces for the same graph and syndrome
+//! (`WeightedDecoder::solve_into` in weighted mode), and the block's cycle
+//! count is reported next to the software decode time.
+
+use super::HardwareBridge;
+use anyhow::{Result, bail};
+use qcu_core::decoder::{UnionFindDecoder, WeightedDecoder};
+use qcu_io::loader::ShotFile;
+use qcu_io::parser;
+use std::time::{Duration, Instant};
+
+/// Maximum number of nodes supported by the reference decoder.
+///
+/// Matches the throughput benchmark and the block's default capacity.
+const MAX_NODES: usize = 4096;
+
+/// Runs the full-decode benchmark against a simulation server.
+///
+/// # Arguments
+///
+/// * `addr` - Simulation server address (see `HardwareBridge::connect`)
+/// * `dem_path` - Path to the decoding graph (.dem file)
+/// * `b8_path` - Path to the syndrome data (.b8 file)
+/// * `shots` - Optional limit on the number of shots decoded
+/// * `max_cycles` - Cycle budget for a single hardware decode
+/// * `weighted` - Decode with weighted growth in hardware and software
+///
+/// # Returns
+///
+/// Ok(()) if every hardware correction list matched the software decoder,
+/// or an error if the graph does not fit the block, a decode hangs, a
+/// correction list mismatches or I/O fails.
+pub fn run_decode_bench(
+    addr: &str,
+    dem_path: &str,
+    b8_path: &str,
+    shots: Option<usize>,
+    max_cycles: u32,
+    weighted: bool,
+) -> Result<()> {
+    let graph = parser::load_graph_file(dem_path)?;
+    let num_nodes = graph.num_nodes();
+    let detections = ShotFile::open(b8_path, num_nodes)?;
+    let num_shots = shots.map_or(detections.len(), |limit| limit.min(detections.len()));
+
+    let mut hw = HardwareBridge::connect(addr)?;
+    let capacity = hw.decoder_capacity()?;
+    println!(
+        "Loading graph ({} nodes, {} edges) into the decode block ({} nodes, {} edges){}...",
+        num_nodes,
+        graph.fast_edges.len(),
+        capacity.nodes,
+        capacity.edges,
+        if weighted { ", weighted growth" } else { "" }
+    );
+    hw.decoder_load_graph(&graph, weighted)?;
+
+    let mut decoder = UnionFindDecoder::<MAX_NODES>::new();
+    let mut weighted_decoder = Box::new(WeightedDecoder::<MAX_NODES>::new());
+    let mut expected: Vec<(usize, usize)> = Vec::with_capacity(128);
+
+    let mut mismatches = 0usize;
+    let mut unmatched = 0usize;
+    let mut cycles_sum = 0u64;
+    let mut cycles_max = 0u32;
+    let mut passes_sum = 0u64;
+    let mut finds_sum = 0u64;
+    let mut corrections_sum = 0u64;
+    let mut hw_wall = Duration::ZERO;
+    let mut sw_wall = Duration::ZERO;
+    let mut syndrome = Vec::with_capacity(128);
+    for shot in 0..num_shots {
+        detections.fired(shot, &mut syndrome);
+        if syndrome.len() > capacity.syndromes as usize {
+            bail!(
+                "Shot with {} detections exceeds the decode block's syndrome buffer ({})",
+                syndrome.len(),
+                capacity.syndromes
+            );
+        }
+        let indices: Vec<u32> = syndrome.iter().map(|&i| i as u32).collect();
+
+        let start = Instant::now();
+        let result = hw.decoder_run(&indices, max_cycles)?;
+        hw_wall += start.elapsed();
+
+        let start = Instant::now();
+        let solved = if weighted {
+            weighted_decoder.solve_into(&graph, &syndrome, &mut expected)
+        } else {
+            decoder.solve_into(&graph, &syndrome, &mut expected)
+        };
+        if let Err(e) = solved {
+            bail!("Software decode failed: {:?}", e);
+        }
+        sw_wall += start.elapsed();
+
+        let matches = result.corrections.len() == expected.len()
+            && result
+                .corrections
+                .iter()
+                .zip(&expected)
+                .all(|(&(u, v), &(eu, ev))| u as usize == eu && v as usize == ev);
+        if !matches {
+            mismatches += 1;
+        }
+        if !result.odd_roots.is_empty() {
+            unmatched += 1;
+        }
+        cycles_sum += result.cycles as u64;
+        cycles_max = cycles_max.max(result.cycles);
+        passes_sum += result.passes as u64;
+        finds_sum += result.finds as u64;
+        corrections_sum += result.corrections.len() as u64;
+    }
+
+    let n = num_shots.max(1) as f64;
+    println!("Shots:            {}", num_shots);
+    println!(
+        "Hardware cycles:  mean {:.1}, max {} ({:.2} sweeps, {:.2} corrections per shot)",
+        cycles_sum as f64 / n,
+        cycles_max,
+        passes_sum as f64 / n,
+        corrections_sum as f64 / n
+    );
+    println!("Hardware finds:   mean {:.1}", finds_sum as f64 / n);
+    println!(
+        "Host round trip:  {:.2} us/shot",
+        hw_wall.as_secs_f64() * 1e6 / n
+    );
+    println!(
+        "Software decode:  {:.2} us/shot ({})",
+        sw_wall.as_secs_f64() * 1e6 / n,
+        if weighted {
+            "WeightedDecoder"
+        } else {
+            "UnionFindDecoder"
+        }
+    );
+    println!(
+        "Odd clusters:     {} shots left unmatched defects",
+        unmatched
+    );
+
+    if mismatches > 0 {
+        bail!(
+            "{} hardware correction lists did not match the software decoder",
+            mismatches
+        );
+    }
+    println!("All hardware corrections matched the software decoder.");
+    Ok(())
+}
@@ -0,0 +1,432 @@
+//! Multi-SoC fan-out soak test.
+//!
+//! Drives several independent simulator sessions from one host process the
+//! way a multi-QPU control rack loads the decoder: every session has its own
+//! `HardwareBridge` and driver thread running the closed-loop rounds of
+//! `closed_loop`, and the syndromes of all sessions are multiplexed into one
+//! shared lock-free `WorkQueue`. A pool of decoder workers, optionally
+//! pinned to one core each, pops whichever syndrome is next and returns the
+//! corrections to the session's own result queue, from which its driver
+//! pulses them with a later round. The simulation server gives every
+//! connection its own SoC, so the sessions simulate in parallel as well, and
+//! the aggregate shots (decoded syndromes) per second show how far the
+//! decoder pool scales across cores.
+
+use super::closed_loop::{CorrectionPacket, LOOP_RABI, PULSE_CYCLES, RoundPipeline, qubit_graph};
+use super::{ADDR_ENABLE, ADDR_RABI, HardwareBridge, Transaction};
+use crate::stats::LatencyStats;
+use crate::stream::TaskPacket;
+use crate::work_queue::WorkQueue;
+use anyhow::{Result, bail};
+use qcu_core::decoder::UnionFindDecoder;
+use qcu_core::graph::DecodingGraph;
+use std::sync::Arc;
+use std::sync::atomic::{AtomicBool, Ordering};
+use std::thread;
+use std::time::Instant;
+
+/// Maximum number of nodes supported by the decoder workers.
+///
+/// Matches the streaming decoder; a 32x32 grid needs 2048.
+const MAX_NODES: usize = 4096;
+
+/// Capacity of the shared syndrome queue.
+const JOB_DEPTH: usize = 4096;
+
+/// Capacity of each session's result queue.
+const RESULT_DEPTH: usize = 1024;
+
+/// One syndrome in the shared work queue.
+#[derive(Clone, Copy)]
+struct Job {
+    /// Session the syndrome was read from.
+    session: u32,
+
+    /// Sequence number within the session (see `RoundPipeline::sent`).
+    seq: u64,
+
+    /// Flagged qubits.
+    packet: TaskPacket,
+}
+
+/// What one session's driver thread measured.
+struct SessionReport {
+    /// Flagged qubits handed to the decoder pool.
+    flagged: u64,
+
+    /// Qubits pulsed.
+    pulsed: u64,
+
+    /// Rounds in which a syndrome from before the previous round was still
+    /// being decoded.
+    behind: u64,
+
+    /// Most such syndromes pending at once.
+    backlog_max: usize,
+
+    /// Syndromes that found the shared queue full and were sent again later.
+    dropped: u64,
+
+    /// Syndrome-to-pulse times in nanoseconds.
+    e2e: LatencyStats,
+}
+
+/// Pins the calling thread to one core.
+///
+/// # Returns
+///
+/// True if the affinity was set.
+fn pin_to_core(core: usize) -> bool {
+    unsafe {
+        let mut set: libc::cpu_set_t = std::mem::zeroed();
+        libc::CPU_SET(core, &mut set);
+        libc::sched_setaffinity(0, std::mem::size_of::<libc::cpu_set_t>(), &set) == 0
+    }
+}
+
+/// Decoder worker loop: decodes jobs from the shared queue until `running`
+/// is cleared.
+///
+/// # Arguments
+///
+/// * `graph` - Decoding graph of the qubit grid
+/// * `jobs` - Shared syndrome queue
+/// * `results` - Result queue of every session
+/// * `running` - Cleared to stop the worker
+///
+/// # Returns
+///
+/// The worker's decode latency statistics and how many of its syndromes
+/// flagged at least one qubit.
+fn run_worker(
+    graph: &DecodingGraph,
+    jobs: &WorkQueue<Job>,
+    results: &[WorkQueue<CorrectionPacket>],
+    running: &AtomicBool,
+) -> (LatencyStats, u64) {
+    let qubits = graph.num_nodes() / 2;
+    let mut decoder = UnionFindDecoder::<MAX_NODES>::new();
+    let mut lat_stats = LatencyStats::new();
+    let mut nonempty = 0u64;
+    let mut corrections = Vec::with_capacity(1024);
+    let mut indices = Vec::with_capacity(64);
+
+    while running.load(Ordering::Relaxed) {
+        let Some(job) = jobs.pop() else {
+            std::hint::spin_loop();
+            continue;
+        };
+        indices.clear();
+        for i in 0..job.packet.syndrome_len as usize {
+            indices.push(job.packet.syndrome_buffer[i] as usize);
+        }
+
+        let start = Instant::now();
+        let _ = decoder.solve_into(graph, &indices, &mut corrections);
+        let lat_ns = start.elapsed().as_nanos() as u64;
+
+        let mut packet = CorrectionPacket::new(job.seq, &corrections, qubits, lat_ns);
+        while let Err(full) = results[job.session as usize].push(packet) {
+            if !running.load(Ordering::Relaxed) {
+                break;
+            }
+            packet = full;
+            std::hint::spin_loop();
+        }
+        lat_stats.update(lat_ns);
+        nonempty += (job.packet.syndrome_len != 0) as u64;
+    }
+    (lat_stats, nonempty)
+}
+
+/// Session driver loop: runs the closed-loop rounds of one simulator
+/// session against the shared decoder pool.
+///
+/// # Arguments
+///
+/// * `hw` - The session's bridge
+/// * `session` - Session index (selects its result queue)
+/// * `qubits` - Number of qubits in the grid
+/// * `rounds` - Syndrome rounds to run
+/// * `round_cycles` - Cycles simulated per round
+/// * `jobs` - Shared syndrome queue
+/// * `results` - The session's result queue
+/// * `deadline_ns` - Syndrome-to-pulse latency above which a round counts
+///   as a deadline miss (0 for none)
+///
+/// # Returns
+///
+/// The session's measurements, or the first request error.
+#[allow(clippy::too_many_arguments)]
+fn run_session(
+    mut hw: HardwareBridge,
+    session: u32,
+    qubits: usize,
+    rounds: u64,
+    round_cycles: u32,
+    jobs: &WorkQueue<Job>,
+    results: &WorkQueue<CorrectionPacket>,
+    deadline_ns: u64,
+) -> Result<SessionReport> {
+    let mut setup = Transaction::new();
+    setup.write(ADDR_ENABLE, 1).write(ADDR_RABI, LOOP_RABI);
+    hw.execute(&setup)?;
+
+    let mut txn = Transaction::new();
+    let mut pipeline = RoundPipeline::new(qubits);
+    let mut report = SessionReport {
+        flagged: 0,
+        pulsed: 0,
+        behind: 0,
+        backlog_max: 0,
+        dropped: 0,
+        e2e: LatencyStats::with_deadline(deadline_ns),
+    };
+
+    for round in 0..rounds {
+        let mut finished = Vec::new();
+        while let Some(done) = results.pop() {
+            finished.push(pipeline.complete(&done)?);
+        }
+        let late = pipeline.late(round);
+        if late != 0 {
+            report.behind += 1;
+            report.backlog_max = report.backlog_max.max(late);
+        }
+
+        report.pulsed += pipeline.frame(&mut txn, round_cycles);
+        let issued = Instant::now();
+        for entry in finished {
+            report
+                .e2e
+                .update((issued - entry.received).as_nanos() as u64);
+        }
+
+        let readout = hw.execute(&txn)?;
+        let received = Instant::now();
+
+        let (packet, mask) = pipeline.syndrome(&readout);
+        let job = Job {
+            session,
+            seq: pipeline.next_seq(),
+            packet,
+        };
+        if jobs.push(job).is_ok() {
+            report.flagged += packet.syndrome_len as u64;
+            pipeline.sent(round, received, mask);
+        } else {
+            report.dropped += 1;
+        }
+    }
+
+    hw.write(ADDR_ENABLE, 0)?;
+    Ok(report)
+}
+
+/// Runs the fan-out soak test against a simulation server.
+///
+/// # Arguments
+///
+/// * `addr` - Simulation server address (see `HardwareBridge::connect`);
+///   every session opens its own connection, so the transport must accept
+///   several (TCP or a Unix socket)
+/// * `sessions` - Simulator sessions to drive
+/// * `workers` - Decoder workers in the pool
+/// * `pin` - Pin worker i to core i (modulo the available cores)
+/// * `rounds` - Syndrome rounds per session
+/// * `round_cycles` - Cycles simulated per round
+/// * `deadline_ns` - Syndrome-to-pulse latency above which a round counts
+///   as a deadline miss (0 for none)
+///
+/// # Returns
+///
+/// Ok(()) on success, or an error if there are no sessions or no workers,
+/// the round is shorter than a pulse, the sessions disagree on the grid size, the grid does not fit the decoder or
+/// a request fails.
+pub fn run_fanout(
+    addr: &str,
+    sessions: usize,
+    workers: usize,
+    pin: bool,
+    rounds: u64,
+    round_cycles: u32,
+    deadline_ns: u64,
+) -> Result<()> {
+    if sessions == 0 || workers == 0 {
+        bail!(
+            "Fan-out needs at least one session and one decoder worker ({} sessions, {} workers)",
+            sessions,
+            workers
+        );
+    }
+    if round_cycles < PULSE_CYCLES {
+        bail!(
+            "A round of {} cycles is shorter than a correction pulse ({} cycles)",
+            round_cycles,
+            PULSE_CYCLES
+        );
+    }
+
+    let mut bridges = Vec::with_capacity(sessions);
+    let mut dim = 0;
+    for session in 0..sessions {
+        let mut hw = HardwareBridge::connect(addr)?;
+        let session_dim = hw.grid_dim()? as usize;
+        if session != 0 && session_dim != dim {
+            bail!(
+                "Session {} has a {}x{} grid, session 0 a {}x{} grid",
+                session,
+                session_dim,
+                session_dim,
+                dim,
+                dim
+            );
+        }
+        dim = session_dim;
+        bridges.push(hw);
+    }
+    let qubits = dim * dim;
+    if 2 * qubits > MAX_NODES {
+        bail!(
+            "A {}x{} grid exceeds the decoder's {} nodes",
+            dim,
+            dim,
+            MAX_NODES
+        );
+    }
+
+    let cores = thread::available_parallelism().map_or(1, |n| n.get());
+    println!(
+        "Fan-out: {} sessions x {} rounds of {} cycles on {}x{} grids, {} decoder workers{}",
+        sessions,
+        rounds,
+        round_cycles,
+        dim,
+        dim,
+        workers,
+        if pin {
+            format!(" (pinned, {} cores)", cores)
+        } else {
+            String::new()
+        }
+    );
+
+    let graph = Arc::new(qubit_graph(qubits));
+    let jobs = Arc::new(WorkQueue::<Job>::new(JOB_DEPTH));
+    let results: Arc<Vec<WorkQueue<CorrectionPacket>>> = Arc::new(
+        (0..sessions)
+            .map(|_| WorkQueue::new(RESULT_DEPTH))
+            .collect(),
+    );
+    let running = Arc::new(AtomicBool::new(true));
+
+    let pool: Vec<_> = (0..workers)
+        .map(|i| {
+            let (graph, jobs, results, running) = (
+                graph.clone(),
+                jobs.clone(),
+                results.clone(),
+                running.clone(),
+            );
+            thread::spawn(move || {
+                if pin && !pin_to_core(i % cores) {
+                    eprintln!("Could not pin decoder worker {} to core {}", i, i % cores);
+                }
+                run_worker(&graph, &jobs, &results, &running)
+            })
+        })
+        .collect();
+
+    let start = Instant::now();
+    let drivers: Vec<_> = bridges
+        .into_iter()
+        .enumerate()
+        .map(|(session, hw)| {
+            let (jobs, results) = (jobs.clone(), results.clone());
+            thread::spawn(move || {
+                run_session(
+                    hw,
+                    session as u32,
+                    qubits,
+                    rounds,
+                    round_cycles,
+                    &jobs,
+                    &results[session],
+                    deadline_ns,
+                )
+            })
+        })
+        .collect();
+    let reports: Vec<Result<SessionReport>> =
+        drivers.into_iter().map(|d| d.join().unwrap()).collect();
+    let wall = start.elapsed();
+
+    running.store(false, Ordering::Relaxed);
+    let decode: Vec<(LatencyStats, u64)> = pool.into_iter().map(|w| w.join().unwrap()).collect();
+    let reports = reports.into_iter().collect::<Result<Vec<_>>>()?;
+
+    let mut decode_all = LatencyStats::new();
+    let mut nonempty = 0;
+    for (d, n) in &decode {
+        decode_all.merge(d);
+        nonempty += n;
+    }
+    let decode_lat = decode_all.summary();
+    let shots = decode_lat.count;
+    let total_rounds = sessions as u64 * rounds;
+    let mut e2e = LatencyStats::with_deadline(deadline_ns);
+    for r in &reports {
+        e2e.merge(&r.e2e);
+    }
+    let e2e_lat = e2e.summary();
+    let secs = wall.as_secs_f64();
+
+    println!(
+        "   Rounds: {} run, {} decoded, {} of them with flagged qubits",
+        total_rounds, shots, nonempty
+    );
+    println!(
+        "   Aggregate: {:.0} shots/s decoded ({:.0}/s with flagged qubits), {:.3} Mcycles/s simulated, {:.2} s wall",
+        shots as f64 / secs,
+        nonempty as f64 / secs,
+        (total_rounds * round_cycles as u64) as f64 / secs / 1e6,
+        secs
+    );
+    println!(
+        "   Decode: {} syndromes, mean {:.2} us, p99 {:.2} us, max {:.2} us; per worker: {}",
+        shots,
+        decode_lat.mean as f64 / 1e3,
+        decode_lat.p99 as f64 / 1e3,
+        decode_lat.max as f64 / 1e3,
+        decode
+            .iter()
+            .map(|(d, _)| d.summary().count.to_string())
+            .collect::<Vec<_>>()
+            .join(", ")
+    );
+    println!(
+        "   Syndrome -> pulse: {} rounds, p50 {:.2} us, p99 {:.2} us, p99.9 {:.2} us, max {:.2} us",
+        e2e_lat.count,
+        e2e_lat.p50 as f64 / 1e3,
+        e2e_lat.p99 as f64 / 1e3,
+        e2e_lat.p999 as f64 / 1e3,
+        e2e_lat.max as f64 / 1e3
+    );
+    if deadline_ns != 0 {
+        println!(
+            "   Deadline {:.1} us: {} of {} rounds missed",
+            deadline_ns as f64 / 1e3,
+            e2e_lat.misses,
+            e2e_lat.count
+        );
+    }
+    for (session, r) in reports.iter().enumerate() {
+        println!(
+            "   Session {:2}: {} flagged, {} pulsed, behind in {} rounds (backlog max {}), {} syndromes dropped",
+            session, r.flagged, r.pulsed, r.behind, r.backlog_max, r.dropped
+        );
+    }
+    println!("{}", decode_lat.line("host.decode", "ns"));
+    println!("{}", e2e_lat.line("host.e2e", "ns"));
+    Ok(())
+}
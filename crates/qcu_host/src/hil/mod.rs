@@ -0,0 +1,2006 @@
+//! Hardware-in-the-loop interface for real-time quantum hardware simulation.
+//!
+//! Provides a TCP-based (or Unix socket / shared-memory) communication
+//! interface to a Verilator simulation of quantum hardware. Enables
+//! real-time monitoring and control of quantum qubit states, error
+//! detection, and correction operations. Used for demonstrating
+//! closed-loop error correction on simulated quantum systems.
+
+use anyhow::{Context, Result, bail};
+use qcu_core::graph::{DecodingGraph, STEPS_PER_WORD};
+use std::io::{Read, Write};
+use std::net::TcpStream;
+use std::os::unix::net::UnixStream;
+use std::thread;
+use std::time::{Duration, Instant};
+
+/// Find-latency benchmark for the union-find accelerator in the SoC.
+///
+/// Loads a parent forest into the accelerator's BRAM and compares the
+/// measured hardware find latency with the software `UnionFind::find`.
+pub mod accel;
+
+/// Closed-loop pipeline through the software Union-Find decoder.
+///
+/// Decodes every syndrome round on the host, overlapped with the next
+/// round's simulation, and writes the corrections back as pulses.
+pub mod closed_loop;
+
+/// Multi-SoC fan-out soak test.
+///
+/// Drives several simulator sessions at once through one shared pool of
+/// decoder workers and reports the aggregate shots per second.
+pub mod fanout;
+
+/// Full-decode benchmark for the SoC's union-find decode block.
+///
+/// Decodes recorded shots in the simulated hardware and checks every
+/// correction list against the software `UnionFindDecoder`.
+pub mod decode;
+
+/// Event-driven register monitor.
+///
+/// Streams the events the simulator pushes for one register watch.
+pub mod monitor;
+
+/// Transport benchmark of the simulation server.
+///
+/// Times single, batched and STEP requests over the connected transport
+/// and reports their throughput and latency percentiles.
+pub mod sim_bench;
+
+/// Shared-memory transport for co-located simulations.
+///
+/// Maps the SPSC ring pair exported by the simulator's `--shm` mode and
+/// presents it as a byte stream, selected with the `shm://` URL scheme.
+mod shm;
+
+/// Byte-stream transport carrying the bridge protocol.
+///
+/// Implemented by `TcpStream`, `UnixStream` and `shm::ShmLink`; the
+/// protocol code in `HardwareBridge` only relies on `Read` and `Write`.
+trait Link: Read + Write + Send {}
+
+impl<T: Read + Write + Send> Link for T {}
+
+/// Command opcodes for hardware bridge protocol.
+///
+/// Defines the binary protocol for communicating with the Verilator simulation.
+/// Commands are sent as single-byte opcodes followed by command-specific data.
+const CMD_STEP: u8 = 0x01;
+
+/// Command opcode for writing to a memory-mapped register.
+///
+/// Sent as the first byte of a write transaction, followed by the 32-bit
+/// address and 32-bit data value. The simulation acknowledges the write
+/// with a 32-bit response.
+const CMD_WRITE: u8 = 0x02;
+
+/// Command opcode for reading from a memory-mapped register.
+///
+/// Sent as the first byte of a read transaction, followed by the 32-bit
+/// address. The simulation responds with the 32-bit register value.
+const CMD_READ: u8 = 0x03;
+
+/// Command opcode for executing a batch of sub-commands in one round trip.
+///
+/// Sent as the first byte of a batch frame, followed by a 32-bit payload
+/// length and the packed STEP/WRITE/READ records built by `Transaction`.
+/// The simulation responds with a 32-bit result count followed by one
+/// 32-bit value per READ record, in issue order.
+const CMD_BATCH: u8 = 0x04;
+
+/// Command opcode for stepping until a register leaves a reference value.
+///
+/// Sent as the first byte, followed by the 32-bit register address, mask,
+/// reference value and cycle budget. The simulation polls the register once
+/// per cycle and responds with the cycles consumed and the last value read.
+const CMD_STEP_UNTIL: u8 = 0x05;
+
+/// Command opcode for a server-side measure-and-correct sequence.
+///
+/// Sent as the first byte, followed by the 32-bit syndrome bank address,
+/// pulse staging bank address, pulse trigger address, pulse duration in
+/// cycles and syndrome word count. The simulation reads the syndrome words
+/// and, if any bit is set, stages them as the pulse mask and fires the
+/// pulse for the requested duration. It responds with the cycles consumed
+/// followed by the syndrome words that were read.
+const CMD_MEASURE_CORRECT: u8 = 0x06;
+
+/// Command opcode for reading a contiguous range of registers.
+///
+/// Sent as the first byte, followed by the 32-bit base address and word
+/// count. The simulation reads the range with an auto-incrementing bus
+/// burst and responds with one 32-bit value per word.
+const CMD_READ_BURST: u8 = 0x07;
+
+/// Command opcode for writing a contiguous range of registers.
+///
+/// Sent as the first byte, followed by the 32-bit base address, word count
+/// and the data words. The simulation acknowledges the burst with a 32-bit
+/// response.
+const CMD_WRITE_BURST: u8 = 0x08;
+
+/// Command opcode for reading the simulator's instrumentation counters.
+///
+/// Sent as the first byte, followed by a 32-bit flags word
+/// (`STATS_FLAG_RESET`). The simulation responds with a 32-bit word count
+/// followed by that many 64-bit counters (see `SimStats`).
+const CMD_STATS: u8 = 0x09;
+
+/// Command opcode for controlling the simulator's waveform capture.
+///
+/// Sent as the first byte, followed by the 32-bit `TraceMode` and a cycle
+/// count whose meaning depends on the mode. The simulation responds with a
+/// 32-bit status (0 on success, see `HardwareBridge::trace`).
+const CMD_TRACE: u8 = 0x0A;
+
+/// Command opcode for checkpointing the simulated SoC.
+///
+/// Sent as the first byte, followed by a 32-bit slot, a 32-bit path length
+/// and the path bytes (see `Snapshot`). The simulation responds with a
+/// 32-bit status and its 64-bit cycle counter.
+const CMD_SAVE: u8 = 0x0B;
+
+/// Command opcode for loading a checkpoint into the simulated SoC.
+///
+/// Same request and reply layout as CMD_SAVE.
+const CMD_RESTORE: u8 = 0x0C;
+
+/// Command opcode for installing or removing a register watch.
+///
+/// Sent as the first byte, followed by the 32-bit watch id, address, mask
+/// and `WatchMode`. The simulation responds with a 32-bit status (0 on
+/// success).
+const CMD_SUBSCRIBE: u8 = 0x0D;
+
+/// Command opcode for free-running the simulation until a watch fires.
+///
+/// Sent as the first byte, followed by a 32-bit cycle budget (0 for none)
+/// and 32-bit flags (`RUN_FLAG_STREAM`). The simulation answers with event
+/// frames (see `RunFrame`), the last of which is always an end frame.
+const CMD_RUN: u8 = 0x0E;
+
+/// Command opcode for stopping a free run.
+///
+/// Answered with a single end frame, whether or not a run was active.
+const CMD_HALT: u8 = 0x0F;
+
+/// Command opcode for reading the simulator's latency histograms.
+///
+/// Sent as the first byte, followed by a 32-bit flags word
+/// (`STATS_FLAG_RESET`, which restarts the whole measurement window as
+/// for CMD_STATS). The simulation responds with a 32-bit byte count
+/// followed by that many bytes of text: one `qcu_core::latency` export
+/// line per histogram, each terminated by a newline.
+const CMD_LATENCY: u8 = 0x10;
+
+/// Upper bound on the size of a CMD_LATENCY reply.
+const MAX_LATENCY_REPLY: usize = 1 << 16;
+
+/// CMD_RUN flag that keeps the run going after a watch has fired.
+const RUN_FLAG_STREAM: u32 = 0x1;
+
+/// Size of one event frame pushed during CMD_RUN.
+const EVENT_FRAME_BYTES: usize = 20;
+
+/// CMD_STATS flag that restarts the counters after they have been sent.
+const STATS_FLAG_RESET: u32 = 1;
+
+/// Buckets of the simulator's syndrome-to-pulse latency histogram.
+const STATS_LAT_BUCKETS: usize = 32;
+
+/// Highest opcode the simulator keeps per-command counters for.
+const STATS_MAX_OPCODE: usize = 15;
+
+/// Display names of the opcodes with per-command counters, from CMD_STEP.
+const STATS_OPCODE_NAMES: [&str; STATS_MAX_OPCODE] = [
+    "STEP",
+    "WRITE",
+    "READ",
+    "BATCH",
+    "STEP_UNTIL",
+    "MEASURE_CORRECT",
+    "READ_BURST",
+    "WRITE_BURST",
+    "STATS",
+    "TRACE",
+    "SAVE",
+    "RESTORE",
+    "SUBSCRIBE",
+    "RUN",
+    "HALT",
+];
+
+/// Index of the pacing and deadline counters in a CMD_STATS reply.
+const STATS_PACE_BASE: usize = 9 + STATS_LAT_BUCKETS + 3 * STATS_MAX_OPCODE;
+
+/// 64-bit words in a CMD_STATS reply of the current layout.
+const STATS_WORDS: usize = STATS_PACE_BASE + 8;
+
+/// Largest grid side length supported by the qubit grid register map.
+const MAX_GRID_DIM: u32 = 32;
+
+/// Memory-mapped register addresses in the hardware simulation.
+///
+/// Defines the register layout for controlling and reading quantum hardware
+/// state. These addresses correspond to MMIO registers in the Verilator model.
+const ADDR_ENABLE: u32 = 0x4000_0000;
+
+/// Register address of the first pulse staging word.
+///
+/// Word i holds the pulse mask for qubits 32i to 32i+31. Staged masks have
+/// no effect until the pulse trigger register is written, so grids wider
+/// than one word are pulsed on all qubits at once.
+const ADDR_PULSE_STAGE: u32 = 0x4000_0020;
+
+/// Register address for triggering the staged correction pulse.
+///
+/// Writing N applies the staged mask to the qubits for N clock cycles,
+/// counted down by the hardware. The pulse strength is controlled by the
+/// Rabi register.
+const ADDR_PULSE_GO: u32 = 0x4000_0006;
+
+/// Register address of the first error syndrome word.
+///
+/// Reading word i returns a bitmask of the qubits 32i to 32i+31 that have
+/// detected errors, with bit 0 of word 0 representing qubit 0, bit 1
+/// representing qubit 1, etc.
+const ADDR_ERRORS: u32 = 0x4000_0040;
+
+/// Register address reporting whether any qubit has detected an error.
+///
+/// Reads 1 while at least one syndrome bit is set anywhere in the grid,
+/// which lets a single register poll cover grids of any size.
+const ADDR_ERR_ANY: u32 = 0x4000_0005;
+
+/// Register address reporting the side length of the qubit grid.
+///
+/// Read-only; set when the simulation is built (`QCU_GRID_DIM`).
+const ADDR_GRID_DIM: u32 = 0x4000_0004;
+
+/// Register address for configuring Rabi frequency (pulse strength).
+///
+/// Writing a value to this register sets the strength of correction pulses
+/// applied to qubits. Higher values correspond to stronger pulses and faster
+/// rotations. The value 468 corresponds to a specific Rabi frequency in
+/// the physics simulation's units.
+const ADDR_RABI: u32 = 0x4000_0003;
+
+/// Register address of the union-find accelerator status register.
+///
+/// Bit 0 is set while a find is running and bit 1 once it has completed;
+/// writing the find register clears the completion bit.
+const ADDR_UF_STATUS: u32 = 0x4001_0000;
+
+/// Register address that starts a hardware find on the written node index.
+const ADDR_UF_FIND: u32 = 0x4001_0001;
+
+/// Register address of the root reported by the last hardware find.
+///
+/// Followed by the cycle count (0x4001_0003) and the number of parent
+/// reads (0x4001_0004) of the same find, so all three are read as a burst.
+const ADDR_UF_ROOT: u32 = 0x4001_0002;
+
+/// Register address reporting the number of parent BRAM entries.
+///
+/// Read-only; set when the simulation is built (`QCU_UF_DEPTH`).
+const ADDR_UF_DEPTH: u32 = 0x4001_0005;
+
+/// Register address reporting the parent BRAM read latency in cycles.
+///
+/// Read-only; set when the simulation is built (`QCU_UF_MEM_LATENCY`).
+const ADDR_UF_MEM_LATENCY: u32 = 0x4001_0006;
+
+/// Register address of parent array entry 0 in the accelerator BRAM.
+///
+/// Entry i lives at this address plus i, so the array is loaded with a
+/// single burst write.
+const ADDR_UF_PARENT: u32 = 0x4001_8000;
+
+/// Register address of the multi-query engine status register.
+///
+/// Bits 15:0 count queries in flight, bit 16 flags a dropped query and
+/// bit 17 is set while nothing is in flight.
+const ADDR_UF_MQ_STATUS: u32 = 0x4001_0007;
+
+/// Register address of the first multi-query counter.
+///
+/// Cycles with queries in flight, completed queries, parent reads and
+/// compression writes follow at consecutive addresses; writing this
+/// register clears all four and the overflow flag.
+const ADDR_UF_MQ_COUNTERS: u32 = 0x4001_0008;
+
+/// Register address of the multi-query engine's walker count.
+const ADDR_UF_MQ_WALKERS: u32 = 0x4001_000C;
+
+/// Register address of query slot 0 of the multi-query engine.
+///
+/// Writing node n to this address plus t queues a find tagged t, so a
+/// batch of up to `UF_MQ_TAGS` queries is pushed with one burst write.
+const ADDR_UF_MQ_QUERY: u32 = 0x4001_0100;
+
+/// Register address of result slot 0 of the multi-query engine.
+///
+/// Slot t holds the root of the query tagged t in bits 30:0 and a valid
+/// flag in bit 31.
+const ADDR_UF_MQ_RESULT: u32 = 0x4001_0200;
+
+/// Number of query tags (and queue slots) of the multi-query engine.
+const UF_MQ_TAGS: usize = 256;
+
+/// Multi-query status bit set while no query is in flight.
+const UF_MQ_IDLE: u32 = 1 << 17;
+
+/// Multi-query status bit set after a query was dropped on a full queue.
+const UF_MQ_OVERFLOW: u32 = 1 << 16;
+
+/// Result slot bit set once the query has completed.
+const UF_MQ_VALID: u32 = 1 << 31;
+
+/// Status bit set once the accelerator has completed a find.
+const UF_STATUS_DONE: u32 = 1 << 1;
+
+/// Register address of the full-decode block's control register.
+///
+/// Writing 1 starts a decode of the loaded syndrome over the loaded graph.
+const ADDR_DEC_CTRL: u32 = 0x4002_0000;
+
+/// Register address of the full-decode block's status register.
+///
+/// Bit 0 is set while a decode runs, bit 1 after the correction buffer
+/// overflowed and bit 2 once the last decode completed.
+const ADDR_DEC_STATUS: u32 = 0x4002_0001;
+
+/// Register address of the syndrome length.
+///
+/// Followed by the graph's node count (0x4002_0003) and edge count
+/// (0x4002_0004).
+const ADDR_DEC_NUM_SYNDROMES: u32 = 0x4002_0002;
+
+/// Register address of the graph's node count.
+const ADDR_DEC_NUM_NODES: u32 = 0x4002_0003;
+
+/// Register address of the correction count of the last decode.
+///
+/// Followed by its cycle count, edge sweeps, root finds and odd-parity
+/// root count, so all five are read as a burst.
+const ADDR_DEC_RESULTS: u32 = 0x4002_0005;
+
+/// Register address of the block's node capacity.
+///
+/// Followed by the edge and syndrome capacities; all three are read-only
+/// and set when the simulation is built (`QCU_DEC_NODES`, `QCU_DEC_EDGES`).
+const ADDR_DEC_CAPACITY: u32 = 0x4002_000A;
+
+/// Register address of the block's mode register (bit 0 weighted growth).
+const ADDR_DEC_MODE: u32 = 0x4002_000D;
+
+/// Register address of growth step word 0.
+///
+/// Takes the graph's `edge_steps` words unchanged, eight 4-bit step counts
+/// per word.
+const ADDR_DEC_STEPS: u32 = 0x4002_1000;
+
+/// Register address of correction 0, packed as `(v << 16) | u`.
+const ADDR_DEC_CORRECTIONS: u32 = 0x4002_2000;
+
+/// Register address of odd-parity root 0.
+const ADDR_DEC_ODD_ROOTS: u32 = 0x4002_3000;
+
+/// Register address of syndrome entry 0 (a fired detector index).
+const ADDR_DEC_SYNDROMES: u32 = 0x4002_4000;
+
+/// Register address of edge 0, packed as `(v << 16) | u`.
+const ADDR_DEC_EDGES: u32 = 0x4002_8000;
+
+/// Decode status bit set while a decode is running.
+const DEC_STATUS_BUSY: u32 = 1 << 0;
+
+/// Decode status bit set after the correction buffer overflowed.
+const DEC_STATUS_OVERFLOW: u32 = 1 << 1;
+
+/// Result of one find executed by the union-find accelerator.
+#[derive(Debug, Clone, Copy)]
+pub struct AccelFind {
+    /// Root of the set containing the queried node.
+    pub root: u32,
+
+    /// Clock cycles from the find request to completion.
+    pub cycles: u32,
+
+    /// Parent array reads the engine issued, including the root's own.
+    pub hops: u32,
+}
+
+/// Activity counters of the multi-query union-find engine.
+#[derive(Debug, Clone, Copy, Default)]
+pub struct AccelCounters {
+    /// Cycles during which at least one query was in flight.
+    pub cycles: u32,
+
+    /// Queries completed.
+    pub finds: u32,
+
+    /// Parent reads issued on the shared memory port.
+    pub reads: u32,
+
+    /// Path compression writes committed to the parent array.
+    pub writes: u32,
+}
+
+/// Buffer capacities of the full-decode block.
+#[derive(Debug, Clone, Copy)]
+pub struct DecoderCapacity {
+    /// Detectors the graph may have.
+    pub nodes: u32,
+
+    /// Edges the graph may have.
+    pub edges: u32,
+
+    /// Fired detectors one syndrome may list.
+    pub syndromes: u32,
+}
+
+/// Result of one decode executed by the full-decode block.
+#[derive(Debug, Clone, Default)]
+pub struct AccelDecode {
+    /// Correction edges `(u, v)` in the order the block produced them.
+    pub corrections: Vec<(u32, u32)>,
+
+    /// Roots whose clusters kept odd parity.
+    pub odd_roots: Vec<u32>,
+
+    /// Clock cycles from the start bit to completion.
+    pub cycles: u32,
+
+    /// Sweeps over the edge list, including the final one without unions.
+    pub passes: u32,
+
+    /// Root finds performed.
+    pub finds: u32,
+}
+
+/// Waveform capture request carried by CMD_TRACE.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+#[repr(u32)]
+pub enum TraceMode {
+    /// Stop and finalize any running capture.
+    Off = 0,
+
+    /// Dump every cycle into a single file until stopped.
+    Continuous = 1,
+
+    /// Keep a rolling window of two segments of the given cycle count.
+    Window = 2,
+
+    /// Keep the window and stop after the given number of further cycles.
+    Trigger = 3,
+}
+
+/// Condition a register watch fires on (CMD_SUBSCRIBE).
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+#[repr(u32)]
+pub enum WatchMode {
+    /// Remove the watch.
+    Off = 0,
+
+    /// Fire whenever a masked bit differs from the previous sample.
+    Change = 1,
+
+    /// Fire when a masked bit becomes set; a bit already set at the start
+    /// of a run fires on its first sample.
+    Set = 2,
+}
+
+/// A watch condition pushed by the simulator during a free run.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct WatchEvent {
+    /// Id of the watch that fired.
+    pub watch: u32,
+
+    /// SoC cycle counter when the register was sampled.
+    pub cycle: u64,
+
+    /// Register value that satisfied the condition.
+    pub value: u32,
+}
+
+/// Why a free run ended.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum RunEnd {
+    /// A watch fired and the run was not streaming.
+    Event,
+
+    /// The cycle budget was exhausted.
+    Budget,
+
+    /// The host sent a command (normally CMD_HALT).
+    Halted,
+
+    /// No watch was active.
+    Idle,
+}
+
+/// One frame received while the simulator free-runs.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum RunFrame {
+    /// A watch fired.
+    Event(WatchEvent),
+
+    /// The run is over; ordinary replies follow.
+    End {
+        /// Why the run ended.
+        reason: RunEnd,
+
+        /// SoC cycle counter at the end of the run.
+        cycle: u64,
+
+        /// Cycles the run consumed.
+        cycles: u32,
+    },
+}
+
+/// Location of a simulator checkpoint (CMD_SAVE/CMD_RESTORE).
+#[derive(Debug, Clone, PartialEq, Eq)]
+pub enum Snapshot {
+    /// In-memory slot shared by all sessions of one simulator process.
+    Slot(u32),
+
+    /// Snapshot file, resolved by the simulator process.
+    File(String),
+}
+
+impl Snapshot {
+    /// Parses a checkpoint specification.
+    ///
+    /// `mem:<n>` selects in-memory slot n; anything else is a file path.
+    ///
+    /// # Arguments
+    ///
+    /// * `spec` - Checkpoint specification
+    ///
+    /// # Returns
+    ///
+    /// The parsed location, or an error if the slot number is malformed.
+    pub fn parse(spec: &str) -> Result<Self> {
+        match spec.strip_prefix("mem:") {
+            Some(slot) => Ok(Snapshot::Slot(slot.parse()?)),
+            None => Ok(Snapshot::File(spec.to_string())),
+        }
+    }
+}
+
+/// Cost of one protocol opcode as accounted by the simulator.
+#[derive(Debug, Clone, Copy, Default)]
+pub struct CommandStats {
+    /// Commands received.
+    pub count: u64,
+
+    /// Server wall time from the opcode arriving to the reply being sent.
+    pub wall_ns: u64,
+
+    /// Simulated clock cycles the commands consumed.
+    pub cycles: u64,
+}
+
+/// Instrumentation counters of one simulation session.
+///
+/// All values cover the current measurement window, which starts with the
+/// session and restarts after a `sim_stats(true)` call.
+#[derive(Debug, Clone, Copy)]
+pub struct SimStats {
+    /// Clock cycles simulated, including fast-forwarded ones.
+    pub cycles: u64,
+
+    /// Clock cycles evaluated by the model.
+    pub ticks: u64,
+
+    /// Clock cycles fast-forwarded while the design was quiescent.
+    pub skipped: u64,
+
+    /// Wall time inside the model's eval() (0 unless `--profile-eval`).
+    pub eval_ns: u64,
+
+    /// Wall time of the measurement window.
+    pub wall_ns: u64,
+
+    /// Syndrome-to-pulse latency samples.
+    pub lat_count: u64,
+
+    /// Sum of the latency samples in cycles.
+    pub lat_sum: u64,
+
+    /// Smallest latency sample in cycles.
+    pub lat_min: u64,
+
+    /// Largest latency sample in cycles.
+    pub lat_max: u64,
+
+    /// Log2 latency histogram: bucket b counts samples in [2^(b-1), 2^b).
+    pub lat_buckets: [u64; STATS_LAT_BUCKETS],
+
+    /// Per-opcode costs, indexed by opcode minus one.
+    pub commands: [CommandStats; STATS_MAX_OPCODE],
+
+    /// Target clock rate of a paced session in Hz (0 when lock-step).
+    pub pace_hz: u64,
+
+    /// Largest lag of the paced clock behind real time.
+    pub lag_max_ns: u64,
+
+    /// Pacing checks that found the clock more than a check interval late.
+    pub late_checks: u64,
+
+    /// Deepest command backlog the paced clock found at a cycle boundary.
+    pub queue_max: u64,
+
+    /// Total time commands waited for a cycle boundary.
+    pub queue_wait_ns: u64,
+
+    /// Longest time a single command waited for a cycle boundary.
+    pub queue_wait_max_ns: u64,
+
+    /// Syndrome-to-pulse deadline in cycles (0 when none is configured).
+    pub deadline_cycles: u64,
+
+    /// Syndromes still unanswered when the deadline passed.
+    pub deadline_misses: u64,
+}
+
+impl SimStats {
+    /// Decodes the counters of a CMD_STATS reply.
+    ///
+    /// Words beyond the known layout are ignored. The reply carries no
+    /// layout version, and the per-command block is sized by the opcode
+    /// table (`STATS_MAX_OPCODE`), so an opcode table of another size moves
+    /// the pacing block at `STATS_PACE_BASE`: the host and the simulator
+    /// must be built with the same layout as `sim_stats.h`.
+    ///
+    /// # Arguments
+    ///
+    /// * `w` - The 64-bit counters in reply order
+    ///
+    /// # Returns
+    ///
+    /// The decoded counters, or None if the reply is too short.
+    fn from_words(w: &[u64]) -> Option<Self> {
+        if w.len() < STATS_WORDS {
+            return None;
+        }
+        let mut lat_buckets = [0u64; STATS_LAT_BUCKETS];
+        lat_buckets.copy_from_slice(&w[9..9 + STATS_LAT_BUCKETS]);
+        let mut commands = [CommandStats::default(); STATS_MAX_OPCODE];
+        for (op, c) in commands.iter_mut().enumerate() {
+            let base = 9 + STATS_LAT_BUCKETS + 3 * op;
+            *c = CommandStats {
+                count: w[base],
+                wall_ns: w[base + 1],
+                cycles: w[base + 2],
+            };
+        }
+        Some(Self {
+            cycles: w[0],
+            ticks: w[1],
+            skipped: w[2],
+            eval_ns: w[3],
+            wall_ns: w[4],
+            lat_count: w[5],
+            lat_sum: w[6],
+            lat_min: w[7],
+            lat_max: w[8],
+            lat_buckets,
+            commands,
+            pace_hz: w[STATS_PACE_BASE],
+            lag_max_ns: w[STATS_PACE_BASE + 1],
+            late_checks: w[STATS_PACE_BASE + 2],
+            queue_max: w[STATS_PACE_BASE + 3],
+            queue_wait_ns: w[STATS_PACE_BASE + 4],
+            queue_wait_max_ns: w[STATS_PACE_BASE + 5],
+            deadline_cycles: w[STATS_PACE_BASE + 6],
+            deadline_misses: w[STATS_PACE_BASE + 7],
+        })
+    }
+
+    /// Server wall time spent executing commands, excluding CMD_STATS.
+    ///
+    /// Reading the counters is instrumentation overhead, so it is left out
+    /// when attributing loop time to the simulator.
+    pub fn server_ns(&self) -> u64 {
+        self.commands
+            .iter()
+            .enumerate()
+            .filter(|&(op, _)| op + 1 != CMD_STATS as usize)
+            .map(|(_, c)| c.wall_ns)
+            .sum()
+    }
+
+    /// Upper bound of the latency quantile q from the log2 histogram.
+    ///
+    /// # Arguments
+    ///
+    /// * `q` - Quantile in [0, 1]
+    ///
+    /// # Returns
+    ///
+    /// The exclusive upper edge of the bucket holding the quantile, in
+    /// cycles, or 0 without samples.
+    pub fn latency_quantile(&self, q: f64) -> u64 {
+        let target = (q * self.lat_count as f64).ceil().max(1.0) as u64;
+        let mut seen = 0u64;
+        for (b, &n) in self.lat_buckets.iter().enumerate() {
+            seen += n;
+            if n != 0 && seen >= target {
+                return 1u64 << b;
+            }
+        }
+        0
+    }
+}
+
+/// Builder for a batched sequence of bus operations.
+///
+/// Accumulates STEP, WRITE, READ and burst records in the wire encoding
+/// used by the simulation server so that a whole correction cycle can be
+/// sent as a single CMD_BATCH frame. The builder can be cleared and reused
+/// to avoid reallocating the payload buffer on every cycle.
+#[derive(Default)]
+pub struct Transaction {
+    /// Packed sub-command records, excluding the frame header.
+    payload: Vec<u8>,
+
+    /// Number of READ records queued, used to size the reply.
+    reads: usize,
+}
+
+impl Transaction {
+    /// Creates an empty transaction.
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    /// Queues a STEP record advancing the simulation by `cycles` clock cycles.
+    pub fn step(&mut self, cycles: u32) -> &mut Self {
+        self.payload.push(CMD_STEP);
+        self.payload.extend_from_slice(&cycles.to_le_bytes());
+        self
+    }
+
+    /// Queues a WRITE record storing `data` at the register `addr`.
+    pub fn write(&mut self, addr: u32, data: u32) -> &mut Self {
+        self.payload.push(CMD_WRITE);
+        self.payload.extend_from_slice(&addr.to_le_bytes());
+        self.payload.extend_from_slice(&data.to_le_bytes());
+        self
+    }
+
+    /// Queues a READ record for the register `addr`.
+    ///
+    /// The value is returned by `HardwareBridge::execute` at the position
+    /// matching the order in which reads were queued.
+    pub fn read(&mut self, addr: u32) -> &mut Self {
+        self.payload.push(CMD_READ);
+        self.payload.extend_from_slice(&addr.to_le_bytes());
+        self.reads += 1;
+        self
+    }
+
+    /// Queues a READ_BURST record for `count` registers starting at `addr`.
+    ///
+    /// The values are returned by `HardwareBridge::execute` in address
+    /// order, at the position matching the order in which reads were queued.
+    pub fn read_burst(&mut self, addr: u32, count: u32) -> &mut Self {
+        self.payload.push(CMD_READ_BURST);
+        self.payload.extend_from_slice(&addr.to_le_bytes());
+        self.payload.extend_from_slice(&count.to_le_bytes());
+        self.reads += count as usize;
+        self
+    }
+
+    /// Queues a WRITE_BURST record storing `data` at consecutive registers
+    /// starting at `addr`.
+    pub fn write_burst(&mut self, addr: u32, data: &[u32]) -> &mut Self {
+        self.payload.push(CMD_WRITE_BURST);
+        self.payload.extend_from_slice(&addr.to_le_bytes());
+        self.payload
+            .extend_from_slice(&(data.len() as u32).to_le_bytes());
+        for word in data {
+            self.payload.extend_from_slice(&word.to_le_bytes());
+        }
+        self
+    }
+
+    /// Removes all queued records while keeping the allocated buffer.
+    pub fn clear(&mut self) {
+        self.payload.clear();
+        self.reads = 0;
+    }
+}
+
+/// Bridge for communicating with Verilator hardware simulation.
+///
+/// Maintains a persistent connection to the simulation and provides
+/// methods for stepping the simulation, reading quantum state, and applying
+/// correction pulses. All operations are synchronous and block until the
+/// simulation responds.
+pub struct HardwareBridge {
+    stream: Box<dyn Link>,
+}
+
+impl HardwareBridge {
+    /// Establishes a connection to the Verilator simulation server.
+    ///
+    /// The transport is selected by URL scheme. `shm://<name>` attaches to
+    /// the shared-memory region exported by a simulator started with
+    /// `--shm <name>`, and `unix:<path>` connects to the Unix domain socket
+    /// of a simulator started with `--unix <path>`. Anything else
+    /// (optionally prefixed with `tcp://`) is treated as a TCP address,
+    /// with TCP_NODELAY enabled to reduce latency for real-time control.
+    /// The connection remains open for the lifetime of the HardwareBridge
+    /// instance.
+    ///
+    /// # Arguments
+    ///
+    /// * `addr` - Server address, e.g. "127.0.0.1:8000", "unix:/tmp/qcu.sock"
+    ///   or "shm://qcu0"
+    ///
+    /// # Returns
+    ///
+    /// Ok(HardwareBridge) on successful connection, or an error if the
+    /// connection cannot be established.
+    pub fn connect(addr: &str) -> Result<Self> {
+        let stream: Box<dyn Link> = if let Some(name) = addr.strip_prefix("shm://") {
+            Box::new(shm::ShmLink::open(name)?)
+        } else if let Some(path) = addr.strip_prefix("unix:") {
+            let path = path.strip_prefix("//").unwrap_or(path);
+            Box::new(UnixStream::connect(path)?)
+        } else {
+            let stream = TcpStream::connect(addr.strip_prefix("tcp://").unwrap_or(addr))?;
+            stream.set_nodelay(true)?;
+            Box::new(stream)
+        };
+        Ok(Self { stream })
+    }
+
+    /// Advances the hardware simulation by the specified number of clock cycles.
+    ///
+    /// Sends a STEP command to the simulation server with the cycle count,
+    /// then waits for acknowledgment. This allows fine-grained control over
+    /// simulation timing for precise error detection and correction timing.
+    ///
+    /// # Arguments
+    ///
+    /// * `cycles` - Number of clock cycles to advance the simulation
+    ///
+    /// # Returns
+    ///
+    /// Ok(()) on success, or an error if the command fails or connection is lost.
+    pub fn step(&mut self, cycles: u32) -> Result<()> {
+        self.stream.write_all(&[CMD_STEP])?;
+        self.stream.write_all(&cycles.to_le_bytes())?;
+        let mut ack = [0u8; 4];
+        self.stream.read_exact(&mut ack)?;
+        Ok(())
+    }
+
+    /// Writes a 32-bit value to a memory-mapped register in the simulation.
+    ///
+    /// Sends a WRITE command with the address and data, then waits for
+    /// acknowledgment. Used to configure hardware peripherals, trigger
+    /// operations, and apply correction pulses to qubits.
+    ///
+    /// # Arguments
+    ///
+    /// * `addr` - 32-bit memory-mapped address to write
+    /// * `data` - 32-bit value to write
+    ///
+    /// # Returns
+    ///
+    /// Ok(()) on success, or an error if the write fails or connection is lost.
+    pub fn write(&mut self, addr: u32, data: u32) -> Result<()> {
+        self.stream.write_all(&[CMD_WRITE])?;
+        self.stream.write_all(&addr.to_le_bytes())?;
+        self.stream.write_all(&data.to_le_bytes())?;
+        let mut ack = [0u8; 4];
+        self.stream.read_exact(&mut ack)?;
+        Ok(())
+    }
+
+    /// Reads a 32-bit value from a memory-mapped register in the simulation.
+    ///
+    /// Sends a READ command with the address, then receives and returns the
+    /// register value. Used to read qubit error states, status registers, and
+    /// measurement results from the quantum hardware simulation.
+    ///
+    /// # Arguments
+    ///
+    /// * `addr` - 32-bit memory-mapped address to read
+    ///
+    /// # Returns
+    ///
+    /// Ok(value) on success with the 32-bit register value, or an error if
+    /// the read fails or connection is lost.
+    pub fn read(&mut self, addr: u32) -> Result<u32> {
+        self.stream.write_all(&[CMD_READ])?;
+        self.stream.write_all(&addr.to_le_bytes())?;
+        let mut data = [0u8; 4];
+        self.stream.read_exact(&mut data)?;
+        Ok(u32::from_le_bytes(data))
+    }
+
+    /// Reads a contiguous range of registers in a single round trip.
+    ///
+    /// The simulation moves the range with an auto-incrementing bus burst,
+    /// one word per clock cycle, so wide syndrome vectors cost one request
+    /// regardless of the grid size.
+    ///
+    /// # Arguments
+    ///
+    /// * `addr` - Address of the first register
+    /// * `count` - Number of consecutive registers to read
+    ///
+    /// # Returns
+    ///
+    /// Ok(values) with `count` register values in address order, or an
+    /// error if the read fails or connection is lost.
+    pub fn read_burst(&mut self, addr: u32, count: u32) -> Result<Vec<u32>> {
+        let mut frame = [0u8; 9];
+        frame[0] = CMD_READ_BURST;
+        frame[1..5].copy_from_slice(&addr.to_le_bytes());
+        frame[5..9].copy_from_slice(&count.to_le_bytes());
+        self.stream.write_all(&frame)?;
+
+        let mut raw = vec![0u8; 4 * count as usize];
+        self.stream.read_exact(&mut raw)?;
+        Ok(raw
+            .chunks_exact(4)
+            .map(|w| u32::from_le_bytes([w[0], w[1], w[2], w[3]]))
+            .collect())
+    }
+
+    /// Writes a contiguous range of registers in a single round trip.
+    ///
+    /// # Arguments
+    ///
+    /// * `addr` - Address of the first register
+    /// * `data` - Values for consecutive registers starting at `addr`
+    ///
+    /// # Returns
+    ///
+    /// Ok(()) on success, or an error if the write fails or connection is
+    /// lost.
+    pub fn write_burst(&mut self, addr: u32, data: &[u32]) -> Result<()> {
+        let mut frame = Vec::with_capacity(9 + 4 * data.len());
+        frame.push(CMD_WRITE_BURST);
+        frame.extend_from_slice(&addr.to_le_bytes());
+        frame.extend_from_slice(&(data.len() as u32).to_le_bytes());
+        for word in data {
+            frame.extend_from_slice(&word.to_le_bytes());
+        }
+        self.stream.write_all(&frame)?;
+        let mut ack = [0u8; 4];
+        self.stream.read_exact(&mut ack)?;
+        Ok(())
+    }
+
+    /// Advances the simulation until a register leaves a reference value.
+    ///
+    /// The simulation polls `addr` once per cycle and stops as soon as
+    /// `value & mask` differs from `reference & mask`, or after
+    /// `max_cycles` cycles. The whole wait costs a single round trip, so
+    /// the host learns about an event on the cycle it happens rather than
+    /// at the next polling interval.
+    ///
+    /// # Arguments
+    ///
+    /// * `addr` - 32-bit memory-mapped address to poll
+    /// * `mask` - Bits of the register taking part in the comparison
+    /// * `reference` - Value the register is compared against
+    /// * `max_cycles` - Upper bound on the number of cycles to run
+    ///
+    /// # Returns
+    ///
+    /// Ok((cycles, value)) with the cycles consumed and the last value
+    /// read, or an error if the connection is lost.
+    pub fn step_until(
+        &mut self,
+        addr: u32,
+        mask: u32,
+        reference: u32,
+        max_cycles: u32,
+    ) -> Result<(u32, u32)> {
+        let mut frame = [0u8; 17];
+        frame[0] = CMD_STEP_UNTIL;
+        frame[1..5].copy_from_slice(&addr.to_le_bytes());
+        frame[5..9].copy_from_slice(&mask.to_le_bytes());
+        frame[9..13].copy_from_slice(&reference.to_le_bytes());
+        frame[13..17].copy_from_slice(&max_cycles.to_le_bytes());
+        self.stream.write_all(&frame)?;
+        self.read_pair()
+    }
+
+    /// Reads the syndrome and applies a correction pulse inside the simulation.
+    ///
+    /// If any of the `words` syndrome words starting at `measure_base` is
+    /// nonzero, the simulation copies them into the pulse staging bank at
+    /// `stage_base` and writes `pulse_cycles` to `go_addr`, pulsing every
+    /// flagged qubit for that many cycles without any host involvement
+    /// between the measurement and the correction.
+    ///
+    /// # Arguments
+    ///
+    /// * `measure_base` - Address of syndrome word 0
+    /// * `stage_base` - Address of pulse staging word 0
+    /// * `go_addr` - Pulse trigger register address
+    /// * `pulse_cycles` - Pulse duration in clock cycles
+    /// * `words` - Number of syndrome words (1 to 32)
+    ///
+    /// # Returns
+    ///
+    /// Ok((cycles, syndrome)) with the cycles consumed and the syndrome
+    /// words that were read, or an error if the connection is lost.
+    pub fn measure_correct(
+        &mut self,
+        measure_base: u32,
+        stage_base: u32,
+        go_addr: u32,
+        pulse_cycles: u32,
+        words: u32,
+    ) -> Result<(u32, Vec<u32>)> {
+        let mut frame = [0u8; 21];
+        frame[0] = CMD_MEASURE_CORRECT;
+        frame[1..5].copy_from_slice(&measure_base.to_le_bytes());
+        frame[5..9].copy_from_slice(&stage_base.to_le_bytes());
+        frame[9..13].copy_from_slice(&go_addr.to_le_bytes());
+        frame[13..17].copy_from_slice(&pulse_cycles.to_le_bytes());
+        frame[17..21].copy_from_slice(&words.to_le_bytes());
+        self.stream.write_all(&frame)?;
+
+        let mut raw = vec![0u8; 4 * (words as usize + 1)];
+        self.stream.read_exact(&mut raw)?;
+        let mut values = raw
+            .chunks_exact(4)
+            .map(|w| u32::from_le_bytes([w[0], w[1], w[2], w[3]]));
+        let cycles = values.next().unwrap_or(0);
+        Ok((cycles, values.collect()))
+    }
+
+    /// Queries the side length of the simulated qubit grid.
+    ///
+    /// # Returns
+    ///
+    /// Ok(dim) for a dim x dim grid, or an error if the simulation reports
+    /// a size outside the supported register map.
+    pub fn grid_dim(&mut self) -> Result<u32> {
+        let dim = self.read(ADDR_GRID_DIM)?;
+        if dim == 0 || dim > MAX_GRID_DIM {
+            bail!("Simulation reported an unsupported grid size {}", dim);
+        }
+        Ok(dim)
+    }
+
+    /// Runs one find on the union-find accelerator.
+    ///
+    /// Writes the node to the find register, lets the simulation run until
+    /// the engine reports completion, and reads back the root together
+    /// with the cycle and hop counters measured by the hardware.
+    ///
+    /// # Arguments
+    ///
+    /// * `node` - Node index to find the root for
+    /// * `max_cycles` - Cycle budget before the find is treated as hung
+    ///
+    /// # Returns
+    ///
+    /// Ok(AccelFind) with the root and its cost, or an error if the engine
+    /// did not finish within `max_cycles` or the connection is lost.
+    pub fn accel_find(&mut self, node: u32, max_cycles: u32) -> Result<AccelFind> {
+        self.write(ADDR_UF_FIND, node)?;
+        let (_, status) = self.step_until(ADDR_UF_STATUS, UF_STATUS_DONE, 0, max_cycles)?;
+        if status & UF_STATUS_DONE == 0 {
+            bail!(
+                "Accelerator find on node {} did not finish in {} cycles",
+                node,
+                max_cycles
+            );
+        }
+        let result = self.read_burst(ADDR_UF_ROOT, 3)?;
+        Ok(AccelFind {
+            root: result[0],
+            cycles: result[1],
+            hops: result[2],
+        })
+    }
+
+    /// Resolves a batch of nodes on the multi-query union-find engine.
+    ///
+    /// Pushes up to `UF_MQ_TAGS` queries at a time with one burst write
+    /// (the slot index is the tag), lets the simulation run until nothing
+    /// is in flight, and collects the per-tag results with one burst read.
+    /// The engine overlaps the walks and writes path compression back to
+    /// the parent array as it goes.
+    ///
+    /// # Arguments
+    ///
+    /// * `nodes` - Node indices to find the roots for
+    /// * `max_cycles` - Cycle budget for each chunk of queries
+    ///
+    /// # Returns
+    ///
+    /// Ok(roots) in the order of `nodes`, or an error if the engine did not
+    /// drain within the budget, dropped a query, or the connection is lost.
+    pub fn accel_find_batch(&mut self, nodes: &[u32], max_cycles: u32) -> Result<Vec<u32>> {
+        let mut roots = Vec::with_capacity(nodes.len());
+        for chunk in nodes.chunks(UF_MQ_TAGS) {
+            self.write_burst(ADDR_UF_MQ_QUERY, chunk)?;
+            let (_, status) = self.step_until(ADDR_UF_MQ_STATUS, UF_MQ_IDLE, 0, max_cycles)?;
+            if status & UF_MQ_OVERFLOW != 0 {
+                bail!("Multi-query engine dropped a query");
+            }
+            if status & UF_MQ_IDLE == 0 {
+                bail!("Multi-query engine did not drain in {} cycles", max_cycles);
+            }
+            for (tag, word) in self
+                .read_burst(ADDR_UF_MQ_RESULT, chunk.len() as u32)?
+                .into_iter()
+                .enumerate()
+            {
+                if word & UF_MQ_VALID == 0 {
+                    bail!("Multi-query result for tag {} is missing", tag);
+                }
+                roots.push(word & !UF_MQ_VALID);
+            }
+        }
+        Ok(roots)
+    }
+
+    /// Reads and clears the multi-query engine's activity counters.
+    ///
+    /// # Returns
+    ///
+    /// Ok(AccelCounters) with the counts accumulated since the last call,
+    /// or an error if the connection is lost.
+    pub fn accel_take_counters(&mut self) -> Result<AccelCounters> {
+        let raw = self.read_burst(ADDR_UF_MQ_COUNTERS, 4)?;
+        self.write(ADDR_UF_MQ_COUNTERS, 0)?;
+        Ok(AccelCounters {
+            cycles: raw[0],
+            finds: raw[1],
+            reads: raw[2],
+            writes: raw[3],
+        })
+    }
+
+    /// Queries the buffer capacities of the full-decode block.
+    ///
+    /// # Returns
+    ///
+    /// Ok(DecoderCapacity) read from the block, or an error if the
+    /// connection is lost.
+    pub fn decoder_capacity(&mut self) -> Result<DecoderCapacity> {
+        let raw = self.read_burst(ADDR_DEC_CAPACITY, 3)?;
+        Ok(DecoderCapacity {
+            nodes: raw[0],
+            edges: raw[1],
+            syndromes: raw[2],
+        })
+    }
+
+    /// Loads a decoding graph into the full-decode block.
+    ///
+    /// The edge list and the packed growth steps are written from the
+    /// graph's own buffers, in the order the software decoders sweep them,
+    /// with one burst each, and stay resident, so any number of syndromes
+    /// can be decoded against them afterwards.
+    ///
+    /// # Arguments
+    ///
+    /// * `graph` - Decoding graph, with its weights quantized
+    /// * `weighted` - Decode with weighted growth (`WeightedDecoder`)
+    ///   instead of unit growth (`UnionFindDecoder`)
+    ///
+    /// # Returns
+    ///
+    /// Ok(()) on success, or an error if the graph exceeds the block's
+    /// capacity, has no growth steps for weighted mode, or the connection
+    /// is lost.
+    pub fn decoder_load_graph(&mut self, graph: &DecodingGraph, weighted: bool) -> Result<()> {
+        let num_nodes = graph.num_nodes() as u32;
+        let edges = &graph.fast_edges;
+        let capacity = self.decoder_capacity()?;
+        if num_nodes > capacity.nodes || edges.len() > capacity.edges as usize {
+            bail!(
+                "Graph of {} nodes and {} edges exceeds the decode block ({} nodes, {} edges)",
+                num_nodes,
+                edges.len(),
+                capacity.nodes,
+                capacity.edges
+            );
+        }
+        let packed: Vec<u32> = edges.iter().map(|&(u, v)| (v << 16) | u).collect();
+        self.write_burst(ADDR_DEC_EDGES, &packed)?;
+        if weighted {
+            if graph.edge_steps.len() != edges.len().div_ceil(STEPS_PER_WORD) {
+                bail!("Graph weights have not been quantized into growth steps");
+            }
+            self.write_burst(ADDR_DEC_STEPS, &graph.edge_steps)?;
+        }
+        self.write(ADDR_DEC_MODE, weighted as u32)?;
+        self.write_burst(ADDR_DEC_NUM_NODES, &[num_nodes, edges.len() as u32])
+    }
+
+    /// Decodes one syndrome on the full-decode block.
+    ///
+    /// Loads the fired detectors, starts the decode, lets the simulation
+    /// run until the block goes idle, and reads back the correction list,
+    /// the odd-parity roots and the block's own counters.
+    ///
+    /// # Arguments
+    ///
+    /// * `syndrome` - Indices of the fired detectors
+    /// * `max_cycles` - Cycle budget before the decode is treated as hung
+    ///
+    /// # Returns
+    ///
+    /// Ok(AccelDecode) with the corrections and their cost, or an error if
+    /// the decode did not finish, overflowed the correction buffer, or the
+    /// connection is lost.
+    pub fn decoder_run(&mut self, syndrome: &[u32], max_cycles: u32) -> Result<AccelDecode> {
+        if !syndrome.is_empty() {
+            self.write_burst(ADDR_DEC_SYNDROMES, syndrome)?;
+        }
+        self.write(ADDR_DEC_NUM_SYNDROMES, syndrome.len() as u32)?;
+        self.write(ADDR_DEC_CTRL, 1)?;
+        let (_, status) = self.step_until(
+            ADDR_DEC_STATUS,
+            DEC_STATUS_BUSY,
+            DEC_STATUS_BUSY,
+            max_cycles,
+        )?;
+        if status & DEC_STATUS_BUSY != 0 {
+            bail!("Decode did not finish in {} cycles", max_cycles);
+        }
+        if status & DEC_STATUS_OVERFLOW != 0 {
+            bail!("Decode overflowed the correction buffer");
+        }
+
+        let counters = self.read_burst(ADDR_DEC_RESULTS, 5)?;
+        let corrections = if counters[0] == 0 {
+            Vec::new()
+        } else {
+            self.read_burst(ADDR_DEC_CORRECTIONS, counters[0])?
+                .into_iter()
+                .map(|w| (w & 0xFFFF, w >> 16))
+                .collect()
+        };
+        let odd_roots = if counters[4] == 0 {
+            Vec::new()
+        } else {
+            self.read_burst(ADDR_DEC_ODD_ROOTS, counters[4])?
+        };
+        Ok(AccelDecode {
+            corrections,
+            odd_roots,
+            cycles: counters[1],
+            passes: counters[2],
+            finds: counters[3],
+        })
+    }
+
+    /// Reads the simulator's instrumentation counters for this session.
+    ///
+    /// # Arguments
+    ///
+    /// * `reset` - Start a new measurement window after reading
+    ///
+    /// # Returns
+    ///
+    /// Ok(SimStats) with the counters of the current window, or an error if
+    /// the reply is malformed or the connection is lost.
+    pub fn sim_stats(&mut self, reset: bool) -> Result<SimStats> {
+        let mut frame = [0u8; 5];
+        frame[0] = CMD_STATS;
+        let flags = if reset { STATS_FLAG_RESET } else { 0 };
+        frame[1..5].copy_from_slice(&flags.to_le_bytes());
+        self.stream.write_all(&frame)?;
+
+        let mut word = [0u8; 4];
+        self.stream.read_exact(&mut word)?;
+        let count = u32::from_le_bytes(word) as usize;
+        let mut raw = vec![0u8; count * 8];
+        self.stream.read_exact(&mut raw)?;
+        let words: Vec<u64> = raw
+            .chunks_exact(8)
+            .map(|w| u64::from_le_bytes(w.try_into().unwrap()))
+            .collect();
+        match SimStats::from_words(&words) {
+            Some(stats) => Ok(stats),
+            None => bail!(
+                "Stats reply carried {} counters, expected {}",
+                count,
+                STATS_WORDS
+            ),
+        }
+    }
+
+    /// Reads the simulator's latency histograms in the shared export format.
+    ///
+    /// The lines cover the syndrome-to-pulse latency in cycles
+    /// (`sim.pulse`, with the simulator's deadline and misses) and the
+    /// server wall time per command (`sim.command`), in the format of
+    /// `qcu_core::latency`, so they can be printed next to host and
+    /// firmware lines.
+    ///
+    /// # Arguments
+    ///
+    /// * `reset` - Start a new measurement window after reading
+    ///
+    /// # Returns
+    ///
+    /// Ok(String) holding newline-terminated export lines, or an error if
+    /// the reply is malformed or the connection is lost.
+    pub fn latency_report(&mut self, reset: bool) -> Result<String> {
+        let mut frame = [0u8; 5];
+        frame[0] = CMD_LATENCY;
+        let flags = if reset { STATS_FLAG_RESET } else { 0 };
+        frame[1..5].copy_from_slice(&flags.to_le_bytes());
+        self.stream.write_all(&frame)?;
+
+        let mut word = [0u8; 4];
+        self.stream.read_exact(&mut word)?;
+        let len = u32::from_le_bytes(word) as usize;
+        if len > MAX_LATENCY_REPLY {
+            bail!("Latency reply of {} bytes exceeds the limit", len);
+        }
+        let mut text = vec![0u8; len];
+        self.stream.read_exact(&mut text)?;
+        String::from_utf8(text).context("Latency reply is not valid UTF-8")
+    }
+
+    /// Controls the simulator's FST waveform capture.
+    ///
+    /// Captures are written by the simulator (see its `--trace-dir`). A
+    /// typical use arms a `Window` early and sends `Trigger` when an event
+    /// of interest is observed, so only the cycles around it are kept.
+    ///
+    /// # Arguments
+    ///
+    /// * `mode` - Requested capture action
+    /// * `cycles` - Segment length for `Window`, post-trigger cycles for
+    ///   `Trigger`, ignored otherwise
+    ///
+    /// # Returns
+    ///
+    /// Ok(()) if the request was accepted, or an error if the simulator was
+    /// built without the `fst-trace` feature, could not create the trace
+    /// file, rejected the request or the connection is lost.
+    pub fn trace(&mut self, mode: TraceMode, cycles: u32) -> Result<()> {
+        let mut frame = [0u8; 9];
+        frame[0] = CMD_TRACE;
+        frame[1..5].copy_from_slice(&(mode as u32).to_le_bytes());
+        frame[5..9].copy_from_slice(&cycles.to_le_bytes());
+        self.stream.write_all(&frame)?;
+
+        let mut word = [0u8; 4];
+        self.stream.read_exact(&mut word)?;
+        match u32::from_le_bytes(word) {
+            0 => Ok(()),
+            1 => bail!("Simulator was built without waveform tracing (fst-trace)"),
+            2 => bail!("Simulator could not create the trace file"),
+            status => bail!(
+                "Simulator rejected the {:?} trace request ({})",
+                mode,
+                status
+            ),
+        }
+    }
+
+    /// Installs, replaces or removes a register watch.
+    ///
+    /// Watches are sampled over the bus once per round while the simulator
+    /// free-runs (see `run_until_event`), so each active watch costs one
+    /// cycle per round. A `Change` watch takes its reference sample now,
+    /// which costs one cycle.
+    ///
+    /// # Arguments
+    ///
+    /// * `id` - Watch slot (the simulator holds 8)
+    /// * `addr` - Register address
+    /// * `mask` - Bits the condition looks at
+    /// * `mode` - Condition to fire on
+    ///
+    /// # Returns
+    ///
+    /// Ok(()) on success, or an error if the simulator rejected the watch or
+    /// the connection is lost.
+    pub fn subscribe(&mut self, id: u32, addr: u32, mask: u32, mode: WatchMode) -> Result<()> {
+        let mut frame = [0u8; 17];
+        frame[0] = CMD_SUBSCRIBE;
+        frame[1..5].copy_from_slice(&id.to_le_bytes());
+        frame[5..9].copy_from_slice(&addr.to_le_bytes());
+        frame[9..13].copy_from_slice(&mask.to_le_bytes());
+        frame[13..17].copy_from_slice(&(mode as u32).to_le_bytes());
+        self.stream.write_all(&frame)?;
+
+        let mut status = [0u8; 4];
+        self.stream.read_exact(&mut status)?;
+        if u32::from_le_bytes(status) != 0 {
+            bail!("Simulator rejected watch {} on {:#010x}", id, addr);
+        }
+        Ok(())
+    }
+
+    /// Free-runs the simulation until a watch fires or the budget elapses.
+    ///
+    /// The simulator pushes the event as soon as the condition holds, so a
+    /// quiet stretch costs one round trip however long it lasts, and the
+    /// event is stamped with the cycle it was sampled on.
+    ///
+    /// # Arguments
+    ///
+    /// * `max_cycles` - Cycle budget (0 runs until an event)
+    ///
+    /// # Returns
+    ///
+    /// The first event of the run (None if the budget elapsed or no watch
+    /// is active) and the cycles the run consumed, or an error if the
+    /// connection is lost.
+    pub fn run_until_event(&mut self, max_cycles: u32) -> Result<(Option<WatchEvent>, u32)> {
+        self.start_run(max_cycles, false)?;
+        let mut first = None;
+        loop {
+            match self.next_frame()? {
+                RunFrame::Event(event) => {
+                    first = first.or(Some(event));
+                }
+                RunFrame::End { cycles, .. } => return Ok((first, cycles)),
+            }
+        }
+    }
+
+    /// Starts a free run without waiting for its frames.
+    ///
+    /// A streaming run keeps pushing events until the budget elapses or the
+    /// host calls `halt`. Until `next_frame` has returned the end frame, no
+    /// other command may be waited on: its reply would follow the frames.
+    ///
+    /// # Arguments
+    ///
+    /// * `max_cycles` - Cycle budget (0 for none)
+    /// * `stream` - Keep running after the first event
+    ///
+    /// # Returns
+    ///
+    /// Ok(()) on success, or an error if the connection is lost.
+    pub fn start_run(&mut self, max_cycles: u32, stream: bool) -> Result<()> {
+        let mut frame = [0u8; 9];
+        frame[0] = CMD_RUN;
+        frame[1..5].copy_from_slice(&max_cycles.to_le_bytes());
+        let flags = if stream { RUN_FLAG_STREAM } else { 0 };
+        frame[5..9].copy_from_slice(&flags.to_le_bytes());
+        self.stream.write_all(&frame)?;
+        Ok(())
+    }
+
+    /// Asks the simulator to end the current free run.
+    ///
+    /// The run ends at its next command check (every few hundred cycles)
+    /// with its end frame, after which the halt itself is answered with a
+    /// second end frame; without an active run only the latter is sent.
+    /// Keep reading `next_frame` until both have arrived.
+    ///
+    /// # Returns
+    ///
+    /// Ok(()) on success, or an error if the connection is lost.
+    pub fn halt(&mut self) -> Result<()> {
+        self.stream.write_all(&[CMD_HALT])?;
+        Ok(())
+    }
+
+    /// Receives the next frame of a free run.
+    ///
+    /// # Returns
+    ///
+    /// The frame, or an error if the connection is lost or the simulator
+    /// sent a malformed frame.
+    pub fn next_frame(&mut self) -> Result<RunFrame> {
+        let mut raw = [0u8; EVENT_FRAME_BYTES];
+        self.stream.read_exact(&mut raw)?;
+        let word = |i: usize| u32::from_le_bytes(raw[i..i + 4].try_into().unwrap());
+        let cycle = u64::from_le_bytes(raw[8..16].try_into().unwrap());
+        match word(0) {
+            1 => Ok(RunFrame::Event(WatchEvent {
+                watch: word(4),
+                cycle,
+                value: word(16),
+            })),
+            2 => {
+                let reason = match word(4) {
+                    0 => RunEnd::Event,
+                    1 => RunEnd::Budget,
+                    2 => RunEnd::Halted,
+                    _ => RunEnd::Idle,
+                };
+                Ok(RunFrame::End {
+                    reason,
+                    cycle,
+                    cycles: word(16),
+                })
+            }
+            kind => bail!("Malformed event frame (kind {})", kind),
+        }
+    }
+
+    /// Checkpoints the complete state of the simulated SoC.
+    ///
+    /// In-memory slots can be restored by any later session of the same
+    /// simulator process, files by any simulator of the same build.
+    ///
+    /// # Arguments
+    ///
+    /// * `snapshot` - Where to keep the checkpoint
+    ///
+    /// # Returns
+    ///
+    /// The cycle counter at which the checkpoint was taken, or an error if
+    /// the simulator was built without the `snapshot` feature, the file
+    /// could not be written or the connection is lost.
+    pub fn save_snapshot(&mut self, snapshot: &Snapshot) -> Result<u64> {
+        match self.snapshot_request(CMD_SAVE, snapshot)? {
+            (0, cycles) => Ok(cycles),
+            (status, _) => bail!(
+                "Simulator could not save {:?}: {}",
+                snapshot,
+                snapshot_error(status)
+            ),
+        }
+    }
+
+    /// Replaces the state of the simulated SoC with a checkpoint.
+    ///
+    /// The simulator stops any waveform capture and restarts its
+    /// instrumentation counters, since simulated time jumps.
+    ///
+    /// # Arguments
+    ///
+    /// * `snapshot` - Checkpoint to load
+    ///
+    /// # Returns
+    ///
+    /// The restored cycle counter, None if the slot is empty or the file
+    /// does not exist, or an error if the simulator was built without the
+    /// `snapshot` feature, the file could not be read or the connection is
+    /// lost.
+    pub fn restore_snapshot(&mut self, snapshot: &Snapshot) -> Result<Option<u64>> {
+        match self.snapshot_request(CMD_RESTORE, snapshot)? {
+            (0, cycles) => Ok(Some(cycles)),
+            (3, _) => Ok(None),
+            (status, _) => bail!(
+                "Simulator could not restore {:?}: {}",
+                snapshot,
+                snapshot_error(status)
+            ),
+        }
+    }
+
+    /// Sends a CMD_SAVE or CMD_RESTORE request and reads its reply.
+    ///
+    /// # Arguments
+    ///
+    /// * `cmd` - CMD_SAVE or CMD_RESTORE
+    /// * `snapshot` - Checkpoint location
+    ///
+    /// # Returns
+    ///
+    /// The status word and cycle counter, or an error if I/O fails.
+    fn snapshot_request(&mut self, cmd: u8, snapshot: &Snapshot) -> Result<(u32, u64)> {
+        let (slot, path) = match snapshot {
+            Snapshot::Slot(slot) => (*slot, ""),
+            Snapshot::File(path) => (0, path.as_str()),
+        };
+        let mut frame = Vec::with_capacity(9 + path.len());
+        frame.push(cmd);
+        frame.extend_from_slice(&slot.to_le_bytes());
+        frame.extend_from_slice(&(path.len() as u32).to_le_bytes());
+        frame.extend_from_slice(path.as_bytes());
+        self.stream.write_all(&frame)?;
+
+        let mut reply = [0u8; 12];
+        self.stream.read_exact(&mut reply)?;
+        let status = u32::from_le_bytes(reply[0..4].try_into().unwrap());
+        let cycles = u64::from_le_bytes(reply[4..12].try_into().unwrap());
+        Ok((status, cycles))
+    }
+
+    /// Receives the two-word reply of a compound primitive.
+    fn read_pair(&mut self) -> Result<(u32, u32)> {
+        let mut raw = [0u8; 8];
+        self.stream.read_exact(&mut raw)?;
+        Ok((
+            u32::from_le_bytes([raw[0], raw[1], raw[2], raw[3]]),
+            u32::from_le_bytes([raw[4], raw[5], raw[6], raw[7]]),
+        ))
+    }
+
+    /// Executes a batched transaction in a single round trip.
+    ///
+    /// Sends the queued records as one CMD_BATCH frame and waits for the
+    /// combined reply. The simulation runs the records back to back, so
+    /// the timing is identical to issuing them one by one without any
+    /// host round trips in between.
+    ///
+    /// # Arguments
+    ///
+    /// * `txn` - Transaction whose records should be executed
+    ///
+    /// # Returns
+    ///
+    /// Ok(values) with one entry per queued READ, in issue order, or an
+    /// error if the frame is rejected or the connection is lost.
+    pub fn execute(&mut self, txn: &Transaction) -> Result<Vec<u32>> {
+        let mut frame = Vec::with_capacity(5 + txn.payload.len());
+        frame.push(CMD_BATCH);
+        frame.extend_from_slice(&(txn.payload.len() as u32).to_le_bytes());
+        frame.extend_from_slice(&txn.payload);
+        self.stream.write_all(&frame)?;
+
+        let mut word = [0u8; 4];
+        self.stream.read_exact(&mut word)?;
+        let count = u32::from_le_bytes(word) as usize;
+        if count != txn.reads {
+            bail!(
+                "Batch reply carried {} results, expected {}",
+                count,
+                txn.reads
+            );
+        }
+
+        let mut raw = vec![0u8; count * 4];
+        self.stream.read_exact(&mut raw)?;
+        Ok(raw
+            .chunks_exact(4)
+            .map(|w| u32::from_le_bytes([w[0], w[1], w[2], w[3]]))
+            .collect())
+    }
+}
+
+/// Describes a CMD_SAVE/CMD_RESTORE failure status.
+///
+/// # Arguments
+///
+/// * `status` - Nonzero status word from the simulator
+///
+/// # Returns
+///
+/// A human-readable reason.
+fn snapshot_error(status: u32) -> &'static str {
+    match status {
+        1 => "built without checkpoint support (snapshot feature)",
+        2 => "snapshot file I/O failed",
+        3 => "no such checkpoint",
+        4 => "slot out of range",
+        5 => "file is not a snapshot",
+        _ => "unknown status",
+    }
+}
+
+/// Runs the hardware-in-the-loop demonstration.
+///
+/// Connects to the Verilator simulation, initializes the physics engine,
+/// subscribes to the grid's error flag, and enters a control loop that: (1)
+/// lets the hardware simulation free-run until it pushes an error event or
+/// the frame budget elapses, (2) has the simulation measure and correct the
+/// detected errors, (3) updates the event history log, and (4) renders a
+/// real-time dashboard showing qubit states. Both feedback steps run inside
+/// the simulator, so the host is not on the detection-to-correction path,
+/// and a quiet frame costs a single round trip. The loop runs at
+/// approximately 30 FPS for responsive visualization. The frame budget is
+/// `FRAME_CYCLES` cycles, pulse
+/// strength is 468 (Rabi frequency), and pulse duration is 110 cycles to
+/// ensure full 180-degree rotations (π radians) for error corrections.
+///
+/// With a trace window the simulator keeps a rolling waveform of the last
+/// `trace_window` to `2 * trace_window` cycles. The first time an error is
+/// detected immediately after a correction, i.e. the correction did not
+/// take, the capture is triggered and stops `trace_window` cycles later,
+/// leaving a waveform around the failed correction. With a trace length
+/// instead, every cycle from the start of the loop is dumped into a single
+/// file and the capture is stopped once that many cycles have run.
+///
+/// With a checkpoint the warm-up (physics enable, Rabi strength and
+/// `WARMUP_CYCLES` of settling) is only simulated when the checkpoint does
+/// not exist yet; it is then saved, and later runs restore it and start
+/// from the warmed-up state.
+///
+/// # Arguments
+///
+/// * `addr` - Simulation server address (see `HardwareBridge::connect`)
+/// * `trace_window` - Optional waveform window in cycles (see
+///   `HardwareBridge::trace`)
+/// * `trace_cycles` - Optional length in cycles of a continuous capture
+/// * `checkpoint` - Optional warm-up checkpoint (see `Snapshot::parse`)
+///
+/// # Returns
+///
+/// Ok(()) on success, or an error if connection or I/O operations fail.
+pub fn run_hil_demo(
+    addr: &str,
+    trace_window: Option<u32>,
+    trace_cycles: Option<u64>,
+    checkpoint: Option<&str>,
+) -> Result<()> {
+    // Cycles the physics engine settles for after being enabled.
+    //
+    // Part of the warm-up recorded in a checkpoint; lets the first noise
+    // events develop before the control loop starts.
+    const WARMUP_CYCLES: u32 = 1000;
+
+    // Cycles the simulator free-runs per frame when no error appears.
+    //
+    // Bounds how long the dashboard waits for an event before refreshing.
+    const FRAME_CYCLES: u32 = 1000;
+
+    // ANSI escape code for green text color.
+    //
+    // Used to display stable qubit states (no errors detected) in the
+    // real-time dashboard. Green indicates coherent quantum states.
+    const GREEN: &str = "\x1b[32m";
+
+    // ANSI escape code for red text color.
+    //
+    // Used to display error states (qubits with detected errors) in the
+    // real-time dashboard. Red indicates qubits that require correction.
+    const RED: &str = "\x1b[31m";
+
+    // ANSI escape code for yellow text color.
+    //
+    // Used to display correction operations in progress in the event log.
+    // Yellow indicates that correction pulses are being applied.
+    const YELLOW: &str = "\x1b[33m";
+
+    // ANSI escape code to reset text formatting.
+    //
+    // Restores default terminal colors and formatting after applying color
+    // codes. Must be used after each colored text segment to prevent color
+    // bleeding into subsequent output.
+    const RESET: &str = "\x1b[0m";
+
+    // ANSI escape code to clear the terminal screen and move cursor to home.
+    //
+    // Clears all terminal content and positions the cursor at the top-left
+    // corner. Used to refresh the dashboard display on each update cycle,
+    // creating a real-time updating visualization.
+    const CLEAR: &str = "\x1b[2J\x1b[1;1H";
+
+    println!("Connecting to Quantum Hardware (Verilator)...");
+    let mut hw = HardwareBridge::connect(addr)?;
+
+    let dim = hw.grid_dim()? as usize;
+    let qubits = dim * dim;
+    let words = qubits.div_ceil(32);
+
+    let checkpoint = checkpoint.map(Snapshot::parse).transpose()?;
+    let restored = match &checkpoint {
+        Some(snapshot) => hw.restore_snapshot(snapshot)?,
+        None => None,
+    };
+
+    if let Some(cycles) = restored {
+        println!("Restored warm-up checkpoint at cycle {}.", cycles);
+    } else {
+        let mut setup = Transaction::new();
+        setup.write(ADDR_ENABLE, 1).write(ADDR_RABI, 468);
+        hw.execute(&setup)?;
+        if let Some(snapshot) = &checkpoint {
+            hw.step(WARMUP_CYCLES)?;
+            let cycles = hw.save_snapshot(snapshot)?;
+            println!("Saved warm-up checkpoint at cycle {}.", cycles);
+        }
+    }
+
+    let mut total_cycles: u64 = 0;
+    let mut history: Vec<String> = Vec::new();
+    let mut prev_stats = hw.sim_stats(false)?;
+
+    if let Some(window) = trace_window {
+        hw.trace(TraceMode::Window, window)?;
+    }
+    let mut trace_armed = trace_window.is_some();
+    if trace_cycles.is_some() {
+        hw.trace(TraceMode::Continuous, 0)?;
+    }
+    let mut trace_running = trace_cycles.is_some();
+    let mut corrected = false;
+    hw.subscribe(0, ADDR_ERR_ANY, 1, WatchMode::Set)?;
+
+    loop {
+        let last_cycles = total_cycles;
+        let frame_start = Instant::now();
+        let (event, waited) = hw.run_until_event(FRAME_CYCLES)?;
+        total_cycles += waited as u64;
+        let detected = event.is_some();
+
+        let mut syndrome = vec![0u32; words];
+        if detected {
+            let (spent, measured) = hw.measure_correct(
+                ADDR_ERRORS,
+                ADDR_PULSE_STAGE,
+                ADDR_PULSE_GO,
+                110,
+                words as u32,
+            )?;
+            total_cycles += spent as u64;
+            syndrome = measured;
+        }
+        let has_error = syndrome.iter().any(|&w| w != 0);
+        if trace_armed && corrected && detected && waited <= 1 {
+            hw.trace(TraceMode::Trigger, trace_window.unwrap_or(0))?;
+            trace_armed = false;
+            history.push(format!(
+                "Cycle {:8} | Correction failed, waveform capture triggered",
+                total_cycles
+            ));
+        }
+        if trace_running && total_cycles >= trace_cycles.unwrap_or(0) {
+            hw.trace(TraceMode::Off, 0)?;
+            trace_running = false;
+            history.push(format!(
+                "Cycle {:8} | Waveform capture stopped",
+                total_cycles
+            ));
+        }
+        corrected = has_error;
+        let bridge_ns = frame_start.elapsed().as_nanos() as u64;
+        let stats = hw.sim_stats(false)?;
+        let server_ns = stats.server_ns().saturating_sub(prev_stats.server_ns());
+        let frame_cycles = stats.cycles.saturating_sub(prev_stats.cycles);
+        prev_stats = stats;
+
+        let correction_str = if has_error {
+            format!("{}CORRECTING{}", YELLOW, RESET)
+        } else {
+            format!("{}STABLE    {}", GREEN, RESET)
+        };
+
+        if has_error || total_cycles / 5000 != last_cycles / 5000 {
+            let log_entry = format!(
+                "Cycle {:8} | Errors: {} | Status: {}",
+                total_cycles,
+                format_syndrome(&syndrome, qubits),
+                correction_str
+            );
+            history.push(log_entry);
+            if history.len() > 10 {
+                history.remove(0);
+            }
+        }
+
+        print!("{}", CLEAR);
+        println!("========================================");
+        println!("   QUANTUM CONTROL UNIT - LIVE STATUS   ");
+        println!("========================================");
+        println!("Total Cycles: {}", total_cycles);
+        println!("----------------------------------------");
+        println!("Physical Qubit Grid ({}x{}):", dim, dim);
+        println!();
+
+        // Grids wider than a terminal row of boxed cells use one character
+        // per qubit.
+        let compact = dim > 12;
+        for row in 0..dim {
+            print!("   ");
+            for col in 0..dim {
+                let idx = row * dim + col;
+                let is_error = (syndrome[idx / 32] >> (idx % 32)) & 1 == 1;
+
+                match (is_error, compact) {
+                    (true, false) => print!("{}[ X ]{} ", RED, RESET),
+                    (false, false) => print!("{}[ O ]{} ", GREEN, RESET),
+                    (true, true) => print!("{}X{}", RED, RESET),
+                    (false, true) => print!("{}O{}", GREEN, RESET),
+                }
+            }
+            println!("{}", if compact { "" } else { "\n" });
+        }
+        println!("   [O] = Coherent  [X] = Error/Decay");
+        println!("----------------------------------------");
+        println!("Simulator:");
+        println!(
+            "   {} cycles ({} evaluated, {} fast-forwarded){}",
+            stats.cycles,
+            stats.ticks,
+            stats.skipped,
+            if stats.eval_ns != 0 {
+                format!(
+                    ", eval {:.1}% of wall",
+                    100.0 * stats.eval_ns as f64 / stats.wall_ns.max(1) as f64
+                )
+            } else {
+                String::new()
+            }
+        );
+        if stats.lat_count != 0 {
+            println!(
+                "   Syndrome -> pulse: {} samples, mean {:.1}, min {}, p50 < {}, p99 < {}, max {} cycles",
+                stats.lat_count,
+                stats.lat_sum as f64 / stats.lat_count as f64,
+                stats.lat_min,
+                stats.latency_quantile(0.5),
+                stats.latency_quantile(0.99),
+                stats.lat_max
+            );
+        }
+        if stats.deadline_cycles != 0 {
+            println!(
+                "   Deadline {} cycles: {} misses",
+                stats.deadline_cycles, stats.deadline_misses
+            );
+        }
+        if stats.pace_hz != 0 {
+            let queued: u64 = stats.commands.iter().map(|c| c.count).sum();
+            println!(
+                "   Real time: {:.3} MHz target, lag max {:.1} us ({} late checks), backlog max {}, queue wait mean {:.1} us, max {:.1} us",
+                stats.pace_hz as f64 / 1e6,
+                stats.lag_max_ns as f64 / 1e3,
+                stats.late_checks,
+                stats.queue_max,
+                stats.queue_wait_ns as f64 / queued.max(1) as f64 / 1e3,
+                stats.queue_wait_max_ns as f64 / 1e3
+            );
+        }
+        println!(
+            "   Last frame: {} cycles, {:.1} us in bridge calls, {:.1} us in server",
+            frame_cycles,
+            bridge_ns as f64 / 1e3,
+            server_ns as f64 / 1e3
+        );
+        let per_command: Vec<String> = STATS_OPCODE_NAMES
+            .iter()
+            .zip(&stats.commands)
+            .filter(|(_, c)| c.count != 0)
+            .map(|(name, c)| {
+                format!(
+                    "{} {:.1}us/{:.0}cyc",
+                    name,
+                    c.wall_ns as f64 / 1e3 / c.count as f64,
+                    c.cycles as f64 / c.count as f64
+                )
+            })
+            .collect();
+        println!("   Per command: {}", per_command.join(", "));
+        println!("----------------------------------------");
+        println!("Event Log:");
+        for entry in &history {
+            println!("   {}", entry);
+        }
+        println!("========================================");
+
+        thread::sleep(Duration::from_millis(30));
+    }
+}
+
+/// Formats a multi-word syndrome for the event log.
+///
+/// Grids of up to 32 qubits are shown as a binary mask with qubit 0 as the
+/// rightmost bit, matching the register layout; larger grids are shown as
+/// hexadecimal words, most significant word first.
+///
+/// # Arguments
+///
+/// * `syndrome` - Syndrome words as read from the error bank
+/// * `qubits` - Number of qubits in the grid
+///
+/// # Returns
+///
+/// The formatted syndrome string.
+fn format_syndrome(syndrome: &[u32], qubits: usize) -> String {
+    if qubits <= 32 {
+        return format!("{:0width$b}", syndrome[0], width = qubits);
+    }
+    syndrome
+        .iter()
+        .rev()
+        .map(|w| format!("{:08x}", w))
+        .collect::<Vec<_>>()
+        .join("_")
+}
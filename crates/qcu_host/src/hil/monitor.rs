@@ -0,0 +1,95 @@
+//! Event-driven register monitor for the simulated SoC.
+//!
+//! Subscribes to a condition on one register and lets the simulator
+//! free-run in streaming mode, printing every event it pushes with its cycle
+//! stamp. The whole run costs one request; events arrive as the simulation
+//! produces them instead of being found by polling.
+
+use super::{HardwareBridge, RunFrame, WatchMode};
+use anyhow::Result;
+use std::time::Instant;
+
+/// Runs the register monitor against a simulation server.
+///
+/// # Arguments
+///
+/// * `addr` - Simulation server address (see `HardwareBridge::connect`)
+/// * `reg` - Register address to watch
+/// * `mask` - Bits of the register the condition looks at
+/// * `mode` - Condition to fire on
+/// * `cycles` - Cycle budget of the run (0 for none)
+/// * `max_events` - Optional number of events after which the run is halted
+///
+/// # Returns
+///
+/// Ok(()) on success, or an error if the watch is rejected or I/O fails.
+pub fn run_monitor(
+    addr: &str,
+    reg: u32,
+    mask: u32,
+    mode: WatchMode,
+    cycles: u32,
+    max_events: Option<usize>,
+) -> Result<()> {
+    let mut hw = HardwareBridge::connect(addr)?;
+    hw.subscribe(0, reg, mask, mode)?;
+    println!(
+        "Watching {:#010x} & {:#010x} ({:?}) for {} cycles...",
+        reg,
+        mask,
+        mode,
+        if cycles == 0 {
+            "unlimited".to_string()
+        } else {
+            cycles.to_string()
+        }
+    );
+
+    let start = Instant::now();
+    hw.start_run(cycles, true)?;
+    let mut events = 0usize;
+    let mut halted = false;
+    let mut prev_cycle = None;
+    loop {
+        match hw.next_frame()? {
+            RunFrame::Event(event) => {
+                events += 1;
+                let gap = prev_cycle.map(|c| event.cycle - c);
+                prev_cycle = Some(event.cycle);
+                println!(
+                    "Cycle {:10} | Value {:#010x}{}",
+                    event.cycle,
+                    event.value,
+                    gap.map(|g| format!(" | +{} cycles", g)).unwrap_or_default()
+                );
+                if !halted && max_events.is_some_and(|n| events >= n) {
+                    hw.halt()?;
+                    halted = true;
+                }
+            }
+            RunFrame::End {
+                reason,
+                cycle,
+                cycles,
+            } => {
+                println!(
+                    "Run ended ({:?}) at cycle {}: {} events in {} cycles, {:.1} ms wall",
+                    reason,
+                    cycle,
+                    events,
+                    cycles,
+                    start.elapsed().as_secs_f64() * 1e3
+                );
+                break;
+            }
+        }
+    }
+
+    // The halt is executed after the run it ended and answered with an end
+    // frame of its own.
+    if halted && !matches!(hw.next_frame()?, RunFrame::End { .. }) {
+        anyhow::bail!("Unexpected event after the run ended");
+    }
+    hw.subscribe(0, reg, 0, WatchMode::Off)?;
+    Ok(())
+}
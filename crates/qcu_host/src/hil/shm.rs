@@ -0,0 +1,313 @@
+//! Shared-memory transport to a co-located Verilator simulation.
+//!
+//! Maps the region created by the simulator's `--shm <name>` mode and
+//! exposes it as a byte stream implementing `Read` and `Write`, so the
+//! `HardwareBridge` protocol code is identical for TCP and shared memory.
+//! The region holds two single-producer single-consumer byte rings (host to
+//! simulator and back) whose indices are busy-polled, avoiding syscalls on
+//! the register access hot path.
+//!
+//! The layout mirrors `crates/qcu_hw/src/sim/shm_channel.h` and must be kept
+//! in sync with it.
+
+use anyhow::{Context, Result, bail};
+use std::fs::OpenOptions;
+use std::io::{self, Read, Write};
+use std::os::fd::AsRawFd;
+use std::sync::atomic::{AtomicU32, AtomicU64, Ordering};
+use std::time::{Duration, Instant};
+
+/// Magic value written by the simulator once the region is initialized ("QCUS").
+const SHM_MAGIC: u32 = 0x5355_4351;
+
+/// Layout version understood by this client.
+const SHM_VERSION: u32 = 2;
+
+/// Capacity of each ring in bytes.
+const SHM_RING_BYTES: usize = 1 << 16;
+
+/// Busy-poll iterations before yielding while waiting on a ring.
+const SHM_SPIN_LIMIT: u32 = 4096;
+
+/// Idle polls between two probes of the simulator's pid (a power of two).
+const SHM_PROBE_INTERVAL: u32 = 1 << 16;
+
+/// How long to wait for the simulator to finish initializing the region.
+const ATTACH_TIMEOUT: Duration = Duration::from_secs(5);
+
+/// Region header shared by both sides.
+#[repr(C)]
+struct ShmHeader {
+    magic: AtomicU32,
+    version: u32,
+    ring_bytes: u32,
+    client_attached: AtomicU32,
+    client_pid: AtomicU32,
+    server_pid: AtomicU32,
+    _pad: [u8; 40],
+}
+
+/// Single-producer single-consumer byte ring.
+///
+/// Both indices are free-running byte counters, each on its own cache line.
+#[repr(C)]
+struct ShmRing {
+    head: AtomicU64,
+    _pad0: [u8; 56],
+    tail: AtomicU64,
+    _pad1: [u8; 56],
+    data: [u8; SHM_RING_BYTES],
+}
+
+/// Complete shared-memory region: header, command ring, response ring.
+#[repr(C)]
+struct ShmRegion {
+    hdr: ShmHeader,
+    cmd: ShmRing,
+    resp: ShmRing,
+}
+
+/// Mapping of the region that only unmaps it when dropped.
+///
+/// Holds the region while `ShmLink::open` validates and claims it, so a
+/// host that is refused leaves the attached host's claim untouched.
+struct Mapping(*mut ShmRegion);
+
+// The region is process-shared memory accessed only through atomics and
+// the SPSC protocol, so moving the handle to another thread is sound.
+unsafe impl Send for Mapping {}
+
+impl Drop for Mapping {
+    /// Unmaps the region.
+    fn drop(&mut self) {
+        unsafe {
+            libc::munmap(
+                self.0 as *mut libc::c_void,
+                std::mem::size_of::<ShmRegion>(),
+            );
+        }
+    }
+}
+
+/// Host side of the shared-memory transport.
+///
+/// Produces into the command ring and consumes from the response ring.
+/// Dropping the link marks the host as detached, which ends the session on
+/// the simulator side.
+pub struct ShmLink {
+    map: Mapping,
+}
+
+impl ShmLink {
+    /// Attaches to the region `/dev/shm/<name>` created by the simulator.
+    ///
+    /// Waits briefly for the simulator to publish the magic value, checks
+    /// the layout version and ring size, and then claims the region by
+    /// switching `client_attached` from 0 to 1, so only one host can attach.
+    /// The host pid is published right after, so the simulator can end the
+    /// session if this process dies without detaching.
+    ///
+    /// # Arguments
+    ///
+    /// * `name` - Region name passed to the simulator's `--shm` option
+    ///
+    /// # Returns
+    ///
+    /// Ok(ShmLink) once attached, or an error if the region is missing or
+    /// incompatible.
+    pub fn open(name: &str) -> Result<Self> {
+        let path = format!("/dev/shm/{}", name);
+        let file = OpenOptions::new()
+            .read(true)
+            .write(true)
+            .open(&path)
+            .with_context(|| format!("Failed to open shared-memory region {}", path))?;
+
+        let size = std::mem::size_of::<ShmRegion>();
+        if (file.metadata()?.len() as usize) < size {
+            bail!("Shared-memory region {} is too small", path);
+        }
+
+        let mem = unsafe {
+            libc::mmap(
+                std::ptr::null_mut(),
+                size,
+                libc::PROT_READ | libc::PROT_WRITE,
+                libc::MAP_SHARED,
+                file.as_raw_fd(),
+                0,
+            )
+        };
+        if mem == libc::MAP_FAILED {
+            return Err(io::Error::last_os_error()).context("Failed to map shared-memory region");
+        }
+
+        let map = Mapping(mem as *mut ShmRegion);
+
+        let hdr = unsafe { &(*map.0).hdr };
+        let start = Instant::now();
+        while hdr.magic.load(Ordering::Acquire) != SHM_MAGIC {
+            if start.elapsed() > ATTACH_TIMEOUT {
+                bail!("Shared-memory region {} was never initialized", path);
+            }
+            std::thread::sleep(Duration::from_millis(1));
+        }
+        if hdr.version != SHM_VERSION || hdr.ring_bytes as usize != SHM_RING_BYTES {
+            bail!(
+                "Shared-memory layout mismatch (version {}, ring {} bytes)",
+                hdr.version,
+                hdr.ring_bytes
+            );
+        }
+        if hdr
+            .client_attached
+            .compare_exchange(0, 1, Ordering::AcqRel, Ordering::Acquire)
+            .is_err()
+        {
+            bail!("Another host controller is already attached to {}", path);
+        }
+        hdr.client_pid.store(std::process::id(), Ordering::Release);
+
+        Ok(Self { map })
+    }
+
+    /// Returns the shared header.
+    fn header(&self) -> &ShmHeader {
+        unsafe { &(*self.map.0).hdr }
+    }
+
+    /// Returns a raw pointer to one of the two rings.
+    fn ring(&self, resp: bool) -> *mut ShmRing {
+        unsafe {
+            if resp {
+                &raw mut (*self.map.0).resp
+            } else {
+                &raw mut (*self.map.0).cmd
+            }
+        }
+    }
+
+    /// Spins on the CPU, yielding after `SHM_SPIN_LIMIT` consecutive idle
+    /// polls, and checks that the simulator is still serving the region.
+    ///
+    /// The simulator clears the magic value when it closes the region; every
+    /// `SHM_PROBE_INTERVAL` idle polls its pid is probed as well, so a
+    /// simulator that was killed does not leave the host waiting forever.
+    ///
+    /// # Arguments
+    ///
+    /// * `spins` - Consecutive idle polls so far (updated in place)
+    ///
+    /// # Returns
+    ///
+    /// Ok to keep waiting, or `io::ErrorKind::BrokenPipe` once the
+    /// simulator has gone away.
+    fn backoff(&self, spins: &mut u32) -> io::Result<()> {
+        *spins = spins.wrapping_add(1);
+        if *spins < SHM_SPIN_LIMIT {
+            std::hint::spin_loop();
+            return Ok(());
+        }
+        let hdr = self.header();
+        let mut alive = hdr.magic.load(Ordering::Acquire) == SHM_MAGIC;
+        if alive && *spins % SHM_PROBE_INTERVAL == 0 {
+            let pid = hdr.server_pid.load(Ordering::Relaxed) as libc::pid_t;
+            alive = pid <= 0
+                || unsafe { libc::kill(pid, 0) } == 0
+                || io::Error::last_os_error().raw_os_error() != Some(libc::ESRCH);
+        }
+        if !alive {
+            return Err(io::Error::new(
+                io::ErrorKind::BrokenPipe,
+                "simulator closed the shared-memory region",
+            ));
+        }
+        std::thread::yield_now();
+        Ok(())
+    }
+}
+
+impl Read for ShmLink {
+    /// Reads whatever is available from the response ring, blocking until
+    /// at least one byte has arrived or the simulator has gone away.
+    fn read(&mut self, buf: &mut [u8]) -> io::Result<usize> {
+        if buf.is_empty() {
+            return Ok(0);
+        }
+        let ring = self.ring(true);
+        let (head_ref, tail_ref) = unsafe { (&(*ring).head, &(*ring).tail) };
+        let tail = tail_ref.load(Ordering::Relaxed);
+        let mut spins = 0;
+
+        let avail = loop {
+            let head = head_ref.load(Ordering::Acquire);
+            let avail = head.wrapping_sub(tail) as usize;
+            if avail > 0 {
+                break avail;
+            }
+            self.backoff(&mut spins)?;
+        };
+
+        let n = avail.min(buf.len());
+        let off = (tail as usize) & (SHM_RING_BYTES - 1);
+        let first = (SHM_RING_BYTES - off).min(n);
+        unsafe {
+            let data = (&raw const (*ring).data) as *const u8;
+            std::ptr::copy_nonoverlapping(data.add(off), buf.as_mut_ptr(), first);
+            std::ptr::copy_nonoverlapping(data, buf.as_mut_ptr().add(first), n - first);
+        }
+        tail_ref.store(tail.wrapping_add(n as u64), Ordering::Release);
+        Ok(n)
+    }
+}
+
+impl Write for ShmLink {
+    /// Writes as much as fits into the command ring, blocking until at
+    /// least one byte of space is free or the simulator has gone away.
+    fn write(&mut self, buf: &[u8]) -> io::Result<usize> {
+        if buf.is_empty() {
+            return Ok(0);
+        }
+        let ring = self.ring(false);
+        let (head_ref, tail_ref) = unsafe { (&(*ring).head, &(*ring).tail) };
+        let head = head_ref.load(Ordering::Relaxed);
+        let mut spins = 0;
+
+        let space = loop {
+            let tail = tail_ref.load(Ordering::Acquire);
+            let space = SHM_RING_BYTES - head.wrapping_sub(tail) as usize;
+            if space > 0 {
+                break space;
+            }
+            self.backoff(&mut spins)?;
+        };
+
+        let n = space.min(buf.len());
+        let off = (head as usize) & (SHM_RING_BYTES - 1);
+        let first = (SHM_RING_BYTES - off).min(n);
+        unsafe {
+            let data = (&raw mut (*ring).data) as *mut u8;
+            std::ptr::copy_nonoverlapping(buf.as_ptr(), data.add(off), first);
+            std::ptr::copy_nonoverlapping(buf.as_ptr().add(first), data, n - first);
+        }
+        head_ref.store(head.wrapping_add(n as u64), Ordering::Release);
+        Ok(n)
+    }
+
+    /// Data is visible to the simulator as soon as `write` returns.
+    fn flush(&mut self) -> io::Result<()> {
+        Ok(())
+    }
+}
+
+impl Drop for ShmLink {
+    /// Detaches from the region; the mapping is unmapped afterwards.
+    ///
+    /// Clearing `client_attached` tells the simulator the session is over;
+    /// the simulator owns the region and unlinks it. The pid is cleared
+    /// first so it is never probed on behalf of the next host.
+    fn drop(&mut self) {
+        self.header().client_pid.store(0, Ordering::Relaxed);
+        self.header().client_attached.store(0, Ordering::Release);
+    }
+}
@@ -0,0 +1,198 @@
+//! Transport benchmark of the simulation server.
+//!
+//! Measures what a host pays per simulator request over whichever transport
+//! it connects with: single reads and writes, batched frames of reads, and
+//! STEP requests with the physics engine running, whose simulated cycles
+//! per second show how much of the core's speed survives the round trips.
+//! Every request is timed individually, so each operation is reported with
+//! latency percentiles next to its throughput. With `json` every result is
+//! printed as one JSON object per line; `scripts/benchmark_sim.py` combines
+//! them with the simulator's own `--bench` figures across grid sizes, model
+//! thread counts, build profiles and transports.
+
+use super::{ADDR_ENABLE, ADDR_GRID_DIM, ADDR_RABI, HardwareBridge, Transaction};
+use anyhow::Result;
+use std::time::Instant;
+
+/// Cycles simulated by one STEP request.
+const STEP_CYCLES: u32 = 1000;
+
+/// READ sub-commands in one batched frame.
+const BATCH_READS: usize = 64;
+
+/// Rabi frequency written before the physics engine is enabled (as in the
+/// HIL demo).
+const BENCH_RABI: u32 = 468;
+
+/// Timed requests of one benchmarked operation.
+struct OpResult {
+    /// Operation name used in the report.
+    op: &'static str,
+
+    /// Wall time of every request in nanoseconds, sorted.
+    ns: Vec<u64>,
+
+    /// Bus transactions or simulated cycles one request performs.
+    units: u64,
+
+    /// What `units` counts ("ops" or "cycles").
+    unit: &'static str,
+}
+
+impl OpResult {
+    /// Times `requests` calls of a request.
+    ///
+    /// # Arguments
+    ///
+    /// * `op` - Operation name
+    /// * `units` - Transactions or cycles one request performs
+    /// * `unit` - What `units` counts
+    /// * `requests` - Number of requests to time
+    /// * `request` - Issues one request
+    ///
+    /// # Returns
+    ///
+    /// The sorted request times, or the first request error.
+    fn measure(
+        op: &'static str,
+        units: u64,
+        unit: &'static str,
+        requests: usize,
+        mut request: impl FnMut() -> Result<()>,
+    ) -> Result<Self> {
+        let mut ns = Vec::with_capacity(requests);
+        for _ in 0..requests {
+            let start = Instant::now();
+            request()?;
+            ns.push(start.elapsed().as_nanos() as u64);
+        }
+        ns.sort_unstable();
+        Ok(Self {
+            op,
+            ns,
+            units,
+            unit,
+        })
+    }
+
+    /// Request time at quantile q (nearest rank).
+    fn quantile(&self, q: f64) -> u64 {
+        if self.ns.is_empty() {
+            return 0;
+        }
+        let rank = ((q * self.ns.len() as f64) as usize).min(self.ns.len() - 1);
+        self.ns[rank]
+    }
+
+    /// Units performed per second over all requests.
+    fn rate(&self) -> f64 {
+        let total: u64 = self.ns.iter().sum();
+        (self.ns.len() as u64 * self.units) as f64 * 1e9 / total.max(1) as f64
+    }
+}
+
+/// Names the transport an address selects, as `HardwareBridge::connect`
+/// interprets it.
+fn transport_name(addr: &str) -> &'static str {
+    if addr.starts_with("shm://") {
+        "shm"
+    } else if addr.starts_with("unix:") {
+        "unix"
+    } else {
+        "tcp"
+    }
+}
+
+/// Runs the transport benchmark against a simulation server.
+///
+/// # Arguments
+///
+/// * `addr` - Simulation server address (see `HardwareBridge::connect`)
+/// * `requests` - Requests timed per operation
+/// * `json` - Print JSON lines instead of a table
+///
+/// # Returns
+///
+/// Ok(()) on success, or an error if a request fails.
+pub fn run_sim_bench(addr: &str, requests: usize, json: bool) -> Result<()> {
+    let mut hw = HardwareBridge::connect(addr)?;
+    let transport = transport_name(addr);
+    let grid_dim = hw.grid_dim()?;
+
+    let mut batch = Transaction::new();
+    for _ in 0..BATCH_READS {
+        batch.read(ADDR_GRID_DIM);
+    }
+
+    let mut results = Vec::new();
+    results.push(OpResult::measure("read", 1, "ops", requests, || {
+        hw.read(ADDR_GRID_DIM).map(drop)
+    })?);
+    results.push(OpResult::measure("write", 1, "ops", requests, || {
+        hw.write(ADDR_RABI, BENCH_RABI)
+    })?);
+    results.push(OpResult::measure(
+        "batch",
+        BATCH_READS as u64,
+        "ops",
+        requests,
+        || hw.execute(&batch).map(drop),
+    )?);
+    hw.write(ADDR_ENABLE, 1)?;
+    results.push(OpResult::measure(
+        "step",
+        STEP_CYCLES as u64,
+        "cycles",
+        requests,
+        || hw.step(STEP_CYCLES),
+    )?);
+    hw.write(ADDR_ENABLE, 0)?;
+
+    if !json {
+        println!(
+            "Transport {} ({}x{} grid), {} requests per operation:",
+            transport, grid_dim, grid_dim, requests
+        );
+        println!(
+            "   {:<6} {:>17} {:>10} {:>10} {:>10} {:>10}",
+            "op", "rate", "p50 us", "p90 us", "p99 us", "max us"
+        );
+    }
+    for r in &results {
+        let (p50, p90, p99, p999, max) = (
+            r.quantile(0.5),
+            r.quantile(0.9),
+            r.quantile(0.99),
+            r.quantile(0.999),
+            r.quantile(1.0),
+        );
+        if json {
+            println!(
+                "{{\"bench\":\"transport\",\"transport\":\"{}\",\"op\":\"{}\",\"grid_dim\":{},\"count\":{},\"unit\":\"{}\",\"rate\":{:.1},\"p50_ns\":{},\"p90_ns\":{},\"p99_ns\":{},\"p999_ns\":{},\"max_ns\":{}}}",
+                transport,
+                r.op,
+                grid_dim,
+                r.ns.len() as u64 * r.units,
+                r.unit,
+                r.rate(),
+                p50,
+                p90,
+                p99,
+                p999,
+                max
+            );
+        } else {
+            println!(
+                "   {:<6} {:>8.0} {:<8} {:>10.2} {:>10.2} {:>10.2} {:>10.2}",
+                r.op,
+                r.rate(),
+                format!("{}/s", r.unit),
+                p50 as f64 / 1e3,
+                p90 as f64 / 1e3,
+                p99 as f64 / 1e3,
+                max as f64 / 1e3
+            );
+        }
+    }
+    Ok(())
+}
@@ -18,7 +18,7 @@ mod generator;
 
 /// Hardware-in-the-loop interface for real-time quantum hardware simulation.
 ///
-/// Provides TCP-based communication with Verilator simulations for demonstrating
+/// Provides TCP or shared-memory communication with Verilator simulations for demonstrating
 /// closed-loop error correction. Enables real-time monitoring and control of
 /// qubit states, error detection, and correction operations.
 mod hil;
@@ -44,8 +44,17 @@ mod stream;
 /// for performance characterization.
 mod throughput;
 
+/// Lock-free bounded multi-producer multi-consumer work queue.
+///
+/// Host-side counterpart of the firmware's SPMC queue, shared by producers
+/// and consumers on any number of threads. Multiplexes the syndromes of
+/// several simulator sessions into one decoder pool.
+mod work_queue;
+
 use anyhow::Result;
 use clap::{Parser, Subcommand};
+use qcu_io::parser;
+use std::time::Instant;
 
 /// Command-line interface structure.
 ///
@@ -53,7 +62,8 @@ use clap::{Parser, Subcommand};
 /// handler. Uses clap for argument parsing and validation.
 #[derive(Parser)]
 struct Cli {
-    /// Subcommand to execute (gen, run, stream, or hil).
+    /// Subcommand to execute (gen, compile-graph, run, stream, hil,
+    /// hil-decode, fanout, accel-bench, decode-bench, monitor or sim-bench).
     #[command(subcommand)]
     command: Commands,
 }
@@ -95,6 +105,21 @@ enum Commands {
         inject_failures: bool,
     },
 
+    /// Compile a decoding graph into a binary graph image.
+    ///
+    /// Parses a .dem file once and writes its edges, weights, observables and
+    /// CSR adjacency as an image that loads without parsing. Every command
+    /// taking `--dem` accepts the image too, and the firmware embeds it.
+    CompileGraph {
+        /// Path to the decoding graph (.dem file).
+        #[arg(short, long)]
+        dem: String,
+
+        /// Output path for the graph image.
+        #[arg(short, long, default_value = "bench.qcg")]
+        out: String,
+    },
+
     /// Run a throughput benchmark on decoding performance.
     ///
     /// Loads a decoding graph and syndrome data, then measures the time
@@ -112,6 +137,19 @@ enum Commands {
         /// Override the number of detectors (defaults to graph node count).
         #[arg(short, long)]
         detectors: Option<usize>,
+
+        /// Read the shots in fixed-size batches instead of mapping the file
+        /// (bounded memory for files larger than RAM).
+        #[arg(long)]
+        streaming: bool,
+
+        /// Decode blocks of 64 bit-transposed shots with the batch decoder.
+        #[arg(long)]
+        batch: bool,
+
+        /// Grow clusters by the quantized edge weights (`WeightedDecoder`).
+        #[arg(long, conflicts_with = "batch")]
+        weighted: bool,
     },
 
     /// Run a streaming simulation with real-time throughput monitoring.
@@ -139,14 +177,275 @@ enum Commands {
         /// Override the number of detectors (defaults to graph node count).
         #[arg(long)]
         detectors: Option<usize>,
+
+        /// Decode latency above which a shot counts as a deadline miss, in
+        /// nanoseconds (0 for none).
+        #[arg(long, default_value_t = 0)]
+        deadline_ns: u64,
     },
 
     /// Run hardware-in-the-loop demonstration.
     ///
-    /// Connects to a Verilator simulation via TCP and demonstrates real-time
-    /// error detection and correction on a simulated quantum hardware system.
-    /// Displays a live dashboard of qubit states and correction operations.
-    Hil,
+    /// Connects to a Verilator simulation (over TCP, a Unix domain socket or
+    /// shared memory) and demonstrates real-time error detection and
+    /// correction on a simulated quantum hardware system. Displays a live
+    /// dashboard of qubit states and correction operations.
+    Hil {
+        /// Simulation server address ("host:port", "unix:<path>" or "shm://<name>").
+        #[arg(long, default_value = "127.0.0.1:8000")]
+        connect: String,
+
+        /// Keep a rolling waveform of this many cycles in the simulator and
+        /// stop it shortly after the first failed correction (needs a
+        /// simulator built with the fst-trace feature).
+        #[arg(long)]
+        trace_window: Option<u32>,
+
+        /// Dump every cycle of the first this many cycles into one waveform
+        /// file and then stop the capture (needs a simulator built with the
+        /// fst-trace feature).
+        #[arg(long, conflicts_with = "trace_window")]
+        trace_cycles: Option<u64>,
+
+        /// Warm-up checkpoint ("mem:<slot>" or a file path on the simulator
+        /// host): restored if it exists, otherwise saved after the warm-up
+        /// (needs a simulator built with the snapshot feature).
+        #[arg(long)]
+        checkpoint: Option<String>,
+    },
+
+    /// Run the closed-loop HIL pipeline through the software decoder.
+    ///
+    /// Streams every syndrome round of the simulation into the decoder
+    /// worker and writes its corrections back as pulses, decoding each round
+    /// while the next one is simulated, and reports the end-to-end latency
+    /// and how often decoding fell behind.
+    HilDecode {
+        /// Simulation server address ("host:port", "unix:<path>" or "shm://<name>").
+        #[arg(long, default_value = "127.0.0.1:8000")]
+        connect: String,
+
+        /// Syndrome rounds to run.
+        #[arg(long, default_value_t = 10_000)]
+        rounds: u64,
+
+        /// Cycles simulated per round.
+        #[arg(long, default_value_t = 1000)]
+        round_cycles: u32,
+
+        /// Syndrome-to-pulse latency above which a round counts as a
+        /// deadline miss, in nanoseconds (0 for none).
+        #[arg(long, default_value_t = 0)]
+        deadline_ns: u64,
+    },
+
+    /// Drive several simulator sessions through one shared decoder pool.
+    ///
+    /// Opens one connection per session, runs the closed-loop rounds of
+    /// hil-decode on each, multiplexes all syndromes into a shared work
+    /// queue served by a pool of decoder workers and reports the aggregate
+    /// shots per second.
+    Fanout {
+        /// Simulation server address ("host:port" or "unix:<path>").
+        #[arg(long, default_value = "127.0.0.1:8000")]
+        connect: String,
+
+        /// Simulator sessions to drive.
+        #[arg(long, default_value_t = 4)]
+        sessions: usize,
+
+        /// Decoder workers in the pool.
+        #[arg(long, default_value_t = 4)]
+        workers: usize,
+
+        /// Pin every decoder worker to a core of its own.
+        #[arg(long)]
+        pin: bool,
+
+        /// Syndrome rounds per session.
+        #[arg(long, default_value_t = 10_000)]
+        rounds: u64,
+
+        /// Cycles simulated per round.
+        #[arg(long, default_value_t = 1000)]
+        round_cycles: u32,
+
+        /// Syndrome-to-pulse latency above which a round counts as a
+        /// deadline miss, in nanoseconds (0 for none).
+        #[arg(long, default_value_t = 0)]
+        deadline_ns: u64,
+    },
+
+    /// Benchmark the union-find accelerator mapped into the simulated SoC.
+    ///
+    /// Loads a randomly grown parent forest into the accelerator's BRAM,
+    /// issues random finds through the simulation and compares the
+    /// hardware roots and cycle counts with the software UnionFind.
+    AccelBench {
+        /// Simulation server address ("host:port", "unix:<path>" or "shm://<name>").
+        #[arg(long, default_value = "127.0.0.1:8000")]
+        connect: String,
+
+        /// Nodes in the forest (defaults to the accelerator's BRAM depth).
+        #[arg(long)]
+        nodes: Option<usize>,
+
+        /// Random unions used to grow the forest.
+        #[arg(long, default_value_t = 2048)]
+        unions: usize,
+
+        /// Random find queries to issue.
+        #[arg(long, default_value_t = 10_000)]
+        finds: usize,
+    },
+
+    /// Benchmark the full-decode block mapped into the simulated SoC.
+    ///
+    /// Loads a decoding graph into the block, decodes recorded shots in the
+    /// simulation and checks every correction list against the software
+    /// decoder, reporting hardware cycles next to the software decode time.
+    DecodeBench {
+        /// Simulation server address ("host:port", "unix:<path>" or "shm://<name>").
+        #[arg(long, default_value = "127.0.0.1:8000")]
+        connect: String,
+
+        /// Path to the decoding graph (.dem file).
+        #[arg(short, long)]
+        dem: String,
+
+        /// Path to the syndrome data (.b8 file).
+        #[arg(short, long)]
+        b8: String,
+
+        /// Decode at most this many shots.
+        #[arg(long)]
+        shots: Option<usize>,
+
+        /// Cycle budget for a single hardware decode.
+        #[arg(long, default_value_t = 50_000_000)]
+        max_cycles: u32,
+
+        /// Grow clusters by the quantized edge weights (`WeightedDecoder`).
+        #[arg(long)]
+        weighted: bool,
+    },
+
+    /// Stream the events the simulator pushes for one register.
+    ///
+    /// Subscribes to a condition on the register and lets the simulation
+    /// free-run, printing every event with its cycle stamp.
+    Monitor {
+        /// Simulation server address ("host:port", "unix:<path>" or "shm://<name>").
+        #[arg(long, default_value = "127.0.0.1:8000")]
+        connect: String,
+
+        /// Register address to watch (decimal or 0x-prefixed hex).
+        #[arg(long, value_parser = parse_u32)]
+        reg: u32,
+
+        /// Bits of the register to watch (decimal or 0x-prefixed hex).
+        #[arg(long, value_parser = parse_u32, default_value = "0xffffffff")]
+        mask: u32,
+
+        /// Fire on every change instead of on bits becoming set.
+        #[arg(long)]
+        change: bool,
+
+        /// Cycle budget of the run (0 for none).
+        #[arg(long, default_value_t = 100_000)]
+        cycles: u32,
+
+        /// Halt the run after this many events.
+        #[arg(long)]
+        events: Option<usize>,
+    },
+
+    /// Benchmark requests to the simulation server over one transport.
+    ///
+    /// Times single reads and writes, batched frames and STEP requests and
+    /// reports their throughput with latency percentiles, as a table or as
+    /// JSON lines for scripts/benchmark_sim.py.
+    SimBench {
+        /// Simulation server address ("host:port", "unix:<path>" or "shm://<name>").
+        #[arg(long, default_value = "127.0.0.1:8000")]
+        connect: String,
+
+        /// Requests timed per operation.
+        #[arg(long, default_value_t = 10_000)]
+        requests: usize,
+
+        /// Print one JSON object per result instead of a table.
+        #[arg(long)]
+        json: bool,
+    },
+}
+
+/// Parses a 32-bit command-line value given in decimal or 0x-prefixed hex.
+///
+/// # Arguments
+///
+/// * `s` - Argument text
+///
+/// # Returns
+///
+/// The parsed value, or the parse error.
+fn parse_u32(s: &str) -> Result<u32, std::num::ParseIntError> {
+    match s.strip_prefix("0x").or_else(|| s.strip_prefix("0X")) {
+        Some(hex) => u32::from_str_radix(hex, 16),
+        None => s.parse(),
+    }
+}
+
+/// Compiles a .dem file into a graph image and checks that it loads back.
+///
+/// Every section of the reloaded graph (edges, weights, growth steps,
+/// observables and the CSR adjacency) must equal the parsed graph's, so an
+/// image that would decode differently is never left behind silently.
+///
+/// # Arguments
+///
+/// * `dem` - Path to the .dem file
+/// * `out` - Output path for the image
+///
+/// # Returns
+///
+/// Ok(()) on success, or an error if parsing, writing or reloading fails.
+fn compile_graph(dem: &str, out: &str) -> Result<()> {
+    let start = Instant::now();
+    let graph = parser::load_dem_file(dem)?;
+    let parsed = start.elapsed();
+    let bytes = parser::save_graph_image(&graph, out)?;
+
+    let start = Instant::now();
+    let image = parser::load_graph_image(out)?;
+    let loaded = start.elapsed();
+    let same_weights = image.edge_weights.len() == graph.edge_weights.len()
+        && image
+            .edge_weights
+            .iter()
+            .zip(graph.edge_weights.iter())
+            .all(|(a, b)| a.to_bits() == b.to_bits());
+    if image.fast_edges != graph.fast_edges
+        || !same_weights
+        || image.edge_steps != graph.edge_steps
+        || image.edge_observables != graph.edge_observables
+        || image.adj_offsets != graph.adj_offsets
+        || image.adj_targets != graph.adj_targets
+        || image.adj_edges != graph.adj_edges
+    {
+        anyhow::bail!("Graph image {} does not match {}", out, dem);
+    }
+
+    println!(
+        "Compiled {} ({} nodes, {} edges) into {} ({} bytes)",
+        dem,
+        graph.num_nodes(),
+        graph.fast_edges.len(),
+        out,
+        bytes
+    );
+    println!("   Parsed in {:?}, image loads in {:?}", parsed, loaded);
+    Ok(())
 }
 
 /// Main entry point for host-side tools.
@@ -171,8 +470,18 @@ fn main() -> Result<()> {
         } => {
             generator::generate_phenomenological_data(&dem, &b8, size, shots, p, inject_failures)?;
         }
-        Commands::Run { dem, b8, detectors } => {
-            throughput::run_benchmark(&dem, &b8, detectors)?;
+        Commands::CompileGraph { dem, out } => {
+            compile_graph(&dem, &out)?;
+        }
+        Commands::Run {
+            dem,
+            b8,
+            detectors,
+            streaming,
+            batch,
+            weighted,
+        } => {
+            throughput::run_benchmark(&dem, &b8, detectors, streaming, batch, weighted)?;
         }
         Commands::Stream {
             dem,
@@ -180,11 +489,84 @@ fn main() -> Result<()> {
             freq,
             duration,
             detectors,
+            deadline_ns,
+        } => {
+            stream::run_stream(&dem, b8, freq, duration, detectors, deadline_ns)?;
+        }
+        Commands::Hil {
+            connect,
+            trace_window,
+            trace_cycles,
+            checkpoint,
         } => {
-            stream::run_stream(&dem, b8, freq, duration, detectors)?;
+            hil::run_hil_demo(&connect, trace_window, trace_cycles, checkpoint.as_deref())?;
         }
-        Commands::Hil => {
-            hil::run_hil_demo()?;
+        Commands::HilDecode {
+            connect,
+            rounds,
+            round_cycles,
+            deadline_ns,
+        } => {
+            hil::closed_loop::run_closed_loop(&connect, rounds, round_cycles, deadline_ns)?;
+        }
+        Commands::Fanout {
+            connect,
+            sessions,
+            workers,
+            pin,
+            rounds,
+            round_cycles,
+            deadline_ns,
+        } => {
+            hil::fanout::run_fanout(
+                &connect,
+                sessions,
+                workers,
+                pin,
+                rounds,
+                round_cycles,
+                deadline_ns,
+            )?;
+        }
+        Commands::AccelBench {
+            connect,
+            nodes,
+            unions,
+            finds,
+        } => {
+            hil::accel::run_accel_bench(&connect, nodes, unions, finds)?;
+        }
+        Commands::DecodeBench {
+            connect,
+            dem,
+            b8,
+            shots,
+            max_cycles,
+            weighted,
+        } => {
+            hil::decode::run_decode_bench(&connect, &dem, &b8, shots, max_cycles, weighted)?;
+        }
+        Commands::Monitor {
+            connect,
+            reg,
+            mask,
+            change,
+            cycles,
+            events,
+        } => {
+            let mode = if change {
+                hil::WatchMode::Change
+            } else {
+                hil::WatchMode::Set
+            };
+            hil::monitor::run_monitor(&connect, reg, mask, mode, cycles, events)?;
+        }
+        Commands::SimBench {
+            connect,
+            requests,
+            json,
+        } => {
+            hil::sim_bench::run_sim_bench(&connect, requests, json)?;
         }
     }
     Ok(())
@@ -1,110 +1,121 @@
 //! Latency statistics tracking for performance analysis.
 //!
 //! Provides data structures and functions for collecting and reporting
-//! decoding latency measurements. Tracks minimum, maximum, average, and
-//! distribution statistics to enable performance profiling and bottleneck
-//! identification.
+//! decoding latency measurements. Latencies are recorded into the shared
+//! HDR-style histogram of `qcu_core::latency`, which reports percentiles
+//! and deadline misses in the same export line the firmware and the
+//! simulation server print, so host numbers can be compared with theirs.
+
+use qcu_core::latency::{LatencyHistogram, LatencySummary};
 
 /// Tracks latency statistics with minimal overhead.
 ///
-/// Accumulates latency measurements and computes summary statistics including
-/// min, max, average, and histogram distribution. Designed for high-frequency
-/// updates in performance-critical paths, using simple arithmetic operations
-/// to minimize measurement overhead.
+/// Accumulates latency measurements in nanoseconds into a lock-free
+/// log-linear histogram and counts the measurements that exceed an
+/// optional deadline. Designed for high-frequency updates in
+/// performance-critical paths: recording is a few relaxed atomic updates
+/// and never allocates.
 pub struct LatencyStats {
-    pub min: u64,
-    pub max: u64,
-    pub sum: u64,
-    pub count: u64,
-    pub buckets: [u64; 20],
+    /// Recorded latencies in nanoseconds.
+    hist: Box<LatencyHistogram>,
+}
+
+impl Default for LatencyStats {
+    /// Creates a tracker without a deadline.
+    ///
+    /// Equivalent to calling `new()`, provided for trait compatibility.
+    fn default() -> Self {
+        Self::new()
+    }
 }
 
 impl LatencyStats {
     /// Creates a new latency statistics tracker with empty state.
     ///
-    /// Initializes all counters to zero and min to u64::MAX so the first
-    /// measurement becomes the minimum. Ready to start collecting measurements
-    /// after construction.
+    /// No deadline is configured, so no measurement counts as a miss.
     pub fn new() -> Self {
         Self {
-            min: u64::MAX,
-            max: 0,
-            sum: 0,
-            count: 0,
-            buckets: [0; 20],
+            hist: Box::new(LatencyHistogram::new()),
         }
     }
 
-    /// Records a latency measurement in nanoseconds.
+    /// Creates a tracker that counts measurements above a deadline.
     ///
-    /// Updates min, max, sum, and count statistics, and increments the
-    /// appropriate histogram bucket. The measurement is assumed to be in
-    /// nanoseconds, and buckets are sized at 10 microsecond intervals.
+    /// # Arguments
+    ///
+    /// * `deadline_ns` - Largest latency that meets the deadline, 0 for none
+    pub fn with_deadline(deadline_ns: u64) -> Self {
+        let stats = Self::new();
+        stats.hist.set_deadline(deadline_ns);
+        stats
+    }
+
+    /// Records a latency measurement in nanoseconds.
     ///
     /// # Arguments
     ///
     /// * `nanos` - Latency measurement in nanoseconds
     pub fn update(&mut self, nanos: u64) {
-        if nanos < self.min {
-            self.min = nanos;
-        }
-        if nanos > self.max {
-            self.max = nanos;
-        }
-        self.sum += nanos;
-        self.count += 1;
-
-        let idx = (nanos / 10_000).min(19) as usize;
-        self.buckets[idx] += 1;
+        self.hist.record(nanos);
     }
 
-    /// Computes the average latency from accumulated statistics.
+    /// Adds the measurements of another tracker.
+    ///
+    /// # Arguments
     ///
-    /// Divides the sum of all latencies by the count of measurements.
-    /// Returns 0.0 if no measurements have been recorded to avoid division
-    /// by zero.
+    /// * `other` - Tracker whose measurements are added
+    pub fn merge(&mut self, other: &LatencyStats) {
+        self.hist.merge(&other.hist);
+    }
+
+    /// Summarizes the measurements recorded so far.
     ///
     /// # Returns
     ///
-    /// The average latency in nanoseconds, or 0.0 if no measurements recorded.
-    pub fn avg(&self) -> f64 {
-        if self.count == 0 {
-            0.0
-        } else {
-            self.sum as f64 / self.count as f64
-        }
+    /// Count, min, mean, p50/p99/p99.9, max and deadline misses in
+    /// nanoseconds.
+    pub fn summary(&self) -> LatencySummary {
+        self.hist.summary()
     }
 
     /// Prints a formatted report of latency statistics.
     ///
-    /// Displays count, min, average, and max latencies, with automatic unit
-    /// conversion (nanoseconds to microseconds) for readability. Also
-    /// prints a histogram showing the distribution of latencies across
-    /// 10-microsecond buckets.
-    pub fn print_report(&self) {
+    /// Displays count, min, average, percentiles and max latencies, with
+    /// automatic unit conversion (nanoseconds to microseconds) for
+    /// readability, the deadline misses when a deadline is set, and the
+    /// export line for tools that compare layers.
+    ///
+    /// # Arguments
+    ///
+    /// * `source` - Name of the measurement in the export line
+    pub fn print_report(&self, source: &str) {
+        let s = self.summary();
         println!("\nLatency Metrics (Service Time)");
-        println!("Count: {}", self.count);
+        println!("Count: {}", s.count);
 
-        let avg_ns = self.avg();
-        if avg_ns < 1000.0 {
-            println!("Min:   {:.2} ns", self.min as f64);
-            println!("Avg:   {:.2} ns", avg_ns);
-            println!("Max:   {:.2} ns", self.max as f64);
+        let (scale, unit) = if s.mean < 1000 {
+            (1.0, "ns")
         } else {
-            println!("Min:   {:.2} us", self.min as f64 / 1000.0);
-            println!("Avg:   {:.2} us", avg_ns / 1000.0);
-            println!("Max:   {:.2} us", self.max as f64 / 1000.0);
+            (1000.0, "us")
+        };
+        for (name, value) in [
+            ("Min:  ", s.min),
+            ("Avg:  ", s.mean),
+            ("p50:  ", s.p50),
+            ("p99:  ", s.p99),
+            ("p99.9:", s.p999),
+            ("Max:  ", s.max),
+        ] {
+            println!("{} {:.2} {}", name, value as f64 / scale, unit);
         }
-
-        println!("Distribution (10us buckets):");
-        for i in 0..20 {
-            let count = self.buckets[i];
-            if count > 0 {
-                let range_end = if i == 19 { ">" } else { "" };
-                let lower = i * 10;
-                let upper = (i + 1) * 10;
-                println!("[{:3}-{:3}{} us]: {}", lower, upper, range_end, count);
-            }
+        if s.deadline != 0 {
+            println!(
+                "Deadline {:.2} us: {} misses ({:.4}%)",
+                s.deadline as f64 / 1000.0,
+                s.misses,
+                100.0 * s.misses as f64 / s.count.max(1) as f64
+            );
         }
+        println!("{}", s.line(source, "ns"));
     }
 }
@@ -8,11 +8,14 @@
 use crate::stats::LatencyStats;
 use anyhow::Result;
 use qcu_core::decoder::UnionFindDecoder;
+use qcu_core::graph::DecodingGraph;
+use qcu_core::latency::LatencyHistogram;
 use qcu_core::ring_buffer::RingBuffer;
-use qcu_io::{loader, parser};
+use qcu_io::loader::ShotFile;
+use qcu_io::parser;
 use std::sync::Arc;
 use std::sync::atomic::{AtomicBool, AtomicU64, Ordering};
-use std::thread;
+use std::thread::{self, JoinHandle};
 use std::time::{Duration, Instant};
 
 /// Packet containing syndrome data for one decoding task.
@@ -45,12 +48,13 @@ impl Default for TaskPacket {
 ///
 /// Maintains atomic counters for monitoring throughput, dropped packets,
 /// and latency in the producer-consumer decoding pipeline. All fields are
-/// shared between threads via Arc for concurrent access.
+/// shared between threads via Arc for concurrent access; `latency` holds
+/// the decode times since the last progress line and is drained by it.
 pub struct StreamStats {
     pub processed: Arc<AtomicU64>,
     pub generated: Arc<AtomicU64>,
     pub dropped: Arc<AtomicU64>,
-    pub latency_us: Arc<AtomicU64>,
+    pub latency: Arc<LatencyHistogram>,
 }
 
 /// Maximum number of nodes supported by the streaming decoder.
@@ -62,12 +66,70 @@ pub struct StreamStats {
 /// codes.
 const MAX_NODES: usize = 4096;
 
+/// Spawns a decoder worker consuming syndrome packets from a ring buffer.
+///
+/// The worker pops packets while `running` is set, decodes each one with
+/// `UnionFindDecoder::solve_into` and hands the correction edges and the
+/// decode time to `on_decoded`, in the order the packets were pushed. Used
+/// by the streaming benchmark and by the closed-loop HIL mode, which writes
+/// the corrections back to the simulator.
+///
+/// # Arguments
+///
+/// * `graph` - Decoding graph shared with the producer
+/// * `tasks` - Ring buffer the syndrome packets are pushed to
+/// * `running` - Cleared to stop the worker
+/// * `deadline_ns` - Decode time above which a packet counts as a deadline
+///   miss in the returned statistics (0 for none)
+/// * `on_decoded` - Called with the corrections and decode time in
+///   nanoseconds of every packet
+///
+/// # Returns
+///
+/// The worker's join handle, yielding its decode latency statistics.
+pub fn spawn_decoder(
+    graph: Arc<DecodingGraph>,
+    tasks: Arc<RingBuffer<TaskPacket>>,
+    running: Arc<AtomicBool>,
+    deadline_ns: u64,
+    mut on_decoded: Box<dyn FnMut(&[(usize, usize)], u64) + Send>,
+) -> JoinHandle<LatencyStats> {
+    thread::spawn(move || {
+        let mut decoder = UnionFindDecoder::<MAX_NODES>::new();
+        let mut lat_stats = LatencyStats::with_deadline(deadline_ns);
+        let mut results = Vec::with_capacity(1024);
+        let mut indices = Vec::with_capacity(64);
+
+        while running.load(Ordering::Relaxed) {
+            if let Some(packet) = tasks.pop() {
+                let len = packet.syndrome_len as usize;
+                indices.clear();
+                for i in 0..len {
+                    indices.push(packet.syndrome_buffer[i] as usize);
+                }
+
+                let start = Instant::now();
+                let _ = decoder.solve_into(&graph, &indices, &mut results);
+                let lat_ns = start.elapsed().as_nanos() as u64;
+
+                on_decoded(&results, lat_ns);
+                lat_stats.update(lat_ns);
+            } else {
+                std::hint::spin_loop();
+            }
+        }
+        lat_stats
+    })
+}
+
 /// Runs a real-time streaming QEC decoder benchmark.
 ///
 /// Spawns separate producer and consumer threads connected via a ring buffer.
 /// The producer generates syndrome packets at the specified frequency, while
 /// the consumer decodes them and records latency statistics. Runs for the
-/// specified duration, printing throughput and latency metrics every second.
+/// specified duration, printing throughput, p50/p99/max decode latency and
+/// deadline misses every second, and ends with the full latency report and
+/// its export line (`host.stream.decode`).
 /// If a .b8 file path is provided, loads pre-generated syndrome patterns;
 /// otherwise uses a single empty pattern for continuous testing.
 ///
@@ -78,6 +140,8 @@ const MAX_NODES: usize = 4096;
 /// * `freq` - Target frequency in Hz for syndrome packet generation
 /// * `duration_secs` - Duration to run the benchmark in seconds
 /// * `user_detectors` - Optional override for number of detectors
+/// * `deadline_ns` - Decode time above which a shot counts as a deadline
+///   miss (0 for none)
 ///
 /// # Returns
 ///
@@ -88,11 +152,15 @@ pub fn run_stream(
     freq: u64,
     duration_secs: u64,
     user_detectors: Option<usize>,
+    deadline_ns: u64,
 ) -> Result<()> {
     println!("QEC STREAMING");
     println!("Graph: {}", dem_path);
     println!("Target Freq: {} Hz", freq);
     println!("Duration: {} s", duration_secs);
+    if deadline_ns != 0 {
+        println!("Deadline: {:.2} us", deadline_ns as f64 / 1e3);
+    }
     println!("-------------------------------");
 
     let running = Arc::new(AtomicBool::new(true));
@@ -100,10 +168,10 @@ pub fn run_stream(
         processed: Arc::new(AtomicU64::new(0)),
         generated: Arc::new(AtomicU64::new(0)),
         dropped: Arc::new(AtomicU64::new(0)),
-        latency_us: Arc::new(AtomicU64::new(0)),
+        latency: Arc::new(LatencyHistogram::new()),
     };
 
-    let graph = parser::load_dem_file(dem_path)?;
+    let graph = parser::load_graph_file(dem_path)?;
     let num_detectors = user_detectors.unwrap_or(graph.num_nodes());
     println!(
         "Graph loaded. Nodes: {}, Edges: {}",
@@ -113,48 +181,30 @@ pub fn run_stream(
 
     let shots = if let Some(path) = b8_path {
         println!("Loading shots from {}...", path);
-        let raw_bits = loader::load_b8_file(&path)?;
-        loader::slice_shots(&raw_bits, num_detectors)
+        let shots = ShotFile::open(&path, num_detectors)?;
+        println!("Loaded {} unique error patterns.", shots.len());
+        Some(Arc::new(shots))
     } else {
-        vec![vec![false; num_detectors]]
+        println!("Loaded 1 unique error patterns.");
+        None
     };
-    println!("Loaded {} unique error patterns.", shots.len());
 
     let graph_arc = Arc::new(graph);
     let ring_buffer = Arc::new(RingBuffer::<TaskPacket>::new(1024));
 
-    let rb_cons = ring_buffer.clone();
     let s_cons = stats.processed.clone();
-    let l_cons = stats.latency_us.clone();
-    let r_cons = running.clone();
-
-    let consumer = thread::spawn(move || {
-        let mut decoder = UnionFindDecoder::<MAX_NODES>::new();
-        let mut lat_stats = LatencyStats::new();
-        let mut results = Vec::with_capacity(1024);
-        let mut indices = Vec::with_capacity(64);
-
-        while r_cons.load(Ordering::Relaxed) {
-            if let Some(packet) = rb_cons.pop() {
-                let len = packet.syndrome_len as usize;
-                indices.clear();
-                for i in 0..len {
-                    indices.push(packet.syndrome_buffer[i] as usize);
-                }
-
-                let start = Instant::now();
-                let _ = decoder.solve_into(&graph_arc, &indices, &mut results);
-                let lat_ns = start.elapsed().as_nanos() as u64;
-
-                s_cons.fetch_add(1, Ordering::Relaxed);
-                l_cons.store(lat_ns / 1000, Ordering::Relaxed);
-                lat_stats.update(lat_ns);
-            } else {
-                std::hint::spin_loop();
-            }
-        }
-        lat_stats.print_report();
-    });
+    let l_cons = stats.latency.clone();
+    l_cons.set_deadline(deadline_ns);
+    let consumer = spawn_decoder(
+        graph_arc.clone(),
+        ring_buffer.clone(),
+        running.clone(),
+        deadline_ns,
+        Box::new(move |_, lat_ns| {
+            s_cons.fetch_add(1, Ordering::Relaxed);
+            l_cons.record(lat_ns);
+        }),
+    );
 
     let rb_prod = ring_buffer.clone();
     let s_gen = stats.generated.clone();
@@ -164,7 +214,8 @@ pub fn run_stream(
 
     let producer = thread::spawn(move || {
         let interval = Duration::from_micros(1_000_000 / freq);
-        let num_patterns = producer_shots.len();
+        let num_patterns = producer_shots.as_ref().map_or(0, |s| s.len());
+        let mut fired = Vec::with_capacity(64);
         let mut idx = 0;
 
         while r_prod.load(Ordering::Relaxed) {
@@ -172,12 +223,11 @@ pub fn run_stream(
             let mut packet = TaskPacket::default();
             let mut count = 0;
 
-            if num_patterns > 0 {
-                for (det_id, &triggered) in producer_shots[idx].iter().enumerate() {
-                    if triggered && count < 64 {
-                        packet.syndrome_buffer[count] = det_id as u32;
-                        count += 1;
-                    }
+            if let Some(shots) = producer_shots.as_ref().filter(|_| num_patterns > 0) {
+                shots.fired(idx, &mut fired);
+                for &det_id in fired.iter().take(64) {
+                    packet.syndrome_buffer[count] = det_id as u32;
+                    count += 1;
                 }
                 idx = (idx + 1) % num_patterns;
             }
@@ -203,25 +253,28 @@ pub fn run_stream(
         let proc = stats.processed.load(Ordering::Relaxed);
         let r#gen = stats.generated.load(Ordering::Relaxed);
         let drop = stats.dropped.load(Ordering::Relaxed);
-        let lat = stats.latency_us.load(Ordering::Relaxed);
+        let lat = stats.latency.drain();
 
         let tput = proc - last_processed;
         last_processed = proc;
 
         println!(
-            "T={:2}s | Gen: {:8} | Proc: {:8} ({:5}/s) | Drop: {:5} | Latency: {:3} us",
+            "T={:2}s | Gen: {:8} | Proc: {:8} ({:5}/s) | Drop: {:5} | Lat p50/p99/max: {:.1}/{:.1}/{:.1} us | Miss: {}",
             start_time.elapsed().as_secs(),
             r#gen,
             proc,
             tput,
             drop,
-            lat
+            lat.p50 as f64 / 1e3,
+            lat.p99 as f64 / 1e3,
+            lat.max as f64 / 1e3,
+            lat.misses
         );
     }
 
     running.store(false, Ordering::Relaxed);
     thread::sleep(Duration::from_millis(100));
-    consumer.join().unwrap();
+    consumer.join().unwrap().print_report("host.stream.decode");
     producer.join().unwrap();
 
     println!("Done.");
@@ -6,8 +6,9 @@
 //! regression testing and optimization validation.
 
 use anyhow::Result;
-use qcu_core::decoder::UnionFindDecoder;
-use qcu_io::{loader, parser};
+use qcu_core::decoder::{BATCH_SHOTS, BatchDecoder, UnionFindDecoder, WeightedDecoder};
+use qcu_io::loader::{self, ShotFile, ShotStream};
+use qcu_io::parser;
 use rayon::prelude::*;
 use std::time::Instant;
 
@@ -18,25 +19,55 @@ use std::time::Instant;
 /// this size.
 const MAX_NODES: usize = 4096;
 
+/// Per-worker decoder and buffers, reused across the shots a Rayon worker
+/// decodes.
+type DecodeState = (UnionFindDecoder<MAX_NODES>, Vec<usize>, Vec<(usize, usize)>);
+
+/// Per-worker batch decoder, block and correction buffers for `--batch`.
+type BatchState = (Box<BatchDecoder<MAX_NODES>>, Vec<u64>, Vec<(usize, usize)>);
+
+/// Per-worker weighted decoder and buffers for `--weighted`.
+type WeightedState = (
+    Box<WeightedDecoder<MAX_NODES>>,
+    Vec<usize>,
+    Vec<(usize, usize)>,
+);
+
 /// Runs a throughput benchmark on decoding performance.
 ///
 /// Loads a decoding graph and syndrome data, then processes all shots in
 /// parallel using Rayon. Measures the total time and computes throughput.
 /// Reports results including total time, shots per second, and success rate.
+/// The shot file is memory-mapped and decoded in place; in streaming mode it
+/// is read in fixed-size batches instead, each decoded in parallel before
+/// the next is read, and the reported time includes reading. In batch mode
+/// every worker transposes blocks of `BATCH_SHOTS` shots and decodes them
+/// with a `BatchDecoder`; in weighted mode every shot is decoded with a
+/// `WeightedDecoder`.
 ///
 /// # Arguments
 ///
 /// * `dem_path` - Path to the decoding graph (.dem file)
 /// * `b8_path` - Path to the syndrome data (.b8 file)
 /// * `user_detectors` - Optional override for detector count (defaults to graph size)
+/// * `streaming` - Read the shots in batches instead of mapping the file
+/// * `batch_mode` - Decode blocks of shots with the batch decoder
+/// * `weighted` - Decode shots with weighted cluster growth
 ///
 /// # Returns
 ///
 /// Ok(()) on success, or an error if file loading or decoding fails.
-pub fn run_benchmark(dem_path: &str, b8_path: &str, user_detectors: Option<usize>) -> Result<()> {
+pub fn run_benchmark(
+    dem_path: &str,
+    b8_path: &str,
+    user_detectors: Option<usize>,
+    streaming: bool,
+    batch_mode: bool,
+    weighted: bool,
+) -> Result<()> {
     println!("Loading Graph from {}...", dem_path);
     let start_load = Instant::now();
-    let graph = parser::load_dem_file(dem_path)?;
+    let graph = parser::load_graph_file(dem_path)?;
     println!(
         "Graph loaded in {:?}. Nodes: {}, Edges: {}",
         start_load.elapsed(),
@@ -46,45 +77,104 @@ pub fn run_benchmark(dem_path: &str, b8_path: &str, user_detectors: Option<usize
 
     let num_detectors = user_detectors.unwrap_or(graph.num_nodes());
 
-    println!("Loading Shots from {}...", b8_path);
-    let raw_bits = loader::load_b8_file(b8_path)?;
-    let shots = loader::slice_shots(&raw_bits, num_detectors);
-    println!("Loaded {} shots.", shots.len());
-
-    println!("Starting Benchmark (Parallel - Rayon)...");
-    let start_bench = Instant::now();
+    // Decodes one shot with the calling Rayon worker's decoder and buffers.
+    let decode = |state: &mut DecodeState, shot: &[u8]| -> usize {
+        let (decoder, syndrome, results) = state;
+        loader::fired_detectors(shot, num_detectors, syndrome);
+        decoder.solve_into(&graph, syndrome, results).is_ok() as usize
+    };
 
-    let solved_count: usize = shots
-        .par_iter()
-        .map(|shot| {
-            let mut local_decoder = UnionFindDecoder::<MAX_NODES>::new();
-            let mut local_results = Vec::with_capacity(128);
+    // Decodes one block of consecutive shots with the batch decoder.
+    let decode_block = |state: &mut BatchState, shots: &[u8]| -> usize {
+        let (decoder, block, results) = state;
+        loader::transpose_shots(shots, num_detectors, block);
+        let mut solved = 0;
+        let count = shots.len() / num_detectors.div_ceil(8);
+        let _ = decoder.solve_batch(&graph, block, count, results, |_, _| solved += 1);
+        solved
+    };
+    let batch_state = || -> BatchState { (Box::default(), Vec::new(), Vec::new()) };
 
-            let syndrome: Vec<usize> = shot
-                .iter()
-                .enumerate()
-                .filter_map(|(i, &triggered)| if triggered { Some(i) } else { None })
-                .collect();
+    // Decodes one shot with the weighted decoder.
+    let decode_weighted = |state: &mut WeightedState, shot: &[u8]| -> usize {
+        let (decoder, syndrome, results) = state;
+        loader::fired_detectors(shot, num_detectors, syndrome);
+        decoder.solve_into(&graph, syndrome, results).is_ok() as usize
+    };
+    let weighted_state = || -> WeightedState { (Box::default(), Vec::new(), Vec::new()) };
 
-            if local_decoder
-                .solve_into(&graph, &syndrome, &mut local_results)
-                .is_ok()
-            {
-                1
-            } else {
-                0
+    let (num_shots, solved_count, duration) = if streaming {
+        println!("Streaming Shots from {}...", b8_path);
+        println!("Starting Benchmark (Parallel - Rayon, batched)...");
+        let mut stream = ShotStream::open(b8_path, num_detectors)?;
+        let stride = stream.stride();
+        let start_bench = Instant::now();
+        let (mut num_shots, mut solved_count) = (0, 0);
+        loop {
+            let batch = stream.next_batch()?;
+            if batch.is_empty() {
+                break;
             }
-        })
-        .sum();
+            num_shots += batch.len() / stride;
+            solved_count += if batch_mode {
+                batch
+                    .par_chunks(BATCH_SHOTS * stride)
+                    .map_init(batch_state, decode_block)
+                    .sum::<usize>()
+            } else if weighted {
+                batch
+                    .par_chunks_exact(stride)
+                    .map_init(weighted_state, decode_weighted)
+                    .sum::<usize>()
+            } else {
+                batch
+                    .par_chunks_exact(stride)
+                    .map_init(DecodeState::default, decode)
+                    .sum::<usize>()
+            };
+        }
+        (num_shots, solved_count, start_bench.elapsed())
+    } else {
+        println!("Loading Shots from {}...", b8_path);
+        let shots = ShotFile::open(b8_path, num_detectors)?;
+        println!("Loaded {} shots.", shots.len());
+
+        println!("Starting Benchmark (Parallel - Rayon)...");
+        let start_bench = Instant::now();
+        let solved_count: usize = if batch_mode {
+            (0..shots.len().div_ceil(BATCH_SHOTS))
+                .into_par_iter()
+                .map_init(batch_state, |state, b| {
+                    let first = b * BATCH_SHOTS;
+                    let count = BATCH_SHOTS.min(shots.len() - first);
+                    decode_block(state, shots.shots(first, count))
+                })
+                .sum()
+        } else if weighted {
+            (0..shots.len())
+                .into_par_iter()
+                .map_init(weighted_state, |state, i| {
+                    decode_weighted(state, shots.shot(i))
+                })
+                .sum()
+        } else {
+            (0..shots.len())
+                .into_par_iter()
+                .map_init(DecodeState::default, |state, i| {
+                    decode(state, shots.shot(i))
+                })
+                .sum()
+        };
+        (shots.len(), solved_count, start_bench.elapsed())
+    };
 
-    let duration = start_bench.elapsed();
     let seconds = duration.as_secs_f64();
-    let throughput = shots.len() as f64 / seconds;
+    let throughput = num_shots as f64 / seconds;
 
     println!("Results");
     println!("Time: {:.4} s", seconds);
     println!("Throughput: {:.2} shots/s", throughput);
-    println!("Solved: {}/{}", solved_count, shots.len());
+    println!("Solved: {}/{}", solved_count, num_shots);
 
     Ok(())
 }
@@ -0,0 +1,155 @@
+//! Lock-free bounded multi-producer multi-consumer work queue.
+//!
+//! The host-side counterpart of `qcu_core::spmc::StaticQueue`: a heap
+//! allocated circular buffer that any number of threads can push to and pop
+//! from concurrently. Every slot carries a sequence number that tells
+//! producers and consumers whether it is free or filled for the current lap,
+//! so each side claims positions with a single compare-and-swap on its own
+//! index and never waits for the other side.
+
+use std::cell::UnsafeCell;
+use std::mem::MaybeUninit;
+use std::sync::atomic::{AtomicUsize, Ordering};
+
+/// One queue slot.
+struct Slot<T> {
+    /// Position the slot is ready for: `pos` when free for the producer
+    /// claiming position `pos`, `pos + 1` once filled for the consumer
+    /// claiming it.
+    seq: AtomicUsize,
+
+    /// Stored item, initialized while the slot is filled.
+    value: UnsafeCell<MaybeUninit<T>>,
+}
+
+/// Lock-free bounded multi-producer multi-consumer queue.
+///
+/// Producers claim positions by compare-and-swap on `head` and consumers by
+/// compare-and-swap on `tail`; the slot's sequence number publishes the item
+/// from the producer to the consumer and the free slot back to the next
+/// lap's producer. The capacity must be a power of two. Cache line padding
+/// is included to reduce false sharing between head and tail pointers.
+///
+/// # Type Parameters
+///
+/// * `T` - Element type, must be Copy for efficient reads
+pub struct WorkQueue<T> {
+    slots: Box<[Slot<T>]>,
+    mask: usize,
+    _pad0: [u8; 64],
+    head: AtomicUsize,
+    _pad1: [u8; 64],
+    tail: AtomicUsize,
+}
+
+/// WorkQueue is safe to share between threads.
+///
+/// Each position is claimed by exactly one producer and one consumer through
+/// the compare-and-swaps, and the slot sequence numbers order their accesses.
+unsafe impl<T: Send> Sync for WorkQueue<T> {}
+unsafe impl<T: Send> Send for WorkQueue<T> {}
+
+impl<T: Copy> WorkQueue<T> {
+    /// Creates a new queue with the specified capacity.
+    ///
+    /// # Arguments
+    ///
+    /// * `capacity` - Queue size (must be power of two and greater than zero)
+    ///
+    /// # Panics
+    ///
+    /// Panics if capacity is zero or not a power of two.
+    pub fn new(capacity: usize) -> Self {
+        assert!(capacity > 0 && capacity.is_power_of_two());
+        Self {
+            slots: (0..capacity)
+                .map(|i| Slot {
+                    seq: AtomicUsize::new(i),
+                    value: UnsafeCell::new(MaybeUninit::uninit()),
+                })
+                .collect(),
+            mask: capacity - 1,
+            _pad0: [0; 64],
+            head: AtomicUsize::new(0),
+            _pad1: [0; 64],
+            tail: AtomicUsize::new(0),
+        }
+    }
+
+    /// Pushes an item into the queue (producer operation).
+    ///
+    /// # Arguments
+    ///
+    /// * `item` - Item to enqueue
+    ///
+    /// # Returns
+    ///
+    /// Ok(()) if the item was enqueued, Err(item) if the queue is full.
+    #[inline(always)]
+    pub fn push(&self, item: T) -> Result<(), T> {
+        let mut pos = self.head.load(Ordering::Relaxed);
+        loop {
+            let slot = &self.slots[pos & self.mask];
+            let seq = slot.seq.load(Ordering::Acquire);
+            let diff = seq.wrapping_sub(pos) as isize;
+
+            if diff < 0 {
+                return Err(item);
+            }
+            if diff > 0 {
+                pos = self.head.load(Ordering::Relaxed);
+                continue;
+            }
+            match self.head.compare_exchange_weak(
+                pos,
+                pos.wrapping_add(1),
+                Ordering::Relaxed,
+                Ordering::Relaxed,
+            ) {
+                Ok(_) => {
+                    unsafe { (*slot.value.get()).write(item) };
+                    slot.seq.store(pos.wrapping_add(1), Ordering::Release);
+                    return Ok(());
+                }
+                Err(actual_head) => pos = actual_head,
+            }
+        }
+    }
+
+    /// Pops an item from the queue (consumer operation).
+    ///
+    /// # Returns
+    ///
+    /// Some(item) if an item was dequeued, None if the queue is empty.
+    #[inline(always)]
+    pub fn pop(&self) -> Option<T> {
+        let mut pos = self.tail.load(Ordering::Relaxed);
+        loop {
+            let slot = &self.slots[pos & self.mask];
+            let seq = slot.seq.load(Ordering::Acquire);
+            let diff = seq.wrapping_sub(pos.wrapping_add(1)) as isize;
+
+            if diff < 0 {
+                return None;
+            }
+            if diff > 0 {
+                pos = self.tail.load(Ordering::Relaxed);
+                continue;
+            }
+            match self.tail.compare_exchange_weak(
+                pos,
+                pos.wrapping_add(1),
+                Ordering::Relaxed,
+                Ordering::Relaxed,
+            ) {
+                Ok(_) => {
+                    let item = unsafe { (*slot.value.get()).assume_init() };
+                    slot.seq
+                        .store(pos.wrapping_add(self.mask + 1), Ordering::Release);
+                    return Some(item);
+                }
+                Err(actual_tail) => pos = actual_tail,
+            }
+        }
+    }
+}
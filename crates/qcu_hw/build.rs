@@ -3,9 +3,12 @@
 /// Invokes Verilator to compile SystemVerilog RTL files into a C++ simulation
 /// executable. Configures include paths, optimization level, and output
 /// directory. Registers file dependencies to trigger rebuilds when RTL
-/// sources change.
+/// sources change. The `mt-sim` feature selects a multithreaded model
+/// compiled for the build machine. A second Verilator run builds the
+/// union-find accelerator as a static library that the crate links
+/// in-process through the `hw_*` C interface.
 use std::env;
-use std::path::PathBuf;
+use std::path::{Path, PathBuf};
 use std::process::Command;
 
 /// Build script entry point for hardware simulation compilation.
@@ -15,6 +18,34 @@ use std::process::Command;
 /// level to -O3, and registers file dependencies to trigger rebuilds when
 /// RTL sources change. The resulting executable can be linked with Rust code
 /// via FFI bindings.
+///
+/// With the `mt-sim` feature (or `QCU_SIM_THREADS` set), Verilator builds a
+/// multithreaded model with `--threads <n>`, where n comes from
+/// `QCU_SIM_THREADS` and defaults to 4. The feature also compiles the C++
+/// harness and model with `-O3 -march=native` and link-time optimization;
+/// the resulting binary is only suitable for the machine it was built on.
+///
+/// The `rtl-trace` feature defines `QCU_TRACE`, compiling in the RTL
+/// `$display` traces; default builds strip them from the clocked paths.
+/// The `fst-trace` feature verilates the SoC with `--trace-fst` and defines
+/// `QCU_FST`, enabling the runtime-armed waveform capture of `CMD_TRACE`.
+/// The `snapshot` feature verilates it with `--savable` and defines
+/// `QCU_SAVABLE`, enabling the `CMD_SAVE`/`CMD_RESTORE` checkpoints;
+/// Verilator cannot combine `--savable` with a multithreaded model.
+///
+/// `QCU_GRID_DIM` sets the side length of the simulated qubit grid (default
+/// 3, at most 32), passed to the top-level module as `-GGRID_DIM=<n>`.
+/// `QCU_UF_DEPTH` (default 4096, at most 32768) and `QCU_UF_MEM_LATENCY`
+/// (default 1 cycle) size the union-find accelerator's parent BRAM and its
+/// read latency in the SoC, and `QCU_UF_WALKERS` (default 4) the number of
+/// finds its multi-query engine keeps in flight. `QCU_DEC_NODES` (default
+/// 4096, at most 4096) and `QCU_DEC_EDGES` (default 16384, at most 32768)
+/// size the decoding graph the full-decode block can hold.
+///
+/// The union-find model is verilated into `OUT_DIR/union_find` and the
+/// archives Verilator produces there (`Vunion_find__ALL.a` and
+/// `libverilated.a`) are linked into the crate together with
+/// `src/sim/hw_api.cpp`, which implements the FFI declared in `lib.rs`.
 fn main() {
     let out_dir = PathBuf::from(env::var("OUT_DIR").unwrap());
     let manifest_dir = PathBuf::from(env::var("CARGO_MANIFEST_DIR").unwrap());
@@ -23,7 +54,113 @@ fn main() {
     let sim_cpp = manifest_dir.join("src/sim/main.cpp");
     let top_sv = rtl_dir.join("top_soc.sv");
 
-    let status = Command::new("verilator")
+    let mt_sim = env::var_os("CARGO_FEATURE_MT_SIM").is_some();
+    let threads = match env::var("QCU_SIM_THREADS") {
+        Ok(n) => n
+            .parse::<u32>()
+            .expect("QCU_SIM_THREADS must be a thread count"),
+        Err(_) if mt_sim => 4,
+        Err(_) => 1,
+    };
+
+    let grid_dim = match env::var("QCU_GRID_DIM") {
+        Ok(n) => n.parse::<u32>().expect("QCU_GRID_DIM must be a grid size"),
+        Err(_) => 3,
+    };
+    assert!(
+        (1..=32).contains(&grid_dim),
+        "QCU_GRID_DIM must be between 1 and 32"
+    );
+
+    let uf_depth = match env::var("QCU_UF_DEPTH") {
+        Ok(n) => n
+            .parse::<u32>()
+            .expect("QCU_UF_DEPTH must be an entry count"),
+        Err(_) => 4096,
+    };
+    assert!(
+        (2..=32768).contains(&uf_depth),
+        "QCU_UF_DEPTH must be between 2 and 32768"
+    );
+
+    let uf_latency = match env::var("QCU_UF_MEM_LATENCY") {
+        Ok(n) => n
+            .parse::<u32>()
+            .expect("QCU_UF_MEM_LATENCY must be a cycle count"),
+        Err(_) => 1,
+    };
+    assert!(uf_latency >= 1, "QCU_UF_MEM_LATENCY must be at least 1");
+
+    let uf_walkers = match env::var("QCU_UF_WALKERS") {
+        Ok(n) => n
+            .parse::<u32>()
+            .expect("QCU_UF_WALKERS must be a walker count"),
+        Err(_) => 4,
+    };
+    assert!(
+        (1..=64).contains(&uf_walkers),
+        "QCU_UF_WALKERS must be between 1 and 64"
+    );
+
+    let dec_nodes = match env::var("QCU_DEC_NODES") {
+        Ok(n) => n
+            .parse::<u32>()
+            .expect("QCU_DEC_NODES must be a node count"),
+        Err(_) => 4096,
+    };
+    assert!(
+        (2..=4096).contains(&dec_nodes),
+        "QCU_DEC_NODES must be between 2 and 4096"
+    );
+
+    let dec_edges = match env::var("QCU_DEC_EDGES") {
+        Ok(n) => n
+            .parse::<u32>()
+            .expect("QCU_DEC_EDGES must be an edge count"),
+        Err(_) => 16384,
+    };
+    assert!(
+        (2..=32768).contains(&dec_edges),
+        "QCU_DEC_EDGES must be between 2 and 32768"
+    );
+
+    let mut cflags = format!("-pthread -DQCU_SIM_THREADS={}", threads);
+    let mut ldflags = String::from("-lrt -pthread");
+
+    let mut verilator = Command::new("verilator");
+    verilator.arg(format!("-GGRID_DIM={}", grid_dim));
+    verilator.arg(format!("-GUF_DEPTH={}", uf_depth));
+    verilator.arg(format!("-GUF_MEM_LATENCY={}", uf_latency));
+    verilator.arg(format!("-GUF_WALKERS={}", uf_walkers));
+    verilator.arg(format!("-GDEC_NODES={}", dec_nodes));
+    verilator.arg(format!("-GDEC_EDGES={}", dec_edges));
+    if env::var_os("CARGO_FEATURE_RTL_TRACE").is_some() {
+        verilator.arg("+define+QCU_TRACE");
+    }
+    if env::var_os("CARGO_FEATURE_FST_TRACE").is_some() {
+        verilator.arg("--trace-fst");
+        cflags.push_str(" -DQCU_FST");
+    }
+    if env::var_os("CARGO_FEATURE_SNAPSHOT").is_some() {
+        assert!(
+            threads == 1,
+            "The snapshot feature needs a single-threaded model (no mt-sim/QCU_SIM_THREADS)"
+        );
+        verilator.arg("--savable");
+        cflags.push_str(" -DQCU_SAVABLE");
+    }
+    if threads > 1 {
+        verilator.arg("--threads").arg(threads.to_string());
+    }
+    if mt_sim {
+        cflags.push_str(" -march=native -flto");
+        ldflags.push_str(" -flto");
+        verilator
+            .arg("-MAKEFLAGS")
+            .arg("OPT_FAST=-O3 OPT_GLOBAL=-O3");
+    }
+
+    let status = verilator
         .arg("--cc")
         .arg("--exe")
         .arg("--build")
@@ -32,6 +169,11 @@ fn main() {
         .arg(&out_dir)
         .arg("-Isrc/rtl")
         .arg("-Isrc/rtl/physics")
+        .arg("-Isrc/rtl/accel")
+        .arg("-CFLAGS")
+        .arg(&cflags)
+        .arg("-LDFLAGS")
+        .arg(&ldflags)
         .arg("-o")
         .arg("Vtop_soc_sim")
         .arg(&top_sv)
@@ -44,8 +186,88 @@ fn main() {
         panic!("Verilator build failed.");
     }
 
+    build_union_find_lib(&manifest_dir, &out_dir);
+
+    println!("cargo:rerun-if-env-changed=QCU_SIM_THREADS");
+    println!("cargo:rerun-if-env-changed=QCU_GRID_DIM");
+    println!("cargo:rerun-if-env-changed=QCU_UF_DEPTH");
+    println!("cargo:rerun-if-env-changed=QCU_UF_MEM_LATENCY");
+    println!("cargo:rerun-if-env-changed=QCU_UF_WALKERS");
+    println!("cargo:rerun-if-env-changed=QCU_DEC_NODES");
+    println!("cargo:rerun-if-env-changed=QCU_DEC_EDGES");
     println!("cargo:rerun-if-changed=src/rtl/top_soc.sv");
     println!("cargo:rerun-if-changed=src/rtl/physics/hamiltonian_engine.sv");
     println!("cargo:rerun-if-changed=src/rtl/physics/qubit_grid.sv");
+    println!("cargo:rerun-if-changed=src/rtl/physics/noise_channel.sv");
+    println!("cargo:rerun-if-changed=src/rtl/accel/union_find.sv");
+    println!("cargo:rerun-if-changed=src/rtl/accel/uf_accel.sv");
+    println!("cargo:rerun-if-changed=src/rtl/accel/union_find_mq.sv");
+    println!("cargo:rerun-if-changed=src/rtl/accel/uf_decoder.sv");
     println!("cargo:rerun-if-changed=src/sim/main.cpp");
+    println!("cargo:rerun-if-changed=src/sim/hw_api.cpp");
+    println!("cargo:rerun-if-changed=src/sim/channel.h");
+    println!("cargo:rerun-if-changed=src/sim/shm_channel.h");
+    println!("cargo:rerun-if-changed=src/sim/sim_stats.h");
+    println!("cargo:rerun-if-changed=src/sim/latency_hist.h");
+    println!("cargo:rerun-if-changed=src/sim/fst_trace.h");
+    println!("cargo:rerun-if-changed=src/sim/snapshot.h");
+    println!("cargo:rerun-if-changed=src/sim/events.h");
+    println!("cargo:rerun-if-changed=src/sim/realtime.h");
+    println!("cargo:rerun-if-changed=src/sim/replay_log.h");
+}
+
+/// Builds the in-process union-find accelerator library.
+///
+/// Verilates `union_find.sv` without a harness so Verilator only produces
+/// the model and runtime archives, then compiles the C interface in
+/// `hw_api.cpp` against the generated headers and emits the link
+/// directives that pull all three into the crate.
+///
+/// # Arguments
+///
+/// * `manifest_dir` - Crate root containing `src/rtl` and `src/sim`
+/// * `out_dir` - Cargo build output directory
+fn build_union_find_lib(manifest_dir: &Path, out_dir: &Path) {
+    let uf_dir = out_dir.join("union_find");
+
+    let status = Command::new("verilator")
+        .arg("--cc")
+        .arg("--build")
+        .arg("-O3")
+        .arg("--Mdir")
+        .arg(&uf_dir)
+        .arg("--prefix")
+        .arg("Vunion_find")
+        .arg("-CFLAGS")
+        .arg("-fPIC")
+        .arg(manifest_dir.join("src/rtl/accel/union_find.sv"))
+        .current_dir(manifest_dir)
+        .status()
+        .expect("Failed to run verilator");
+
+    if !status.success() {
+        panic!("Verilator build of union_find failed.");
+    }
+
+    let root = Command::new("verilator")
+        .arg("--getenv")
+        .arg("VERILATOR_ROOT")
+        .output()
+        .expect("Failed to query VERILATOR_ROOT");
+    let root = PathBuf::from(String::from_utf8_lossy(&root.stdout).trim());
+
+    cc::Build::new()
+        .cpp(true)
+        .std("c++17")
+        .opt_level(3)
+        .include(&uf_dir)
+        .include(root.join("include"))
+        .include(root.join("include/vltstd"))
+        .file(manifest_dir.join("src/sim/hw_api.cpp"))
+        .compile("qcu_hw_api");
+
+    println!("cargo:rustc-link-search=native={}", uf_dir.display());
+    println!("cargo:rustc-link-lib=static=Vunion_find__ALL");
+    println!("cargo:rustc-link-lib=static=verilated");
+    println!("cargo:rustc-link-lib=pthread");
 }
@@ -4,14 +4,19 @@
 //! implemented in Verilog/SystemVerilog. The interface communicates with
 //! a Verilator simulation via FFI bindings to test hardware acceleration
 //! of the decoder's critical path operations.
+//!
+//! The model is linked into the process (see `src/sim/hw_api.cpp`), so every
+//! call below is a plain function call with no simulation server or IPC in
+//! between. The batch entry points run whole sequences of finds inside the
+//! C++ side for high-volume co-verification against the software DSU.
 
 // Foreign function interface to hardware simulation functions.
 //
-// These functions are implemented in C++ and linked with the Verilator
-// simulation. They provide low-level control over the hardware accelerator's
-// state machine and data paths. All functions are marked unsafe because
-// they interact with external C++ code that may have different safety
-// guarantees than Rust.
+// These functions are implemented in `src/sim/hw_api.cpp` and linked with
+// the Verilator model of `union_find.sv`. They provide low-level control
+// over the hardware accelerator's state machine and data paths. All
+// functions are marked unsafe because they interact with external C++ code
+// that may have different safety guarantees than Rust.
 unsafe extern "C" {
     /// Initializes the hardware accelerator with parent array data.
     ///
@@ -67,14 +72,57 @@ unsafe extern "C" {
     ///
     /// Non-zero if done, zero if still processing
     fn hw_is_done() -> i32;
+
+    /// Finds the roots of an array of nodes in one call.
+    ///
+    /// Runs the finds back to back inside the simulation, cycle-for-cycle
+    /// identical to driving each one through hw_set_input and hw_step, and
+    /// stops at the first find that exceeds its cycle budget.
+    ///
+    /// # Arguments
+    ///
+    /// * `nodes` - Pointer to the starting node indices
+    /// * `roots` - Pointer to the output buffer, one root per node
+    /// * `count` - Number of entries in both buffers
+    /// * `max_cycles` - Cycle budget for each individual find
+    ///
+    /// # Returns
+    ///
+    /// Number of finds completed (equal to count unless one timed out)
+    fn hw_find_roots(nodes: *const u32, roots: *mut u32, count: usize, max_cycles: u64) -> usize;
+
+    /// Overwrites a range of the accelerator's parent array.
+    ///
+    /// Writing past the current end grows the array; skipped entries become
+    /// roots of their own sets.
+    ///
+    /// # Arguments
+    ///
+    /// * `offset` - Index of the first entry to write
+    /// * `data` - Pointer to the replacement parent values
+    /// * `len` - Number of entries to write
+    fn hw_write_parents(offset: usize, data: *const u32, len: usize);
+
+    /// Returns the number of clock cycles simulated since hw_init.
+    ///
+    /// # Returns
+    ///
+    /// Cycle count, excluding the reset sequence
+    fn hw_cycles() -> u64;
 }
 
+/// Cycle budget for a single find before the accelerator is considered hung.
+const FIND_TIMEOUT_CYCLES: u64 = 2000;
+
 /// Wrapper for hardware-accelerated union-find operations.
 ///
 /// Provides a safe Rust interface to the hardware accelerator, managing
 /// initialization and cleanup automatically. The accelerator performs
 /// path compression in hardware to reduce latency compared to software
 /// implementations.
+///
+/// The underlying model is a process-wide singleton, so only one instance
+/// may exist at a time and it must not be shared between threads.
 pub struct UnionFindAccel {
     /// Phantom data marker to prevent construction without initialization.
     _marker: std::marker::PhantomData<()>,
@@ -133,7 +181,7 @@ impl UnionFindAccel {
             while hw_is_done() == 0 {
                 hw_step();
                 cycles += 1;
-                if cycles > 2000 {
+                if cycles > FIND_TIMEOUT_CYCLES {
                     panic!(
                         "Hardware Accelerator Timeout on node {}! Cycles: {}",
                         node_idx, cycles
@@ -143,6 +191,66 @@ impl UnionFindAccel {
             hw_get_root() as u32
         }
     }
+
+    /// Finds the roots of many nodes with a single call into the model.
+    ///
+    /// Equivalent to calling find_root for each node in order, but the
+    /// per-cycle stepping happens on the C++ side, so the cost per find is
+    /// one simulated walk rather than one FFI round trip per cycle.
+    ///
+    /// # Arguments
+    ///
+    /// * `nodes` - Node indices to find the roots for
+    ///
+    /// # Returns
+    ///
+    /// The root of each node, in the same order as `nodes`.
+    ///
+    /// # Panics
+    ///
+    /// Panics if any find does not complete within 2000 simulation cycles.
+    pub fn find_roots(&self, nodes: &[u32]) -> Vec<u32> {
+        let mut roots = vec![0u32; nodes.len()];
+        let done = unsafe {
+            hw_find_roots(
+                nodes.as_ptr(),
+                roots.as_mut_ptr(),
+                nodes.len(),
+                FIND_TIMEOUT_CYCLES,
+            )
+        };
+        if done < nodes.len() {
+            panic!(
+                "Hardware Accelerator Timeout on node {}! Cycles: {}",
+                nodes[done], FIND_TIMEOUT_CYCLES
+            );
+        }
+        roots
+    }
+
+    /// Updates part of the parent array held by the model.
+    ///
+    /// Lets the caller mirror unions applied to a software DSU without
+    /// resetting the accelerator.
+    ///
+    /// # Arguments
+    ///
+    /// * `offset` - Index of the first parent entry to overwrite
+    /// * `parents` - Replacement parent values
+    pub fn write_parents(&self, offset: usize, parents: &[u32]) {
+        unsafe {
+            hw_write_parents(offset, parents.as_ptr(), parents.len());
+        }
+    }
+
+    /// Returns the number of clock cycles the accelerator has simulated.
+    ///
+    /// # Returns
+    ///
+    /// Cycles elapsed since construction, excluding reset.
+    pub fn cycles(&self) -> u64 {
+        unsafe { hw_cycles() }
+    }
 }
 
 impl Drop for UnionFindAccel {
@@ -0,0 +1,367 @@
+/**
+ * @file uf_accel.sv
+ * @brief Memory-mapped union-find find engine with a parent-array BRAM.
+ *
+ * Wraps the union_find path-walking FSM with the memory it walks and a
+ * register interface on the system bus. The parent array lives in an
+ * on-chip BRAM of UF_DEPTH words that the host bulk-loads with burst
+ * writes; the engine's memory port reads it through a pipeline of
+ * UF_MEM_LATENCY cycles, so find latency can be measured under the memory
+ * timing of the target instead of the zero-wait model used by the FFI
+ * harness. A find is started by writing the node index to the find
+ * register; status, root, cycle and hop counters are readable once it
+ * completes.
+ *
+ * A second engine, union_find_mq, serves streams of tagged queries with
+ * several walks in flight and writes path compression back to the BRAM.
+ * Writing node n to mq_query[t] queues a query with tag t; its root shows
+ * up in mq_result[t] once done, so a batch is pushed with one burst write
+ * and collected with one burst read. The two engines share the BRAM read
+ * port, with the single-query engine taking priority; a compression write
+ * that collides with a bus write to the BRAM is dropped, which only costs
+ * the compression, never correctness.
+ *
+ * Register map (word offsets):
+ *   0x00       status          bit 0 busy, bit 1 done (cleared by find)
+ *   0x01       find            write a node index to start a find
+ *   0x02       root            root reported by the last find
+ *   0x03       cycles          cycles from the find write to done
+ *   0x04       hops            parent reads issued by the last find
+ *   0x05       depth           UF_DEPTH (read-only)
+ *   0x06       mem_latency     UF_MEM_LATENCY (read-only)
+ *   0x07       mq_status       bits 15:0 queries in flight, bit 16 queue
+ *                              overflow, bit 17 idle (nothing in flight)
+ *   0x08       mq_cycles       cycles with queries in flight; any write
+ *                              clears all mq counters and the overflow
+ *   0x09       mq_finds        queries completed
+ *   0x0A       mq_reads        parent reads issued
+ *   0x0B       mq_writes       path compression writes committed
+ *   0x0C       mq_walkers      UF_WALKERS (read-only)
+ *   0x100+t    mq_query[t]     write a node index to queue it with tag t
+ *   0x200+t    mq_result[t]    bit 31 valid, bits 30:0 root of query t
+ *   0x8000+i   parent[i]       parent array entry i
+ *
+ * Engine reads past UF_DEPTH return the address itself, so a pointer out
+ * of range terminates the walk as a root. The BRAM powers up with every
+ * node as its own root.
+ *
+ * @param UF_DEPTH Parent array entries (2 to 32768)
+ * @param UF_MEM_LATENCY Parent read latency in clock cycles (at least 1)
+ * @param UF_WALKERS Walks the multi-query engine keeps in flight
+ */
+module uf_accel #(
+    parameter int UF_DEPTH       = 4096,
+    parameter int UF_MEM_LATENCY = 1,
+    parameter int UF_WALKERS     = 4
+)(
+    input  logic        clk,      /**< System clock */
+    input  logic        rst_n,    /**< Active-low asynchronous reset */
+
+    input  logic        cs,       /**< Chip select (register access valid) */
+    input  logic        we,       /**< Write enable (1=write, 0=read) */
+    input  logic [15:0] addr,     /**< 16-bit register address */
+    input  logic [31:0] wdata,    /**< 32-bit write data */
+    output logic [31:0] rdata,    /**< 32-bit read data */
+    output logic        quiescent /**< Idle cycles leave all state unchanged */
+);
+
+    localparam int IDX_BITS = $clog2(UF_DEPTH); /**< Parent array index width */
+    localparam int MQ_TAGS  = 256;               /**< Query tags and queue slots */
+    localparam int CTX_BITS = (UF_WALKERS > 1) ? $clog2(UF_WALKERS) : 1;
+
+    logic [31:0] parent_mem [UF_DEPTH]; /**< Parent array BRAM */
+
+    logic        mem_rd_en;  /**< Engine read request */
+    logic [31:0] mem_addr;   /**< Engine read address */
+    logic [31:0] mem_rdata;  /**< Parent value returned to the engine */
+    logic        mem_ready;  /**< Read data valid this cycle */
+
+    logic        find_wr;    /**< Bus write to the find register */
+    logic        eng_done;   /**< Engine reports a completed find */
+    logic        eng_busy;   /**< Engine is walking */
+    logic [31:0] eng_root;   /**< Engine root output */
+
+    logic        running;    /**< Find issued and not yet completed */
+    logic        done_flag;  /**< Last find completed */
+    logic [31:0] root_reg;   /**< Root of the last completed find */
+    logic [31:0] cycle_cnt;  /**< Cycles spent by the current/last find */
+    logic [31:0] hop_cnt;    /**< Parent reads by the current/last find */
+
+    logic [UF_MEM_LATENCY-1:0] rd_valid_pipe;                 /**< Read in flight per stage */
+    logic [UF_MEM_LATENCY-1:0] rd_mq_pipe;                    /**< Read issued by the mq engine */
+    logic [31:0]               rd_addr_pipe [UF_MEM_LATENCY]; /**< Read address per stage */
+    logic [CTX_BITS-1:0]       rd_ctx_pipe  [UF_MEM_LATENCY]; /**< mq walker per stage */
+
+    logic                mq_q_valid;    /**< Queue holds a query for the engine */
+    logic                mq_q_ready;    /**< Engine takes the queued query */
+    logic [31:0]         mq_q_node;     /**< Node of the queue head */
+    logic [7:0]          mq_q_tag;      /**< Tag of the queue head */
+    logic                mq_r_valid;    /**< Engine completed a query */
+    logic [31:0]         mq_r_root;     /**< Root of the completed query */
+    logic [7:0]          mq_r_tag;      /**< Tag of the completed query */
+    logic                mq_rd_en;      /**< mq engine parent read request */
+    logic                mq_rd_gnt;     /**< mq read granted this cycle */
+    logic [31:0]         mq_rd_addr;    /**< mq engine read address */
+    logic [CTX_BITS-1:0] mq_rd_ctx;     /**< mq engine issuing walker */
+    logic                mq_rsp_valid;  /**< Read data for the mq engine */
+    logic                mq_wr_en;      /**< Path compression write request */
+    logic [31:0]         mq_wr_addr;    /**< Node being repointed */
+    logic [31:0]         mq_wr_data;    /**< Its new parent */
+    logic                mq_busy;       /**< A walker is occupied */
+
+    logic [31:0]         mq_fifo_node [MQ_TAGS]; /**< Query queue nodes */
+    logic [7:0]          mq_fifo_tag  [MQ_TAGS]; /**< Query queue tags */
+    logic [7:0]          mq_head;       /**< Queue read slot */
+    logic [7:0]          mq_tail;       /**< Queue write slot */
+    logic [8:0]          mq_count;      /**< Queued queries */
+    logic [30:0]         mq_root_mem  [MQ_TAGS]; /**< Result root per tag */
+    logic [MQ_TAGS-1:0]  mq_done_mask;  /**< Result valid per tag */
+    logic [15:0]         mq_inflight;   /**< Queued or walking queries */
+    logic                mq_overflow;   /**< A query was dropped on a full queue */
+    logic [31:0]         mq_cycle_cnt;  /**< Cycles with queries in flight */
+    logic [31:0]         mq_find_cnt;   /**< Completed queries */
+    logic [31:0]         mq_read_cnt;   /**< Parent reads issued */
+    logic [31:0]         mq_write_cnt;  /**< Compression writes committed */
+
+    logic        bram_sel;   /**< Access targets the parent array window */
+    logic [14:0] bram_idx;   /**< Parent array index of the access */
+    assign bram_sel = addr[15];
+    assign bram_idx = addr[14:0];
+
+    assign find_wr = cs && we && !bram_sel && (addr[14:0] == 15'h0001);
+
+    logic mq_push;       /**< Bus write to an mq_query slot */
+    logic mq_clear;      /**< Bus write clearing the mq counters */
+    logic bus_bram_wr;   /**< Bus write to the parent array */
+    logic mq_wr_commit;  /**< Compression write reaches the BRAM */
+    assign mq_push      = cs && we && !bram_sel && (addr[14:8] == 7'h01);
+    assign mq_clear     = cs && we && !bram_sel && (addr[14:0] == 15'h0008);
+    assign bus_bram_wr  = cs && we && bram_sel && (32'(bram_idx) < UF_DEPTH);
+    assign mq_wr_commit = mq_wr_en && !bus_bram_wr && (mq_wr_addr < UF_DEPTH);
+
+    union_find #(
+        .WIDTH(32)
+    ) u_find (
+        .clk(clk),
+        .rst_n(rst_n),
+        .start(find_wr),
+        .node_in(wdata),
+        .root_out(eng_root),
+        .done(eng_done),
+        .busy(eng_busy),
+        .mem_rd_en(mem_rd_en),
+        .mem_addr(mem_addr),
+        .mem_rdata(mem_rdata),
+        .mem_ready(mem_ready)
+    );
+
+    union_find_mq #(
+        .WIDTH(32),
+        .TAG_BITS(8),
+        .NUM_WALKERS(UF_WALKERS),
+        .CTX_BITS(CTX_BITS)
+    ) u_find_mq (
+        .clk(clk),
+        .rst_n(rst_n),
+        .q_valid(mq_q_valid),
+        .q_ready(mq_q_ready),
+        .q_node(mq_q_node),
+        .q_tag(mq_q_tag),
+        .r_valid(mq_r_valid),
+        .r_ready(1'b1),
+        .r_root(mq_r_root),
+        .r_tag(mq_r_tag),
+        .mem_rd_en(mq_rd_en),
+        .mem_rd_gnt(mq_rd_gnt),
+        .mem_rd_addr(mq_rd_addr),
+        .mem_rd_ctx(mq_rd_ctx),
+        .mem_rsp_valid(mq_rsp_valid),
+        .mem_rsp_ctx(rd_ctx_pipe[UF_MEM_LATENCY-1]),
+        .mem_rsp_data(mem_rdata),
+        .mem_wr_en(mq_wr_en),
+        .mem_wr_addr(mq_wr_addr),
+        .mem_wr_data(mq_wr_data),
+        .busy(mq_busy)
+    );
+
+    initial begin
+        for (int i = 0; i < UF_DEPTH; i++) parent_mem[IDX_BITS'(i)] = 32'(i);
+    end
+
+    /**
+     * Parent array write port (system bus, then path compression).
+     */
+    always_ff @(posedge clk) begin
+        if (bus_bram_wr) begin
+            parent_mem[bram_idx[IDX_BITS-1:0]] <= wdata;
+        end else if (mq_wr_commit) begin
+            parent_mem[mq_wr_addr[IDX_BITS-1:0]] <= mq_wr_data;
+        end
+    end
+
+    /**
+     * Parent array read pipeline (engine port).
+     *
+     * A request enters stage 0 on the edge after it is issued and the data
+     * is presented once it reaches the last stage, i.e. UF_MEM_LATENCY
+     * cycles after the request cycle. The port accepts one read per cycle;
+     * the single-query engine wins, the mq engine is granted otherwise, and
+     * each stage remembers which engine and walker the read belongs to.
+     */
+    assign mq_rd_gnt = mq_rd_en && !mem_rd_en;
+
+    always_ff @(posedge clk or negedge rst_n) begin
+        if (!rst_n) begin
+            rd_valid_pipe <= '0;
+            rd_mq_pipe    <= '0;
+        end else begin
+            rd_valid_pipe[0] <= mem_rd_en || mq_rd_gnt;
+            rd_mq_pipe[0]    <= !mem_rd_en;
+            for (int s = 1; s < UF_MEM_LATENCY; s++) begin
+                rd_valid_pipe[s] <= rd_valid_pipe[s-1];
+                rd_mq_pipe[s]    <= rd_mq_pipe[s-1];
+            end
+        end
+    end
+
+    always_ff @(posedge clk) begin
+        rd_addr_pipe[0] <= mem_rd_en ? mem_addr : mq_rd_addr;
+        rd_ctx_pipe[0]  <= mq_rd_ctx;
+        for (int s = 1; s < UF_MEM_LATENCY; s++) begin
+            rd_addr_pipe[s] <= rd_addr_pipe[s-1];
+            rd_ctx_pipe[s]  <= rd_ctx_pipe[s-1];
+        end
+    end
+
+    logic [31:0] rd_out_addr;
+    assign rd_out_addr  = rd_addr_pipe[UF_MEM_LATENCY-1];
+    assign mem_ready    = rd_valid_pipe[UF_MEM_LATENCY-1] && !rd_mq_pipe[UF_MEM_LATENCY-1];
+    assign mq_rsp_valid = rd_valid_pipe[UF_MEM_LATENCY-1] && rd_mq_pipe[UF_MEM_LATENCY-1];
+    assign mem_rdata   = (rd_out_addr < UF_DEPTH) ? parent_mem[rd_out_addr[IDX_BITS-1:0]]
+                                                  : rd_out_addr;
+
+    /**
+     * Find bookkeeping: completion flag, latched root and counters.
+     *
+     * cycles counts clock edges from the find write until the engine
+     * enters DONE_ST; hops counts the parent reads it issued on the way.
+     */
+    always_ff @(posedge clk or negedge rst_n) begin
+        if (!rst_n) begin
+            running   <= 1'b0;
+            done_flag <= 1'b0;
+            root_reg  <= '0;
+            cycle_cnt <= '0;
+            hop_cnt   <= '0;
+        end else if (find_wr && !eng_busy) begin
+            running   <= 1'b1;
+            done_flag <= 1'b0;
+            cycle_cnt <= '0;
+            hop_cnt   <= '0;
+        end else if (running) begin
+            if (eng_done) begin
+                running   <= 1'b0;
+                done_flag <= 1'b1;
+                root_reg  <= eng_root;
+            end else begin
+                cycle_cnt <= cycle_cnt + 32'd1;
+                if (mem_rd_en) hop_cnt <= hop_cnt + 32'd1;
+            end
+        end
+    end
+
+    /**
+     * Multi-query front end: query queue, per-tag results and counters.
+     *
+     * Pushing a query clears the result of its tag; a result landing in
+     * the same cycle for that tag belonged to an earlier query and is
+     * discarded. Queries pushed while the queue is full are dropped and
+     * flagged in mq_status.
+     */
+    assign mq_q_valid = (mq_count != 9'd0);
+    assign mq_q_node  = mq_fifo_node[mq_head];
+    assign mq_q_tag   = mq_fifo_tag[mq_head];
+
+    logic mq_pop;     /**< Engine takes the queue head this cycle */
+    logic mq_accept;  /**< Bus push enters the queue this cycle */
+    assign mq_pop    = mq_q_valid && mq_q_ready;
+    assign mq_accept = mq_push && (mq_count != 9'(MQ_TAGS));
+
+    always_ff @(posedge clk) begin
+        if (mq_accept) begin
+            mq_fifo_node[mq_tail] <= wdata;
+            mq_fifo_tag[mq_tail]  <= addr[7:0];
+        end
+        if (mq_r_valid) begin
+            mq_root_mem[mq_r_tag] <= mq_r_root[30:0];
+        end
+    end
+
+    always_ff @(posedge clk or negedge rst_n) begin
+        if (!rst_n) begin
+            mq_head      <= '0;
+            mq_tail      <= '0;
+            mq_count     <= '0;
+            mq_done_mask <= '0;
+            mq_inflight  <= '0;
+            mq_overflow  <= 1'b0;
+            mq_cycle_cnt <= '0;
+            mq_find_cnt  <= '0;
+            mq_read_cnt  <= '0;
+            mq_write_cnt <= '0;
+        end else begin
+            if (mq_pop) mq_head <= mq_head + 8'd1;
+            if (mq_accept) mq_tail <= mq_tail + 8'd1;
+            mq_count    <= mq_count + 9'(mq_accept) - 9'(mq_pop);
+            mq_inflight <= mq_inflight + 16'(mq_accept) - 16'(mq_r_valid);
+
+            if (mq_r_valid) mq_done_mask[mq_r_tag] <= 1'b1;
+            if (mq_accept) mq_done_mask[addr[7:0]] <= 1'b0;
+
+            if (mq_clear) begin
+                mq_overflow  <= 1'b0;
+                mq_cycle_cnt <= '0;
+                mq_find_cnt  <= '0;
+                mq_read_cnt  <= '0;
+                mq_write_cnt <= '0;
+            end else begin
+                if (mq_push && !mq_accept) mq_overflow <= 1'b1;
+                if (mq_inflight != 16'd0) mq_cycle_cnt <= mq_cycle_cnt + 32'd1;
+                if (mq_r_valid) mq_find_cnt <= mq_find_cnt + 32'd1;
+                if (mq_rd_gnt) mq_read_cnt <= mq_read_cnt + 32'd1;
+                if (mq_wr_commit) mq_write_cnt <= mq_write_cnt + 32'd1;
+            end
+        end
+    end
+
+    assign quiescent = !running && !eng_busy && !eng_done && (rd_valid_pipe == '0)
+                    && !mq_busy && (mq_inflight == 16'd0);
+
+    always_comb begin
+        rdata = '0;
+        if (cs && !we) begin
+            if (bram_sel) begin
+                if (32'(bram_idx) < UF_DEPTH) rdata = parent_mem[bram_idx[IDX_BITS-1:0]];
+            end else begin
+                if (addr[14:8] == 7'h02) begin
+                    rdata = {mq_done_mask[addr[7:0]], mq_root_mem[addr[7:0]]};
+                end else case (addr[14:0])
+                    15'h0000: rdata = {30'b0, done_flag, running};
+                    15'h0002: rdata = root_reg;
+                    15'h0003: rdata = cycle_cnt;
+                    15'h0004: rdata = hop_cnt;
+                    15'h0005: rdata = 32'(UF_DEPTH);
+                    15'h0006: rdata = 32'(UF_MEM_LATENCY);
+                    15'h0007: rdata = {14'b0, mq_inflight == 16'd0, mq_overflow, mq_inflight};
+                    15'h0008: rdata = mq_cycle_cnt;
+                    15'h0009: rdata = mq_find_cnt;
+                    15'h000A: rdata = mq_read_cnt;
+                    15'h000B: rdata = mq_write_cnt;
+                    15'h000C: rdata = 32'(UF_WALKERS);
+                    default:  rdata = '0;
+                endcase
+            end
+        end
+    end
+
+endmodule
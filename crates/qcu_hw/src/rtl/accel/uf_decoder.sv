@@ -0,0 +1,394 @@
+/**
+ * @file uf_decoder.sv
+ * @brief Full union-find decode offload: syndrome in, corrections out.
+ *
+ * Runs the complete cluster growth of `UnionFindDecoder::solve_into` in
+ * hardware over a decoding graph held in on-chip memory. The host loads the
+ * edge list and the fired detector indices through the register windows,
+ * writes the start bit and polls the busy bit, the same trigger/poll shape
+ * as the firmware's `DecoderAccelerator` driver. The simulated SoC has no
+ * bus master, so the buffers live in the block instead of being fetched
+ * from the syndrome and result pointers the driver passes.
+ *
+ * The engine follows the software step for step: it resets the forest,
+ * toggles the parity of every fired detector, then sweeps the edge list,
+ * skipping edges with no touched endpoint, finding both roots with path
+ * halving and merging by rank when either root has odd parity, until a
+ * sweep performs no union. Each union appends its edge to the correction
+ * buffer. Unlike dsu.rs, the union reuses the two roots just found instead
+ * of finding them again; cluster membership, parities and therefore the
+ * correction list are identical. A final scan lists the roots still
+ * carrying odd parity (clusters that could not be neutralized).
+ *
+ * In weighted mode the engine follows `WeightedDecoder::solve_into`
+ * instead: every edge carries a 4-bit growth step count, loaded from the
+ * same packed buffer the software decoder reads (`edge_steps`), and each
+ * round is a growth sweep, which advances every live edge between two
+ * different roots by the number of odd roots it joins, followed by a
+ * fusion sweep, which merges across every fully grown edge and records it
+ * as a correction. Rounds repeat until a growth sweep grows nothing.
+ *
+ * Register map (word offsets):
+ *   0x00       ctrl            write bit 0 to start a decode
+ *   0x01       status          bit 0 busy, bit 1 correction overflow,
+ *                              bit 2 done
+ *   0x02       num_syndromes   fired detectors loaded in the syndrome window
+ *   0x03       num_nodes       detectors in the graph
+ *   0x04       num_edges       edges loaded in the edge window
+ *   0x05       num_corrections corrections produced (read-only)
+ *   0x06       cycles          cycles taken by the last decode (read-only)
+ *   0x07       passes          edge list sweeps (read-only)
+ *   0x08       finds           root finds performed (read-only)
+ *   0x09       num_odd_roots   odd-parity roots after decode (read-only)
+ *   0x0A       max_nodes       DEC_NODES (read-only)
+ *   0x0B       max_edges       DEC_EDGES (read-only)
+ *   0x0C       max_syndromes   DEC_SYNDROMES (read-only)
+ *   0x0D       mode            bit 0 weighted growth
+ *   0x1000+k   steps[k]        growth steps of edges 8k..8k+7, edge 8k+j in
+ *                              bits 4j+3:4j
+ *   0x2000+k   correction[k]   {v[15:0], u[15:0]} of correction k
+ *   0x3000+k   odd_root[k]     node index of odd-parity root k
+ *   0x4000+i   syndrome[i]     fired detector index i
+ *   0x8000+e   edge[e]         {v[15:0], u[15:0]} of edge e
+ *
+ * Configuration and buffer writes are ignored while a decode is running.
+ *
+ * @param DEC_NODES Detector capacity (2 to 4096)
+ * @param DEC_EDGES Edge capacity (2 to 32768)
+ * @param DEC_SYNDROMES Syndrome list capacity (2 to 16384)
+ */
+module uf_decoder #(
+    parameter int DEC_NODES     = 4096,
+    parameter int DEC_EDGES     = 16384,
+    parameter int DEC_SYNDROMES = 4096
+)(
+    input  logic        clk,      /**< System clock */
+    input  logic        rst_n,    /**< Active-low asynchronous reset */
+
+    input  logic        cs,       /**< Chip select (register access valid) */
+    input  logic        we,       /**< Write enable (1=write, 0=read) */
+    input  logic [15:0] addr,     /**< 16-bit register address */
+    input  logic [31:0] wdata,    /**< 32-bit write data */
+    output logic [31:0] rdata,    /**< 32-bit read data */
+    output logic        quiescent /**< Idle cycles leave all state unchanged */
+);
+
+    localparam int NODE_BITS = $clog2(DEC_NODES);     /**< Node index width */
+    localparam int EDGE_BITS = $clog2(DEC_EDGES);     /**< Edge index width */
+    localparam int SYN_BITS  = $clog2(DEC_SYNDROMES); /**< Syndrome index width */
+    localparam int STEP_WORDS = (DEC_EDGES + 7) / 8;  /**< Packed step words */
+    localparam int STEP_BITS  = (STEP_WORDS > 1) ? $clog2(STEP_WORDS) : 1; /**< Step word index width */
+
+    /**
+     * Decoder sequencing states.
+     *
+     * INIT resets one node per cycle and SYN applies one syndrome per
+     * cycle. EDGE fetches an edge and either skips it or starts FIND_U;
+     * each FIND cycle performs one path-halving step. UNION merges the two
+     * roots if needed (or, in a weighted growth sweep, grows the edge), and
+     * SCAN collects the odd-parity roots at the end.
+     */
+    typedef enum logic [2:0] {
+        D_IDLE   = 3'd0, /**< Waiting for start */
+        D_INIT   = 3'd1, /**< Reset parent, rank, parity, touched (and growth) */
+        D_SYN    = 3'd2, /**< Toggle parity of fired detectors */
+        D_EDGE   = 3'd3, /**< Fetch the next edge */
+        D_FIND_U = 3'd4, /**< Find the root of u */
+        D_FIND_V = 3'd5, /**< Find the root of v */
+        D_UNION  = 3'd6, /**< Merge clusters and record the correction */
+        D_SCAN   = 3'd7  /**< List odd-parity roots */
+    } dstate_t;
+
+    dstate_t state;
+
+    logic [15:0]          parent_mem [DEC_NODES];     /**< Parent forest */
+    logic [7:0]           rank_mem   [DEC_NODES];     /**< Union-by-rank ranks */
+    logic [DEC_NODES-1:0] parity;                     /**< Odd parity per root */
+    logic [DEC_NODES-1:0] touched;                    /**< Node joined the frontier */
+    logic [31:0]          edge_mem   [DEC_EDGES];     /**< Edge list {v, u} */
+    logic [31:0]          step_mem   [STEP_WORDS];    /**< Packed growth steps */
+    logic [3:0]           grow_mem   [DEC_EDGES];     /**< Growth taken per edge */
+    logic [15:0]          syn_mem    [DEC_SYNDROMES]; /**< Fired detectors */
+    logic [31:0]          corr_mem   [DEC_NODES];     /**< Corrections {v, u} */
+    logic [15:0]          odd_mem    [DEC_NODES];     /**< Odd-parity roots */
+
+    logic [31:0] num_syn;    /**< Syndromes to apply */
+    logic [31:0] num_nodes;  /**< Nodes in the graph */
+    logic [31:0] num_edges;  /**< Edges in the graph */
+    logic [31:0] num_corr;   /**< Corrections produced */
+    logic [31:0] num_odd;    /**< Odd-parity roots found */
+    logic [31:0] cycle_cnt;  /**< Cycles of the current/last decode */
+    logic [31:0] pass_cnt;   /**< Edge list sweeps */
+    logic [31:0] find_cnt;   /**< Root finds */
+    logic        overflow;   /**< Correction buffer filled up */
+    logic        done_flag;  /**< Last decode completed */
+    logic        weighted;   /**< Weighted growth mode */
+    logic        fuse;       /**< Weighted round is in its fusion sweep */
+
+    logic [31:0] idx;        /**< Node, syndrome or edge counter */
+    logic        changed;    /**< Current sweep performed a union (grew an edge) */
+    logic [15:0] eu, ev;     /**< Endpoints of the current edge */
+    logic [15:0] x;          /**< Node being walked by FIND */
+    logic [15:0] ru;         /**< Root of eu */
+    logic [15:0] rv;         /**< Root of ev */
+
+    logic busy;
+    assign busy = (state != D_IDLE);
+
+    logic cfg_wr;            /**< Accepted bus write */
+    assign cfg_wr = cs && we && !busy;
+
+    logic [NODE_BITS-1:0] xi, pi, rui, rvi; /**< Truncated node indices */
+    logic [15:0]          xp, xgp;          /**< parent[x] and parent[parent[x]] */
+    assign xi  = x[NODE_BITS-1:0];
+    assign xp  = parent_mem[xi];
+    assign pi  = xp[NODE_BITS-1:0];
+    assign xgp = parent_mem[pi];
+    assign rui = ru[NODE_BITS-1:0];
+    assign rvi = rv[NODE_BITS-1:0];
+
+    logic [31:0] cur_edge;   /**< Edge at idx */
+    logic        edge_live;  /**< Edge has a touched endpoint in range */
+    assign cur_edge  = edge_mem[idx[EDGE_BITS-1:0]];
+    assign edge_live = (32'(cur_edge[15:0]) < num_nodes) && (32'(cur_edge[31:16]) < num_nodes)
+                    && (touched[cur_edge[NODE_BITS-1:0]] || touched[cur_edge[16 +: NODE_BITS]]);
+
+    logic [3:0]  cur_steps;  /**< Growth steps of the edge at idx */
+    logic [3:0]  cur_grow;   /**< Growth taken by the edge at idx */
+    logic        edge_due;   /**< Edge takes part in the current sweep */
+    logic [4:0]  grown;      /**< Growth after this sweep's step */
+    assign cur_steps = step_mem[STEP_BITS'(idx >> 3)][4 * idx[2:0] +: 4];
+    assign cur_grow  = grow_mem[idx[EDGE_BITS-1:0]];
+    assign edge_due  = !weighted || (fuse ? (cur_grow >= cur_steps) : (cur_grow < cur_steps));
+    assign grown     = 5'(cur_grow) + 5'(parity[rui]) + 5'(parity[rvi]);
+
+    logic [15:0] cur_syn;    /**< Syndrome at idx */
+    assign cur_syn = syn_mem[idx[SYN_BITS-1:0]];
+
+    /**
+     * Buffer write ports (system bus).
+     */
+    always_ff @(posedge clk) begin
+        if (cfg_wr && addr[15] && (32'(addr[14:0]) < DEC_EDGES)) begin
+            edge_mem[addr[EDGE_BITS-1:0]] <= wdata;
+        end
+        if (cfg_wr && addr[15:14] == 2'b01 && (32'(addr[13:0]) < DEC_SYNDROMES)) begin
+            syn_mem[addr[SYN_BITS-1:0]] <= wdata[15:0];
+        end
+        if (cfg_wr && addr[15:12] == 4'h1 && (32'(addr[11:0]) < STEP_WORDS)) begin
+            step_mem[addr[STEP_BITS-1:0]] <= wdata;
+        end
+    end
+
+    /**
+     * Decode sequencer.
+     */
+    always_ff @(posedge clk or negedge rst_n) begin
+        if (!rst_n) begin
+            state     <= D_IDLE;
+            num_syn   <= '0;
+            num_nodes <= '0;
+            num_edges <= '0;
+            num_corr  <= '0;
+            num_odd   <= '0;
+            cycle_cnt <= '0;
+            pass_cnt  <= '0;
+            find_cnt  <= '0;
+            overflow  <= 1'b0;
+            done_flag <= 1'b0;
+            weighted  <= 1'b0;
+            fuse      <= 1'b0;
+            idx       <= '0;
+            changed   <= 1'b0;
+            eu        <= '0;
+            ev        <= '0;
+            x         <= '0;
+            ru        <= '0;
+            rv        <= '0;
+            parity    <= '0;
+            touched   <= '0;
+        end else begin
+            if (busy) cycle_cnt <= cycle_cnt + 32'd1;
+
+            case (state)
+                D_IDLE: begin
+                    if (cfg_wr && addr == 16'h0002) num_syn <= wdata;
+                    if (cfg_wr && addr == 16'h0003) num_nodes <= (wdata > DEC_NODES) ? DEC_NODES : wdata;
+                    if (cfg_wr && addr == 16'h0004) num_edges <= (wdata > DEC_EDGES) ? DEC_EDGES : wdata;
+                    if (cfg_wr && addr == 16'h000D) weighted <= wdata[0];
+                    if (cfg_wr && addr == 16'h0000 && wdata[0]) begin
+                        state     <= D_INIT;
+                        idx       <= '0;
+                        num_corr  <= '0;
+                        num_odd   <= '0;
+                        cycle_cnt <= '0;
+                        pass_cnt  <= '0;
+                        find_cnt  <= '0;
+                        overflow  <= 1'b0;
+                        done_flag <= 1'b0;
+                    end
+                end
+
+                D_INIT: begin
+                    if (idx < num_nodes || (weighted && idx < num_edges)) begin
+                        if (idx < num_nodes) begin
+                            parent_mem[idx[NODE_BITS-1:0]] <= idx[15:0];
+                            rank_mem[idx[NODE_BITS-1:0]]   <= '0;
+                            parity[idx[NODE_BITS-1:0]]     <= 1'b0;
+                            touched[idx[NODE_BITS-1:0]]    <= 1'b0;
+                        end
+                        if (idx < num_edges) grow_mem[idx[EDGE_BITS-1:0]] <= '0;
+                        idx <= idx + 32'd1;
+                    end else begin
+                        idx   <= '0;
+                        state <= D_SYN;
+                    end
+                end
+
+                D_SYN: begin
+                    if (idx < num_syn && idx < DEC_SYNDROMES) begin
+                        if (32'(cur_syn) < num_nodes) begin
+                            parity[cur_syn[NODE_BITS-1:0]]  <= !parity[cur_syn[NODE_BITS-1:0]];
+                            touched[cur_syn[NODE_BITS-1:0]] <= 1'b1;
+                        end
+                        idx <= idx + 32'd1;
+                    end else begin
+                        idx     <= '0;
+                        changed <= 1'b0;
+                        fuse    <= 1'b0;
+                        state   <= D_EDGE;
+                    end
+                end
+
+                D_EDGE: begin
+                    if (idx < num_edges) begin
+                        if (edge_live && edge_due) begin
+                            eu       <= cur_edge[15:0];
+                            ev       <= cur_edge[31:16];
+                            x        <= cur_edge[15:0];
+                            find_cnt <= find_cnt + 32'd2;
+                            state    <= D_FIND_U;
+                        end else begin
+                            idx <= idx + 32'd1;
+                        end
+                    end else begin
+                        pass_cnt <= pass_cnt + 32'd1;
+                        idx      <= '0;
+                        changed  <= 1'b0;
+                        if (weighted) begin
+                            // A fusion sweep always starts a new round; a
+                            // growth sweep that grew nothing ends the decode.
+                            fuse  <= !fuse;
+                            state <= (fuse || changed) ? D_EDGE : D_SCAN;
+                        end else begin
+                            state <= changed ? D_EDGE : D_SCAN;
+                        end
+                    end
+                end
+
+                D_FIND_U: begin
+                    if (xp == x) begin
+                        ru    <= x;
+                        x     <= ev;
+                        state <= D_FIND_V;
+                    end else begin
+                        parent_mem[xi] <= xgp;
+                        x <= xp;
+                    end
+                end
+
+                D_FIND_V: begin
+                    if (xp == x) begin
+                        rv    <= x;
+                        state <= D_UNION;
+                    end else begin
+                        parent_mem[xi] <= xgp;
+                        x <= xp;
+                    end
+                end
+
+                D_UNION: begin
+                    state <= D_EDGE;
+                    idx   <= idx + 32'd1;
+                    if (weighted && !fuse) begin
+                        if (ru != rv && (parity[rui] || parity[rvi])) begin
+                            grow_mem[idx[EDGE_BITS-1:0]] <= (grown > 5'(cur_steps)) ? cur_steps : grown[3:0];
+                            changed <= 1'b1;
+                        end
+                    end else if (ru != rv && (fuse || parity[rui] || parity[rvi])) begin
+                        if (num_corr == DEC_NODES) begin
+                            overflow <= 1'b1;
+                            state    <= D_IDLE;
+                        end else begin
+                            if (rank_mem[rui] < rank_mem[rvi]) begin
+                                parent_mem[rui] <= rv;
+                                if (parity[rui]) parity[rvi] <= !parity[rvi];
+                            end else begin
+                                parent_mem[rvi] <= ru;
+                                if (parity[rvi]) parity[rui] <= !parity[rui];
+                                if (rank_mem[rui] == rank_mem[rvi]) rank_mem[rui] <= rank_mem[rui] + 8'd1;
+                            end
+                            corr_mem[num_corr[NODE_BITS-1:0]] <= {ev, eu};
+                            num_corr <= num_corr + 32'd1;
+                            touched[eu[NODE_BITS-1:0]] <= 1'b1;
+                            touched[ev[NODE_BITS-1:0]] <= 1'b1;
+                            changed <= 1'b1;
+                        end
+                    end
+                end
+
+                D_SCAN: begin
+                    if (idx < num_nodes) begin
+                        if (parent_mem[idx[NODE_BITS-1:0]] == idx[15:0] && parity[idx[NODE_BITS-1:0]]) begin
+                            odd_mem[num_odd[NODE_BITS-1:0]] <= idx[15:0];
+                            num_odd <= num_odd + 32'd1;
+                        end
+                        idx <= idx + 32'd1;
+                    end else begin
+                        done_flag <= 1'b1;
+                        state     <= D_IDLE;
+                    end
+                end
+
+                default: state <= D_IDLE;
+            endcase
+        end
+    end
+
+    assign quiescent = !busy;
+
+    always_comb begin
+        rdata = '0;
+        if (cs && !we) begin
+            if (addr[15]) begin
+                if (32'(addr[14:0]) < DEC_EDGES) rdata = edge_mem[addr[EDGE_BITS-1:0]];
+            end else if (addr[15:14] == 2'b01) begin
+                if (32'(addr[13:0]) < DEC_SYNDROMES) rdata = {16'b0, syn_mem[addr[SYN_BITS-1:0]]};
+            end else if (addr[15:12] == 4'h2) begin
+                if (32'(addr[11:0]) < num_corr) rdata = corr_mem[addr[NODE_BITS-1:0]];
+            end else if (addr[15:12] == 4'h3) begin
+                if (32'(addr[11:0]) < num_odd) rdata = {16'b0, odd_mem[addr[NODE_BITS-1:0]]};
+            end else if (addr[15:12] == 4'h1) begin
+                if (32'(addr[11:0]) < STEP_WORDS) rdata = step_mem[addr[STEP_BITS-1:0]];
+            end else begin
+                case (addr)
+                    16'h0001: rdata = {29'b0, done_flag, overflow, busy};
+                    16'h0002: rdata = num_syn;
+                    16'h0003: rdata = num_nodes;
+                    16'h0004: rdata = num_edges;
+                    16'h0005: rdata = num_corr;
+                    16'h0006: rdata = cycle_cnt;
+                    16'h0007: rdata = pass_cnt;
+                    16'h0008: rdata = find_cnt;
+                    16'h0009: rdata = num_odd;
+                    16'h000A: rdata = 32'(DEC_NODES);
+                    16'h000B: rdata = 32'(DEC_EDGES);
+                    16'h000C: rdata = 32'(DEC_SYNDROMES);
+                    16'h000D: rdata = {31'b0, weighted};
+                    default:  rdata = '0;
+                endcase
+            end
+        end
+    end
+
+endmodule
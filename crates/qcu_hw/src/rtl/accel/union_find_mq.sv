@@ -0,0 +1,169 @@
+/**
+ * @file union_find_mq.sv
+ * @brief Multi-query union-find engine with overlapping walks.
+ *
+ * Variant of union_find that keeps up to NUM_WALKERS independent find
+ * operations in flight over a single pipelined memory port. Queries arrive
+ * on a valid/ready stream together with a tag; each is assigned a free
+ * walker context, and the walkers take turns issuing one parent read per
+ * cycle, so the memory latency of one walk is hidden behind the reads of
+ * the others. Responses return in issue order tagged with the walker
+ * context, and completed roots leave on the result stream in completion
+ * order, carrying the tag of their query.
+ *
+ * Path compression is written back by path splitting: whenever a walk
+ * reads the parent p of its current node and p is not a root, the
+ * previous node on the path is pointed at p, its grandparent. Every node
+ * keeps pointing at an ancestor, so concurrent walks over the same trees
+ * stay correct and the roots never change.
+ *
+ * @param WIDTH Bit width of node indices and memory data (default 32)
+ * @param TAG_BITS Bit width of the query tags (default 8)
+ * @param NUM_WALKERS Walks kept in flight (default 4)
+ */
+module union_find_mq #(
+    parameter int WIDTH       = 32,
+    parameter int TAG_BITS    = 8,
+    parameter int NUM_WALKERS = 4,
+    parameter int CTX_BITS    = (NUM_WALKERS > 1) ? $clog2(NUM_WALKERS) : 1
+)(
+    input  logic                clk,           /**< System clock */
+    input  logic                rst_n,         /**< Active-low asynchronous reset */
+
+    input  logic                q_valid,       /**< Query available */
+    output logic                q_ready,       /**< A walker can accept the query */
+    input  logic [WIDTH-1:0]    q_node,        /**< Query start node */
+    input  logic [TAG_BITS-1:0] q_tag,         /**< Query tag */
+
+    output logic                r_valid,       /**< Result available */
+    input  logic                r_ready,       /**< Consumer accepts the result */
+    output logic [WIDTH-1:0]    r_root,        /**< Root of the completed query */
+    output logic [TAG_BITS-1:0] r_tag,         /**< Tag of the completed query */
+
+    output logic                mem_rd_en,     /**< Parent read request */
+    input  logic                mem_rd_gnt,    /**< Memory accepts the request */
+    output logic [WIDTH-1:0]    mem_rd_addr,   /**< Node whose parent is read */
+    output logic [CTX_BITS-1:0] mem_rd_ctx,    /**< Issuing walker context */
+    input  logic                mem_rsp_valid, /**< Parent read response */
+    input  logic [CTX_BITS-1:0] mem_rsp_ctx,   /**< Walker context of the response */
+    input  logic [WIDTH-1:0]    mem_rsp_data,  /**< Parent value read */
+
+    output logic                mem_wr_en,     /**< Path compression write */
+    output logic [WIDTH-1:0]    mem_wr_addr,   /**< Node being repointed */
+    output logic [WIDTH-1:0]    mem_wr_data,   /**< Its new parent (grandparent) */
+
+    output logic                busy           /**< Any walker is occupied */
+);
+
+    /**
+     * Walker context states.
+     *
+     * A walker is FREE until it takes a query, ISSUE while its next parent
+     * read waits for the memory port, WAIT while that read is in flight and
+     * DONE once it has found the root and waits to hand out the result.
+     */
+    typedef enum logic [1:0] {
+        W_FREE  = 2'd0, /**< Unoccupied */
+        W_ISSUE = 2'd1, /**< Parent read of curr pending issue */
+        W_WAIT  = 2'd2, /**< Parent read of curr in flight */
+        W_DONE  = 2'd3  /**< Root found, result pending */
+    } wstate_t;
+
+    wstate_t             state    [NUM_WALKERS]; /**< Per-walker state */
+    logic [WIDTH-1:0]    curr     [NUM_WALKERS]; /**< Node being resolved */
+    logic [WIDTH-1:0]    prev     [NUM_WALKERS]; /**< Node whose parent is curr */
+    logic                has_prev [NUM_WALKERS]; /**< prev is valid */
+    logic [TAG_BITS-1:0] tag      [NUM_WALKERS]; /**< Tag of the walker's query */
+
+    logic [CTX_BITS-1:0] free_idx, issue_idx, done_idx;  /**< Selected walkers */
+    logic                any_free, any_issue, any_done;  /**< Selection valid */
+
+    /**
+     * Fixed-priority walker selection (lowest index wins).
+     */
+    always_comb begin
+        free_idx  = '0;
+        issue_idx = '0;
+        done_idx  = '0;
+        any_free  = 1'b0;
+        any_issue = 1'b0;
+        any_done  = 1'b0;
+        busy      = 1'b0;
+        for (int i = NUM_WALKERS - 1; i >= 0; i--) begin
+            if (state[i] == W_FREE) begin
+                free_idx = CTX_BITS'(i);
+                any_free = 1'b1;
+            end else begin
+                busy = 1'b1;
+            end
+            if (state[i] == W_ISSUE) begin
+                issue_idx = CTX_BITS'(i);
+                any_issue = 1'b1;
+            end
+            if (state[i] == W_DONE) begin
+                done_idx = CTX_BITS'(i);
+                any_done = 1'b1;
+            end
+        end
+    end
+
+    assign q_ready     = any_free;
+    assign mem_rd_en   = any_issue;
+    assign mem_rd_addr = curr[issue_idx];
+    assign mem_rd_ctx  = issue_idx;
+    assign r_valid     = any_done;
+    assign r_root      = curr[done_idx];
+    assign r_tag       = tag[done_idx];
+
+    logic rsp_is_root; /**< Response reports a self-parented node */
+    assign rsp_is_root = (mem_rsp_data == curr[mem_rsp_ctx]);
+
+    assign mem_wr_en   = mem_rsp_valid && !rsp_is_root && has_prev[mem_rsp_ctx];
+    assign mem_wr_addr = prev[mem_rsp_ctx];
+    assign mem_wr_data = mem_rsp_data;
+
+    /**
+     * Walker state updates.
+     *
+     * At most one walker takes a query, one issues, one receives a response
+     * and one retires per cycle; the four events always hit walkers in
+     * different states, so they never collide.
+     */
+    always_ff @(posedge clk or negedge rst_n) begin
+        if (!rst_n) begin
+            for (int i = 0; i < NUM_WALKERS; i++) begin
+                state[i]    <= W_FREE;
+                curr[i]     <= '0;
+                prev[i]     <= '0;
+                has_prev[i] <= 1'b0;
+                tag[i]      <= '0;
+            end
+        end else begin
+            for (int i = 0; i < NUM_WALKERS; i++) begin
+                if (q_valid && any_free && free_idx == CTX_BITS'(i)) begin
+                    state[i]    <= W_ISSUE;
+                    curr[i]     <= q_node;
+                    has_prev[i] <= 1'b0;
+                    tag[i]      <= q_tag;
+                end
+                if (any_issue && mem_rd_gnt && issue_idx == CTX_BITS'(i)) begin
+                    state[i] <= W_WAIT;
+                end
+                if (mem_rsp_valid && mem_rsp_ctx == CTX_BITS'(i)) begin
+                    if (rsp_is_root) begin
+                        state[i] <= W_DONE;
+                    end else begin
+                        state[i]    <= W_ISSUE;
+                        prev[i]     <= curr[i];
+                        has_prev[i] <= 1'b1;
+                        curr[i]     <= mem_rsp_data;
+                    end
+                end
+                if (any_done && r_ready && done_idx == CTX_BITS'(i)) begin
+                    state[i] <= W_FREE;
+                end
+            end
+        end
+    end
+
+endmodule
@@ -10,6 +10,10 @@
  * becomes too small. Noise is injected as random phase rotations, and control
  * pulses can be applied to perform quantum gates or error corrections.
  *
+ * The effective PRNG seed is SEED XOR the `+qcu_seed=<hex>` plusarg, which
+ * lets each simulation instance run an independent noise realization without
+ * rebuilding the model. Without the plusarg the seed is SEED unchanged.
+ *
  * @param SEED Initial seed for the Xorshift32 pseudo-random number generator
  */
 module hamiltonian_engine #(
@@ -35,18 +39,23 @@ module hamiltonian_engine #(
     fixed_t state_x;        /**< X component of qubit state vector */
     fixed_t state_z;        /**< Z component of qubit state vector */
     logic [31:0] rng;       /**< Xorshift32 PRNG state for noise generation */
+    logic [31:0] seed;      /**< Effective PRNG seed (SEED mixed with plusarg) */
 
     /**
      * Initial state: qubit starts in |0⟩ state.
      *
      * Initializes state vector to |0⟩ (X=0, Z=1.0 in fixed-point).
-     * The PRNG is seeded with the module parameter for deterministic
-     * noise generation.
+     * The PRNG is seeded with the module parameter, mixed with the optional
+     * per-instance seed plusarg, for deterministic noise generation. A mixed
+     * seed of zero falls back to SEED since Xorshift32 cannot leave zero.
      */
     initial begin
+        logic [31:0] salt;
+        if (!$value$plusargs("qcu_seed=%h", salt)) salt = 32'h0;
+        seed = ((SEED ^ salt) == 0) ? SEED : (SEED ^ salt);
         state_x = 16'h0000;
         state_z = 16'h4000;
-        rng = SEED;
+        rng = seed;
     end
 
     /**
@@ -54,17 +63,19 @@ module hamiltonian_engine #(
      *
      * Generates pseudo-random values for noise injection. Uses three
      * XOR-shift operations (13, 17, 5 bit shifts) to produce a uniform
-     * distribution. Resets to SEED if the state becomes zero to avoid
-     * getting stuck.
+     * distribution. Resets to the effective seed if the state becomes zero
+     * to avoid getting stuck. Advances only while enabled, so a disabled
+     * engine holds all of its state and idle cycles can be skipped without
+     * changing the noise sequence.
      */
     always_ff @(posedge clk or negedge rst_n) begin
-        if (!rst_n) rng <= SEED;
-        else begin
+        if (!rst_n) rng <= seed;
+        else if (enable) begin
             logic [31:0] x = rng;
             x = x ^ (x << 13);
             x = x ^ (x >> 17);
             x = x ^ (x << 5);
-            rng <= (x == 0) ? SEED : x;
+            rng <= (x == 0) ? seed : x;
         end
     end
 
@@ -94,8 +105,8 @@ module hamiltonian_engine #(
      * new X using current Z, (2) calculate new Z using the NEW X (symplectic
      * property), (3) perform energy rescue (renormalization) if state vector
      * magnitude becomes too small, simulating T1 relaxation that resets the
-     * qubit to |0⟩. Includes optimized logging that prints state every ~4000
-     * cycles to reduce simulation overhead.
+     * qubit to |0⟩. Trace builds (QCU_TRACE) also print the state every
+     * ~4000 cycles; the logging is compiled out otherwise.
      */
     always_ff @(posedge clk or negedge rst_n) begin
         if (!rst_n) begin
@@ -118,9 +129,11 @@ module hamiltonian_engine #(
                 state_z <= next_z;
             end
             
+`ifdef QCU_TRACE
             if ((rng & 32'hFFF) == 0) begin
                 $display("[HW-PHYS] %m | Time: %0t | X: %d | Z: %d", $time, next_x, next_z);
             end
+`endif
         end
     end
 
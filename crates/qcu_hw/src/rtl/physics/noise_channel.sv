@@ -8,7 +8,8 @@
  * the error_state signal is asserted. The accumulation mechanism models
  * gradual decoherence processes. Corrections can be applied to reset the
  * accumulation counter and clear the error state, simulating active error
- * correction operations.
+ * correction operations. Error events are logged only in trace builds
+ * (QCU_TRACE).
  *
  * @param WIDTH Bit width for accumulation counter (default 32)
  * @param THRESHOLD Accumulation value that triggers error state (default 31)
@@ -60,7 +61,9 @@ module noise_channel #(
                 
                 if (accumulation > THRESHOLD) begin
                     error_state <= 1'b1;
+`ifdef QCU_TRACE
                     $display("[HW-NOISE] %m | ERROR TRIGGERED! Acc: %d", accumulation);
+`endif
                 end
             end
         end
@@ -1,33 +1,66 @@
 /**
  * @file qubit_grid.sv
- * @brief 3x3 grid of quantum qubits with individual Hamiltonian engines.
+ * @brief Square grid of quantum qubits with individual Hamiltonian engines.
  *
- * Implements a grid of 9 qubits, each with its own Hamiltonian evolution engine.
- * Provides a memory-mapped interface for enabling/disabling physics simulation,
- * applying correction pulses to individual qubits, and reading error states.
- * The module acts as a register file that controls the physics engines and
- * aggregates their measurement outputs into a single syndrome word. Used for
+ * Implements a GRID_DIM x GRID_DIM grid of qubits, each with its own
+ * Hamiltonian evolution engine (3x3 by default). Provides a memory-mapped
+ * interface for enabling/disabling physics simulation, applying correction
+ * pulses to individual qubits, and reading error states. The module acts as
+ * a register file that controls the physics engines and aggregates their
+ * measurement outputs into syndrome words of 32 qubits each. Used for
  * hardware-in-the-loop testing of quantum error correction algorithms.
+ *
+ * Register map (word offsets):
+ *   0x00       enable          physics_running (bit 0)
+ *   0x01       pulse           momentary pulse on qubits 0..31
+ *   0x02       errors          syndrome word 0 (qubits 0..31)
+ *   0x03       rabi            pulse strength
+ *   0x04       grid_dim        GRID_DIM (read-only)
+ *   0x05       err_any         1 if any qubit reports an error (read-only)
+ *   0x06       pulse_go        fire the staged mask for wdata cycles;
+ *                              reads back the remaining pulse cycles
+ *   0x20+i     pulse_stage[i]  staged pulse mask for qubits 32i..32i+31
+ *   0x40+i     errors[i]       syndrome word i (qubits 32i..32i+31)
+ *
+ * While physics is disabled and no pulse is pending, the engines hold their
+ * state, so clock cycles without bus traffic are no-ops; this is reported on
+ * the quiescent output so the simulator can fast-forward such stretches.
+ * The syndrome_any and pulse_busy outputs expose the err_any flag and a
+ * running pulse without a bus access, so the simulator can timestamp the
+ * detection-to-correction latency without perturbing the bus.
+ *
+ * @param GRID_DIM Side length of the square qubit grid (at most 32)
  */
-module qubit_grid (
+module qubit_grid #(
+    parameter int GRID_DIM = 3
+)(
     input  logic        clk,     /**< System clock */
     input  logic        rst_n,   /**< Active-low asynchronous reset */
     
     input  logic        cs,      /**< Chip select (register access valid) */
     input  logic        we,      /**< Write enable (1=write, 0=read) */
-    input  logic [3:0]  addr,    /**< 4-bit register address */
+    input  logic [7:0]  addr,    /**< 8-bit register address */
     input  logic [31:0] wdata,   /**< 32-bit write data */
-    output logic [31:0] rdata    /**< 32-bit read data */
+    output logic [31:0] rdata,   /**< 32-bit read data */
+    output logic        quiescent, /**< Idle cycles leave all state unchanged */
+    output logic        syndrome_any, /**< Some qubit reports an error */
+    output logic        pulse_busy    /**< A correction pulse is being applied */
 );
 
-    logic [8:0] pulse_active;      /**< Per-qubit pulse enable signals (one-hot) */
-    logic [8:0] errors;              /**< Per-qubit measurement results (syndrome bits) */
-    logic physics_running;          /**< Global enable for all physics engines */
-    logic [15:0] pulse_strength_reg; /**< Shared pulse strength (Rabi frequency) for all qubits */ 
+    localparam int NUM_QUBITS = GRID_DIM * GRID_DIM;   /**< Qubits in the grid */
+    localparam int NUM_WORDS  = (NUM_QUBITS + 31) / 32; /**< 32-bit syndrome words */
+    localparam int PAD_BITS   = NUM_WORDS * 32;         /**< Qubit lanes rounded up to words */
+
+    logic [PAD_BITS-1:0] pulse_active;  /**< Per-qubit pulse enable signals */
+    logic [PAD_BITS-1:0] pulse_stage;   /**< Pulse mask armed by pulse_go */
+    logic [PAD_BITS-1:0] errors;        /**< Per-qubit measurement results (syndrome bits) */
+    logic [15:0] pulse_remaining;       /**< Cycles left on the active pulse */
+    logic physics_running;              /**< Global enable for all physics engines */
+    logic [15:0] pulse_strength_reg;    /**< Shared pulse strength (Rabi frequency) for all qubits */ 
 
     genvar i;
     generate
-        for (i = 0; i < 9; i++) begin : gen_qubits
+        for (i = 0; i < NUM_QUBITS; i++) begin : gen_qubits
             hamiltonian_engine #(
                 .SEED(32'hDEAD_BEEF ^ (i * 32'h9E3779B9)) 
             ) u_physics_core (
@@ -39,45 +72,80 @@ module qubit_grid (
                 .measurement(errors[i])
             );
         end
+        for (i = NUM_QUBITS; i < PAD_BITS; i++) begin : gen_pad
+            assign errors[i] = 1'b0;
+        end
     endgenerate
 
+    /**
+     * Bank-relative word index of the current register address.
+     *
+     * Valid for the pulse_stage (0x20) and errors (0x40) banks; accesses
+     * past NUM_WORDS are ignored on write and read as zero.
+     */
+    logic [4:0] word_idx;
+    logic       word_valid;
+    assign word_idx   = addr[4:0];
+    assign word_valid = (32'(word_idx) < NUM_WORDS);
+
     /**
      * Register write logic for qubit grid control.
      *
      * Handles writes to memory-mapped registers: enable/disable physics
      * simulation, trigger correction pulses on individual qubits, and set
-     * pulse strength (Rabi frequency). Pulses are momentary triggers in
-     * this bus protocol, so the controller must sustain writes for long
-     * pulse durations. Default pulse strength is 500 (Rabi frequency units).
+     * pulse strength (Rabi frequency). A write to the pulse register is a
+     * momentary trigger lasting one cycle, so the controller must sustain
+     * writes for long pulse durations on the low 32 qubits. For larger grids
+     * the mask is staged word by word and pulse_go applies it to all qubits
+     * at once for the requested number of cycles, counted down in hardware.
+     * Default pulse strength is 500 (Rabi frequency units).
      */
     always_ff @(posedge clk or negedge rst_n) begin
         if (!rst_n) begin
             physics_running <= 1'b0;
             pulse_active    <= '0;
+            pulse_stage     <= '0;
+            pulse_remaining <= '0;
             pulse_strength_reg <= 16'd500;
         end else begin
-            pulse_active <= '0; 
+            if (pulse_remaining != 0) begin
+                pulse_remaining <= pulse_remaining - 16'd1;
+                if (pulse_remaining == 16'd1) pulse_active <= '0;
+            end
             
             if (cs && we) begin
-                case (addr)
-                    4'h0: physics_running <= wdata[0];
-                    4'h1: pulse_active    <= wdata[8:0];
-                    4'h3: pulse_strength_reg <= wdata[15:0];
-                    default: ;
-                endcase
+                if (addr == 8'h00) begin
+                    physics_running <= wdata[0];
+                end else if (addr == 8'h01) begin
+                    pulse_active    <= PAD_BITS'(wdata);
+                    pulse_remaining <= 16'd1;
+                end else if (addr == 8'h03) begin
+                    pulse_strength_reg <= wdata[15:0];
+                end else if (addr == 8'h06) begin
+                    pulse_active    <= pulse_stage;
+                    pulse_remaining <= (wdata[15:0] == 16'd0) ? 16'd1 : wdata[15:0];
+                end else if (addr[7:5] == 3'b001 && word_valid) begin
+                    pulse_stage[{word_idx, 5'b0} +: 32] <= wdata;
+                end
             end
         end
     end
 
+    assign quiescent    = !physics_running && (pulse_remaining == 16'd0);
+    assign syndrome_any = |errors;
+    assign pulse_busy   = (pulse_remaining != 16'd0);
+
     always_comb begin
         rdata = '0;
         if (cs && !we) begin
-            case (addr)
-                4'h0: rdata = {31'b0, physics_running};
-                4'h2: rdata = {23'b0, errors};
-                4'h3: rdata = {16'b0, pulse_strength_reg};
-                default: rdata = '0;
-            endcase
+            if (addr == 8'h00)      rdata = {31'b0, physics_running};
+            else if (addr == 8'h02) rdata = errors[31:0];
+            else if (addr == 8'h03) rdata = {16'b0, pulse_strength_reg};
+            else if (addr == 8'h04) rdata = 32'(GRID_DIM);
+            else if (addr == 8'h05) rdata = {31'b0, |errors};
+            else if (addr == 8'h06) rdata = {16'b0, pulse_remaining};
+            else if (addr[7:5] == 3'b001 && word_valid) rdata = pulse_stage[{word_idx, 5'b0} +: 32];
+            else if (addr[7:5] == 3'b010 && word_valid) rdata = errors[{word_idx, 5'b0} +: 32];
         end
     end
 endmodule
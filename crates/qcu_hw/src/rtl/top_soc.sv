@@ -4,52 +4,166 @@
  *
  * Implements the system bus interface and address decoding logic for memory-mapped
  * quantum hardware peripherals. The module routes bus transactions to the appropriate
- * peripheral based on the upper 16 bits of the address. Currently integrates the
- * qubit grid physics engine at address 0x4000_0000. The bus protocol supports
+ * peripheral based on the upper 16 bits of the address. Integrates the qubit
+ * grid physics engine at address 0x4000_0000 and the union-find find engine,
+ * with its parent-array BRAM, at 0x4001_0000, and the full-decode block,
+ * which runs a complete union-find decode over a loaded graph, at
+ * 0x4002_0000. The bus protocol supports
  * both read and write transactions with chip select and write enable signals
- * for transaction qualification.
+ * for transaction qualification. Bursts are supported with an
+ * auto-incrementing address mode: while bus_burst is asserted, the beat
+ * targets the address of the previous beat plus one and bus_addr is ignored,
+ * so contiguous register ranges such as wide syndrome vectors can be moved
+ * one word per cycle without re-driving the address. The quiescent output
+ * tells the simulation driver that idle clock cycles cannot change any
+ * state and may be skipped; syndrome_any and pulse_busy mirror the qubit
+ * grid's error flag and correction pulse for latency instrumentation.
+ *
+ * @param GRID_DIM Side length of the qubit grid (set with -GGRID_DIM=<n>)
+ * @param UF_DEPTH Entries in the union-find parent array
+ * @param UF_MEM_LATENCY Parent array read latency in clock cycles
+ * @param UF_WALKERS Finds the multi-query engine keeps in flight
+ * @param DEC_NODES Detector capacity of the full-decode block
+ * @param DEC_EDGES Edge capacity of the full-decode block
  */
-module top_soc (
+module top_soc #(
+    parameter int GRID_DIM       = 3,
+    parameter int UF_DEPTH       = 4096,
+    parameter int UF_MEM_LATENCY = 1,
+    parameter int UF_WALKERS     = 4,
+    parameter int DEC_NODES      = 4096,
+    parameter int DEC_EDGES      = 16384
+)(
     input  logic        clk,       /**< System clock */
     input  logic        rst_n,     /**< Active-low asynchronous reset */
 
     input  logic        bus_cs,    /**< Bus chip select (transaction valid) */
     input  logic        bus_we,    /**< Bus write enable (1=write, 0=read) */
+    input  logic        bus_burst, /**< Continue burst: use previous address + 1 */
     input  logic [31:0] bus_addr,   /**< 32-bit memory-mapped address */
     input  logic [31:0] bus_wdata,  /**< 32-bit write data */
-    output logic [31:0] bus_rdata   /**< 32-bit read data */
+    output logic [31:0] bus_rdata,  /**< 32-bit read data */
+
+    output logic        quiescent,  /**< No state changes on idle cycles */
+    output logic        syndrome_any, /**< Some qubit reports an error */
+    output logic        pulse_busy    /**< A correction pulse is being applied */
 );
 
+    /**
+     * Effective bus address with burst auto-increment.
+     *
+     * The address of every selected beat is latched; a beat issued with
+     * bus_burst asserted targets the latched address plus one, so a burst
+     * is started by one ordinary beat carrying the base address.
+     */
+    logic [31:0] last_addr;
+    logic [31:0] addr;
+    assign addr = bus_burst ? (last_addr + 32'd1) : bus_addr;
+
+    always_ff @(posedge clk or negedge rst_n) begin
+        if (!rst_n) last_addr <= '0;
+        else if (bus_cs) last_addr <= addr;
+    end
+
     /**
      * Address decode signal for physics engine peripheral.
      *
      * Asserted when bus_cs is active and the upper 16 address bits match
-     * 0x4000, selecting the qubit grid physics engine. The lower 16 bits
-     * are passed to the peripheral for register selection.
+     * 0x4000, selecting the qubit grid physics engine. The low 8 bits of
+     * the word address are passed to the peripheral for register selection.
      */
     logic physics_sel;
-    assign physics_sel = bus_cs && (bus_addr[31:16] == 16'h4000);
+    assign physics_sel = bus_cs && (addr[31:16] == 16'h4000);
+
+    /**
+     * Address decode signal for the union-find accelerator.
+     *
+     * Asserted for addresses 0x4001_xxxx; the low 16 bits select a control
+     * register or, with bit 15 set, an entry of the parent array.
+     */
+    logic uf_sel;
+    assign uf_sel = bus_cs && (addr[31:16] == 16'h4001);
+
+    /**
+     * Address decode signal for the full-decode block.
+     *
+     * Asserted for addresses 0x4002_xxxx; the low 16 bits select a control
+     * register or one of the graph, syndrome and correction windows.
+     */
+    logic dec_sel;
+    assign dec_sel = bus_cs && (addr[31:16] == 16'h4002);
+
+    logic [31:0] physics_rdata;   /**< Read data from the qubit grid */
+    logic [31:0] uf_rdata;        /**< Read data from the union-find engine */
+    logic [31:0] dec_rdata;       /**< Read data from the full-decode block */
+    logic        physics_quiet;   /**< Qubit grid is quiescent */
+    logic        uf_quiet;        /**< Union-find engine is quiescent */
+    logic        dec_quiet;       /**< Full-decode block is quiescent */
 
+    assign bus_rdata = physics_sel ? physics_rdata
+                     : uf_sel      ? uf_rdata
+                     : dec_sel     ? dec_rdata
+                     : 32'b0;
+    assign quiescent = physics_quiet && uf_quiet && dec_quiet;
+
+`ifdef QCU_TRACE
     /**
      * Debug logging for physics engine bus transactions.
      *
      * Prints a message whenever a write transaction targets the physics
-     * engine, showing the address and data for debugging purposes.
+     * engine, showing the address and data for debugging purposes. Only
+     * compiled in trace builds (QCU_TRACE), since formatted output on every
+     * write dominates simulation time under sustained load.
      */
     always_ff @(posedge clk) begin
         if (physics_sel && bus_we) begin
-            $display("[HW-TOP] Write to Physics! Addr: %h Data: %h", bus_addr, bus_wdata);
+            $display("[HW-TOP] Write to Physics! Addr: %h Data: %h", addr, bus_wdata);
         end
     end
+`endif
 
-    qubit_grid u_physics (
+    qubit_grid #(
+        .GRID_DIM(GRID_DIM)
+    ) u_physics (
         .clk(clk),
         .rst_n(rst_n),
         .cs(physics_sel),
         .we(bus_we),
-        .addr(bus_addr[3:0]), 
+        .addr(addr[7:0]),
+        .wdata(bus_wdata),
+        .rdata(physics_rdata),
+        .quiescent(physics_quiet),
+        .syndrome_any(syndrome_any),
+        .pulse_busy(pulse_busy)
+    );
+
+    uf_accel #(
+        .UF_DEPTH(UF_DEPTH),
+        .UF_MEM_LATENCY(UF_MEM_LATENCY),
+        .UF_WALKERS(UF_WALKERS)
+    ) u_uf_accel (
+        .clk(clk),
+        .rst_n(rst_n),
+        .cs(uf_sel),
+        .we(bus_we),
+        .addr(addr[15:0]),
+        .wdata(bus_wdata),
+        .rdata(uf_rdata),
+        .quiescent(uf_quiet)
+    );
+
+    uf_decoder #(
+        .DEC_NODES(DEC_NODES),
+        .DEC_EDGES(DEC_EDGES)
+    ) u_uf_decoder (
+        .clk(clk),
+        .rst_n(rst_n),
+        .cs(dec_sel),
+        .we(bus_we),
+        .addr(addr[15:0]),
         .wdata(bus_wdata),
-        .rdata(bus_rdata)
+        .rdata(dec_rdata),
+        .quiescent(dec_quiet)
     );
 
 endmodule
@@ -0,0 +1,123 @@
+/**
+ * @file channel.h
+ * @brief Byte-stream transport abstraction for the simulation server.
+ *
+ * The command protocol is a plain byte stream, so the server loop only needs
+ * "receive exactly N bytes" and "send exactly N bytes", plus a non-blocking
+ * check for pending input while it free-runs. This header defines
+ * that interface and the socket-backed implementation used for TCP
+ * connections. Other transports (shared memory) implement the same
+ * interface so the command loop stays transport-agnostic.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+/**
+ * Abstract bidirectional byte channel between host and simulator.
+ *
+ * Implementations block until the full request has been transferred or the
+ * peer has gone away. A false return value always means the session is over.
+ */
+class Channel {
+public:
+  virtual ~Channel() = default;
+
+  /**
+   * Receives exactly len bytes into buf.
+   *
+   * @param buf Destination buffer
+   * @param len Number of bytes to receive
+   * @return true on success, false if the peer closed or an error occurred.
+   */
+  virtual bool recv_exact(void *buf, size_t len) = 0;
+
+  /**
+   * Sends exactly len bytes from buf.
+   *
+   * @param buf Source buffer
+   * @param len Number of bytes to send
+   * @return true on success, false if the peer closed or an error occurred.
+   */
+  virtual bool send_all(const void *buf, size_t len) = 0;
+
+  /**
+   * Checks without blocking whether the peer has sent anything.
+   *
+   * @return true if recv_exact would not block (data pending, or the peer
+   *         has gone away), false otherwise.
+   */
+  virtual bool readable() = 0;
+
+  /**
+   * Ends the session from the server side.
+   *
+   * May be called from another thread than the one receiving: a blocked
+   * or later recv_exact returns false, exactly as if the peer had closed.
+   */
+  virtual void shutdown() = 0;
+};
+
+/**
+ * Channel backed by a connected stream socket.
+ *
+ * Loops over partial reads and writes so multi-byte fields are never split
+ * across commands. Owns the descriptor and closes it on destruction.
+ */
+class SocketChannel : public Channel {
+public:
+  /**
+   * Wraps an already connected socket.
+   *
+   * @param fd Connected socket descriptor (ownership is transferred)
+   */
+  explicit SocketChannel(int fd) : fd(fd) {}
+
+  ~SocketChannel() override {
+    if (fd >= 0)
+      close(fd);
+  }
+
+  SocketChannel(const SocketChannel &) = delete;
+  SocketChannel &operator=(const SocketChannel &) = delete;
+
+  bool recv_exact(void *buf, size_t len) override {
+    uint8_t *p = static_cast<uint8_t *>(buf);
+    while (len > 0) {
+      ssize_t n = read(fd, p, len);
+      if (n <= 0)
+        return false;
+      p += n;
+      len -= static_cast<size_t>(n);
+    }
+    return true;
+  }
+
+  bool send_all(const void *buf, size_t len) override {
+    const uint8_t *p = static_cast<const uint8_t *>(buf);
+    while (len > 0) {
+      ssize_t n = send(fd, p, len, MSG_NOSIGNAL);
+      if (n <= 0)
+        return false;
+      p += n;
+      len -= static_cast<size_t>(n);
+    }
+    return true;
+  }
+
+  bool readable() override {
+    struct pollfd pfd = {fd, POLLIN, 0};
+    return poll(&pfd, 1, 0) > 0;
+  }
+
+  void shutdown() override { ::shutdown(fd, SHUT_RDWR); }
+
+private:
+  /** Connected socket descriptor. */
+  int fd;
+};
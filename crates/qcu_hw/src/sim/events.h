@@ -0,0 +1,101 @@
+/**
+ * @file events.h
+ * @brief Register watches and the event frames pushed while free-running.
+ *
+ * Instead of polling a register with one round trip per detection window,
+ * a host subscribes to a condition on it with CMD_SUBSCRIBE and lets the
+ * simulator free-run with CMD_RUN. Every active watch samples its register
+ * over the bus once per sampling round, exactly as firmware polling it
+ * would, and the server pushes an EVENT_FIRED frame with the cycle stamp
+ * and the value read as soon as a condition holds. A run ends after the
+ * first event (or, in streaming mode, keeps pushing events) and is always
+ * closed by one EVENT_END frame, so the host knows when ordinary replies
+ * resume.
+ *
+ * Event frames are five little-endian words: kind, watch id or end reason,
+ * 64-bit cycle stamp, and value (the register value for EVENT_FIRED, the
+ * cycles the run consumed for EVENT_END).
+ */
+
+#pragma once
+
+#include <cstdint>
+
+/**
+ * @defgroup WatchModes CMD_SUBSCRIBE Modes
+ * @{
+ */
+#define WATCH_OFF 0    /**< Remove the watch */
+#define WATCH_CHANGE 1 /**< Fire when a masked bit differs from last sample */
+#define WATCH_SET 2    /**< Fire when a masked bit becomes set */
+/** @} */
+
+/**
+ * @defgroup EventFrames Event Frame Kinds, End Reasons and Run Flags
+ * @{
+ */
+#define EVENT_FIRED 1 /**< A watch condition held */
+#define EVENT_END 2   /**< The run is over; ordinary replies follow */
+
+#define RUN_END_EVENT 0  /**< Stopped after the first event */
+#define RUN_END_BUDGET 1 /**< Cycle budget exhausted */
+#define RUN_END_HALTED 2 /**< Host sent a command while running */
+#define RUN_END_IDLE 3   /**< No active watch */
+
+#define RUN_FLAG_STREAM 0x1u /**< Keep running after an event */
+/** @} */
+
+/** Watches a session can hold at once. */
+#define MAX_WATCHES 8
+
+/**
+ * Cycles between checks for host commands while running.
+ *
+ * A pending command ends the run; checking costs a system call on socket
+ * transports, so it is amortized over this many cycles.
+ */
+#define RUN_POLL_CYCLES 256
+
+/** One frame pushed to the host during CMD_RUN. */
+struct EventFrame {
+  uint32_t kind;  /**< EVENT_FIRED or EVENT_END */
+  uint32_t id;    /**< Watch id, or RUN_END_* reason */
+  uint64_t cycle; /**< SoC cycle counter when the frame was produced */
+  uint32_t value; /**< Register value, or cycles the run consumed */
+} __attribute__((packed));
+
+static_assert(sizeof(EventFrame) == 20, "event frame layout");
+
+/** Condition on one memory-mapped register. */
+struct Watch {
+  uint32_t mode = WATCH_OFF; /**< One of the WATCH_* modes */
+  uint32_t addr = 0;         /**< Register address */
+  uint32_t mask = 0;         /**< Bits the condition looks at */
+  uint32_t last = 0;         /**< Previous sample */
+
+  /**
+   * Prepares the watch for a new run.
+   *
+   * A WATCH_SET watch forgets its last sample, so a bit that is already
+   * set fires on the first sample of the run; a WATCH_CHANGE watch keeps
+   * comparing against the value seen before.
+   */
+  void start_run() {
+    if (mode == WATCH_SET)
+      last = 0;
+  }
+
+  /**
+   * Feeds one sample and evaluates the condition.
+   *
+   * @param value Register value read this round
+   * @return true if the watch fires.
+   */
+  bool update(uint32_t value) {
+    uint32_t prev = last;
+    last = value;
+    if (mode == WATCH_CHANGE)
+      return ((value ^ prev) & mask) != 0;
+    return (value & mask) != 0 && (prev & mask) == 0;
+  }
+};
@@ -0,0 +1,265 @@
+/**
+ * @file fst_trace.h
+ * @brief Runtime-armed FST waveform capture for one simulation session.
+ *
+ * Waveforms are only recorded while a capture is armed through CMD_TRACE,
+ * so a traced build can serve production runs: while disarmed the harness
+ * pays a single predictable branch per clock edge. Two capture modes exist.
+ * A continuous capture dumps every cycle into one file until it is
+ * disarmed. A windowed capture rotates through segment files of a fixed
+ * cycle count and deletes all but the newest two, so the disk footprint
+ * stays bounded while the last one to two segments before a trigger are
+ * always available; after a TRACE_MODE_TRIGGER request the capture
+ * continues for the requested number of post-trigger cycles and then
+ * stops, leaving only the cycles around the event. Pointing the trace
+ * directory at a tmpfs such as /dev/shm keeps the rolling window in memory.
+ *
+ * Tracing needs a model verilated with `--trace-fst` (the `fst-trace`
+ * feature, which defines QCU_FST). Without it every arm request is answered
+ * with TRACE_UNSUPPORTED and the recorder compiles down to nothing.
+ */
+
+#pragma once
+
+#include "Vtop_soc.h"
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <unistd.h>
+
+#ifdef QCU_FST
+#include "verilated_fst_c.h"
+#endif
+
+/**
+ * @defgroup TraceModes CMD_TRACE Modes and Status Codes
+ * @{
+ */
+#define TRACE_MODE_OFF 0        /**< Stop and close any capture */
+#define TRACE_MODE_CONTINUOUS 1 /**< Dump every cycle into one file */
+#define TRACE_MODE_WINDOW 2     /**< Rolling window of two segments */
+#define TRACE_MODE_TRIGGER 3    /**< Keep the window, stop after N cycles */
+
+#define TRACE_OK 0          /**< Request accepted */
+#define TRACE_UNSUPPORTED 1 /**< Model built without FST support */
+#define TRACE_IO_ERROR 2    /**< Trace file could not be opened */
+#define TRACE_BAD_REQUEST 3 /**< Unknown mode or nothing to trigger */
+/** @} */
+
+/** FST hierarchy depth recorded (all levels). */
+#define TRACE_DEPTH 99
+
+/**
+ * Waveform recorder bound to one SoC model.
+ *
+ * The model calls sample() after every evaluation and end_cycle() after
+ * every clock cycle, both only while armed() is true. File names are
+ * `<prefix>_<capture>.fst` for continuous captures and
+ * `<prefix>_<capture>_seg<k>.fst` for the segments of a windowed one.
+ */
+class TraceRecorder {
+public:
+  TraceRecorder() = default;
+
+  ~TraceRecorder() {
+#ifdef QCU_FST
+    if (fst && fst->isOpen())
+      fst->close();
+#endif
+  }
+
+  TraceRecorder(const TraceRecorder &) = delete;
+  TraceRecorder &operator=(const TraceRecorder &) = delete;
+
+  /**
+   * Binds the recorder to a model and an output file prefix.
+   *
+   * @param model Model whose signals are traced
+   * @param path_prefix Directory and base name of the trace files
+   */
+  void attach(Vtop_soc *model, const std::string &path_prefix) {
+    top = model;
+    prefix = path_prefix;
+  }
+
+  /** Whether the harness must feed samples to the recorder. */
+  bool armed() const { return state != Idle; }
+
+  /**
+   * Records the model state at the current simulation time.
+   *
+   * @param time Simulation time of the sample
+   */
+  void sample(uint64_t time) {
+#ifdef QCU_FST
+    fst->dump(time);
+#else
+    (void)time;
+#endif
+  }
+
+  /**
+   * Advances segment rotation and post-trigger countdown.
+   *
+   * @param cycle SoC cycle counter after the cycle just simulated
+   */
+  void end_cycle(uint64_t cycle) {
+    if (state == Triggered && cycle >= stop_cycle) {
+      stop(cycle);
+    } else if (state == Window && cycle - seg_start >= seg_cycles) {
+      if (!open_segment(segment + 1, cycle))
+        stop(cycle);
+    }
+  }
+
+  /**
+   * Executes a CMD_TRACE request.
+   *
+   * @param mode One of the TRACE_MODE_* values
+   * @param cycles Segment length (WINDOW) or post-trigger cycles (TRIGGER)
+   * @param cycle Current SoC cycle counter
+   * @return One of the TRACE_* status codes.
+   */
+  uint32_t control(uint32_t mode, uint32_t cycles, uint64_t cycle) {
+    switch (mode) {
+    case TRACE_MODE_OFF:
+      stop(cycle);
+      return TRACE_OK;
+
+    case TRACE_MODE_CONTINUOUS:
+    case TRACE_MODE_WINDOW:
+#ifdef QCU_FST
+      if (mode == TRACE_MODE_WINDOW && cycles == 0)
+        return TRACE_BAD_REQUEST;
+      stop(cycle);
+      if (!fst) {
+        fst = std::make_unique<VerilatedFstC>();
+        top->trace(fst.get(), TRACE_DEPTH);
+      }
+      capture++;
+      capture_start = cycle;
+      segment = 0;
+      seg_start = cycle;
+      prev_seg_start = cycle;
+      if (mode == TRACE_MODE_CONTINUOUS) {
+        fst->open(file_name(capture, -1).c_str());
+        if (!fst->isOpen())
+          return TRACE_IO_ERROR;
+        state = Continuous;
+      } else {
+        seg_cycles = cycles;
+        if (!open_segment(0, cycle))
+          return TRACE_IO_ERROR;
+        state = Window;
+      }
+      return TRACE_OK;
+#else
+      return TRACE_UNSUPPORTED;
+#endif
+
+    case TRACE_MODE_TRIGGER:
+      if (state != Window && state != Continuous)
+        return TRACE_BAD_REQUEST;
+      state = Triggered;
+      trigger_cycle = cycle;
+      stop_cycle = cycle + cycles;
+      return TRACE_OK;
+
+    default:
+      return TRACE_BAD_REQUEST;
+    }
+  }
+
+private:
+  /** Capture state. */
+  enum State {
+    Idle,       /**< Nothing is recorded */
+    Continuous, /**< Single growing file */
+    Window,     /**< Rotating segments, waiting for a trigger */
+    Triggered   /**< Recording the post-trigger cycles */
+  };
+
+  /**
+   * Builds the file name of a capture or one of its segments.
+   *
+   * @param n Capture number
+   * @param seg Segment index, or -1 for a continuous capture
+   * @return Trace file path.
+   */
+  std::string file_name(uint32_t n, int64_t seg) const {
+    std::string name = prefix + "_" + std::to_string(n);
+    if (seg >= 0)
+      name += "_seg" + std::to_string(seg);
+    return name + ".fst";
+  }
+
+  /**
+   * Closes the current segment and starts segment k.
+   *
+   * Segment k-2 is deleted, so the newest complete segment and the one
+   * being written always survive.
+   *
+   * @param k Index of the new segment
+   * @param cycle First cycle recorded in it
+   * @return true if the segment file could be opened.
+   */
+  bool open_segment(uint64_t k, uint64_t cycle) {
+#ifdef QCU_FST
+    if (fst->isOpen())
+      fst->close();
+    if (k >= 2)
+      unlink(file_name(capture, static_cast<int64_t>(k - 2)).c_str());
+    segment = k;
+    prev_seg_start = seg_start;
+    seg_start = cycle;
+    fst->open(file_name(capture, static_cast<int64_t>(k)).c_str());
+    return fst->isOpen();
+#else
+    (void)k;
+    (void)cycle;
+    return false;
+#endif
+  }
+
+  /**
+   * Finalizes the running capture, if any, and reports what it kept.
+   *
+   * @param cycle Current SoC cycle counter
+   */
+  void stop(uint64_t cycle) {
+    if (state == Idle)
+      return;
+#ifdef QCU_FST
+    if (fst->isOpen())
+      fst->close();
+#endif
+    uint64_t first = capture_start;
+    if (state != Continuous && segment > 0)
+      first = prev_seg_start;
+    printf("[HW-TRACE] %s_%u: cycles %llu..%llu", prefix.c_str(), capture,
+           static_cast<unsigned long long>(first),
+           static_cast<unsigned long long>(cycle));
+    if (state == Triggered)
+      printf(", trigger at %llu",
+             static_cast<unsigned long long>(trigger_cycle));
+    printf("\n");
+    fflush(stdout);
+    state = Idle;
+  }
+
+  Vtop_soc *top = nullptr;     /**< Traced model */
+  std::string prefix;          /**< Output path prefix */
+  State state = Idle;          /**< Capture state */
+  uint32_t capture = 0;        /**< Captures started so far */
+  uint64_t capture_start = 0;  /**< First cycle of the capture */
+  uint64_t seg_cycles = 0;     /**< Cycles per window segment */
+  uint64_t segment = 0;        /**< Index of the segment being written */
+  uint64_t seg_start = 0;      /**< First cycle of the current segment */
+  uint64_t prev_seg_start = 0; /**< First cycle of the previous segment */
+  uint64_t trigger_cycle = 0;  /**< Cycle the trigger arrived */
+  uint64_t stop_cycle = 0;     /**< Cycle the post-trigger capture ends */
+#ifdef QCU_FST
+  std::unique_ptr<VerilatedFstC> fst; /**< FST writer (created on first arm) */
+#endif
+};
@@ -0,0 +1,244 @@
+/**
+ * @file hw_api.cpp
+ * @brief In-process C interface to the union-find accelerator model.
+ *
+ * Implements the `hw_*` functions declared in `qcu_hw/src/lib.rs` on top of
+ * a Verilator model of `union_find.sv`, so Rust code can drive the
+ * accelerator cycle by cycle without a simulation server in between. The
+ * parent array the engine walks is modeled here as a single-cycle memory:
+ * a read request issued on one cycle is answered with `mem_ready` on the
+ * next, matching the BRAM the RTL expects.
+ *
+ * The model is a process-wide singleton created by hw_init() and destroyed
+ * by hw_shutdown(); none of the functions are thread-safe.
+ */
+
+#include "Vunion_find.h"
+#include "verilated.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ * Union-find accelerator instance with its backing parent memory.
+ *
+ * Owns a private Verilator context so the library does not interfere with
+ * any other model in the process.
+ */
+struct UnionFindModel {
+  /** Verilator context holding simulation time. */
+  std::unique_ptr<VerilatedContext> ctx;
+
+  /** Verilator-generated accelerator instance. */
+  std::unique_ptr<Vunion_find> top;
+
+  /** Parent array served on the accelerator's memory port. */
+  std::vector<uint32_t> parent;
+
+  /** Whether a read was requested on the previous cycle. */
+  bool rd_pending = false;
+
+  /** Address of the pending read. */
+  uint32_t rd_addr = 0;
+
+  /** Clock cycles simulated since hw_init(). */
+  uint64_t cycles = 0;
+
+  /**
+   * Creates the model, loads the parent array and applies reset.
+   *
+   * @param data Parent array (copied)
+   * @param len Number of entries in data
+   */
+  UnionFindModel(const uint32_t *data, size_t len)
+      : ctx(std::make_unique<VerilatedContext>()), parent(data, data + len) {
+    top = std::make_unique<Vunion_find>(ctx.get(), "TOP");
+    top->clk = 0;
+    top->start = 0;
+    top->node_in = 0;
+    top->mem_ready = 0;
+    top->mem_rdata = 0;
+    top->rst_n = 0;
+    tick();
+    top->rst_n = 1;
+    tick();
+    cycles = 0;
+  }
+
+  ~UnionFindModel() { top->final(); }
+
+  UnionFindModel(const UnionFindModel &) = delete;
+  UnionFindModel &operator=(const UnionFindModel &) = delete;
+
+  /**
+   * Advances the model by one clock cycle, servicing the memory port.
+   *
+   * A read latched on the previous cycle is answered before the rising
+   * edge; the request lines are sampled again once the edge has settled.
+   * Reads past the end of the parent array return the address itself, so
+   * a stray pointer terminates the walk instead of reading garbage.
+   */
+  void tick() {
+    if (rd_pending) {
+      top->mem_ready = 1;
+      top->mem_rdata = rd_addr < parent.size() ? parent[rd_addr] : rd_addr;
+    } else {
+      top->mem_ready = 0;
+    }
+
+    top->clk = 1;
+    top->eval();
+    ctx->timeInc(1);
+    top->clk = 0;
+    top->eval();
+    ctx->timeInc(1);
+    cycles++;
+
+    rd_pending = top->mem_rd_en;
+    rd_addr = top->mem_addr;
+  }
+
+  /**
+   * Runs one complete find operation.
+   *
+   * Pulses start for one cycle and then steps until done is asserted. A
+   * find issued while the previous one is still in DONE_ST is accepted
+   * immediately, so back-to-back calls do not pay an idle cycle.
+   *
+   * @param node Starting node index
+   * @param max_cycles Cycle budget for this find
+   * @param root Receives the root on success
+   * @return true if the find completed within max_cycles.
+   */
+  bool find(uint32_t node, uint64_t max_cycles, uint32_t &root) {
+    top->start = 1;
+    top->node_in = node;
+    tick();
+    top->start = 0;
+
+    for (uint64_t n = 0; !top->done; n++) {
+      if (n >= max_cycles)
+        return false;
+      tick();
+    }
+    root = top->root_out;
+    return true;
+  }
+};
+
+/** The process-wide accelerator instance (null until hw_init()). */
+static std::unique_ptr<UnionFindModel> model;
+
+extern "C" {
+
+/**
+ * Creates the accelerator model and loads the parent array.
+ *
+ * Any previous instance is discarded first.
+ *
+ * @param data Parent array (copied; need not outlive the call)
+ * @param len Number of entries in data
+ */
+void hw_init(const uint32_t *data, size_t len) {
+  model.reset();
+  model = std::make_unique<UnionFindModel>(data, len);
+}
+
+/**
+ * Destroys the accelerator model.
+ */
+void hw_shutdown() { model.reset(); }
+
+/**
+ * Advances the accelerator by one clock cycle.
+ */
+void hw_step() {
+  if (model)
+    model->tick();
+}
+
+/**
+ * Drives the start and node inputs for the next clock edge.
+ *
+ * @param start Non-zero to request a new find
+ * @param node Starting node index
+ */
+void hw_set_input(int32_t start, int32_t node) {
+  if (!model)
+    return;
+  model->top->start = start != 0;
+  model->top->node_in = static_cast<uint32_t>(node);
+}
+
+/**
+ * Returns the root reported by the last completed find.
+ *
+ * @return root_out, or -1 if the model is not initialized.
+ */
+int32_t hw_get_root() {
+  return model ? static_cast<int32_t>(model->top->root_out) : -1;
+}
+
+/**
+ * Returns whether the current find has completed.
+ *
+ * @return Non-zero while done is asserted.
+ */
+int32_t hw_is_done() { return model && model->top->done ? 1 : 0; }
+
+/**
+ * Finds the roots of an array of nodes in one call.
+ *
+ * Runs the finds back to back on the model, exactly as repeated
+ * hw_set_input()/hw_step() sequences would, but without crossing the FFI
+ * boundary per cycle. Stops at the first find that exceeds its budget; the
+ * engine is then still walking (e.g. a parent cycle) and ignores further
+ * start requests until hw_init() resets it.
+ *
+ * @param nodes Starting node indices
+ * @param roots Receives one root per completed find
+ * @param count Number of entries in nodes and roots
+ * @param max_cycles Cycle budget for each individual find
+ * @return Number of finds completed (count unless one timed out).
+ */
+size_t hw_find_roots(const uint32_t *nodes, uint32_t *roots, size_t count,
+                     uint64_t max_cycles) {
+  if (!model)
+    return 0;
+  for (size_t i = 0; i < count; i++) {
+    if (!model->find(nodes[i], max_cycles, roots[i]))
+      return i;
+  }
+  return count;
+}
+
+/**
+ * Overwrites a range of the parent array.
+ *
+ * Lets a caller mirror unions performed in software without reloading and
+ * resetting the model. Writing past the current end grows the array; any
+ * entries skipped over become roots of their own sets.
+ *
+ * @param offset Index of the first entry to write
+ * @param data Replacement parent values
+ * @param len Number of entries in data
+ */
+void hw_write_parents(size_t offset, const uint32_t *data, size_t len) {
+  if (!model)
+    return;
+  std::vector<uint32_t> &parent = model->parent;
+  for (size_t i = parent.size(); i < offset + len; i++)
+    parent.push_back(static_cast<uint32_t>(i));
+  for (size_t i = 0; i < len; i++)
+    parent[offset + i] = data[i];
+}
+
+/**
+ * Returns the number of clock cycles simulated since hw_init().
+ *
+ * @return Cycle count (excluding the reset sequence).
+ */
+uint64_t hw_cycles() { return model ? model->cycles : 0; }
+
+} /* extern "C" */
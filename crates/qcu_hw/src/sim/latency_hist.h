@@ -0,0 +1,150 @@
+/**
+ * @file latency_hist.h
+ * @brief Log-linear latency histogram in the host's shared export format.
+ *
+ * Mirrors qcu_core::latency on the host and firmware: values below
+ * LAT_SUB_BUCKETS get one bucket each and every further power of two is
+ * split into LAT_SUB_BUCKETS equal buckets, so any value is known to within
+ * about 3% over the whole 64-bit range with a fixed LAT_BUCKETS counters.
+ * Summaries are printed as the same one-line export every layer uses:
+ *
+ *   LAT <source> unit=<unit> count=<n> min=<v> mean=<v> p50=<v> p99=<v>
+ *       p999=<v> max=<v> deadline=<v> misses=<n>
+ *
+ * (on one line), with percentiles reported as the highest value of the
+ * bucket holding that rank, clamped to the maximum. CMD_LATENCY replies
+ * with these lines, so simulated latencies can be compared with the
+ * host's and the firmware's directly.
+ *
+ * A histogram belongs to one session's SimStats and is only touched by the
+ * thread running that session, so its counters are plain integers; the
+ * host and firmware versions are atomic because several threads or harts
+ * record into them.
+ */
+
+#pragma once
+
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+/** Bits of sub-bucket resolution per power of two. */
+#define LAT_SUB_BITS 5
+
+/** Buckets per power of two. */
+#define LAT_SUB_BUCKETS (1u << LAT_SUB_BITS)
+
+/** Number of buckets needed to cover every 64-bit value. */
+#define LAT_BUCKETS ((65 - LAT_SUB_BITS) * LAT_SUB_BUCKETS)
+
+/**
+ * Returns the bucket a value is recorded in.
+ *
+ * @param value Recorded value
+ * @return Bucket index, below LAT_BUCKETS.
+ */
+static inline unsigned lat_bucket_index(uint64_t value) {
+  if (value < LAT_SUB_BUCKETS)
+    return static_cast<unsigned>(value);
+  unsigned shift = 63 - __builtin_clzll(value) - LAT_SUB_BITS;
+  return (shift + 1) * LAT_SUB_BUCKETS +
+         static_cast<unsigned>((value >> shift) - LAT_SUB_BUCKETS);
+}
+
+/**
+ * Returns the highest value recorded in a bucket.
+ *
+ * @param index Bucket index, below LAT_BUCKETS
+ * @return Largest value whose lat_bucket_index() is index.
+ */
+static inline uint64_t lat_bucket_high(unsigned index) {
+  if (index < LAT_SUB_BUCKETS)
+    return index;
+  unsigned shift = index / LAT_SUB_BUCKETS - 1;
+  uint64_t sub = index % LAT_SUB_BUCKETS + LAT_SUB_BUCKETS;
+  return (sub << shift) | ((uint64_t{1} << shift) - 1);
+}
+
+/**
+ * Log-linear histogram of latency samples.
+ */
+struct LatencyHistogram {
+  /** Samples per bucket. */
+  uint64_t buckets[LAT_BUCKETS] = {};
+
+  /** Number of samples. */
+  uint64_t count = 0;
+
+  /** Sum of the samples. */
+  uint64_t sum = 0;
+
+  /** Smallest sample (meaningful once count > 0). */
+  uint64_t min = UINT64_MAX;
+
+  /** Largest sample. */
+  uint64_t max = 0;
+
+  /**
+   * Records one sample.
+   *
+   * @param value Latency to record
+   */
+  void record(uint64_t value) {
+    buckets[lat_bucket_index(value)]++;
+    count++;
+    sum += value;
+    if (value < min)
+      min = value;
+    if (value > max)
+      max = value;
+  }
+
+  /**
+   * Returns the value at a percentile.
+   *
+   * @param per_mille Percentile in per mille (500 for the median)
+   * @return Highest value of the bucket holding that rank, clamped to the
+   *         maximum; 0 without samples.
+   */
+  uint64_t percentile(unsigned per_mille) const {
+    if (count == 0)
+      return 0;
+    uint64_t rank = (count * per_mille + 999) / 1000;
+    if (rank == 0)
+      rank = 1;
+    uint64_t seen = 0;
+    for (unsigned b = 0; b < LAT_BUCKETS; b++) {
+      seen += buckets[b];
+      if (seen >= rank)
+        return lat_bucket_high(b) < max ? lat_bucket_high(b) : max;
+    }
+    return max;
+  }
+
+  /**
+   * Appends the export line of the histogram.
+   *
+   * The deadline and miss count are passed in because the simulator
+   * decides what a miss is (a syndrome still unanswered at the deadline,
+   * whether or not it is answered later).
+   *
+   * @param source Name of the measurement (e.g. "sim.pulse")
+   * @param unit Unit of the samples ("ns" or "cycles")
+   * @param deadline Deadline the samples were checked against (0 for none)
+   * @param misses Samples that missed the deadline
+   * @param out Receives the line, terminated by a newline
+   */
+  void append_line(const char *source, const char *unit, uint64_t deadline,
+                   uint64_t misses, std::string &out) const {
+    char line[384];
+    snprintf(line, sizeof(line),
+             "LAT %s unit=%s count=%" PRIu64 " min=%" PRIu64 " mean=%" PRIu64
+             " p50=%" PRIu64 " p99=%" PRIu64 " p999=%" PRIu64 " max=%" PRIu64
+             " deadline=%" PRIu64 " misses=%" PRIu64 "\n",
+             source, unit, count, count ? min : 0, count ? sum / count : 0,
+             percentile(500), percentile(990), percentile(999), max, deadline,
+             misses);
+    out += line;
+  }
+};
@@ -6,68 +6,282 @@
  * top-level System-on-Chip module. Provides a TCP server interface that accepts
  * commands from the Rust host controller to step the simulation, read/write
  * memory-mapped registers, and control quantum hardware peripherals. The server
- * listens on port 8000 and processes commands in a blocking loop until the
- * connection is closed or an exit command is received.
+ * listens on port 8000 by default (the address, port and an optional Unix
+ * domain socket path are configurable) and gives every connection its own
+ * SoC instance and worker thread, so independent experiments run side by
+ * side in one process.
+ * With `--shm <name>` a single session is served over a shared-memory ring
+ * pair instead. Each session processes commands in a blocking loop until its
+ * connection is closed or an exit command is received, and keeps the
+ * instrumentation counters of sim_stats.h, readable with CMD_STATS and
+ * optionally dumped periodically. Sessions can checkpoint their SoC with
+ * CMD_SAVE and fork from any checkpoint of the same server with
+ * CMD_RESTORE (snapshot.h). Instead of polling, a host can subscribe to
+ * register conditions and let the session free-run until the simulator
+ * pushes an event (events.h). With `--pace` every session instead runs its
+ * clock continuously on a thread of its own at a fixed real-time rate and
+ * applies host commands at cycle boundaries (realtime.h). With `--record`
+ * every bus transaction of a session is logged, and `--replay` feeds such a
+ * log straight into a fresh SoC, without any transport (replay_log.h);
+ * `--bench` measures the same core directly.
  */
 
 #include "Vtop_soc.h"
+#include "channel.h"
+#include "events.h"
+#include "fst_trace.h"
+#include "realtime.h"
+#include "replay_log.h"
+#include "shm_channel.h"
+#include "sim_stats.h"
+#include "snapshot.h"
 #include "verilated.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
+#include <functional>
 #include <iostream>
+#include <arpa/inet.h>
 #include <memory>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <string>
 #include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <thread>
 #include <unistd.h>
 #include <vector>
 
 /**
- * Global simulation time counter for SystemC compatibility.
+ * Thread count the model was verilated with (`--threads`, set by build.rs).
  *
- * Incremented on each clock edge to provide a monotonically increasing
- * time value for simulation logging and debugging. Used by Verilator's
- * time stamp callback function.
+ * Verilator aborts when a context's thread count differs from the model's,
+ * so it is fixed at verilation time and not a runtime choice.
  */
-vluint64_t main_time = 0;
+#ifndef QCU_SIM_THREADS
+#define QCU_SIM_THREADS 1
+#endif
 
 /**
- * SystemC time stamp callback function.
+ * Simulation server configuration shared by all sessions.
  *
- * Returns the current simulation time in SystemC units. Required by
- * Verilator for SystemC-style simulation integration. The time value
- * is derived from main_time, which increments with each clock cycle.
- *
- * @return Current simulation time as a double-precision value.
+ * Every session builds its own Verilator context from these arguments, so
+ * plusargs given on the command line apply to all instances while the
+ * per-session noise seed is appended separately. The listener fields select
+ * where the server accepts connections.
  */
-double sc_time_stamp() { return main_time; }
+struct SimOptions {
+  int argc = 0;                      /**< Command-line argument count */
+  char **argv = nullptr;             /**< Command-line arguments (plusargs) */
+  uint32_t seed_base = 0;            /**< Noise seed of the first session */
+  std::string bind_addr = "0.0.0.0"; /**< IPv4 address to listen on */
+  uint16_t port = 8000;              /**< TCP port (0 picks an ephemeral one) */
+  std::string port_file;             /**< File receiving the bound TCP port */
+  std::string unix_path;             /**< Unix socket path (replaces TCP) */
+  bool fast_forward = true;          /**< Skip idle cycles while quiescent */
+  unsigned threads = 0;              /**< Expected model threads (0 = any) */
+  bool profile_eval = false;         /**< Time every model evaluation */
+  uint32_t stats_interval_ms = 0;    /**< Periodic stats dump (0 = off) */
+  std::string trace_dir = ".";       /**< Directory receiving FST captures */
+  uint64_t pace_cycles = 0;          /**< Paced cycles per period (0 = off) */
+  uint64_t pace_us = 0;              /**< Pacing period in microseconds */
+  uint64_t deadline_cycles = 0;      /**< Pulse deadline in cycles (0 = off) */
+  std::string record_dir;            /**< Directory of transaction logs */
+};
 
 /**
  * System-on-Chip simulation wrapper class.
  *
- * Encapsulates the Verilator-generated top-level module and provides
- * methods for clock generation, reset control, and bus transactions.
- * Manages the simulation state machine and coordinates between the
- * Verilator evaluation calls and the TCP command interface.
+ * Encapsulates one Verilator-generated top-level module together with its
+ * own simulation context, and provides methods for clock generation, reset
+ * control, and bus transactions. Instances share no state, so several can
+ * be driven concurrently from different threads.
  */
 class SoC {
 public:
+  /** Per-instance Verilator context holding simulation time and plusargs. */
+  std::unique_ptr<VerilatedContext> ctx;
+
   /** Verilator-generated top-level module instance. */
   std::unique_ptr<Vtop_soc> top;
 
+  /** Whether step() may skip cycles while the design is quiescent. */
+  bool fast_forward;
+
+  /** Clock cycles simulated since reset, including skipped ones. */
+  uint64_t cycles = 0;
+
+  /** Clock cycles skipped by fast-forwarding instead of evaluated. */
+  uint64_t skipped = 0;
+
+  /** Whether tick() measures the wall time of the model evaluations. */
+  bool profile_eval;
+
+  /** Instrumentation counters of the session driving this SoC. */
+  SimStats stats;
+
+  /** A syndrome is visible and no correction pulse has started yet. */
+  bool syndrome_pending = false;
+
+  /** Cycle at which the pending syndrome became visible. */
+  uint64_t syndrome_cycle = 0;
+
+  /** Correction pulse activity seen on the previous cycle. */
+  bool pulse_seen = false;
+
+  /** The pending syndrome has already been counted as a deadline miss. */
+  bool deadline_missed = false;
+
+  /** Wall-clock pacing of paced sessions (disabled otherwise). */
+  Pacer pace;
+
+  /** Transaction log of a recorded session (null otherwise). */
+  std::unique_ptr<ReplayWriter> log;
+
+  /** Waveform recorder, armed and disarmed through CMD_TRACE. */
+  TraceRecorder trace;
+
   /**
    * Constructs and initializes the SoC simulation.
    *
-   * Creates the Verilator module instance, applies reset sequence (assert
-   * reset for one clock cycle, then deassert), and prepares the simulation
-   * for normal operation. The reset sequence ensures all state machines
-   * and registers start in known initial states.
+   * Creates a private Verilator context, sized to the thread count the
+   * model was verilated with, carrying the command-line plusargs plus
+   * `+qcu_seed=<seed>`, which the physics engines mix into their PRNG
+   * seeds so each instance sees an independent noise realization. Then
+   * creates the module instance, applies the reset sequence (assert reset
+   * for one clock cycle, then deassert), and prepares the simulation for
+   * normal operation. The reset sequence ensures all state machines and
+   * registers start in known initial states. Waveform captures of the
+   * instance are written to `<trace_dir>/qcu_s<session>_*.fst`. The pacing
+   * rate and the latency deadline are taken over from the options; pacing
+   * only takes effect once a paced session starts the clock. With a record
+   * directory configured, every bus transaction after the reset sequence
+   * is logged to `<record_dir>/qcu_s<session>.qlog`.
+   *
+   * @param opts Server options (command-line plusargs)
+   * @param seed Noise seed for this instance (0 reproduces the RTL defaults)
+   * @param session Session id used in trace file names
    */
-  SoC() {
-    top = std::make_unique<Vtop_soc>();
+  SoC(const SimOptions &opts, uint32_t seed, uint32_t session)
+      : fast_forward(opts.fast_forward), profile_eval(opts.profile_eval) {
+    ctx = std::make_unique<VerilatedContext>();
+#ifdef QCU_FST
+    ctx->traceEverOn(true);
+#endif
+    if (QCU_SIM_THREADS > 1)
+      ctx->threads(QCU_SIM_THREADS);
+    ctx->commandArgs(opts.argc, opts.argv);
+    char seed_arg[32];
+    snprintf(seed_arg, sizeof(seed_arg), "+qcu_seed=%08x", seed);
+    const char *extra[] = {seed_arg};
+    ctx->commandArgsAdd(1, extra);
+
+    if (opts.pace_cycles != 0)
+      pace.configure(opts.pace_cycles, opts.pace_us * 1000);
+    stats.pace_hz = pace.rate_hz();
+    stats.deadline_cycles = opts.deadline_cycles;
+
+    top = std::make_unique<Vtop_soc>(ctx.get(), "TOP");
+    trace.attach(top.get(),
+                 opts.trace_dir + "/qcu_s" + std::to_string(session));
     top->clk = 0;
+    top->bus_cs = 0;
+    top->bus_burst = 0;
     top->rst_n = 0;
     tick();
     top->rst_n = 1;
     tick();
+
+    if (!opts.record_dir.empty()) {
+      std::vector<std::string> plusargs;
+      for (int i = 1; i < opts.argc; i++)
+        if (opts.argv[i][0] == '+')
+          plusargs.push_back(opts.argv[i]);
+      std::string path =
+          opts.record_dir + "/qcu_s" + std::to_string(session) + ".qlog";
+      log = std::make_unique<ReplayWriter>();
+      if (!log->open(path, seed, plusargs, cycles)) {
+        fprintf(stderr, "[HW-SRV] Cannot record to %s: %s\n", path.c_str(),
+                strerror(errno));
+        log.reset();
+      }
+    }
+  }
+
+  ~SoC() {
+    trace.control(TRACE_MODE_OFF, 0, cycles);
+    top->final();
+  }
+
+  SoC(const SoC &) = delete;
+  SoC &operator=(const SoC &) = delete;
+
+  /**
+   * Serializes the model and harness state into a snapshot image.
+   *
+   * Saves the complete Verilated model followed by the simulation time,
+   * the cycle counters and the latency tracking state, so a restored
+   * instance continues exactly where this one is now.
+   *
+   * @param image Output image
+   * @return SNAP_OK, or SNAP_UNSUPPORTED without --savable.
+   */
+  uint32_t save(SnapshotImage &image) {
+#ifdef QCU_SAVABLE
+    MemorySave os(image);
+    os << *top;
+    uint64_t state[7] = {ctx->time(),    cycles,           skipped,
+                         syndrome_cycle, syndrome_pending, pulse_seen,
+                         deadline_missed};
+    os.write(state, sizeof(state));
+    os.close();
+    return SNAP_OK;
+#else
+    (void)image;
+    return SNAP_UNSUPPORTED;
+#endif
+  }
+
+  /**
+   * Replaces the model and harness state with a snapshot image.
+   *
+   * A running waveform capture is finalized first, since simulation time
+   * jumps, and the instrumentation counters start a new measurement window
+   * at the restored cycle count. A paced clock is re-anchored there, and a
+   * recorded session logs the image so a replay can restore it too.
+   *
+   * @param image Image written by save() in the same build
+   * @return SNAP_OK, or SNAP_UNSUPPORTED without --savable.
+   */
+  uint32_t restore(const SnapshotImage &image) {
+#ifdef QCU_SAVABLE
+    trace.control(TRACE_MODE_OFF, 0, cycles);
+    uint64_t before = cycles;
+    MemoryRestore os(image);
+    os >> *top;
+    uint64_t state[7];
+    os.read(state, sizeof(state));
+    os.close();
+    ctx->time(state[0]);
+    cycles = state[1];
+    skipped = state[2];
+    syndrome_cycle = state[3];
+    syndrome_pending = state[4] != 0;
+    pulse_seen = state[5] != 0;
+    deadline_missed = state[6] != 0;
+    stats.reset(cycles, skipped);
+    pace.start(cycles);
+    if (log)
+      log->restore(before, image, cycles);
+    return SNAP_OK;
+#else
+    (void)image;
+    return SNAP_UNSUPPORTED;
+#endif
   }
 
   /**
@@ -76,15 +290,96 @@ public:
    * Generates a complete clock cycle by setting clk high, evaluating the
    * Verilator model, then setting clk low and evaluating again. This two-phase
    * evaluation ensures proper setup and hold time behavior for sequential
-   * logic. Increments main_time to track simulation progress.
+   * logic. Advances the context time by one unit per edge. With eval
+   * profiling enabled the wall time of both evaluations is accumulated;
+   * the clock reads are skipped otherwise, as they would cost a sizeable
+   * fraction of a small model's evaluation. While a waveform capture is
+   * armed both edges are sampled into it. A paced clock is held to its
+   * schedule every few cycles; unpaced, that costs a single compare.
    */
   void tick() {
+    uint64_t start = profile_eval ? stats_now_ns() : 0;
     top->clk = 1;
     top->eval();
-    main_time++;
+    if (trace.armed())
+      trace.sample(ctx->time());
+    ctx->timeInc(1);
     top->clk = 0;
     top->eval();
-    main_time++;
+    if (trace.armed())
+      trace.sample(ctx->time());
+    ctx->timeInc(1);
+    if (profile_eval)
+      stats.eval_ns += stats_now_ns() - start;
+    cycles++;
+    track_latency();
+    if (trace.armed())
+      trace.end_cycle(cycles);
+    if (cycles >= pace.next_check)
+      pace.sync(cycles, stats);
+  }
+
+  /**
+   * Timestamps syndromes and the correction pulses answering them.
+   *
+   * A syndrome counts as visible on the first cycle the qubit grid flags an
+   * error while no pulse is running; the sample ends on the cycle a pulse
+   * starts. A syndrome that clears by itself before any pulse is dropped.
+   * With a deadline configured, a syndrome still unanswered that many
+   * cycles after it became visible counts once as a deadline miss.
+   * Fast-forwarded cycles need no tracking because both flags are frozen
+   * while the design is quiescent.
+   */
+  void track_latency() {
+    bool pulse = top->pulse_busy;
+    if (pulse && !pulse_seen && syndrome_pending) {
+      stats.record_latency(cycles - syndrome_cycle);
+      syndrome_pending = false;
+    } else if (!top->syndrome_any) {
+      syndrome_pending = false;
+    } else if (!syndrome_pending && !pulse) {
+      syndrome_pending = true;
+      syndrome_cycle = cycles;
+      deadline_missed = false;
+    }
+    if (syndrome_pending && !deadline_missed && stats.deadline_cycles != 0 &&
+        cycles - syndrome_cycle >= stats.deadline_cycles) {
+      stats.deadline_misses++;
+      deadline_missed = true;
+    }
+    pulse_seen = pulse;
+  }
+
+  /**
+   * Advances simulation by n clock cycles with no bus activity.
+   *
+   * Ticks the clock cycle by cycle, but as soon as the design reports
+   * quiescent (physics disabled, no pulse pending) the remaining cycles are
+   * skipped by advancing the context time directly. Quiescence can only end
+   * through a bus write, so the skipped cycles are exactly equivalent to
+   * evaluating them. Long idle stretches therefore cost O(1) instead of two
+   * model evaluations per cycle. A paced clock still waits out the wall
+   * time of the skipped cycles.
+   *
+   * @param n Number of clock cycles to advance
+   */
+  void step(uint32_t n) {
+    if (log && n != 0)
+      log->step(cycles, n);
+    while (n > 0) {
+      if (fast_forward && top->quiescent) {
+        ctx->timeInc(2 * static_cast<uint64_t>(n));
+        cycles += n;
+        skipped += n;
+        if (trace.armed())
+          trace.end_cycle(cycles);
+        if (cycles >= pace.next_check)
+          pace.sync(cycles, stats);
+        return;
+      }
+      tick();
+      n--;
+    }
   }
 
   /**
@@ -105,6 +400,8 @@ public:
     tick();
     top->bus_cs = 0;
     top->bus_we = 0;
+    if (log)
+      log->write(cycles - 1, addr, data);
   }
 
   /**
@@ -124,8 +421,125 @@ public:
     tick();
     uint32_t data = top->bus_rdata;
     top->bus_cs = 0;
+    if (log)
+      log->read(cycles - 1, addr, data);
     return data;
   }
+
+  /**
+   * Reads count consecutive words with an auto-incrementing bus burst.
+   *
+   * Drives the base address on the first beat and holds bus_burst on the
+   * following ones, so the bus moves one word per clock cycle without
+   * re-addressing. Each beat samples the register before the clock edge
+   * that ends it.
+   *
+   * @param addr Address of the first word
+   * @param count Number of words to read
+   * @param out Destination for count words
+   */
+  void read_burst(uint32_t addr, uint32_t count, uint32_t *out) {
+    top->bus_cs = 1;
+    top->bus_we = 0;
+    top->bus_addr = addr;
+    for (uint32_t i = 0; i < count; i++) {
+      top->bus_burst = i != 0;
+      top->eval();
+      out[i] = top->bus_rdata;
+      tick();
+    }
+    top->bus_burst = 0;
+    top->bus_cs = 0;
+    if (log)
+      log->burst(RLOG_READ_BURST, cycles - count, addr, count, out);
+  }
+
+  /**
+   * Writes count consecutive words with an auto-incrementing bus burst.
+   *
+   * @param addr Address of the first word
+   * @param count Number of words to write
+   * @param data Source of count words
+   */
+  void write_burst(uint32_t addr, uint32_t count, const uint32_t *data) {
+    top->bus_cs = 1;
+    top->bus_we = 1;
+    top->bus_addr = addr;
+    for (uint32_t i = 0; i < count; i++) {
+      top->bus_burst = i != 0;
+      top->bus_wdata = data[i];
+      tick();
+    }
+    top->bus_burst = 0;
+    top->bus_cs = 0;
+    top->bus_we = 0;
+    if (log)
+      log->burst(RLOG_WRITE_BURST, cycles - count, addr, count, data);
+  }
+
+  /**
+   * Advances the simulation until a register leaves a reference value.
+   *
+   * Reads the register once per cycle (each read is a full bus transaction
+   * and therefore advances the clock by one cycle) and stops as soon as
+   * the masked value differs from the masked reference, or when the cycle
+   * budget is exhausted. Passing the last observed value as the reference
+   * waits for a change; passing zero waits for any bit under the mask to
+   * become set.
+   *
+   * @param addr Register address to poll
+   * @param mask Bits of the register that are compared
+   * @param ref Reference value the register is compared against
+   * @param max_cycles Maximum number of cycles to run (0 returns at once)
+   * @param value Output: last value read (0 if no cycle was run)
+   * @return Number of clock cycles consumed.
+   */
+  uint32_t step_until(uint32_t addr, uint32_t mask, uint32_t ref,
+                      uint32_t max_cycles, uint32_t &value) {
+    value = 0;
+    uint32_t cycles = 0;
+    while (cycles < max_cycles) {
+      value = read(addr);
+      cycles++;
+      if ((value ^ ref) & mask)
+        break;
+    }
+    return cycles;
+  }
+
+  /**
+   * Reads the syndrome words and applies a correction pulse if needed.
+   *
+   * Reads `words` consecutive syndrome registers starting at measure_base.
+   * If any bit is set, the syndrome is copied into the pulse staging bank
+   * at stage_base and a write of pulse_cycles to go_addr fires it on every
+   * flagged qubit at once, after which the simulation runs until the pulse
+   * has finished. No cycles beyond the initial reads are spent when the
+   * syndrome is zero.
+   *
+   * @param measure_base Address of syndrome word 0
+   * @param stage_base Address of pulse staging word 0
+   * @param go_addr Address of the pulse trigger register
+   * @param pulse_cycles Pulse duration in clock cycles
+   * @param syndrome Syndrome words to read; resized by the caller
+   * @return Number of clock cycles consumed.
+   */
+  uint32_t measure_correct(uint32_t measure_base, uint32_t stage_base,
+                           uint32_t go_addr, uint32_t pulse_cycles,
+                           std::vector<uint32_t> &syndrome) {
+    uint32_t words = static_cast<uint32_t>(syndrome.size());
+    read_burst(measure_base, words, syndrome.data());
+    uint32_t any = 0;
+    for (uint32_t w : syndrome)
+      any |= w;
+    if (any == 0)
+      return words;
+
+    write_burst(stage_base, words, syndrome.data());
+    write(go_addr, pulse_cycles);
+    step(pulse_cycles);
+    return 2 * words + 1 + pulse_cycles;
+  }
 };
 
 /**
@@ -134,130 +548,1296 @@ public:
  *
  * The protocol uses a simple command format: 1-byte opcode followed by
  * optional 4-byte address and/or 4-byte data fields. All multi-byte
- * values are transmitted in little-endian byte order.
+ * values are transmitted in little-endian byte order. CMD_BATCH carries a
+ * 4-byte payload length followed by packed STEP/WRITE/READ records and is
+ * answered with a single reply holding every read result. CMD_STEP_UNTIL
+ * and CMD_MEASURE_CORRECT run a whole feedback sequence inside the
+ * simulator and reply with the cycles consumed followed by the value(s)
+ * read: one word for CMD_STEP_UNTIL, one per syndrome word for
+ * CMD_MEASURE_CORRECT. CMD_READ_BURST (addr, count) replies with count
+ * words; CMD_WRITE_BURST (addr, count, count data words) is acknowledged
+ * with a single word. Both move a contiguous range in one round trip.
+ * CMD_STATS (flags) replies with a 32-bit word count followed by that many
+ * 64-bit counters in the layout of sim_stats.h; flag STATS_FLAG_RESET
+ * clears the counters after they have been sent. CMD_LATENCY (flags)
+ * replies with a 32-bit byte count followed by that many bytes of text:
+ * the percentile lines of the session's latency histograms in the export
+ * format of latency_hist.h; STATS_FLAG_RESET again restarts the whole
+ * measurement window. CMD_TRACE (mode, cycles) arms, triggers or stops a
+ * waveform capture (fst_trace.h) and replies with a TRACE_* status word.
+ * CMD_SAVE and CMD_RESTORE (slot, path length, path bytes) checkpoint the
+ * SoC into or load it from an in-memory slot shared by all sessions (empty
+ * path) or a snapshot file (snapshot.h); they reply with a SNAP_* status
+ * word and the 64-bit cycle counter after the operation. CMD_SUBSCRIBE (id,
+ * addr, mask, mode) installs or removes a register watch and replies with a
+ * status word (0 on success). CMD_RUN (max_cycles, flags) free-runs the
+ * simulation and answers with event frames (events.h) closed by an
+ * EVENT_END frame; any command sent while running ends the run. CMD_HALT is
+ * answered with an EVENT_END frame only, so it both stops a run and
+ * confirms that none is active.
  * @{
  */
-#define CMD_STEP 0x01  /**< Step simulation by N clock cycles */
-#define CMD_WRITE 0x02 /**< Write data to memory-mapped address */
-#define CMD_READ 0x03  /**< Read data from memory-mapped address */
-#define CMD_EXIT 0xFF  /**< Exit simulation and close connection */
+#define CMD_STEP 0x01            /**< Step simulation by N clock cycles */
+#define CMD_WRITE 0x02           /**< Write data to memory-mapped address */
+#define CMD_READ 0x03            /**< Read data from memory-mapped address */
+#define CMD_BATCH 0x04           /**< Execute a frame of sub-commands */
+#define CMD_STEP_UNTIL 0x05      /**< Step until a masked register changes */
+#define CMD_MEASURE_CORRECT 0x06 /**< Read syndrome, pulse it if nonzero */
+#define CMD_READ_BURST 0x07      /**< Read a contiguous range of words */
+#define CMD_WRITE_BURST 0x08     /**< Write a contiguous range of words */
+#define CMD_STATS 0x09           /**< Read (and optionally reset) counters */
+#define CMD_TRACE 0x0A           /**< Control the FST waveform capture */
+#define CMD_SAVE 0x0B            /**< Checkpoint the SoC state */
+#define CMD_RESTORE 0x0C         /**< Load a checkpointed SoC state */
+#define CMD_SUBSCRIBE 0x0D       /**< Install or remove a register watch */
+#define CMD_RUN 0x0E             /**< Free-run, pushing watch events */
+#define CMD_HALT 0x0F            /**< Stop a run (reply: EVENT_END frame) */
+#define CMD_LATENCY 0x10         /**< Read latency percentile lines */
+#define CMD_EXIT 0xFF            /**< Exit simulation and close connection */
 /** @} */
 
 /**
- * Main entry point for Verilator simulation server.
+ * Upper bound on the payload size of a single CMD_BATCH frame.
  *
- * Initializes the Verilator simulation, sets up a TCP server socket on port
- * 8000, and enters a command processing loop. Accepts connections from the
- * Rust host controller and processes commands to step the simulation and
- * access hardware registers. The loop continues until the connection is
- * closed or an exit command is received.
+ * Protects the server from allocating unbounded memory when a corrupted
+ * length prefix arrives. 1 MiB holds well over 100k sub-commands, far more
+ * than a correction cycle needs.
+ */
+#define MAX_BATCH_BYTES (1u << 20)
+
+/**
+ * Upper bound on the syndrome words handled by CMD_MEASURE_CORRECT.
  *
- * @param argc Command-line argument count
- * @param argv Command-line argument vector (passed to Verilator)
- * @return Exit status code (0 on success)
+ * Matches the 32-word syndrome bank of the qubit grid (a 32x32 grid).
  */
-int main(int argc, char **argv) {
-  Verilated::commandArgs(argc, argv);
-  SoC soc;
+#define MAX_SYNDROME_WORDS 32
+
+/**
+ * Upper bound on the word count of a single burst.
+ *
+ * Bounds the staging buffer a burst request can make the server allocate;
+ * 64 Ki words (256 KiB) covers any register bank or BRAM in the design.
+ */
+#define MAX_BURST_WORDS (1u << 16)
 
+/**
+ * CMD_STATS and CMD_LATENCY flag: start a new measurement window after
+ * replying.
+ */
+#define STATS_FLAG_RESET 0x1u
+
+/**
+ * Prints a session's counters to stdout.
+ *
+ * One summary line with the cycle, wall-time and latency figures is
+ * followed by one line listing every opcode that was used, with its count,
+ * mean host wall time and mean simulated cycles per command, and by the
+ * CMD_LATENCY export lines.
+ *
+ * @param id Session id
+ * @param soc Simulation instance whose counters are printed
+ */
+static void dump_stats(uint32_t id, const SoC &soc) {
+  static const char *const names[STATS_MAX_OPCODE + 1] = {
+      "?",          "STEP",       "WRITE",           "READ",
+      "BATCH",      "STEP_UNTIL", "MEASURE_CORRECT", "READ_BURST",
+      "WRITE_BURST", "STATS",     "TRACE",           "SAVE",
+      "RESTORE",    "SUBSCRIBE",  "RUN",             "HALT"};
+
+  std::vector<uint64_t> w;
+  soc.stats.serialize(soc.cycles, soc.skipped, w);
+  double wall_ms = static_cast<double>(w[4]) / 1e6;
+  printf("[HW-STATS] Session %u: %llu cycles (%llu evaluated, %llu skipped) "
+         "in %.1f ms",
+         id, static_cast<unsigned long long>(w[0]),
+         static_cast<unsigned long long>(w[1]),
+         static_cast<unsigned long long>(w[2]), wall_ms);
+  if (soc.profile_eval && w[4] != 0)
+    printf(", eval %.1f%%", 100.0 * static_cast<double>(w[3]) / w[4]);
+  if (w[5] != 0)
+    printf(", syndrome->pulse %llu samples mean %.1f min %llu max %llu cycles",
+           static_cast<unsigned long long>(w[5]),
+           static_cast<double>(w[6]) / w[5],
+           static_cast<unsigned long long>(w[7]),
+           static_cast<unsigned long long>(w[8]));
+  printf("\n[HW-STATS] Session %u commands:", id);
+  for (unsigned op = 1; op <= STATS_MAX_OPCODE; op++) {
+    size_t base = 9 + STATS_LAT_BUCKETS + 3 * (op - 1);
+    uint64_t count = w[base];
+    if (count == 0)
+      continue;
+    printf(" %s %llux %.2fus/%.1fcyc", names[op],
+           static_cast<unsigned long long>(count),
+           static_cast<double>(w[base + 1]) / 1e3 / count,
+           static_cast<double>(w[base + 2]) / count);
+  }
+  std::string latency;
+  soc.stats.latency_report(latency);
+  printf("\n%s", latency.c_str());
+  fflush(stdout);
+}
+
+/** Checkpoints shared by all sessions of the server. */
+static SnapshotStore snapshots;
+
+/**
+ * Executes a CMD_SAVE or CMD_RESTORE request.
+ *
+ * @param soc Simulation instance to checkpoint or overwrite
+ * @param save true for CMD_SAVE, false for CMD_RESTORE
+ * @param slot In-memory slot (used when path is empty)
+ * @param path Snapshot file, or empty for the in-memory slot
+ * @param session Id of the requesting session (names the temporary file)
+ * @return One of the SNAP_* status codes.
+ */
+static uint32_t run_snapshot(SoC &soc, bool save, uint32_t slot,
+                             const std::string &path, uint32_t session) {
+#ifndef QCU_SAVABLE
+  (void)soc;
+  (void)save;
+  (void)slot;
+  (void)path;
+  (void)session;
+  return SNAP_UNSUPPORTED;
+#else
+  if (path.empty() && slot >= SNAP_SLOTS)
+    return SNAP_BAD_REQUEST;
+
+  if (save) {
+    auto image = std::make_shared<SnapshotImage>();
+    uint32_t status = soc.save(*image);
+    if (status != SNAP_OK)
+      return status;
+    if (!path.empty())
+      return write_snapshot_file(path, *image, session);
+    snapshots.put(slot, std::move(image));
+    return SNAP_OK;
+  }
+
+  if (path.empty()) {
+    std::shared_ptr<const SnapshotImage> image = snapshots.get(slot);
+    if (!image)
+      return SNAP_NOT_FOUND;
+    return soc.restore(*image);
+  }
+  SnapshotImage image;
+  uint32_t status = read_snapshot_file(path, image);
+  if (status != SNAP_OK)
+    return status;
+  return soc.restore(image);
+#endif
+}
+
+/**
+ * Free-runs the simulation and pushes watch events to the host.
+ *
+ * Every round reads each active watch's register once, so a round costs
+ * one bus cycle per watch, and evaluates its condition; firing watches are
+ * pushed as EVENT_FIRED frames right away. While the design is quiescent
+ * no register can change, so once every watch has sampled the current
+ * state the cycles up to the next command check are fast-forwarded
+ * instead; the watches sample again after every skip before the next one,
+ * so a condition that already holds at the start of the run (or when the
+ * design goes quiet) still fires. Every RUN_POLL_CYCLES cycles the session is
+ * asked whether a command is waiting, and a pending command ends the run
+ * so it can be executed. The run always ends with an EVENT_END frame.
+ *
+ * @param soc Simulation instance to drive
+ * @param chan Connected transport
+ * @param watches Session watches
+ * @param max_cycles Cycle budget (0 runs until an event or a command)
+ * @param flags RUN_FLAG_* bits
+ * @param interrupted Whether a host command is waiting
+ * @return false if the channel failed, true otherwise.
+ */
+static bool free_run(SoC &soc, Channel &chan, Watch *watches,
+                     uint32_t max_cycles, uint32_t flags,
+                     const std::function<bool()> &interrupted) {
+  uint64_t start = soc.cycles;
+  uint64_t next_poll = start + RUN_POLL_CYCLES;
+  bool stream = (flags & RUN_FLAG_STREAM) != 0;
+  bool any_watch = false;
+  for (unsigned i = 0; i < MAX_WATCHES; i++) {
+    watches[i].start_run();
+    any_watch |= watches[i].mode != WATCH_OFF;
+  }
+
+  uint32_t reason = any_watch ? RUN_END_BUDGET : RUN_END_IDLE;
+  EventFrame frames[MAX_WATCHES + 1];
+  unsigned pending = 0;
+  bool sampled = false;
+  while (any_watch && reason == RUN_END_BUDGET) {
+    uint64_t used = soc.cycles - start;
+    if (max_cycles != 0 && used >= max_cycles)
+      break;
+    if (soc.cycles >= next_poll) {
+      next_poll = soc.cycles + RUN_POLL_CYCLES;
+      if (interrupted()) {
+        reason = RUN_END_HALTED;
+        break;
+      }
+    }
+
+    if (sampled && soc.fast_forward && soc.top->quiescent) {
+      uint64_t skip = next_poll - soc.cycles;
+      if (max_cycles != 0)
+        skip = std::min<uint64_t>(skip, max_cycles - used);
+      soc.step(static_cast<uint32_t>(skip));
+      sampled = false;
+      continue;
+    }
+
+    for (unsigned i = 0; i < MAX_WATCHES; i++) {
+      Watch &w = watches[i];
+      if (w.mode == WATCH_OFF)
+        continue;
+      uint32_t value = soc.read(w.addr);
+      if (w.update(value))
+        frames[pending++] = {EVENT_FIRED, i, soc.cycles, value};
+    }
+    sampled = true;
+    if (pending != 0) {
+      if (!stream) {
+        reason = RUN_END_EVENT;
+        break;
+      }
+      if (!chan.send_all(frames, pending * sizeof(EventFrame)))
+        return false;
+      pending = 0;
+    }
+  }
+
+  uint32_t used =
+      static_cast<uint32_t>(std::min<uint64_t>(soc.cycles - start, UINT32_MAX));
+  frames[pending++] = {EVENT_END, reason, soc.cycles, used};
+  return chan.send_all(frames, pending * sizeof(EventFrame));
+}
+
+/**
+ * Executes the sub-commands of a CMD_BATCH frame back to back.
+ *
+ * The payload is a packed sequence of STEP (opcode + cycles), WRITE (opcode
+ * + addr + data), READ (opcode + addr), READ_BURST (opcode + addr + count)
+ * and WRITE_BURST (opcode + addr + count + data words) records using the
+ * same encoding as the top-level protocol. Every READ appends its result,
+ * and every READ_BURST its count results, to the reply,
+ * which is laid out as a 32-bit result count followed by the values in
+ * issue order. The whole frame costs a single receive and a single send.
+ *
+ * @param soc Simulation instance to drive
+ * @param payload Frame payload (without the opcode and length prefix)
+ * @param len Payload length in bytes
+ * @param reply Output buffer; reply[0] is the count, results follow
+ * @return true if the payload was well formed, false otherwise.
+ */
+static bool run_batch(SoC &soc, const uint8_t *payload, size_t len,
+                      std::vector<uint32_t> &reply) {
+  reply.assign(1, 0);
+  size_t pos = 0;
+
+  auto take_u32 = [&](uint32_t &out) {
+    if (pos + 4 > len)
+      return false;
+    memcpy(&out, payload + pos, 4);
+    pos += 4;
+    return true;
+  };
+
+  while (pos < len) {
+    uint8_t op = payload[pos++];
+    uint32_t addr = 0;
+    uint32_t data = 0;
+
+    switch (op) {
+    case CMD_STEP:
+      if (!take_u32(data))
+        return false;
+      soc.step(data);
+      break;
+
+    case CMD_WRITE:
+      if (!take_u32(addr) || !take_u32(data))
+        return false;
+      soc.write(addr, data);
+      break;
+
+    case CMD_READ:
+      if (!take_u32(addr))
+        return false;
+      reply.push_back(soc.read(addr));
+      break;
+
+    case CMD_READ_BURST: {
+      if (!take_u32(addr) || !take_u32(data) || data > MAX_BURST_WORDS)
+        return false;
+      size_t base = reply.size();
+      reply.resize(base + data);
+      soc.read_burst(addr, data, reply.data() + base);
+      break;
+    }
+
+    case CMD_WRITE_BURST: {
+      if (!take_u32(addr) || !take_u32(data) ||
+          (len - pos) / 4 < static_cast<size_t>(data))
+        return false;
+      std::vector<uint32_t> words(data);
+      memcpy(words.data(), payload + pos, data * sizeof(uint32_t));
+      pos += data * sizeof(uint32_t);
+      soc.write_burst(addr, data, words.data());
+      break;
+    }
+
+    default:
+      return false;
+    }
+  }
+
+  reply[0] = static_cast<uint32_t>(reply.size() - 1);
+  return true;
+}
+
+/**
+ * One host command, received in full and waiting to be executed.
+ *
+ * Fixed-size arguments are kept as words in protocol order; variable-size
+ * parts (batch payloads, burst data, snapshot paths) as raw bytes.
+ */
+struct Command {
+  uint8_t op = 0;               /**< Opcode */
+  uint32_t args[5] = {};        /**< Fixed-size argument words */
+  std::vector<uint8_t> payload; /**< Variable-size part */
+  uint64_t arrival_ns = 0;      /**< When the opcode was received */
+};
+
+/**
+ * Receives one complete command from the channel.
+ *
+ * Unknown opcodes carry no arguments and are received as such, so the
+ * executor can ignore them like the original loop did.
+ *
+ * @param chan Connected transport
+ * @param cmd Output command (its payload buffer is reused)
+ * @return false if the peer disconnected or sent a malformed frame.
+ */
+static bool recv_command(Channel &chan, Command &cmd) {
+  if (!chan.recv_exact(&cmd.op, 1))
+    return false;
+  cmd.arrival_ns = stats_now_ns();
+  cmd.payload.clear();
+  uint32_t *a = cmd.args;
+
+  switch (cmd.op) {
+  case CMD_STEP:
+  case CMD_READ:
+  case CMD_STATS:
+  case CMD_LATENCY:
+    return chan.recv_exact(a, 4);
+
+  case CMD_WRITE:
+  case CMD_TRACE:
+  case CMD_RUN:
+    return chan.recv_exact(a, 8);
+
+  case CMD_READ_BURST:
+    return chan.recv_exact(a, 8) && a[1] <= MAX_BURST_WORDS;
+
+  case CMD_WRITE_BURST:
+    if (!chan.recv_exact(a, 8) || a[1] > MAX_BURST_WORDS)
+      return false;
+    cmd.payload.resize(a[1] * sizeof(uint32_t));
+    return chan.recv_exact(cmd.payload.data(), cmd.payload.size());
+
+  case CMD_BATCH:
+    if (!chan.recv_exact(a, 4))
+      return false;
+    if (a[0] > MAX_BATCH_BYTES) {
+      fprintf(stderr, "[HW-SRV] Rejecting batch frame of %u bytes\n", a[0]);
+      return false;
+    }
+    cmd.payload.resize(a[0]);
+    return chan.recv_exact(cmd.payload.data(), a[0]);
+
+  case CMD_STEP_UNTIL:
+  case CMD_SUBSCRIBE:
+    return chan.recv_exact(a, 16);
+
+  case CMD_MEASURE_CORRECT:
+    return chan.recv_exact(a, 20) && a[4] != 0 && a[4] <= MAX_SYNDROME_WORDS;
+
+  case CMD_SAVE:
+  case CMD_RESTORE:
+    if (!chan.recv_exact(a, 8) || a[1] > SNAP_MAX_PATH)
+      return false;
+    cmd.payload.resize(a[1]);
+    return a[1] == 0 || chan.recv_exact(cmd.payload.data(), a[1]);
+
+  default:
+    return true;
+  }
+}
+
+/**
+ * Command executor of one session.
+ *
+ * Owns the per-session protocol state (watches, reply buffers, stats dump
+ * schedule) and executes received commands against the session's SoC,
+ * sending their replies. The same executor serves lock-step sessions,
+ * where commands run as soon as they arrive, and paced sessions, where the
+ * clock thread runs them at cycle boundaries.
+ */
+class Session {
+public:
   /**
-   * Setup TCP server socket for host controller communication.
+   * Binds the executor to a session.
    *
-   * Creates a TCP socket, binds to port 8000, and listens for incoming
-   * connections. The server accepts a single connection and processes
-   * commands until the connection is closed.
+   * @param soc Simulation instance to drive
+   * @param chan Connected transport receiving the replies
+   * @param opts Server options (stats interval)
+   * @param id Session id used in the stats dump
+   * @param interrupted Whether a further command is waiting; ends CMD_RUN
    */
-  int server_fd, new_socket;
+  Session(SoC &soc, Channel &chan, const SimOptions &opts, uint32_t id,
+          std::function<bool()> interrupted)
+      : soc(soc), chan(chan), id(id), interrupted(std::move(interrupted)),
+        interval_ns(static_cast<uint64_t>(opts.stats_interval_ms) * 1000000),
+        last_dump(stats_now_ns()) {}
+
+  /**
+   * Executes one command and sends its reply.
+   *
+   * Every command is accounted in the SoC's counters with the host wall
+   * time from its opcode arriving to its reply being sent and the
+   * simulated cycles it consumed. With a stats interval configured, the
+   * counters are dumped after the first command that completes once the
+   * interval has elapsed.
+   *
+   * @param cmd Command to execute
+   * @return false if the session is over (CMD_EXIT, malformed batch or a
+   *         failed event push), true otherwise.
+   */
+  bool execute(const Command &cmd) {
+    const uint32_t *a = cmd.args;
+    uint64_t cmd_cycles = soc.cycles;
+    bool restart_stats = false;
+    bool running = true;
+    uint32_t response = 0;
+    uint32_t len = 0;
+    uint32_t pair[2] = {0, 0};
+
+    switch (cmd.op) {
+    case CMD_STEP:
+      soc.step(a[0]);
+      chan.send_all(&response, 4);
+      break;
+
+    case CMD_WRITE:
+      soc.write(a[0], a[1]);
+      chan.send_all(&response, 4);
+      break;
+
+    case CMD_READ:
+      response = soc.read(a[0]);
+      chan.send_all(&response, 4);
+      break;
+
+    case CMD_READ_BURST:
+      burst.resize(a[1]);
+      soc.read_burst(a[0], a[1], burst.data());
+      chan.send_all(burst.data(), a[1] * sizeof(uint32_t));
+      break;
+
+    case CMD_WRITE_BURST:
+      burst.resize(a[1]);
+      memcpy(burst.data(), cmd.payload.data(), cmd.payload.size());
+      soc.write_burst(a[0], a[1], burst.data());
+      chan.send_all(&response, 4);
+      break;
+
+    case CMD_BATCH:
+      if (!run_batch(soc, cmd.payload.data(), cmd.payload.size(),
+                     batch_reply)) {
+        fprintf(stderr, "[HW-SRV] Malformed batch frame\n");
+        running = false;
+        break;
+      }
+      chan.send_all(batch_reply.data(), batch_reply.size() * sizeof(uint32_t));
+      break;
+
+    case CMD_STEP_UNTIL:
+      pair[0] = soc.step_until(a[0], a[1], a[2], a[3], pair[1]);
+      chan.send_all(pair, 8);
+      break;
+
+    case CMD_MEASURE_CORRECT:
+      syndrome.resize(a[4]);
+      mc_reply.resize(a[4] + 1);
+      mc_reply[0] = soc.measure_correct(a[0], a[1], a[2], a[3], syndrome);
+      std::copy(syndrome.begin(), syndrome.end(), mc_reply.begin() + 1);
+      chan.send_all(mc_reply.data(), mc_reply.size() * sizeof(uint32_t));
+      break;
+
+    case CMD_STATS:
+      soc.stats.serialize(soc.cycles, soc.skipped, stats_words);
+      len = STATS_WORDS;
+      stats_reply.resize(4 + STATS_WORDS * sizeof(uint64_t));
+      memcpy(stats_reply.data(), &len, 4);
+      memcpy(stats_reply.data() + 4, stats_words.data(),
+             STATS_WORDS * sizeof(uint64_t));
+      chan.send_all(stats_reply.data(), stats_reply.size());
+      restart_stats = (a[0] & STATS_FLAG_RESET) != 0;
+      break;
+
+    case CMD_LATENCY:
+      soc.stats.latency_report(latency_text);
+      len = static_cast<uint32_t>(latency_text.size());
+      stats_reply.resize(4 + latency_text.size());
+      memcpy(stats_reply.data(), &len, 4);
+      memcpy(stats_reply.data() + 4, latency_text.data(), latency_text.size());
+      chan.send_all(stats_reply.data(), stats_reply.size());
+      restart_stats = (a[0] & STATS_FLAG_RESET) != 0;
+      break;
+
+    case CMD_TRACE:
+      response = soc.trace.control(a[0], a[1], soc.cycles);
+      chan.send_all(&response, 4);
+      break;
+
+    case CMD_SAVE:
+    case CMD_RESTORE: {
+      std::string path(cmd.payload.begin(), cmd.payload.end());
+      response = run_snapshot(soc, cmd.op == CMD_SAVE, a[0], path, id);
+      if (cmd.op == CMD_RESTORE)
+        cmd_cycles = soc.cycles;
+      uint8_t snap_reply[12];
+      memcpy(snap_reply, &response, 4);
+      memcpy(snap_reply + 4, &soc.cycles, 8);
+      chan.send_all(snap_reply, sizeof(snap_reply));
+      break;
+    }
+
+    case CMD_SUBSCRIBE:
+      response = 1;
+      if (a[0] < MAX_WATCHES && a[3] <= WATCH_SET) {
+        Watch &w = watches[a[0]];
+        w.mode = a[3];
+        w.addr = a[1];
+        w.mask = a[2];
+        w.last = w.mode == WATCH_CHANGE ? soc.read(w.addr) : 0;
+        response = 0;
+      }
+      chan.send_all(&response, 4);
+      break;
+
+    case CMD_RUN:
+      running = free_run(soc, chan, watches, a[0], a[1], interrupted);
+      break;
+
+    case CMD_HALT: {
+      EventFrame end_frame = {EVENT_END, RUN_END_HALTED, soc.cycles, 0};
+      chan.send_all(&end_frame, sizeof(end_frame));
+      break;
+    }
+
+    case CMD_EXIT:
+      running = false;
+      break;
+    }
+
+    uint64_t now = stats_now_ns();
+    soc.stats.record_command(cmd.op, now - cmd.arrival_ns,
+                             soc.cycles - cmd_cycles);
+    if (restart_stats)
+      soc.stats.reset(soc.cycles, soc.skipped);
+    if (interval_ns != 0 && now - last_dump >= interval_ns) {
+      dump_stats(id, soc);
+      last_dump = now;
+    }
+    return running;
+  }
+
+private:
+  SoC &soc;                           /**< Simulation instance */
+  Channel &chan;                      /**< Reply transport */
+  uint32_t id;                        /**< Session id */
+  std::function<bool()> interrupted;  /**< Pending-command test for CMD_RUN */
+  uint64_t interval_ns;               /**< Stats dump interval (0 = off) */
+  uint64_t last_dump;                 /**< Time of the last stats dump */
+  Watch watches[MAX_WATCHES];         /**< Register watches */
+  std::vector<uint32_t> batch_reply;  /**< CMD_BATCH reply */
+  std::vector<uint32_t> syndrome;     /**< CMD_MEASURE_CORRECT syndrome */
+  std::vector<uint32_t> mc_reply;     /**< CMD_MEASURE_CORRECT reply */
+  std::vector<uint32_t> burst;        /**< Burst staging buffer */
+  std::vector<uint64_t> stats_words;  /**< Serialized counters */
+  std::vector<uint8_t> stats_reply;   /**< CMD_STATS/CMD_LATENCY reply */
+  std::string latency_text;           /**< CMD_LATENCY export lines */
+};
+
+/**
+ * Runs a lock-step session over an established channel.
+ *
+ * Receives and executes one command at a time, so the simulation only
+ * advances while a command runs. Returns when the peer disconnects, a
+ * malformed frame arrives, or an exit command is received.
+ *
+ * @param soc Simulation instance to drive
+ * @param chan Connected transport
+ * @param opts Server options (stats interval)
+ * @param id Session id used in the stats dump
+ */
+static void serve(SoC &soc, Channel &chan, const SimOptions &opts,
+                  uint32_t id) {
+  Session session(soc, chan, opts, id, [&chan] { return chan.readable(); });
+  Command cmd;
+  while (recv_command(chan, cmd) && session.execute(cmd)) {
+  }
+}
+
+/**
+ * Runs a paced session over an established channel.
+ *
+ * A clock thread owns the SoC and ticks it continuously at the configured
+ * rate, whether or not the host is keeping up; the calling thread only
+ * receives commands and queues them. At every cycle boundary the clock
+ * thread takes whatever has arrived, records the backlog and the time each
+ * command waited, and executes the commands in order. Commands that span
+ * cycles (STEP, STEP_UNTIL, RUN, ...) are paced as well, so they complete
+ * in real time. Returns when the peer disconnects or sends CMD_EXIT, or
+ * when a command ends the session (a malformed frame, a failed reply): the
+ * clock thread then shuts the channel down, so the receiving thread stops
+ * queueing and the connection closes as it would unpaced.
+ *
+ * @param soc Simulation instance to drive (pacer configured)
+ * @param chan Connected transport
+ * @param opts Server options (stats interval)
+ * @param id Session id used in the stats dump
+ */
+static void serve_paced(SoC &soc, Channel &chan, const SimOptions &opts,
+                        uint32_t id) {
+  MpscQueue<Command> queue;
+  Session session(soc, chan, opts, id, [&queue] { return queue.pending(); });
+  std::atomic<bool> ended{false};
+
+  std::thread clock([&soc, &chan, &queue, &session, &ended] {
+    std::vector<Command> ready;
+    soc.pace.start(soc.cycles);
+    while (true) {
+      if (!queue.pending()) {
+        soc.step(1);
+        continue;
+      }
+      soc.stats.record_backlog(queue.drain(ready));
+      for (const Command &cmd : ready) {
+        soc.stats.record_queue_wait(stats_now_ns() - cmd.arrival_ns);
+        if (!session.execute(cmd)) {
+          ended.store(true, std::memory_order_release);
+          chan.shutdown();
+          return;
+        }
+      }
+      ready.clear();
+    }
+  });
+
+  while (!ended.load(std::memory_order_acquire)) {
+    Command cmd;
+    if (!recv_command(chan, cmd))
+      cmd.op = CMD_EXIT;
+    bool last = cmd.op == CMD_EXIT;
+    queue.push(std::move(cmd));
+    if (last)
+      break;
+  }
+  clock.join();
+}
+
+/**
+ * Number of sessions started so far, used for session ids and seeds.
+ */
+static std::atomic<uint32_t> session_count{0};
+
+/**
+ * Number of sessions currently being served.
+ */
+static std::atomic<uint32_t> active_sessions{0};
+
+/**
+ * Runs one complete session on the calling thread.
+ *
+ * Builds a fresh SoC for the session, so every host controller gets its
+ * own reset state, clock counter and noise seed (seed_base + session id),
+ * and serves commands until the peer disconnects or sends CMD_EXIT.
+ *
+ * @param opts Server options
+ * @param chan Connected transport for this session
+ */
+static void run_session(const SimOptions &opts, Channel &chan) {
+  uint32_t id = session_count.fetch_add(1);
+  uint32_t seed = opts.seed_base + id;
+  active_sessions.fetch_add(1);
+  printf("[HW-SRV] Session %u connected (seed 0x%08x, %u active).\n", id,
+         seed, active_sessions.load());
+  fflush(stdout);
+
+  SoC soc(opts, seed, id);
+  if (soc.pace.enabled())
+    serve_paced(soc, chan, opts, id);
+  else
+    serve(soc, chan, opts, id);
+  if (opts.stats_interval_ms != 0)
+    dump_stats(id, soc);
+
+  active_sessions.fetch_sub(1);
+  printf("[HW-SRV] Session %u closed (%llu cycles, %llu fast-forwarded).\n", id,
+         static_cast<unsigned long long>(soc.cycles),
+         static_cast<unsigned long long>(soc.skipped));
+  fflush(stdout);
+}
+
+/**
+ * Writes the bound port number to a file for launch scripts.
+ *
+ * The number is written to a temporary file named after the process, which
+ * is then renamed into place, so a script polling for the file never reads
+ * a partial value even if several servers share the path.
+ *
+ * @param path Destination file
+ * @param port Port the listener is bound to
+ */
+static void write_port_file(const std::string &path, uint16_t port) {
+  std::string tmp = path + ".tmp." + std::to_string(getpid());
+  FILE *f = fopen(tmp.c_str(), "w");
+  if (!f) {
+    perror("port file");
+    exit(EXIT_FAILURE);
+  }
+  fprintf(f, "%u\n", port);
+  fclose(f);
+  if (rename(tmp.c_str(), path.c_str()) < 0) {
+    perror("port file");
+    exit(EXIT_FAILURE);
+  }
+}
+
+/**
+ * Creates a listening TCP socket on the configured address and port.
+ *
+ * With port 0 the kernel picks a free port; the port that was actually
+ * bound is printed and, if requested, written to the port file.
+ *
+ * @param opts Server options
+ * @return Listening socket descriptor (exits on failure).
+ */
+static int open_tcp_listener(const SimOptions &opts) {
+  int server_fd;
   struct sockaddr_in address;
+  socklen_t addrlen = sizeof(address);
   int opt = 1;
-  int addrlen = sizeof(address);
 
-  if ((server_fd = socket(AF_INET, SOCK_STREAM, 0)) == 0) {
+  if ((server_fd = socket(AF_INET, SOCK_STREAM, 0)) < 0) {
     perror("socket failed");
     exit(EXIT_FAILURE);
   }
 
-  if (setsockopt(server_fd, SOL_SOCKET, SO_REUSEADDR | SO_REUSEPORT, &opt,
-                 sizeof(opt))) {
+  if (setsockopt(server_fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt))) {
     perror("setsockopt");
     exit(EXIT_FAILURE);
   }
 
+  memset(&address, 0, sizeof(address));
   address.sin_family = AF_INET;
-  address.sin_addr.s_addr = INADDR_ANY;
-  address.sin_port = htons(8000);
+  address.sin_port = htons(opts.port);
+  if (inet_pton(AF_INET, opts.bind_addr.c_str(), &address.sin_addr) != 1) {
+    fprintf(stderr, "[HW-SRV] Invalid bind address %s\n",
+            opts.bind_addr.c_str());
+    exit(EXIT_FAILURE);
+  }
 
   if (bind(server_fd, (struct sockaddr *)&address, sizeof(address)) < 0) {
     perror("bind failed");
     exit(EXIT_FAILURE);
   }
 
-  if (listen(server_fd, 3) < 0) {
+  if (listen(server_fd, SOMAXCONN) < 0) {
     perror("listen");
     exit(EXIT_FAILURE);
   }
 
-  printf("[HW-SRV] Physics Engine listening on port 8000...\n");
-  printf("[HW-SRV] Waiting for Rust Host Controller...\n");
+  getsockname(server_fd, (struct sockaddr *)&address, &addrlen);
+  uint16_t port = ntohs(address.sin_port);
+  printf("[HW-SRV] Physics Engine listening on %s:%u...\n",
+         opts.bind_addr.c_str(), port);
+  if (!opts.port_file.empty())
+    write_port_file(opts.port_file, port);
+
+  return server_fd;
+}
 
-  if ((new_socket = accept(server_fd, (struct sockaddr *)&address,
-                           (socklen_t *)&addrlen)) < 0) {
-    perror("accept");
+/**
+ * Removes a Unix domain socket file.
+ *
+ * Only sockets are removed, so a mistyped path cannot delete a regular
+ * file or directory.
+ *
+ * @param path Socket path
+ * @return false if something other than a socket exists at the path.
+ */
+static bool unlink_socket_file(const std::string &path) {
+  struct stat st;
+  if (lstat(path.c_str(), &st) < 0)
+    return true;
+  if (!S_ISSOCK(st.st_mode))
+    return false;
+  unlink(path.c_str());
+  return true;
+}
+
+/**
+ * Creates a listening Unix domain socket at the configured path.
+ *
+ * A stale socket file left behind by an earlier run is removed first;
+ * any other kind of file at the path is left alone and rejected.
+ * Co-located host controllers connecting here bypass the TCP stack.
+ *
+ * @param opts Server options
+ * @return Listening socket descriptor (exits on failure).
+ */
+static int open_unix_listener(const SimOptions &opts) {
+  struct sockaddr_un address;
+  if (opts.unix_path.size() >= sizeof(address.sun_path)) {
+    fprintf(stderr, "[HW-SRV] Unix socket path too long: %s\n",
+            opts.unix_path.c_str());
     exit(EXIT_FAILURE);
   }
 
-  printf("[HW-SRV] Controller Connected! Starting Simulation Loop.\n");
+  int server_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (server_fd < 0) {
+    perror("socket failed");
+    exit(EXIT_FAILURE);
+  }
 
-  /**
-   * Command processing loop.
-   *
-   * Continuously reads commands from the TCP connection and executes
-   * corresponding operations: step simulation, read/write registers, or
-   * exit. Each command consists of a 1-byte opcode followed by optional
-   * address and data fields.
-   */
-  uint8_t buffer[1024];
-  bool running = true;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  strcpy(address.sun_path, opts.unix_path.c_str());
+  if (!unlink_socket_file(opts.unix_path)) {
+    fprintf(stderr, "[HW-SRV] %s exists and is not a socket\n",
+            opts.unix_path.c_str());
+    exit(EXIT_FAILURE);
+  }
+
+  if (bind(server_fd, (struct sockaddr *)&address, sizeof(address)) < 0) {
+    perror("bind failed");
+    exit(EXIT_FAILURE);
+  }
+
+  if (listen(server_fd, SOMAXCONN) < 0) {
+    perror("listen");
+    exit(EXIT_FAILURE);
+  }
 
-  while (running) {
-    int valread = read(new_socket, buffer, 1);
-    if (valread <= 0)
+  printf("[HW-SRV] Physics Engine listening on unix:%s...\n",
+         opts.unix_path.c_str());
+  return server_fd;
+}
+
+/**
+ * Serves any number of host controllers over a stream socket.
+ *
+ * Listens on TCP (the configured address and port) or, when a Unix socket
+ * path is set, on that path instead. Every accepted connection is handed to
+ * a detached worker thread that owns an independent SoC instance, so
+ * concurrent experiments scale across cores without launching extra
+ * processes. TCP connections have Nagle's algorithm disabled so short
+ * replies are not delayed. Runs until the process is terminated.
+ *
+ * @param opts Server options
+ */
+static void serve_sockets(const SimOptions &opts) {
+  bool is_unix = !opts.unix_path.empty();
+  int server_fd = is_unix ? open_unix_listener(opts) : open_tcp_listener(opts);
+
+  printf("[HW-SRV] Waiting for Rust Host Controllers...\n");
+  fflush(stdout);
+
+  while (true) {
+    int new_socket = accept(server_fd, nullptr, nullptr);
+    if (new_socket < 0) {
+      if (errno == EINTR)
+        continue;
+      perror("accept");
       break;
+    }
 
-    uint8_t cmd = buffer[0];
-    uint32_t addr = 0;
-    uint32_t data = 0;
-    uint32_t response = 0;
+    if (!is_unix) {
+      int one = 1;
+      setsockopt(new_socket, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
 
-    switch (cmd) {
-    case CMD_STEP:
-      read(new_socket, &data, 4);
-      for (uint32_t i = 0; i < data; i++)
-        soc.tick();
-      send(new_socket, &response, 4, 0);
+    std::thread([&opts, new_socket] {
+      SocketChannel chan(new_socket);
+      run_session(opts, chan);
+    }).detach();
+  }
+
+  close(server_fd);
+  if (is_unix)
+    unlink_socket_file(opts.unix_path);
+}
+
+/**
+ * Serves a single host controller over a shared-memory ring pair.
+ *
+ * Creates the region /dev/shm/<name>, waits for a host to attach, and then
+ * runs one session over it with the same command loop as the TCP
+ * transport. The region is unlinked when the session ends.
+ *
+ * @param opts Server options
+ * @param name Region name (host connects with "shm://<name>")
+ */
+static void serve_shm(const SimOptions &opts, const std::string &name) {
+  auto chan = ShmChannel::create(name);
+  if (!chan)
+    exit(EXIT_FAILURE);
+
+  printf("[HW-SRV] Physics Engine listening on shm://%s...\n", name.c_str());
+  printf("[HW-SRV] Waiting for Rust Host Controller...\n");
+  fflush(stdout);
+
+  chan->wait_for_client();
+  run_session(opts, *chan);
+}
+
+/**
+ * Replays a transaction log into a fresh SoC and reports its throughput.
+ *
+ * Rebuilds the recorded session's SoC from the seed and plusargs in the log
+ * header and applies every record in order, checking each record's cycle
+ * stamp and every value read against the log; the replay stops at the
+ * first divergence. No transport is involved, so the summary doubles as an
+ * offline benchmark of the simulator core, and the session's counters are
+ * dumped at the end as if it had just closed. With a shot file, every
+ * burst read of the error bank is also written to it as one .b8 shot of
+ * the grid size the session read.
+ *
+ * @param opts Server options (fast-forward, model threads, trace directory)
+ * @param path Log written by a recorded session
+ * @param shots_path Shot file to export the syndromes to, or empty
+ * @return Exit status: 0 if the replay matched the log, 1 otherwise.
+ */
+static int run_replay(const SimOptions &opts, const std::string &path,
+                      const std::string &shots_path) {
+  ReplayReader reader;
+  if (!reader.open(path)) {
+    fprintf(stderr, "[HW-REPLAY] %s is not a readable transaction log\n",
+            path.c_str());
+    return EXIT_FAILURE;
+  }
+
+  SimOptions replay_opts = opts;
+  replay_opts.record_dir.clear();
+  replay_opts.pace_cycles = 0;
+  std::vector<char *> args = {opts.argv[0]};
+  for (std::string &arg : reader.plusargs)
+    args.push_back(&arg[0]);
+  replay_opts.argc = static_cast<int>(args.size());
+  replay_opts.argv = args.data();
+  SoC soc(replay_opts, reader.seed, 0);
+
+  ReplayRecord rec;
+  std::vector<uint32_t> burst;
+  ShotWriter shots;
+  uint32_t grid_dim = 0;
+  uint64_t records = 0;
+  char diverged[160] = "";
+  if (soc.cycles != reader.start_cycle)
+    snprintf(diverged, sizeof(diverged), "log starts at cycle %llu",
+             static_cast<unsigned long long>(reader.start_cycle));
+
+  uint64_t start = stats_now_ns();
+  int more = 1;
+  while (!diverged[0] && (more = reader.next(rec, soc.cycles)) > 0) {
+    if (rec.cycle != soc.cycles) {
+      snprintf(diverged, sizeof(diverged), "record stamped cycle %llu",
+               static_cast<unsigned long long>(rec.cycle));
+      break;
+    }
+    switch (rec.tag) {
+    case RLOG_STEP:
+      while (rec.cycles > 0) {
+        uint32_t n =
+            static_cast<uint32_t>(std::min<uint64_t>(rec.cycles, UINT32_MAX));
+        soc.step(n);
+        rec.cycles -= n;
+      }
       break;
 
-    case CMD_WRITE:
-      read(new_socket, &addr, 4);
-      read(new_socket, &data, 4);
-      soc.write(addr, data);
-      send(new_socket, &response, 4, 0);
+    case RLOG_WRITE:
+      soc.write(rec.addr, rec.value);
       break;
 
-    case CMD_READ:
-      read(new_socket, &addr, 4);
-      response = soc.read(addr);
-      send(new_socket, &response, 4, 0);
+    case RLOG_READ: {
+      uint32_t value = soc.read(rec.addr);
+      if (value != rec.value)
+        snprintf(diverged, sizeof(diverged),
+                 "read of 0x%08x returned 0x%08x, log has 0x%08x", rec.addr,
+                 value, rec.value);
+      if (rec.addr == RLOG_ADDR_GRID_DIM)
+        grid_dim = value;
       break;
+    }
 
-    case CMD_EXIT:
-      running = false;
+    case RLOG_READ_BURST: {
+      uint32_t count = static_cast<uint32_t>(rec.words.size());
+      burst.resize(count);
+      soc.read_burst(rec.addr, count, burst.data());
+      for (uint32_t i = 0; i < count && !diverged[0]; i++)
+        if (burst[i] != rec.words[i])
+          snprintf(diverged, sizeof(diverged),
+                   "burst read of 0x%08x word %u returned 0x%08x, "
+                   "log has 0x%08x",
+                   rec.addr, i, burst[i], rec.words[i]);
+      if (diverged[0] || rec.addr != RLOG_ADDR_ERRORS || shots_path.empty())
+        break;
+      // Without a recorded grid size every word read counts as 32 qubits.
+      if (!shots.is_open() &&
+          !shots.open(shots_path,
+                      grid_dim != 0 ? grid_dim * grid_dim : 32 * count)) {
+        fprintf(stderr, "[HW-REPLAY] Cannot create %s\n", shots_path.c_str());
+        return EXIT_FAILURE;
+      }
+      shots.append(burst.data(), count);
       break;
     }
+
+    case RLOG_WRITE_BURST:
+      soc.write_burst(rec.addr, static_cast<uint32_t>(rec.words.size()),
+                      rec.words.data());
+      break;
+
+    case RLOG_RESTORE:
+      if (soc.restore(rec.image) != SNAP_OK)
+        snprintf(diverged, sizeof(diverged),
+                 "snapshot restore needs a --savable model");
+      break;
+    }
+    records++;
   }
+  uint64_t elapsed = stats_now_ns() - start;
+
+  if (more < 0)
+    fprintf(stderr, "[HW-REPLAY] Log truncated after %llu records\n",
+            static_cast<unsigned long long>(records));
+  if (diverged[0])
+    printf("[HW-REPLAY] Diverged at record %llu (cycle %llu): %s\n",
+           static_cast<unsigned long long>(records),
+           static_cast<unsigned long long>(soc.cycles), diverged);
+
+  uint64_t cycles = soc.cycles - reader.start_cycle;
+  printf("[HW-REPLAY] %s: %llu records, %llu cycles (%llu fast-forwarded) "
+         "in %.3f s, %.2f Mcycles/s\n",
+         path.c_str(), static_cast<unsigned long long>(records),
+         static_cast<unsigned long long>(cycles),
+         static_cast<unsigned long long>(soc.skipped),
+         static_cast<double>(elapsed) / 1e9,
+         static_cast<double>(cycles) * 1e3 / static_cast<double>(elapsed + 1));
+  if (shots.is_open())
+    printf("[HW-REPLAY] Wrote %llu syndromes of %u qubits to %s\n",
+           static_cast<unsigned long long>(shots.shots), shots.bits,
+           shots_path.c_str());
+  dump_stats(0, soc);
+  return diverged[0] ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+/**
+ * @defgroup BenchRegs Registers Used by the Core Benchmark
+ * @{
+ */
+#define BENCH_ADDR_ENABLE 0x40000000u   /**< Physics engine enable */
+#define BENCH_ADDR_RABI 0x40000003u     /**< Rabi frequency (harmless write) */
+#define BENCH_ADDR_GRID_DIM 0x40000004u /**< Grid side length (read-only) */
+#define BENCH_RABI 468u                 /**< Rabi value the host demo uses */
+/** @} */
+
+/**
+ * Prints one core benchmark result as a JSON object on its own line.
+ *
+ * @param soc Benchmarked instance (grid size and model threads)
+ * @param op Operation name
+ * @param unit What count counts ("cycles" or "ops")
+ * @param count Cycles or operations performed
+ * @param ns Wall time they took
+ */
+static void print_bench(SoC &soc, const char *op, const char *unit,
+                        uint64_t count, uint64_t ns) {
+  printf("{\"bench\":\"core\",\"op\":\"%s\",\"grid_dim\":%u,"
+         "\"threads\":%u,\"count\":%llu,\"unit\":\"%s\",\"ns\":%llu,"
+         "\"rate\":%.1f,\"ns_per_op\":%.2f}\n",
+         op, soc.read(BENCH_ADDR_GRID_DIM), soc.ctx->threads(),
+         static_cast<unsigned long long>(count), unit,
+         static_cast<unsigned long long>(ns),
+         static_cast<double>(count) * 1e9 / static_cast<double>(ns + 1),
+         static_cast<double>(ns) /
+             static_cast<double>(std::max<uint64_t>(count, 1)));
+  fflush(stdout);
+}
+
+/**
+ * Measures the simulator core without any transport.
+ *
+ * Drives one SoC through SoC::step(), SoC::read() and SoC::write() in
+ * place and prints the rate of each as a JSON line: clock cycles of the
+ * idle and the running design (fast-forwarding disabled, so every cycle is
+ * evaluated), then single-cycle bus reads and writes with the physics
+ * engine running. scripts/benchmark_sim.py combines these lines with the
+ * transport figures of `qcu_host sim-bench` across grid sizes, model
+ * thread counts and build profiles.
+ *
+ * @param opts Server options (model threads, plusargs)
+ * @param count Cycles or transactions per measurement
+ * @return Exit status (0 on success)
+ */
+static int run_bench(const SimOptions &opts, uint64_t count) {
+  SimOptions bench_opts = opts;
+  bench_opts.fast_forward = false;
+  bench_opts.record_dir.clear();
+  bench_opts.pace_cycles = 0;
+  SoC soc(bench_opts, opts.seed_base, 0);
+  uint32_t n = static_cast<uint32_t>(std::min<uint64_t>(count, UINT32_MAX));
+
+  uint64_t start = stats_now_ns();
+  soc.step(n);
+  print_bench(soc, "tick_idle", "cycles", n, stats_now_ns() - start);
+
+  soc.write(BENCH_ADDR_RABI, BENCH_RABI);
+  soc.write(BENCH_ADDR_ENABLE, 1);
+  start = stats_now_ns();
+  soc.step(n);
+  print_bench(soc, "tick_active", "cycles", n, stats_now_ns() - start);
+
+  uint32_t sink = 0;
+  start = stats_now_ns();
+  for (uint32_t i = 0; i < n; i++)
+    sink += soc.read(BENCH_ADDR_GRID_DIM);
+  print_bench(soc, "read", "ops", n, stats_now_ns() - start);
+
+  start = stats_now_ns();
+  for (uint32_t i = 0; i < n; i++)
+    soc.write(BENCH_ADDR_RABI, BENCH_RABI);
+  print_bench(soc, "write", "ops", n, stats_now_ns() - start);
+  return sink == 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+/**
+ * Main entry point for Verilator simulation server.
+ *
+ * Serves host controllers over the selected transport, with one independent
+ * SoC and worker thread per connection: TCP on `--bind <addr>` (default
+ * 0.0.0.0) and `--port <n>` (default 8000, 0 for an ephemeral port whose
+ * number is written to `--port-file <path>`), or a Unix domain socket with
+ * `--unix <path>`. `--shm <name>` instead serves a single session over a
+ * shared-memory ring pair. `--seed <n>` sets the noise seed of the first
+ * session; later sessions use consecutive seeds. `--no-fast-forward` makes
+ * every idle cycle evaluate the model, for comparing against fast-forwarded
+ * runs. Each SoC's model runs on the QCU_SIM_THREADS threads it was
+ * verilated with (the `mt-sim` feature, or QCU_SIM_THREADS at build time);
+ * with several concurrent sessions, build it so that sessions x threads
+ * stays within the core count. `--sim-threads <n>` states the thread count
+ * a caller expects and refuses to start if the model was built otherwise.
+ * `--profile-eval` times every model evaluation for the eval wall-time
+ * counter, and `--stats-interval <ms>` prints each session's counters at
+ * that interval while it is busy and once more when it closes.
+ * `--trace-dir <dir>` chooses where waveform captures armed with CMD_TRACE
+ * are written (default: the working directory; a tmpfs keeps the rolling
+ * pre-trigger window in memory). `--pace <cycles>:<us>` turns every session
+ * into a paced one whose clock runs freely at that many cycles per that
+ * many microseconds, and `--deadline <cycles>` counts syndromes left
+ * unanswered for longer than that as deadline misses. `--record <dir>`
+ * logs every bus transaction of each session to `<dir>/qcu_s<id>.qlog`;
+ * `--replay <log>` replays such a log offline instead of serving, checks
+ * it reproduces every recorded read and prints the simulation throughput;
+ * with `--shots <file>` it also writes every syndrome readout of the
+ * session to a .b8 shot file for the host's decoder benchmarks.
+ * `--bench <n>` instead measures n cycles and n transactions of the core
+ * directly and prints the rates as JSON lines.
+ *
+ * @param argc Command-line argument count
+ * @param argv Command-line argument vector (plusargs are passed to Verilator)
+ * @return Exit status code (0 on success)
+ */
+int main(int argc, char **argv) {
+  SimOptions opts;
+  opts.argc = argc;
+  opts.argv = argv;
+
+  std::string shm_name;
+  std::string replay_path;
+  std::string shots_path;
+  uint64_t bench_count = 0;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--shm") == 0 && i + 1 < argc)
+      shm_name = argv[++i];
+    else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+      opts.seed_base = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 0));
+    else if (strcmp(argv[i], "--bind") == 0 && i + 1 < argc)
+      opts.bind_addr = argv[++i];
+    else if (strcmp(argv[i], "--port") == 0 && i + 1 < argc)
+      opts.port = static_cast<uint16_t>(strtoul(argv[++i], nullptr, 0));
+    else if (strcmp(argv[i], "--port-file") == 0 && i + 1 < argc)
+      opts.port_file = argv[++i];
+    else if (strcmp(argv[i], "--unix") == 0 && i + 1 < argc)
+      opts.unix_path = argv[++i];
+    else if (strcmp(argv[i], "--no-fast-forward") == 0)
+      opts.fast_forward = false;
+    else if (strcmp(argv[i], "--sim-threads") == 0 && i + 1 < argc)
+      opts.threads = static_cast<unsigned>(strtoul(argv[++i], nullptr, 0));
+    else if (strcmp(argv[i], "--profile-eval") == 0)
+      opts.profile_eval = true;
+    else if (strcmp(argv[i], "--trace-dir") == 0 && i + 1 < argc)
+      opts.trace_dir = argv[++i];
+    else if (strcmp(argv[i], "--stats-interval") == 0 && i + 1 < argc)
+      opts.stats_interval_ms =
+          static_cast<uint32_t>(strtoul(argv[++i], nullptr, 0));
+    else if (strcmp(argv[i], "--pace") == 0 && i + 1 < argc) {
+      unsigned long long c = 0, us = 0;
+      if (sscanf(argv[++i], "%llu:%llu", &c, &us) != 2 || c == 0 || us == 0) {
+        fprintf(stderr, "--pace expects <cycles>:<us>\n");
+        return EXIT_FAILURE;
+      }
+      opts.pace_cycles = c;
+      opts.pace_us = us;
+    } else if (strcmp(argv[i], "--deadline") == 0 && i + 1 < argc)
+      opts.deadline_cycles = strtoull(argv[++i], nullptr, 0);
+    else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc)
+      opts.record_dir = argv[++i];
+    else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc)
+      replay_path = argv[++i];
+    else if (strcmp(argv[i], "--shots") == 0 && i + 1 < argc)
+      shots_path = argv[++i];
+    else if (strcmp(argv[i], "--bench") == 0 && i + 1 < argc) {
+      bench_count = strtoull(argv[++i], nullptr, 0);
+      if (bench_count == 0) {
+        fprintf(stderr, "--bench expects a positive count\n");
+        return EXIT_FAILURE;
+      }
+    }
+  }
+
+  if (opts.threads != 0 && opts.threads != QCU_SIM_THREADS) {
+    fprintf(stderr,
+            "[HW-SRV] --sim-threads %u does not match the model, which was "
+            "verilated with %u thread(s); rebuild with QCU_SIM_THREADS=%u\n",
+            opts.threads, static_cast<unsigned>(QCU_SIM_THREADS), opts.threads);
+    return EXIT_FAILURE;
+  }
+
+  if (bench_count != 0)
+    return run_bench(opts, bench_count);
+  if (!replay_path.empty())
+    return run_replay(opts, replay_path, shots_path);
+  if (shm_name.empty())
+    serve_sockets(opts);
+  else
+    serve_shm(opts, shm_name);
 
   printf("[HW-SRV] Simulation Closed.\n");
-  close(new_socket);
-  close(server_fd);
   return 0;
 }
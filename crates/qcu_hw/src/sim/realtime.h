@@ -0,0 +1,161 @@
+/**
+ * @file realtime.h
+ * @brief Wall-clock pacing and the command queue of free-running sessions.
+ *
+ * A paced session runs its clock on a dedicated thread at a fixed ratio of
+ * simulated cycles to wall time, like a QPU that does not wait for its
+ * controller. The Pacer holds the clock to that ratio: every few cycles it
+ * compares the cycle counter with the wall clock, sleeps while the model is
+ * ahead and records how far it fell behind otherwise. Host commands reach
+ * the clock thread through an MpscQueue and are applied at the next cycle
+ * boundary, so how long they waited there is the controller's backlog.
+ */
+
+#pragma once
+
+#include "sim_stats.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/** Wall time between two pacing checks (ns). */
+#define PACE_CHECK_NS 50000
+
+/**
+ * Remaining lead below which the pacer spins instead of sleeping (ns).
+ *
+ * Larger than the default timer slack of a Linux thread, so a sleep does
+ * not overshoot the deadline it was meant to reach.
+ */
+#define PACE_SPIN_NS 100000
+
+/**
+ * Keeps a cycle counter in step with the wall clock.
+ *
+ * Disabled until configured; while disabled next_check stays at its
+ * maximum, so the per-cycle test in the harness never triggers.
+ */
+class Pacer {
+public:
+  /** Cycle at which sync() must be called next. */
+  uint64_t next_check = UINT64_MAX;
+
+  /**
+   * Sets the target rate.
+   *
+   * @param cycles Simulated cycles per period
+   * @param ns Wall-clock period in nanoseconds
+   */
+  void configure(uint64_t cycles, uint64_t ns) {
+    num_cycles = cycles;
+    period_ns = ns;
+    check_cycles = std::max<uint64_t>(1, cycles * PACE_CHECK_NS / ns);
+    check_ns = check_cycles * ns / cycles;
+  }
+
+  /** Whether a rate has been configured. */
+  bool enabled() const { return num_cycles != 0; }
+
+  /** Target rate in simulated cycles per second (0 when disabled). */
+  uint64_t rate_hz() const {
+    return enabled() ? num_cycles * 1000000000ull / period_ns : 0;
+  }
+
+  /**
+   * Anchors the schedule: the given cycle is due now.
+   *
+   * Called when the clock starts and whenever the cycle counter jumps
+   * (restored snapshots).
+   *
+   * @param cycle Current cycle counter
+   */
+  void start(uint64_t cycle) {
+    if (!enabled())
+      return;
+    base_cycle = cycle;
+    base_ns = stats_now_ns();
+    next_check = cycle + check_cycles;
+  }
+
+  /**
+   * Waits until the cycle is due, or records how late it is.
+   *
+   * A check that finds the simulation more than one check interval behind
+   * schedule counts as late: the model cannot sustain the target rate.
+   *
+   * @param cycle Current cycle counter
+   * @param stats Counters receiving the lag figures
+   */
+  void sync(uint64_t cycle, SimStats &stats) {
+    unsigned __int128 offset =
+        static_cast<unsigned __int128>(cycle - base_cycle) * period_ns;
+    uint64_t target = base_ns + static_cast<uint64_t>(offset / num_cycles);
+    uint64_t now = stats_now_ns();
+    if (now < target) {
+      if (target - now > PACE_SPIN_NS)
+        std::this_thread::sleep_for(
+            std::chrono::nanoseconds(target - now - PACE_SPIN_NS));
+      while (stats_now_ns() < target) {
+      }
+    } else {
+      stats.record_lag(now - target, now - target > check_ns);
+    }
+    next_check = cycle + check_cycles;
+  }
+
+private:
+  uint64_t num_cycles = 0;   /**< Cycles per period (0 = disabled) */
+  uint64_t period_ns = 0;    /**< Period length */
+  uint64_t check_cycles = 0; /**< Cycles between checks */
+  uint64_t check_ns = 0;     /**< Wall time between checks */
+  uint64_t base_cycle = 0;   /**< Cycle anchored at base_ns */
+  uint64_t base_ns = 0;      /**< Wall time of base_cycle */
+};
+
+/**
+ * Multi-producer single-consumer queue.
+ *
+ * Producers append under a lock; the consumer polls pending() with a
+ * single atomic load per cycle and takes every queued item in one drain(),
+ * so the lock is only touched when there is work.
+ *
+ * @tparam T Item type
+ */
+template <typename T> class MpscQueue {
+public:
+  /**
+   * Appends an item (any thread).
+   *
+   * @param item Item to move into the queue
+   */
+  void push(T &&item) {
+    std::lock_guard<std::mutex> lock(mutex);
+    items.push_back(std::move(item));
+    count.store(items.size(), std::memory_order_release);
+  }
+
+  /** Whether items are waiting (consumer thread). */
+  bool pending() const { return count.load(std::memory_order_acquire) != 0; }
+
+  /**
+   * Takes every queued item, oldest first (consumer thread).
+   *
+   * @param out Receives the items; must be empty
+   * @return Number of items taken.
+   */
+  size_t drain(std::vector<T> &out) {
+    std::lock_guard<std::mutex> lock(mutex);
+    out.swap(items);
+    count.store(0, std::memory_order_release);
+    return out.size();
+  }
+
+private:
+  std::mutex mutex;             /**< Guards items */
+  std::vector<T> items;         /**< Queued items */
+  std::atomic<size_t> count{0}; /**< items.size(), readable without lock */
+};
@@ -0,0 +1,507 @@
+/**
+ * @file replay_log.h
+ * @brief Append-only bus transaction log of a session and its replay reader.
+ *
+ * A recorded session writes every bus-level primitive the harness applies
+ * to its SoC (idle steps, register reads and writes, bursts and snapshot
+ * restores) to a compact binary log, each stamped with the SoC cycle it
+ * started on. Because the model is deterministic given its seed and
+ * plusargs, feeding the same primitives to a fresh SoC in the same order
+ * reproduces the session cycle for cycle, however the host's commands were
+ * timed; the recorded read values and cycle stamps let the replay detect
+ * the first point where it diverges.
+ *
+ * A log starts with RLOG_MAGIC, the 32-bit noise seed, the plusargs of the
+ * session (a varint count, then each as a varint length and its bytes) and
+ * the varint cycle counter at which recording began. Records follow back
+ * to back: a tag byte, the cycle stamp as a varint delta from the previous
+ * record's stamp, and the tag's fields. Unless noted, fields are LEB128
+ * varints:
+ *
+ *   RLOG_STEP         cycles (consecutive steps are merged)
+ *   RLOG_WRITE        addr, data
+ *   RLOG_READ         addr, value read
+ *   RLOG_READ_BURST   addr, count, count values read
+ *   RLOG_WRITE_BURST  addr, count, count values written
+ *   RLOG_RESTORE      image length, raw snapshot image; later stamps are
+ *                     relative to the restored cycle counter
+ *
+ * ShotWriter exports the syndromes of a replayed session, i.e. its burst
+ * reads of the error bank, in the Stim .b8 shot format the host's decoder
+ * benchmarks load (`qcu_io::loader`): shots back to back, each padded to
+ * whole bytes, with qubit i at bit i % 8 of byte i / 8.
+ */
+
+#pragma once
+
+#include "snapshot.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+/** Magic at the start of a log file (8 bytes, version in the last). */
+#define RLOG_MAGIC "QCULOG01"
+
+/**
+ * @defgroup ReplayTags Replay Log Record Tags
+ * @{
+ */
+#define RLOG_STEP 1        /**< Idle clock cycles */
+#define RLOG_WRITE 2       /**< Single-word bus write */
+#define RLOG_READ 3        /**< Single-word bus read */
+#define RLOG_READ_BURST 4  /**< Auto-incrementing burst read */
+#define RLOG_WRITE_BURST 5 /**< Auto-incrementing burst write */
+#define RLOG_RESTORE 6     /**< Snapshot image loaded into the SoC */
+/** @} */
+
+/** Bytes buffered by the writer and the reader between file accesses. */
+#define RLOG_BUFFER_BYTES (1 << 16)
+
+/** Upper bound on the length of a recorded plusarg. */
+#define RLOG_MAX_ARG 4096
+
+/**
+ * @defgroup ShotRegs Registers Identifying Syndrome Readouts
+ * @{
+ */
+#define RLOG_ADDR_GRID_DIM 0x40000004u /**< Grid side length (read-only) */
+#define RLOG_ADDR_ERRORS 0x40000040u   /**< Error bank word 0 */
+/** @} */
+
+/**
+ * Writer of one session's transaction log.
+ *
+ * Records are encoded into a memory buffer that is appended to the file
+ * whenever it fills, so recording costs a few stores per bus transaction.
+ * Idle steps are held back and merged while they follow each other
+ * without a gap, which keeps paced sessions (one step per cycle) compact.
+ */
+class ReplayWriter {
+public:
+  ReplayWriter() = default;
+
+  ~ReplayWriter() { close(); }
+
+  ReplayWriter(const ReplayWriter &) = delete;
+  ReplayWriter &operator=(const ReplayWriter &) = delete;
+
+  /**
+   * Creates the log file and writes its header.
+   *
+   * @param path Destination file (truncated)
+   * @param seed Noise seed of the session
+   * @param plusargs Plusargs of the session's Verilator context
+   * @param cycle SoC cycle counter the log starts at
+   * @return false if the file could not be created.
+   */
+  bool open(const std::string &path, uint32_t seed,
+            const std::vector<std::string> &plusargs, uint64_t cycle) {
+    file = fopen(path.c_str(), "wb");
+    if (!file)
+      return false;
+    buf.reserve(RLOG_BUFFER_BYTES + 64);
+    buf.insert(buf.end(), RLOG_MAGIC, RLOG_MAGIC + 8);
+    for (unsigned i = 0; i < 4; i++)
+      buf.push_back(static_cast<uint8_t>(seed >> (8 * i)));
+    put(plusargs.size());
+    for (const std::string &arg : plusargs) {
+      put(arg.size());
+      buf.insert(buf.end(), arg.begin(), arg.end());
+    }
+    put(cycle);
+    last_cycle = cycle;
+    return true;
+  }
+
+  /** Flushes everything recorded so far and closes the file. */
+  void close() {
+    if (!file)
+      return;
+    flush_step();
+    flush();
+    fclose(file);
+    file = nullptr;
+  }
+
+  /**
+   * Records idle clock cycles.
+   *
+   * @param cycle Cycle counter before the step
+   * @param n Cycles stepped
+   */
+  void step(uint64_t cycle, uint64_t n) {
+    if (step_cycles != 0 && cycle == step_start + step_cycles) {
+      step_cycles += n;
+      return;
+    }
+    flush_step();
+    step_start = cycle;
+    step_cycles = n;
+  }
+
+  /**
+   * Records a single-word write.
+   *
+   * @param cycle Cycle counter before the write
+   * @param addr Bus address
+   * @param data Value written
+   */
+  void write(uint64_t cycle, uint32_t addr, uint32_t data) {
+    begin(RLOG_WRITE, cycle);
+    put(addr);
+    put(data);
+    end();
+  }
+
+  /**
+   * Records a single-word read.
+   *
+   * @param cycle Cycle counter before the read
+   * @param addr Bus address
+   * @param value Value returned by the model
+   */
+  void read(uint64_t cycle, uint32_t addr, uint32_t value) {
+    begin(RLOG_READ, cycle);
+    put(addr);
+    put(value);
+    end();
+  }
+
+  /**
+   * Records a burst transfer.
+   *
+   * @param tag RLOG_READ_BURST or RLOG_WRITE_BURST
+   * @param cycle Cycle counter before the burst
+   * @param addr Address of the first word
+   * @param count Number of words
+   * @param words Values read or written
+   */
+  void burst(uint8_t tag, uint64_t cycle, uint32_t addr, uint32_t count,
+             const uint32_t *words) {
+    begin(tag, cycle);
+    put(addr);
+    put(count);
+    for (uint32_t i = 0; i < count; i++)
+      put(words[i]);
+    end();
+  }
+
+  /**
+   * Records a snapshot restore, embedding the image.
+   *
+   * @param cycle Cycle counter before the restore
+   * @param image Image being restored
+   * @param restored Cycle counter after the restore
+   */
+  void restore(uint64_t cycle, const SnapshotImage &image, uint64_t restored) {
+    begin(RLOG_RESTORE, cycle);
+    put(image.size());
+    flush();
+    fwrite(image.data(), 1, image.size(), file);
+    last_cycle = restored;
+  }
+
+private:
+  /**
+   * Appends a varint.
+   *
+   * @param v Value to encode
+   */
+  void put(uint64_t v) {
+    while (v >= 0x80) {
+      buf.push_back(static_cast<uint8_t>(v) | 0x80);
+      v >>= 7;
+    }
+    buf.push_back(static_cast<uint8_t>(v));
+  }
+
+  /**
+   * Starts a record, after any held-back step.
+   *
+   * @param tag Record tag
+   * @param cycle Cycle stamp of the record
+   */
+  void begin(uint8_t tag, uint64_t cycle) {
+    flush_step();
+    buf.push_back(tag);
+    put(cycle - last_cycle);
+    last_cycle = cycle;
+  }
+
+  /** Ends a record, writing the buffer out once it is full. */
+  void end() {
+    if (buf.size() >= RLOG_BUFFER_BYTES)
+      flush();
+  }
+
+  /** Emits the held-back step, if any. */
+  void flush_step() {
+    if (step_cycles == 0)
+      return;
+    uint64_t n = step_cycles;
+    step_cycles = 0;
+    begin(RLOG_STEP, step_start);
+    put(n);
+    end();
+  }
+
+  /** Appends the buffer to the file. */
+  void flush() {
+    fwrite(buf.data(), 1, buf.size(), file);
+    buf.clear();
+  }
+
+  FILE *file = nullptr;     /**< Log file */
+  std::vector<uint8_t> buf; /**< Encoded records not yet written */
+  uint64_t last_cycle = 0;  /**< Stamp of the previous record */
+  uint64_t step_start = 0;  /**< First cycle of the held-back step */
+  uint64_t step_cycles = 0; /**< Length of the held-back step (0 = none) */
+};
+
+/** One decoded log record. */
+struct ReplayRecord {
+  uint8_t tag = 0;             /**< RLOG_* tag */
+  uint64_t cycle = 0;          /**< Absolute cycle stamp */
+  uint64_t cycles = 0;         /**< RLOG_STEP length */
+  uint32_t addr = 0;           /**< Bus address */
+  uint32_t value = 0;          /**< Word written or read */
+  std::vector<uint32_t> words; /**< Burst values */
+  SnapshotImage image;         /**< RLOG_RESTORE image */
+};
+
+/** Sequential reader of a transaction log. */
+class ReplayReader {
+public:
+  ReplayReader() = default;
+
+  ~ReplayReader() {
+    if (file)
+      fclose(file);
+  }
+
+  ReplayReader(const ReplayReader &) = delete;
+  ReplayReader &operator=(const ReplayReader &) = delete;
+
+  /** Noise seed of the recorded session. */
+  uint32_t seed = 0;
+
+  /** Plusargs of the recorded session. */
+  std::vector<std::string> plusargs;
+
+  /** SoC cycle counter at which recording began. */
+  uint64_t start_cycle = 0;
+
+  /**
+   * Opens a log and reads its header.
+   *
+   * @param path Log file
+   * @return false if the file cannot be opened or is not a log.
+   */
+  bool open(const std::string &path) {
+    file = fopen(path.c_str(), "rb");
+    if (!file)
+      return false;
+    uint8_t magic[8];
+    uint64_t count = 0;
+    if (!take(magic, 8) || memcmp(magic, RLOG_MAGIC, 8) != 0 ||
+        !take(&seed, 4) || !get(count))
+      return false;
+    for (uint64_t i = 0; i < count; i++) {
+      uint64_t len = 0;
+      if (!get(len) || len > RLOG_MAX_ARG)
+        return false;
+      std::string arg(len, '\0');
+      if (!take(&arg[0], len))
+        return false;
+      plusargs.push_back(arg);
+    }
+    if (!get(start_cycle))
+      return false;
+    last_cycle = start_cycle;
+    return true;
+  }
+
+  /**
+   * Decodes the next record.
+   *
+   * @param rec Output record (buffers are reused)
+   * @param cycle Cycle counter after the previous record was applied,
+   *        needed to resolve stamps following a restore
+   * @return 1 for a record, 0 at the end of the log, -1 if it is
+   *         truncated or malformed.
+   */
+  int next(ReplayRecord &rec, uint64_t cycle) {
+    if (rec.tag == RLOG_RESTORE)
+      last_cycle = cycle;
+    uint8_t tag;
+    if (!take(&tag, 1))
+      return 0;
+    uint64_t delta = 0, addr = 0, value = 0;
+    if (!get(delta))
+      return -1;
+    rec.tag = tag;
+    rec.cycle = last_cycle + delta;
+    last_cycle = rec.cycle;
+
+    switch (tag) {
+    case RLOG_STEP:
+      return get(rec.cycles) ? 1 : -1;
+
+    case RLOG_WRITE:
+    case RLOG_READ:
+      if (!get(addr) || !get(value))
+        return -1;
+      rec.addr = static_cast<uint32_t>(addr);
+      rec.value = static_cast<uint32_t>(value);
+      return 1;
+
+    case RLOG_READ_BURST:
+    case RLOG_WRITE_BURST:
+      if (!get(addr) || !get(value))
+        return -1;
+      rec.addr = static_cast<uint32_t>(addr);
+      rec.words.resize(value);
+      for (uint32_t &w : rec.words) {
+        uint64_t v = 0;
+        if (!get(v))
+          return -1;
+        w = static_cast<uint32_t>(v);
+      }
+      return 1;
+
+    case RLOG_RESTORE:
+      if (!get(value))
+        return -1;
+      rec.image.resize(value);
+      return take(rec.image.data(), value) ? 1 : -1;
+
+    default:
+      return -1;
+    }
+  }
+
+private:
+  /** Refills the buffer; false at the end of the file. */
+  bool fill() {
+    end = fread(buf, 1, sizeof(buf), file);
+    pos = 0;
+    return end != 0;
+  }
+
+  /**
+   * Copies raw bytes out of the log.
+   *
+   * @param out Destination
+   * @param n Bytes to copy
+   * @return false if the log ends first.
+   */
+  bool take(void *out, size_t n) {
+    uint8_t *dst = static_cast<uint8_t *>(out);
+    while (n > 0) {
+      if (pos == end && !fill())
+        return false;
+      size_t k = std::min(n, end - pos);
+      memcpy(dst, buf + pos, k);
+      dst += k;
+      pos += k;
+      n -= k;
+    }
+    return true;
+  }
+
+  /**
+   * Decodes a varint.
+   *
+   * @param v Output value
+   * @return false if the log ends inside it or it is too long.
+   */
+  bool get(uint64_t &v) {
+    v = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+      if (pos == end && !fill())
+        return false;
+      uint8_t b = buf[pos++];
+      v |= static_cast<uint64_t>(b & 0x7F) << shift;
+      if ((b & 0x80) == 0)
+        return true;
+    }
+    return false;
+  }
+
+  FILE *file = nullptr;           /**< Log file */
+  uint8_t buf[RLOG_BUFFER_BYTES]; /**< Read buffer */
+  size_t pos = 0;                 /**< Next unread byte in buf */
+  size_t end = 0;                 /**< Valid bytes in buf */
+  uint64_t last_cycle = 0;        /**< Stamp of the previous record */
+};
+
+/**
+ * Writer of syndromes as a Stim .b8 shot file.
+ *
+ * Every appended readout becomes one shot of a fixed number of detector
+ * bits, taken from the low bits of its 32-bit words; stdio buffers the
+ * file, so a shot costs one small copy.
+ */
+class ShotWriter {
+public:
+  ShotWriter() = default;
+
+  ~ShotWriter() { close(); }
+
+  ShotWriter(const ShotWriter &) = delete;
+  ShotWriter &operator=(const ShotWriter &) = delete;
+
+  /**
+   * Creates the shot file.
+   *
+   * @param path Destination file (truncated)
+   * @param shot_bits Detector bits per shot (the qubit count)
+   * @return false if the file could not be created.
+   */
+  bool open(const std::string &path, uint32_t shot_bits) {
+    file = fopen(path.c_str(), "wb");
+    if (!file)
+      return false;
+    bits = shot_bits;
+    shot.assign((shot_bits + 7) / 8, 0);
+    return true;
+  }
+
+  /** Whether the file is open. */
+  bool is_open() const { return file != nullptr; }
+
+  /**
+   * Appends one syndrome readout as a shot.
+   *
+   * @param words Error bank words, qubit i at bit i % 32 of word i / 32
+   * @param count Number of words (missing words count as zero)
+   */
+  void append(const uint32_t *words, uint32_t count) {
+    for (size_t i = 0; i < shot.size(); i++)
+      shot[i] = i / 4 < count
+                    ? static_cast<uint8_t>(words[i / 4] >> (8 * (i % 4)))
+                    : 0;
+    if (bits % 8 != 0)
+      shot.back() &= static_cast<uint8_t>((1u << (bits % 8)) - 1);
+    fwrite(shot.data(), 1, shot.size(), file);
+    shots++;
+  }
+
+  /** Closes the file. */
+  void close() {
+    if (!file)
+      return;
+    fclose(file);
+    file = nullptr;
+  }
+
+  uint64_t shots = 0; /**< Shots appended */
+  uint32_t bits = 0;  /**< Detector bits per shot */
+
+private:
+  FILE *file = nullptr;      /**< Shot file */
+  std::vector<uint8_t> shot; /**< Encoding buffer of one shot */
+};
@@ -0,0 +1,300 @@
+/**
+ * @file shm_channel.h
+ * @brief POSIX shared-memory transport for co-located host controllers.
+ *
+ * Implements the Channel interface over a shared-memory region containing
+ * two single-producer single-consumer byte rings: one carrying commands from
+ * the host to the simulator and one carrying responses back. Both sides
+ * busy-poll the ring indices, backing off to sched_yield() after a short
+ * spin, so a register access costs a few cache-line transfers instead of a
+ * pair of socket syscalls.
+ *
+ * The layout below is mirrored by `qcu_host::hil::shm` and must be kept in
+ * sync with it. All fields are little-endian and naturally aligned; every
+ * ring index lives on its own 64-byte cache line to avoid false sharing.
+ */
+
+#pragma once
+
+#include "channel.h"
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <memory>
+#include <sched.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/** Magic value identifying an initialized region ("QCUS"). */
+#define SHM_MAGIC 0x53554351u
+
+/** Layout version, bumped whenever ShmRegion changes. */
+#define SHM_VERSION 2u
+
+/** Capacity of each ring in bytes (must be a power of two). */
+#define SHM_RING_BYTES (1u << 16)
+
+/** Busy-poll iterations before yielding the CPU while waiting on a ring. */
+#define SHM_SPIN_LIMIT 4096
+
+/**
+ * Single-producer single-consumer byte ring.
+ *
+ * head is advanced by the producer after copying data in; tail is advanced
+ * by the consumer after copying data out. Both are free-running counters,
+ * masked with SHM_RING_BYTES - 1 to obtain the slot offset.
+ */
+struct ShmRing {
+  std::atomic<uint64_t> head; /**< Total bytes produced */
+  uint8_t _pad0[56];
+  std::atomic<uint64_t> tail; /**< Total bytes consumed */
+  uint8_t _pad1[56];
+  uint8_t data[SHM_RING_BYTES]; /**< Ring storage */
+};
+
+/**
+ * Region header shared by both sides.
+ *
+ * magic is written last by the server once the rings are initialized, so a
+ * client that observes it can safely start using the rings, and cleared
+ * again when the server closes the region. The client claims the region by
+ * switching client_attached from 0 to 1, publishes its pid and clears both
+ * when it leaves. Each side probes the other's pid while it waits, so a peer
+ * that was killed without detaching does not leave it spinning forever.
+ */
+struct ShmHeader {
+  std::atomic<uint32_t> magic;           /**< SHM_MAGIC once initialized */
+  uint32_t version;                      /**< SHM_VERSION */
+  uint32_t ring_bytes;                   /**< SHM_RING_BYTES */
+  std::atomic<uint32_t> client_attached; /**< 1 while a host is attached */
+  std::atomic<uint32_t> client_pid;      /**< Process id of the host */
+  std::atomic<uint32_t> server_pid;      /**< Process id of the simulator */
+  uint8_t _pad[40];
+};
+
+/** Complete shared-memory region: header, command ring, response ring. */
+struct ShmRegion {
+  ShmHeader hdr;
+  ShmRing cmd;  /**< Host -> simulator */
+  ShmRing resp; /**< Simulator -> host */
+};
+
+static_assert(sizeof(std::atomic<uint64_t>) == 8, "ring index must be 8 bytes");
+static_assert(sizeof(ShmHeader) == 64, "ShmHeader must be one cache line");
+static_assert(sizeof(ShmRing) == 128 + SHM_RING_BYTES,
+              "unexpected ShmRing size");
+
+/**
+ * Hints to the CPU that the caller is spinning on a shared variable.
+ */
+static inline void shm_cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__)
+  asm volatile("yield");
+#endif
+}
+
+/**
+ * Server side of the shared-memory transport.
+ *
+ * Creates and owns the region under /dev/shm and unlinks it on destruction.
+ * Only one host may be attached at a time.
+ */
+class ShmChannel : public Channel {
+public:
+  /**
+   * Creates, sizes and maps a fresh shared-memory region.
+   *
+   * Any stale region with the same name is removed first.
+   *
+   * @param name Region name without the leading slash (e.g. "qcu0")
+   * @return The channel, or nullptr if the region could not be created.
+   */
+  static std::unique_ptr<ShmChannel> create(const std::string &name) {
+    std::string path = "/" + name;
+    shm_unlink(path.c_str());
+
+    int fd = shm_open(path.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) {
+      perror("shm_open");
+      return nullptr;
+    }
+    if (ftruncate(fd, sizeof(ShmRegion)) < 0) {
+      perror("ftruncate");
+      close(fd);
+      shm_unlink(path.c_str());
+      return nullptr;
+    }
+    void *mem = mmap(nullptr, sizeof(ShmRegion), PROT_READ | PROT_WRITE,
+                     MAP_SHARED, fd, 0);
+    close(fd);
+    if (mem == MAP_FAILED) {
+      perror("mmap");
+      shm_unlink(path.c_str());
+      return nullptr;
+    }
+
+    auto *region = static_cast<ShmRegion *>(mem);
+    region->hdr.version = SHM_VERSION;
+    region->hdr.ring_bytes = SHM_RING_BYTES;
+    region->hdr.client_attached.store(0, std::memory_order_relaxed);
+    region->hdr.client_pid.store(0, std::memory_order_relaxed);
+    region->hdr.server_pid.store(static_cast<uint32_t>(getpid()),
+                                 std::memory_order_relaxed);
+    region->cmd.head.store(0, std::memory_order_relaxed);
+    region->cmd.tail.store(0, std::memory_order_relaxed);
+    region->resp.head.store(0, std::memory_order_relaxed);
+    region->resp.tail.store(0, std::memory_order_relaxed);
+    region->hdr.magic.store(SHM_MAGIC, std::memory_order_release);
+
+    return std::unique_ptr<ShmChannel>(new ShmChannel(path, region));
+  }
+
+  /**
+   * Clears the magic so an attached host stops waiting, then unmaps and
+   * unlinks the region.
+   */
+  ~ShmChannel() override {
+    region->hdr.magic.store(0, std::memory_order_release);
+    munmap(region, sizeof(ShmRegion));
+    shm_unlink(path.c_str());
+  }
+
+  ShmChannel(const ShmChannel &) = delete;
+  ShmChannel &operator=(const ShmChannel &) = delete;
+
+  /**
+   * Blocks until a host controller attaches to the region.
+   */
+  void wait_for_client() {
+    while (region->hdr.client_attached.load(std::memory_order_acquire) == 0)
+      usleep(1000);
+  }
+
+  bool recv_exact(void *buf, size_t len) override {
+    ShmRing &ring = region->cmd;
+    uint8_t *p = static_cast<uint8_t *>(buf);
+    uint64_t tail = ring.tail.load(std::memory_order_relaxed);
+    unsigned spins = 0;
+
+    while (len > 0) {
+      uint64_t head = ring.head.load(std::memory_order_acquire);
+      size_t avail = static_cast<size_t>(head - tail);
+      if (avail == 0) {
+        if (!backoff(spins))
+          return false;
+        continue;
+      }
+      spins = 0;
+
+      size_t n = avail < len ? avail : len;
+      copy_out(ring, tail, p, n);
+      tail += n;
+      ring.tail.store(tail, std::memory_order_release);
+      p += n;
+      len -= n;
+    }
+    return true;
+  }
+
+  bool send_all(const void *buf, size_t len) override {
+    ShmRing &ring = region->resp;
+    const uint8_t *p = static_cast<const uint8_t *>(buf);
+    uint64_t head = ring.head.load(std::memory_order_relaxed);
+    unsigned spins = 0;
+
+    while (len > 0) {
+      uint64_t tail = ring.tail.load(std::memory_order_acquire);
+      size_t space = SHM_RING_BYTES - static_cast<size_t>(head - tail);
+      if (space == 0) {
+        if (!backoff(spins))
+          return false;
+        continue;
+      }
+      spins = 0;
+
+      size_t n = space < len ? space : len;
+      copy_in(ring, head, p, n);
+      head += n;
+      ring.head.store(head, std::memory_order_release);
+      p += n;
+      len -= n;
+    }
+    return true;
+  }
+
+  bool readable() override {
+    const ShmRing &ring = region->cmd;
+    return ring.head.load(std::memory_order_acquire) !=
+               ring.tail.load(std::memory_order_relaxed) ||
+           region->hdr.client_attached.load(std::memory_order_acquire) == 0;
+  }
+
+  void shutdown() override { closing.store(true, std::memory_order_release); }
+
+private:
+  ShmChannel(std::string path, ShmRegion *region)
+      : path(std::move(path)), region(region) {}
+
+  /**
+   * Spins, then yields, while waiting for the peer.
+   *
+   * Every 64Ki idle iterations the host pid is probed so a host that died
+   * without detaching does not leave the server waiting forever.
+   *
+   * @param spins Consecutive idle iterations so far (updated in place)
+   * @return false once the host has detached or exited or the channel has
+   *         been shut down, true to keep waiting.
+   */
+  bool backoff(unsigned &spins) {
+    if (closing.load(std::memory_order_acquire))
+      return false;
+    if (++spins < SHM_SPIN_LIMIT) {
+      shm_cpu_relax();
+      return true;
+    }
+    if (region->hdr.client_attached.load(std::memory_order_acquire) == 0)
+      return false;
+    if ((spins & 0xFFFF) == 0) {
+      pid_t pid = static_cast<pid_t>(
+          region->hdr.client_pid.load(std::memory_order_relaxed));
+      if (pid > 0 && kill(pid, 0) < 0 && errno == ESRCH)
+        return false;
+    }
+    sched_yield();
+    return true;
+  }
+
+  /** Copies n bytes out of ring starting at counter pos, handling wrap. */
+  static void copy_out(const ShmRing &ring, uint64_t pos, uint8_t *dst,
+                       size_t n) {
+    size_t off = static_cast<size_t>(pos & (SHM_RING_BYTES - 1));
+    size_t first = SHM_RING_BYTES - off < n ? SHM_RING_BYTES - off : n;
+    memcpy(dst, ring.data + off, first);
+    memcpy(dst + first, ring.data, n - first);
+  }
+
+  /** Copies n bytes into ring starting at counter pos, handling wrap. */
+  static void copy_in(ShmRing &ring, uint64_t pos, const uint8_t *src,
+                      size_t n) {
+    size_t off = static_cast<size_t>(pos & (SHM_RING_BYTES - 1));
+    size_t first = SHM_RING_BYTES - off < n ? SHM_RING_BYTES - off : n;
+    memcpy(ring.data + off, src, first);
+    memcpy(ring.data, src + first, n - first);
+  }
+
+  /** shm_open name including the leading slash. */
+  std::string path;
+
+  /** Mapped region. */
+  ShmRegion *region;
+
+  /** Set by shutdown() to fail every further wait. */
+  std::atomic<bool> closing{false};
+};
@@ -0,0 +1,299 @@
+/**
+ * @file sim_stats.h
+ * @brief Per-session instrumentation counters for the simulation server.
+ *
+ * Every session keeps one SimStats block next to its SoC. The harness
+ * counts evaluated and fast-forwarded clock cycles, optionally the wall
+ * time spent inside the Verilated model, and, per protocol opcode, how many
+ * commands arrived, how much host wall time they took and how many
+ * simulated cycles they consumed, so simulated cost and host cost can be
+ * compared side by side. A log2 histogram records the latency from a
+ * syndrome becoming visible at the qubit grid to the next correction pulse,
+ * in simulated cycles, and a configurable deadline on that latency counts
+ * the syndromes the controller failed to answer in time. Paced sessions
+ * (realtime.h) add how far the clock fell behind real time and how long
+ * host commands waited for the next cycle boundary. The syndrome-to-pulse
+ * latency and the wall time of every command are also kept in log-linear
+ * histograms (latency_hist.h), reported by CMD_LATENCY as percentile lines
+ * in the export format shared with the host and firmware.
+ *
+ * The block is serialized for CMD_STATS as a flat array of 64-bit words:
+ *
+ *   0          cycles          clock cycles simulated, including skipped
+ *   1          ticks           clock cycles evaluated by the model
+ *   2          skipped         clock cycles fast-forwarded
+ *   3          eval_ns         wall time inside eval() (0 unless profiled)
+ *   4          wall_ns         wall time of the measurement window
+ *   5          lat_count       syndrome-to-pulse samples
+ *   6          lat_sum         sum of the samples in cycles
+ *   7          lat_min         smallest sample (0 without samples)
+ *   8          lat_max         largest sample
+ *   9+b        lat_bucket[b]   samples in [2^(b-1), 2^b) cycles (b=0: 0)
+ *   41+3(o-1)  cmd[o]          count, wall_ns, cycles of opcode o (1..15)
+ *   86         pace_hz         target clock rate (0 for lock-step sessions)
+ *   87         lag_max_ns      largest lag of the clock behind schedule
+ *   88         late_checks     pacing checks more than an interval late
+ *   89         queue_max       deepest command backlog at a cycle boundary
+ *   90         queue_wait_ns   total time commands waited in the queue
+ *   91         queue_wait_max  longest wait of a single command
+ *   92         deadline        syndrome-to-pulse deadline (0 for none)
+ *   93         deadline_miss   syndromes not answered within the deadline
+ *
+ * All values cover the measurement window, which starts with the session
+ * and restarts whenever the counters are reset; pace_hz and deadline are
+ * settings and survive resets.
+ */
+
+#pragma once
+
+#include "latency_hist.h"
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/** Buckets of the syndrome-to-pulse latency histogram. */
+#define STATS_LAT_BUCKETS 32
+
+/** Highest protocol opcode with its own counters (CMD_HALT). */
+#define STATS_MAX_OPCODE 15
+
+/** Index of the pacing block in a serialized SimStats block. */
+#define STATS_PACE_BASE (9 + STATS_LAT_BUCKETS + 3 * STATS_MAX_OPCODE)
+
+/** Words in the pacing and deadline block. */
+#define STATS_PACE_WORDS 8
+
+/** Words in a serialized SimStats block. */
+#define STATS_WORDS (STATS_PACE_BASE + STATS_PACE_WORDS)
+
+/**
+ * Monotonic wall clock in nanoseconds.
+ *
+ * @return Nanoseconds since an arbitrary fixed point.
+ */
+static inline uint64_t stats_now_ns() {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+}
+
+/**
+ * Instrumentation counters of one simulation session.
+ *
+ * The cycle counters themselves live in the SoC, which updates them on
+ * every tick; this block remembers their values at the start of the
+ * measurement window, so it can be reset without touching the simulation.
+ */
+struct SimStats {
+  /** SoC cycle counter at the start of the window. */
+  uint64_t cycles_base = 0;
+
+  /** SoC skipped-cycle counter at the start of the window. */
+  uint64_t skipped_base = 0;
+
+  /** Wall time spent inside the model's eval() calls. */
+  uint64_t eval_ns = 0;
+
+  /** Start of the current measurement window. */
+  uint64_t start_ns = stats_now_ns();
+
+  /** Syndrome-to-pulse samples recorded. */
+  uint64_t lat_count = 0;
+
+  /** Sum of all samples in cycles. */
+  uint64_t lat_sum = 0;
+
+  /** Smallest sample in cycles (meaningful once lat_count > 0). */
+  uint64_t lat_min = UINT64_MAX;
+
+  /** Largest sample in cycles. */
+  uint64_t lat_max = 0;
+
+  /** Log2 latency histogram. */
+  uint64_t lat_hist[STATS_LAT_BUCKETS] = {};
+
+  /** Commands received per opcode (index 0 unused). */
+  uint64_t cmd_count[STATS_MAX_OPCODE + 1] = {};
+
+  /** Host wall time spent executing each opcode. */
+  uint64_t cmd_ns[STATS_MAX_OPCODE + 1] = {};
+
+  /** Simulated cycles consumed by each opcode. */
+  uint64_t cmd_cycles[STATS_MAX_OPCODE + 1] = {};
+
+  /** Target clock rate of a paced session (setting). */
+  uint64_t pace_hz = 0;
+
+  /** Largest lag of the clock behind its schedule. */
+  uint64_t lag_max_ns = 0;
+
+  /** Pacing checks that found the clock more than an interval late. */
+  uint64_t late_checks = 0;
+
+  /** Deepest command backlog seen at a cycle boundary. */
+  uint64_t queue_max = 0;
+
+  /** Total time commands waited for a cycle boundary. */
+  uint64_t queue_wait_ns = 0;
+
+  /** Longest single-command wait for a cycle boundary. */
+  uint64_t queue_wait_max_ns = 0;
+
+  /** Syndrome-to-pulse deadline in cycles, 0 for none (setting). */
+  uint64_t deadline_cycles = 0;
+
+  /** Syndromes that were still unanswered when the deadline passed. */
+  uint64_t deadline_misses = 0;
+
+  /** Syndrome-to-pulse latencies in cycles, for percentiles. */
+  LatencyHistogram pulse_hist;
+
+  /** Wall time of every accounted command, for percentiles. */
+  LatencyHistogram cmd_hist;
+
+  /**
+   * Records one syndrome-to-pulse latency sample.
+   *
+   * @param cycles Cycles from syndrome visible to pulse applied
+   */
+  void record_latency(uint64_t cycles) {
+    lat_count++;
+    lat_sum += cycles;
+    if (cycles < lat_min)
+      lat_min = cycles;
+    if (cycles > lat_max)
+      lat_max = cycles;
+    pulse_hist.record(cycles);
+    unsigned bucket = 0;
+    while (bucket + 1 < STATS_LAT_BUCKETS && (cycles >> bucket) != 0)
+      bucket++;
+    lat_hist[bucket]++;
+  }
+
+  /**
+   * Accounts one executed command.
+   *
+   * Every command enters the wall-time histogram; opcodes without their
+   * own counters (CMD_EXIT, CMD_LATENCY and unknown ones) get no per-opcode
+   * totals.
+   *
+   * @param op Protocol opcode
+   * @param ns Host wall time the command took
+   * @param cycles Simulated cycles the command consumed
+   */
+  void record_command(uint8_t op, uint64_t ns, uint64_t cycles) {
+    cmd_hist.record(ns);
+    if (op == 0 || op > STATS_MAX_OPCODE)
+      return;
+    cmd_count[op]++;
+    cmd_ns[op] += ns;
+    cmd_cycles[op] += cycles;
+  }
+
+  /**
+   * Records one pacing check that found the clock behind schedule.
+   *
+   * @param ns Lag behind schedule
+   * @param late Whether the lag exceeds a check interval
+   */
+  void record_lag(uint64_t ns, bool late) {
+    if (ns > lag_max_ns)
+      lag_max_ns = ns;
+    late_checks += late;
+  }
+
+  /**
+   * Records the commands taken from the queue at one cycle boundary.
+   *
+   * @param depth Commands taken at once
+   */
+  void record_backlog(uint64_t depth) {
+    if (depth > queue_max)
+      queue_max = depth;
+  }
+
+  /**
+   * Records how long one command waited for a cycle boundary.
+   *
+   * @param ns Time from arrival to execution
+   */
+  void record_queue_wait(uint64_t ns) {
+    queue_wait_ns += ns;
+    if (ns > queue_wait_max_ns)
+      queue_wait_max_ns = ns;
+  }
+
+  /**
+   * Serializes the block in the CMD_STATS layout.
+   *
+   * @param cycles Cycles simulated (SoC counter)
+   * @param skipped Cycles fast-forwarded (SoC counter)
+   * @param out Output; resized to STATS_WORDS words
+   */
+  void serialize(uint64_t cycles, uint64_t skipped,
+                 std::vector<uint64_t> &out) const {
+    cycles -= cycles_base;
+    skipped -= skipped_base;
+    out.assign(STATS_WORDS, 0);
+    out[0] = cycles;
+    out[1] = cycles - skipped;
+    out[2] = skipped;
+    out[3] = eval_ns;
+    out[4] = stats_now_ns() - start_ns;
+    out[5] = lat_count;
+    out[6] = lat_sum;
+    out[7] = lat_count ? lat_min : 0;
+    out[8] = lat_max;
+    for (unsigned b = 0; b < STATS_LAT_BUCKETS; b++)
+      out[9 + b] = lat_hist[b];
+    for (unsigned op = 1; op <= STATS_MAX_OPCODE; op++) {
+      size_t base = 9 + STATS_LAT_BUCKETS + 3 * (op - 1);
+      out[base] = cmd_count[op];
+      out[base + 1] = cmd_ns[op];
+      out[base + 2] = cmd_cycles[op];
+    }
+    uint64_t *pace = out.data() + STATS_PACE_BASE;
+    pace[0] = pace_hz;
+    pace[1] = lag_max_ns;
+    pace[2] = late_checks;
+    pace[3] = queue_max;
+    pace[4] = queue_wait_ns;
+    pace[5] = queue_wait_max_ns;
+    pace[6] = deadline_cycles;
+    pace[7] = deadline_misses;
+  }
+
+  /**
+   * Formats the latency histograms as export lines for CMD_LATENCY.
+   *
+   * One line for the syndrome-to-pulse latency ("sim.pulse", in cycles,
+   * with the deadline and its misses) and one for the command wall time
+   * ("sim.command", in nanoseconds).
+   *
+   * @param out Output; replaced by the newline-terminated lines
+   */
+  void latency_report(std::string &out) const {
+    out.clear();
+    pulse_hist.append_line("sim.pulse", "cycles", deadline_cycles,
+                           deadline_misses, out);
+    cmd_hist.append_line("sim.command", "ns", 0, 0, out);
+  }
+
+  /**
+   * Clears every counter and restarts the measurement window.
+   *
+   * @param cycles Current SoC cycle counter
+   * @param skipped Current SoC skipped-cycle counter
+   */
+  void reset(uint64_t cycles, uint64_t skipped) {
+    uint64_t hz = pace_hz;
+    uint64_t deadline = deadline_cycles;
+    *this = SimStats();
+    cycles_base = cycles;
+    skipped_base = skipped;
+    pace_hz = hz;
+    deadline_cycles = deadline;
+  }
+};
@@ -0,0 +1,250 @@
+/**
+ * @file snapshot.h
+ * @brief Checkpoint images of a simulation session for CMD_SAVE/CMD_RESTORE.
+ *
+ * A snapshot holds the complete state of a Verilated SoC model (serialized
+ * with Verilator's save/restore support) followed by the harness state the
+ * model does not know about: simulation time, the cycle counters and the
+ * syndrome-to-pulse tracking flags. Images live either in a process-wide
+ * store of numbered slots, so one session can warm a design up and any
+ * number of later sessions of the same server can fork from it, or in a
+ * file, so checkpoints survive the server process.
+ *
+ * The model must be verilated with `--savable` (the `snapshot` feature,
+ * which defines QCU_SAVABLE); otherwise every request is answered with
+ * SNAP_UNSUPPORTED. Images can only be restored into the build that wrote
+ * them; Verilator checks this when restoring and aborts on a mismatch.
+ */
+
+#pragma once
+
+#include "Vtop_soc.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#ifdef QCU_SAVABLE
+#include "verilated_save.h"
+#endif
+
+/**
+ * @defgroup SnapStatus CMD_SAVE/CMD_RESTORE Status Codes
+ * @{
+ */
+#define SNAP_OK 0          /**< Request completed */
+#define SNAP_UNSUPPORTED 1 /**< Model built without --savable */
+#define SNAP_IO_ERROR 2    /**< Snapshot file could not be written or read */
+#define SNAP_NOT_FOUND 3   /**< Slot is empty or file does not exist */
+#define SNAP_BAD_REQUEST 4 /**< Slot out of range */
+#define SNAP_BAD_FILE 5    /**< File is not a complete snapshot */
+/** @} */
+
+/** In-memory snapshot slots shared by all sessions of a server. */
+#define SNAP_SLOTS 64
+
+/** Upper bound on the length of a snapshot file path. */
+#define SNAP_MAX_PATH 4096
+
+/** Magic at the start of a snapshot file (8 bytes, version in the last). */
+#define SNAP_FILE_MAGIC "QCUSNAP1"
+
+/** Serialized model and harness state. */
+using SnapshotImage = std::vector<uint8_t>;
+
+#ifdef QCU_SAVABLE
+/**
+ * Verilator serializer that appends to an in-memory image.
+ *
+ * Mirrors VerilatedSave, with the buffer flushed into a vector instead of
+ * a file descriptor.
+ */
+class MemorySave : public VerilatedSerialize {
+public:
+  /**
+   * Starts a new image.
+   *
+   * @param out Image to fill; cleared first
+   */
+  explicit MemorySave(SnapshotImage &out) : image(out) {
+    image.clear();
+    m_isOpen = true;
+    header();
+  }
+
+  ~MemorySave() override { close(); }
+
+  /** Writes the trailer and flushes the remaining buffer. */
+  void close() override {
+    if (!isOpen())
+      return;
+    trailer();
+    flush();
+    m_isOpen = false;
+  }
+
+  /** Moves the buffered bytes into the image. */
+  void flush() override {
+    image.insert(image.end(), m_bufp, m_cp);
+    m_cp = m_bufp;
+  }
+
+private:
+  SnapshotImage &image; /**< Destination image */
+};
+
+/**
+ * Verilator deserializer that reads from an in-memory image.
+ *
+ * Mirrors VerilatedRestore, with the buffer refilled from a vector instead
+ * of a file descriptor.
+ */
+class MemoryRestore : public VerilatedDeserialize {
+public:
+  /**
+   * Opens an image and checks its header.
+   *
+   * @param in Image to read; must outlive the restorer
+   */
+  explicit MemoryRestore(const SnapshotImage &in) : image(in) {
+    m_isOpen = true;
+    m_cp = m_bufp;
+    m_endp = m_bufp;
+    fill();
+    header();
+  }
+
+  ~MemoryRestore() override { close(); }
+
+  /** Checks the trailer. */
+  void close() override {
+    if (!isOpen())
+      return;
+    trailer();
+    m_isOpen = false;
+  }
+
+  /** Moves the unread bytes down and tops the buffer up from the image. */
+  void fill() override {
+    size_t left = static_cast<size_t>(m_endp - m_cp);
+    memmove(m_bufp, m_cp, left);
+    m_cp = m_bufp;
+    m_endp = m_bufp + left;
+    size_t n = std::min(bufferSize() - left, image.size() - pos);
+    memcpy(m_endp, image.data() + pos, n);
+    m_endp += n;
+    pos += n;
+  }
+
+private:
+  const SnapshotImage &image; /**< Source image */
+  size_t pos = 0;             /**< Next image byte to load */
+};
+#endif
+
+/**
+ * Process-wide table of in-memory snapshots.
+ *
+ * Images are immutable once stored and handed out as shared pointers, so a
+ * slot can be overwritten while other sessions are still restoring from
+ * the previous image.
+ */
+class SnapshotStore {
+public:
+  /**
+   * Stores an image in a slot, replacing the previous one.
+   *
+   * @param slot Slot index (< SNAP_SLOTS)
+   * @param image Image to store
+   */
+  void put(uint32_t slot, std::shared_ptr<const SnapshotImage> image) {
+    std::lock_guard<std::mutex> lock(mutex);
+    slots[slot] = std::move(image);
+  }
+
+  /**
+   * Looks up the image in a slot.
+   *
+   * @param slot Slot index (< SNAP_SLOTS)
+   * @return The stored image, or null if the slot is empty.
+   */
+  std::shared_ptr<const SnapshotImage> get(uint32_t slot) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return slots[slot];
+  }
+
+private:
+  std::mutex mutex;                                       /**< Guards slots */
+  std::shared_ptr<const SnapshotImage> slots[SNAP_SLOTS]; /**< Images */
+};
+
+/**
+ * Writes an image to a snapshot file.
+ *
+ * The file holds SNAP_FILE_MAGIC, the 64-bit image size and the image. It
+ * is written to a temporary name and renamed into place, so a concurrent
+ * restore never sees a partial file. The temporary name carries the process
+ * and session ids, so concurrent saves to one path never share it; the last
+ * rename wins.
+ *
+ * @param path Destination file
+ * @param image Image to write
+ * @param session Id of the saving session
+ * @return SNAP_OK or SNAP_IO_ERROR.
+ */
+static inline uint32_t write_snapshot_file(const std::string &path,
+                                           const SnapshotImage &image,
+                                           uint32_t session) {
+  std::string tmp = path + ".tmp." + std::to_string(getpid()) + "." +
+                    std::to_string(session);
+  FILE *f = fopen(tmp.c_str(), "wb");
+  if (!f)
+    return SNAP_IO_ERROR;
+  uint64_t size = image.size();
+  bool ok = fwrite(SNAP_FILE_MAGIC, 8, 1, f) == 1 &&
+            fwrite(&size, sizeof(size), 1, f) == 1 &&
+            fwrite(image.data(), 1, image.size(), f) == image.size();
+  ok = fclose(f) == 0 && ok;
+  if (!ok || rename(tmp.c_str(), path.c_str()) != 0) {
+    remove(tmp.c_str());
+    return SNAP_IO_ERROR;
+  }
+  return SNAP_OK;
+}
+
+/**
+ * Reads an image from a snapshot file.
+ *
+ * @param path Source file
+ * @param image Output image
+ * @return SNAP_OK, SNAP_NOT_FOUND if the file does not exist,
+ *         SNAP_BAD_FILE if it is not a complete snapshot file, or
+ *         SNAP_IO_ERROR if it cannot be opened.
+ */
+static inline uint32_t read_snapshot_file(const std::string &path,
+                                          SnapshotImage &image) {
+  FILE *f = fopen(path.c_str(), "rb");
+  if (!f)
+    return errno == ENOENT ? SNAP_NOT_FOUND : SNAP_IO_ERROR;
+  char magic[8];
+  uint64_t size = 0;
+  uint32_t status = SNAP_BAD_FILE;
+  fseek(f, 0, SEEK_END);
+  long length = ftell(f);
+  rewind(f);
+  if (fread(magic, 8, 1, f) == 1 && memcmp(magic, SNAP_FILE_MAGIC, 8) == 0 &&
+      fread(&size, sizeof(size), 1, f) == 1 &&
+      size == static_cast<uint64_t>(length) - 8 - sizeof(size)) {
+    image.resize(size);
+    if (fread(image.data(), 1, size, f) == size)
+      status = SNAP_OK;
+  }
+  fclose(f);
+  return status;
+}
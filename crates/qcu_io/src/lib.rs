@@ -16,5 +16,6 @@ pub mod loader;
 ///
 /// Parses detector error model (.dem) files that describe the connectivity
 /// structure of quantum error correction codes. Constructs DecodingGraph
-/// instances from the parsed edge and node information.
+/// instances from the parsed edge and node information, and saves and loads
+/// them as precompiled graph images.
 pub mod parser;
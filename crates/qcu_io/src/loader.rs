@@ -1,69 +1,331 @@
 //! Loader for binary syndrome measurement data files.
 //!
-//! Provides functions for reading Stim .b8 files, which contain packed binary
-//! data representing syndrome measurements from multiple quantum shots. The
-//! loader unpacks the binary data into per-shot boolean vectors for processing
-//! by the decoder.
+//! Provides readers for Stim .b8 files, which contain packed binary data
+//! representing syndrome measurements from multiple quantum shots. Shots are
+//! stored back to back, each padded to whole bytes with detector i at bit
+//! i % 8 of byte i / 8, so a shot read as little-endian u64 words has the
+//! `BitPack` layout the decoder works with. `ShotFile` maps a file into
+//! memory and hands out views of its shots without copying or unpacking
+//! them; `ShotStream` reads a file of any size in fixed-size batches of
+//! shots for sequential consumers. The simulator's `--replay --shots`
+//! export writes the syndromes of a recorded session in the same format.
+//! `transpose_shots` turns up to 64 consecutive shots into the
+//! bit-transposed block `qcu_core::decoder::BatchDecoder` decodes.
 
-use anyhow::{Context, Result};
-use bitvec::prelude::*;
+use anyhow::{Context, Result, bail};
+use qcu_core::bit_utils::BitPack;
+use qcu_core::decoder::BATCH_SHOTS;
 use std::fs::File;
-use std::io::Read;
+use std::io::{self, Read};
+use std::os::fd::AsRawFd;
 use std::path::Path;
 
-/// Loads a Stim .b8 file containing binary measurement data.
+/// Bytes a `ShotStream` reads per batch, rounded down to whole shots.
+const STREAM_BATCH_BYTES: usize = 4 << 20;
+
+/// Appends the indices of the detectors that fired in one shot.
 ///
-/// Reads the entire file into memory and converts it to a BitVec for efficient
-/// bit-level access. The .b8 format uses little-endian byte order, with bits
-/// packed 8 per byte. Each bit represents one detector measurement result.
+/// Walks the shot as 64-bit words and extracts the set bits with
+/// `trailing_zeros`, so the cost is proportional to the number of words and
+/// fired detectors rather than to the number of detectors. Padding bits
+/// beyond `bits_per_shot` are ignored.
 ///
 /// # Arguments
 ///
-/// * `path` - Path to the .b8 file
-///
-/// # Returns
-///
-/// A BitVec containing all measurement bits, or an error if the file cannot
-/// be read.
-pub fn load_b8_file<P: AsRef<Path>>(path: P) -> Result<BitVec<u8, Lsb0>> {
-    let mut file = File::open(path).context("Failed to open .b8 file")?;
-    let mut buffer = Vec::new();
-    file.read_to_end(&mut buffer)?;
-
-    let bits = BitVec::<u8, Lsb0>::from_vec(buffer);
-    Ok(bits)
+/// * `shot` - Packed shot bytes
+/// * `bits_per_shot` - Number of detector bits in the shot
+/// * `out` - Cleared, then receives the fired detector indices in order
+pub fn fired_detectors(shot: &[u8], bits_per_shot: usize, out: &mut Vec<usize>) {
+    out.clear();
+    for (w, chunk) in shot.chunks(8).enumerate() {
+        let mut bytes = [0u8; 8];
+        bytes[..chunk.len()].copy_from_slice(chunk);
+        let mut word = u64::from_le_bytes(bytes);
+        while word != 0 {
+            let index = w * 64 + word.trailing_zeros() as usize;
+            if index >= bits_per_shot {
+                return;
+            }
+            out.push(index);
+            word &= word - 1;
+        }
+    }
 }
 
-/// Splits raw bit data into per-shot boolean vectors.
+/// Transposes up to `BATCH_SHOTS` consecutive shots into a detector-major
+/// block.
 ///
-/// Divides the packed bit vector into individual shots, where each shot
-/// contains bits_per_shot detector measurements. Shots are stored as
-/// separate boolean vectors for easy iteration and processing by the decoder.
+/// Gathers word t of every shot into a 64 x 64 tile, transposes the tile
+/// with `BitPack::transpose64` and stores it as detectors 64t..64t+64, so
+/// word d of the block has bit s set if detector d fired in shot s.
 ///
 /// # Arguments
 ///
-/// * `raw_bits` - Packed bit vector from load_b8_file
-/// * `bits_per_shot` - Number of detector bits per measurement shot
+/// * `shots` - Packed bytes of the shots, back to back
+/// * `bits_per_shot` - Number of detector bits per shot
+/// * `block` - Receives `bits_per_shot` detector words
+pub fn transpose_shots(shots: &[u8], bits_per_shot: usize, block: &mut Vec<u64>) {
+    let stride = bits_per_shot.div_ceil(8);
+    let count = (shots.len() / stride).min(BATCH_SHOTS);
+    let tiles = bits_per_shot.div_ceil(64);
+    block.clear();
+    block.resize(tiles * 64, 0);
+
+    let mut tile = [0u64; 64];
+    for t in 0..tiles {
+        for (s, row) in tile.iter_mut().enumerate() {
+            *row = 0;
+            if s < count {
+                let shot = &shots[s * stride..(s + 1) * stride];
+                let start = (8 * t).min(shot.len());
+                let end = (8 * t + 8).min(shot.len());
+                let mut bytes = [0u8; 8];
+                bytes[..end - start].copy_from_slice(&shot[start..end]);
+                *row = u64::from_le_bytes(bytes);
+            }
+        }
+        BitPack::transpose64(&mut tile);
+        block[64 * t..64 * t + 64].copy_from_slice(&tile);
+    }
+    block.truncate(bits_per_shot);
+}
+
+/// Memory-mapped .b8 file with random access to its shots.
+///
+/// The file is mapped read-only and never copied: shots are returned as
+/// slices of the mapping, so opening a file costs no time or memory
+/// proportional to its size, and pages are loaded on first access and can
+/// be evicted again by the kernel, which keeps files larger than RAM
+/// usable. The mapping may be shared between threads.
+pub struct ShotFile {
+    /// Start of the mapping (null for an empty file).
+    data: *const u8,
+
+    /// Mapped length in bytes.
+    len: usize,
+
+    /// Detector bits per shot.
+    bits_per_shot: usize,
+
+    /// Bytes per shot, including padding.
+    stride: usize,
+
+    /// Number of complete shots in the file.
+    num_shots: usize,
+}
+
+/// ShotFile is safe to share between threads.
 ///
-/// # Returns
+/// The mapping is read-only and stays valid until the ShotFile is dropped.
+unsafe impl Send for ShotFile {}
+unsafe impl Sync for ShotFile {}
+
+impl ShotFile {
+    /// Maps a .b8 file.
+    ///
+    /// # Arguments
+    ///
+    /// * `path` - Path to the .b8 file
+    /// * `bits_per_shot` - Number of detector bits per measurement shot
+    ///
+    /// # Returns
+    ///
+    /// The mapped file, or an error if it cannot be opened or mapped.
+    /// Trailing bytes that do not form a complete shot are ignored.
+    pub fn open<P: AsRef<Path>>(path: P, bits_per_shot: usize) -> Result<Self> {
+        if bits_per_shot == 0 {
+            bail!("Shots must have at least one detector bit");
+        }
+        let file = File::open(path).context("Failed to open .b8 file")?;
+        let len = file.metadata()?.len() as usize;
+        let stride = bits_per_shot.div_ceil(8);
+
+        let data = if len == 0 {
+            std::ptr::null()
+        } else {
+            let mem = unsafe {
+                libc::mmap(
+                    std::ptr::null_mut(),
+                    len,
+                    libc::PROT_READ,
+                    libc::MAP_PRIVATE,
+                    file.as_raw_fd(),
+                    0,
+                )
+            };
+            if mem == libc::MAP_FAILED {
+                return Err(io::Error::last_os_error()).context("Failed to map .b8 file");
+            }
+            mem as *const u8
+        };
+
+        Ok(Self {
+            data,
+            len,
+            bits_per_shot,
+            stride,
+            num_shots: len / stride,
+        })
+    }
+
+    /// Returns the number of shots in the file.
+    pub fn len(&self) -> usize {
+        self.num_shots
+    }
+
+    /// Returns whether the file holds no complete shot.
+    pub fn is_empty(&self) -> bool {
+        self.num_shots == 0
+    }
+
+    /// Returns the number of detector bits per shot.
+    pub fn bits_per_shot(&self) -> usize {
+        self.bits_per_shot
+    }
+
+    /// Returns the packed bytes of shot `i`.
+    ///
+    /// # Panics
+    ///
+    /// Panics if `i` is out of range.
+    #[inline(always)]
+    pub fn shot(&self, i: usize) -> &[u8] {
+        assert!(i < self.num_shots);
+        unsafe { std::slice::from_raw_parts(self.data.add(i * self.stride), self.stride) }
+    }
+
+    /// Returns the packed bytes of shots `first..first + count`, back to back.
+    ///
+    /// # Panics
+    ///
+    /// Panics if the range is out of bounds.
+    #[inline(always)]
+    pub fn shots(&self, first: usize, count: usize) -> &[u8] {
+        assert!(first + count <= self.num_shots);
+        if count == 0 {
+            return &[];
+        }
+        unsafe {
+            std::slice::from_raw_parts(self.data.add(first * self.stride), count * self.stride)
+        }
+    }
+
+    /// Returns shot `i` as packed 64-bit words, without copying.
+    ///
+    /// Available when a shot is a whole number of 64-bit words (a multiple
+    /// of 64 detector bits) on a little-endian host, so every shot starts on
+    /// a word boundary of the page-aligned mapping; otherwise use
+    /// `fired_detectors` on `shot`.
+    ///
+    /// # Returns
+    ///
+    /// The words in `BitPack` layout, or None if shots are not word-sized.
+    #[inline(always)]
+    pub fn shot_words(&self, i: usize) -> Option<&[u64]> {
+        if self.stride % 8 != 0 || cfg!(target_endian = "big") {
+            return None;
+        }
+        let bytes = self.shot(i);
+        Some(unsafe { std::slice::from_raw_parts(bytes.as_ptr() as *const u64, self.stride / 8) })
+    }
+
+    /// Appends the indices of the detectors that fired in shot `i`.
+    ///
+    /// # Arguments
+    ///
+    /// * `i` - Shot index
+    /// * `out` - Cleared, then receives the fired detector indices
+    #[inline(always)]
+    pub fn fired(&self, i: usize, out: &mut Vec<usize>) {
+        fired_detectors(self.shot(i), self.bits_per_shot, out);
+    }
+}
+
+impl Drop for ShotFile {
+    /// Unmaps the file.
+    fn drop(&mut self) {
+        if !self.data.is_null() {
+            unsafe {
+                libc::munmap(self.data as *mut libc::c_void, self.len);
+            }
+        }
+    }
+}
+
+/// Sequential batched reader for .b8 files of any size.
 ///
-/// A vector of boolean vectors, where each inner vector represents one shot's
-/// detector measurements.
-pub fn slice_shots(raw_bits: &BitVec<u8, Lsb0>, bits_per_shot: usize) -> Vec<Vec<bool>> {
-    let bytes_per_shot = bits_per_shot.div_ceil(8);
-    let stride_bits = bytes_per_shot * 8;
-
-    let num_shots = raw_bits.len() / stride_bits;
-    let mut shots = Vec::with_capacity(num_shots);
-
-    for i in 0..num_shots {
-        let start = i * stride_bits;
-        let end = start + bits_per_shot;
-
-        let slice = &raw_bits[start..end];
-        let shot_bools: Vec<bool> = slice.iter().map(|b| *b).collect();
-        shots.push(shot_bools);
+/// Reads whole shots in batches of about `STREAM_BATCH_BYTES` into one
+/// reused buffer, so memory use is bounded no matter how large the file is
+/// and works for inputs that cannot be mapped. Each batch can be split into
+/// shots with `chunks_exact(stride())`.
+pub struct ShotStream {
+    /// Source file.
+    file: File,
+
+    /// Batch buffer; holds whole shots only.
+    buffer: Vec<u8>,
+
+    /// Detector bits per shot.
+    bits_per_shot: usize,
+
+    /// Bytes per shot, including padding.
+    stride: usize,
+}
+
+impl ShotStream {
+    /// Opens a .b8 file for batched reading.
+    ///
+    /// # Arguments
+    ///
+    /// * `path` - Path to the .b8 file
+    /// * `bits_per_shot` - Number of detector bits per measurement shot
+    ///
+    /// # Returns
+    ///
+    /// The stream, or an error if the file cannot be opened.
+    pub fn open<P: AsRef<Path>>(path: P, bits_per_shot: usize) -> Result<Self> {
+        if bits_per_shot == 0 {
+            bail!("Shots must have at least one detector bit");
+        }
+        let file = File::open(path).context("Failed to open .b8 file")?;
+        let stride = bits_per_shot.div_ceil(8);
+        Ok(Self {
+            file,
+            buffer: Vec::with_capacity((STREAM_BATCH_BYTES / stride).max(1) * stride),
+            bits_per_shot,
+            stride,
+        })
+    }
+
+    /// Returns the number of detector bits per shot.
+    pub fn bits_per_shot(&self) -> usize {
+        self.bits_per_shot
     }
 
-    shots
+    /// Returns the number of bytes per shot.
+    pub fn stride(&self) -> usize {
+        self.stride
+    }
+
+    /// Reads the next batch of shots.
+    ///
+    /// # Returns
+    ///
+    /// The packed bytes of the batch's shots, empty at the end of the file,
+    /// or an error if reading fails. A trailing partial shot is ignored.
+    pub fn next_batch(&mut self) -> Result<&[u8]> {
+        let capacity = self.buffer.capacity();
+        self.buffer.resize(capacity, 0);
+        let mut filled = 0;
+        while filled < capacity {
+            match self.file.read(&mut self.buffer[filled..]) {
+                Ok(0) => break,
+                Ok(n) => filled += n,
+                Err(e) if e.kind() == io::ErrorKind::Interrupted => {}
+                Err(e) => return Err(e).context("Failed to read .b8 file"),
+            }
+        }
+        self.buffer.truncate(filled - filled % self.stride);
+        Ok(&self.buffer)
+    }
 }
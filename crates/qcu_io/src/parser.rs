@@ -3,12 +3,15 @@
 //! Provides functions for parsing Stim .dem (Detector Error Model) files,
 //! which describe the error model topology for stabilizer codes. The parser
 //! extracts edges between detector nodes and constructs a DecodingGraph structure
-//! for use by the decoder.
+//! for use by the decoder. Parsed graphs can be saved as precompiled graph
+//! images (`qcu_core::graph_image`), which `load_graph_file` loads without
+//! parsing; it accepts either format.
 
-use anyhow::{Context, Result};
+use anyhow::{Context, Result, anyhow};
 use qcu_core::graph::DecodingGraph;
-use std::fs::File;
-use std::io::{BufRead, BufReader};
+use qcu_core::graph_image::{self, GraphImage};
+use std::fs::{self, File};
+use std::io::{BufRead, BufReader, Read};
 use std::path::Path;
 
 /// Loads a Stim .dem file and constructs a DecodingGraph.
@@ -17,6 +20,9 @@ use std::path::Path;
 /// node connections. Each "error" line defines an edge in the decoding graph
 /// with an associated error probability. The probability is converted to a
 /// weight using negative log probability for use in weighted decoding algorithms.
+/// The logical observables (`L<k>`) of a line are recorded on its first edge;
+/// an edge holds them as a 32-bit mask, so files naming `L32` or above are
+/// rejected rather than losing those observables.
 ///
 /// # Arguments
 ///
@@ -24,7 +30,8 @@ use std::path::Path;
 ///
 /// # Returns
 ///
-/// A DecodingGraph containing all edges from the file, or an error if parsing fails.
+/// A DecodingGraph containing all edges from the file, or an error if parsing
+/// fails or an observable index does not fit the edge masks.
 #[allow(clippy::collapsible_if)]
 pub fn load_dem_file<P: AsRef<Path>>(path: P) -> Result<DecodingGraph> {
     let file = File::open(path).context("Failed to open .dem file")?;
@@ -55,15 +62,33 @@ pub fn load_dem_file<P: AsRef<Path>>(path: P) -> Result<DecodingGraph> {
                     let weight = -p.ln();
 
                     let mut detectors = Vec::new();
+                    let mut observables = 0u32;
                     for part in &parts[1..] {
                         if let Some(Ok(idx)) = part.strip_prefix('D').map(|s| s.parse::<usize>()) {
                             detectors.push(idx);
+                        } else if let Some(Ok(idx)) =
+                            part.strip_prefix('L').map(|s| s.parse::<u32>())
+                        {
+                            if idx >= u32::BITS {
+                                return Err(anyhow!(
+                                    "Observable L{} exceeds the {} observables an edge can hold",
+                                    idx,
+                                    u32::BITS
+                                ));
+                            }
+                            observables ^= 1u32 << idx;
                         }
                     }
 
                     if detectors.len() >= 2 {
                         for i in 0..detectors.len() - 1 {
-                            let _ = graph.add_edge(detectors[i], detectors[i + 1], weight);
+                            let mask = if i == 0 { observables } else { 0 };
+                            let _ = graph.add_edge_with_observables(
+                                detectors[i],
+                                detectors[i + 1],
+                                weight,
+                                mask,
+                            );
                         }
                     }
                 }
@@ -75,3 +100,78 @@ pub fn load_dem_file<P: AsRef<Path>>(path: P) -> Result<DecodingGraph> {
 
     Ok(graph)
 }
+
+/// Loads a precompiled graph image.
+///
+/// Reads the file into an aligned word buffer in one pass, validates it and
+/// copies its sections into the graph; no text is parsed and the adjacency
+/// list is taken from the image rather than rebuilt.
+///
+/// # Arguments
+///
+/// * `path` - Path to the image
+///
+/// # Returns
+///
+/// The graph, or an error if the file cannot be read or is not a valid image.
+pub fn load_graph_image<P: AsRef<Path>>(path: P) -> Result<DecodingGraph> {
+    let mut file = File::open(path).context("Failed to open graph image")?;
+    let len = file.metadata()?.len() as usize;
+    if len % 4 != 0 {
+        return Err(anyhow!("Graph image is not a whole number of words"));
+    }
+
+    let mut words = vec![0u32; len / 4];
+    let bytes = unsafe { std::slice::from_raw_parts_mut(words.as_mut_ptr() as *mut u8, len) };
+    file.read_exact(bytes)
+        .context("Failed to read graph image")?;
+
+    let image =
+        GraphImage::from_words(&words).map_err(|e| anyhow!("Invalid graph image: {:?}", e))?;
+    DecodingGraph::from_image(&image).map_err(|e| anyhow!("Failed to load graph image: {:?}", e))
+}
+
+/// Saves a decoding graph as a precompiled image.
+///
+/// # Arguments
+///
+/// * `graph` - Graph to save, with its adjacency built
+/// * `path` - Destination file (overwritten)
+///
+/// # Returns
+///
+/// The image size in bytes, or an error if the graph cannot be encoded or
+/// the file cannot be written.
+pub fn save_graph_image<P: AsRef<Path>>(graph: &DecodingGraph, path: P) -> Result<usize> {
+    let words =
+        graph_image::encode(graph).map_err(|e| anyhow!("Failed to encode graph image: {:?}", e))?;
+    let bytes: Vec<u8> = words.iter().flat_map(|w| w.to_le_bytes()).collect();
+    fs::write(path, &bytes).context("Failed to write graph image")?;
+    Ok(bytes.len())
+}
+
+/// Loads a decoding graph from a .dem file or a precompiled image.
+///
+/// Tells the formats apart by the image magic in the first four bytes, so
+/// every command that takes a `--dem` file accepts an image as well.
+///
+/// # Arguments
+///
+/// * `path` - Path to the .dem file or graph image
+///
+/// # Returns
+///
+/// The graph, or an error if the file cannot be read or parsed.
+pub fn load_graph_file<P: AsRef<Path>>(path: P) -> Result<DecodingGraph> {
+    let path = path.as_ref();
+    let mut magic = [0u8; 4];
+    let is_image = File::open(path)
+        .and_then(|mut f| f.read_exact(&mut magic))
+        .is_ok()
+        && u32::from_le_bytes(magic) == graph_image::IMAGE_MAGIC;
+    if is_image {
+        load_graph_image(path)
+    } else {
+        load_dem_file(path)
+    }
+}
@@ -0,0 +1,173 @@
+#!/usr/bin/env python3
+"""Simulator throughput benchmark: cycles/s and round trips across builds.
+
+For every grid size, model thread count and build profile this builds the
+Verilator simulation, measures the core directly (`Vtop_soc_sim --bench`)
+and then serves it over each transport to `qcu_host sim-bench`. All results
+are written to <out>.json and <out>.csv, one row per measurement, as a
+regression baseline for simulated cycles per second and request latency
+percentiles.
+
+Profiles: "default" is the plain build, "native" adds the mt-sim feature's
+-O3 -march=native and LTO. Thread counts above 1 build a multithreaded
+model (QCU_SIM_THREADS); the snapshot and trace features are left off.
+"""
+import argparse
+import csv
+import json
+import os
+import subprocess
+import sys
+import time
+
+OUTPUT_DIR = "output"
+BUILD_ROOT = os.path.join("target", "simbench")
+HOST_BIN = os.path.join("target", "release", "qcu_host")
+TRANSPORTS = ["tcp", "unix", "shm"]
+STARTUP_TIMEOUT = 10
+
+
+def run_cmd(cmd, env=None):
+    """Runs a command, exiting on failure."""
+    print(f"[$] {' '.join(cmd)}")
+    ret = subprocess.call(cmd, env=env)
+    if ret != 0:
+        print(f"[!] Command failed: {' '.join(cmd)}")
+        sys.exit(ret)
+
+
+def json_lines(cmd):
+    """Runs a command and returns the JSON objects it prints, one per line."""
+    out = subprocess.run(cmd, capture_output=True, text=True, check=True).stdout
+    return [json.loads(line) for line in out.splitlines() if line.startswith("{")]
+
+
+def build_sim(dim, threads, profile):
+    """Builds the simulator for one configuration and returns its path."""
+    target_dir = os.path.join(BUILD_ROOT, f"{profile}-g{dim}-t{threads}")
+    env = dict(os.environ, QCU_GRID_DIM=str(dim), QCU_SIM_THREADS=str(threads),
+               CARGO_TARGET_DIR=target_dir)
+    cmd = ["cargo", "build", "--release", "-p", "qcu_hw"]
+    if profile == "native":
+        cmd += ["--features", "mt-sim"]
+    run_cmd(cmd, env)
+    found = subprocess.check_output(
+        ["find", target_dir, "-name", "Vtop_soc_sim", "-type", "f"]).decode().split()
+    if not found:
+        print(f"[!] No Vtop_soc_sim under {target_dir}")
+        sys.exit(1)
+    return found[0]
+
+
+def server_waiting(log_path):
+    """Returns whether the simulator has logged that it accepts hosts.
+
+    The line is printed (and flushed) once the listener or shared-memory
+    region is ready, so connecting after it never races the startup.
+    """
+    with open(log_path) as f:
+        return "Waiting for Rust Host Controller" in f.read()
+
+
+def wait_for_server(proc, ready):
+    """Polls ready() until the server is up, exiting if it dies or stalls."""
+    deadline = time.time() + STARTUP_TIMEOUT
+    while not ready():
+        if proc.poll() is not None:
+            print(f"[!] Simulator exited with status {proc.returncode}")
+            sys.exit(1)
+        if time.time() > deadline:
+            print("[!] Simulator did not start listening")
+            sys.exit(1)
+        time.sleep(0.05)
+
+
+def bench_transport(sim, transport, threads, requests):
+    """Serves the simulator over one transport and runs qcu_host sim-bench."""
+    port_file = os.path.join(OUTPUT_DIR, "simbench.port")
+    unix_path = os.path.join(OUTPUT_DIR, "simbench.sock")
+    shm_name = f"qcu_bench{os.getpid()}"
+    for path in (port_file, unix_path):
+        if os.path.exists(path):
+            os.remove(path)
+
+    args = [sim, "--sim-threads", str(threads)]
+    if transport == "tcp":
+        args += ["--bind", "127.0.0.1", "--port", "0", "--port-file", port_file]
+    elif transport == "unix":
+        args += ["--unix", unix_path]
+        connect = f"unix:{unix_path}"
+    else:
+        args += ["--shm", shm_name]
+        connect = f"shm://{shm_name}"
+
+    log_path = os.path.join(OUTPUT_DIR, "simbench_hw.log")
+    with open(log_path, "w") as log_file:
+        hw_proc = subprocess.Popen(args, stdout=log_file, stderr=subprocess.STDOUT)
+    try:
+        if transport == "tcp":
+            wait_for_server(hw_proc, lambda: os.path.exists(port_file))
+            with open(port_file) as f:
+                connect = f"127.0.0.1:{f.read().strip()}"
+        else:
+            wait_for_server(hw_proc, lambda: server_waiting(log_path))
+        return json_lines([HOST_BIN, "sim-bench", "--connect", connect,
+                           "--requests", str(requests), "--json"])
+    finally:
+        hw_proc.terminate()
+        hw_proc.wait()
+
+
+def write_results(rows, out):
+    """Writes the rows to <out>.json and <out>.csv."""
+    with open(out + ".json", "w") as f:
+        json.dump(rows, f, indent=1)
+    fields = []
+    for row in rows:
+        fields += [k for k in row if k not in fields]
+    with open(out + ".csv", "w", newline="") as f:
+        writer = csv.DictWriter(f, fieldnames=fields)
+        writer.writeheader()
+        writer.writerows(rows)
+    print(f"--> Wrote {len(rows)} results to {out}.json and {out}.csv")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Simulator throughput benchmark")
+    parser.add_argument("--dims", default="3,5,9", help="Grid sizes to build")
+    parser.add_argument("--threads", default="1,4", help="Model thread counts")
+    parser.add_argument("--profiles", default="default,native",
+                        help="Build profiles (default, native)")
+    parser.add_argument("--transports", default=",".join(TRANSPORTS),
+                        help="Transports to measure (tcp, unix, shm)")
+    parser.add_argument("--cycles", type=int, default=1000000,
+                        help="Cycles and transactions per core measurement")
+    parser.add_argument("--requests", type=int, default=10000,
+                        help="Requests per transport measurement")
+    parser.add_argument("--out", default=os.path.join(OUTPUT_DIR, "sim_bench"),
+                        help="Output path without extension")
+    args = parser.parse_args()
+
+    os.makedirs(OUTPUT_DIR, exist_ok=True)
+    run_cmd(["cargo", "build", "--release", "-p", "qcu_host"])
+
+    rows = []
+    for profile in args.profiles.split(","):
+        for dim in [int(d) for d in args.dims.split(",")]:
+            for threads in [int(t) for t in args.threads.split(",")]:
+                sim = build_sim(dim, threads, profile)
+                print(f"--> {profile} build, {dim}x{dim} grid, {threads} threads")
+                results = json_lines([sim, "--bench", str(args.cycles),
+                                      "--sim-threads", str(threads)])
+                for transport in args.transports.split(","):
+                    results += bench_transport(sim, transport, threads, args.requests)
+                for row in results:
+                    name = row.get("transport", "core")
+                    print(f"    {name:<5} {row['op']:<12} {row['rate']:>14.0f} {row.get('unit', 'ops')}/s")
+                    rows.append({"profile": profile, "threads": threads, **row})
+
+    write_results(rows, args.out)
+
+
+if __name__ == "__main__":
+    main()
@@ -3,6 +3,8 @@ import argparse
 import subprocess
 import sys
 import os
+import re
+import struct
 import time
 import signal
 
@@ -13,6 +15,11 @@ TARGET_ARCH = "riscv64gc-unknown-none-elf"
 OUTPUT_DIR = "output"
 DEM_FILE = os.path.join(OUTPUT_DIR, "bench.dem")
 B8_FILE = os.path.join(OUTPUT_DIR, "bench.b8")
+GRAPH_FILE = os.path.join(OUTPUT_DIR, "bench.qcg")
+# The image is rebuilt when the error model or the image layout changes.
+GRAPH_SOURCES = [DEM_FILE, "crates/qcu_core/src/graph.rs", "crates/qcu_core/src/graph_image.rs"]
+GRAPH_IMAGE_RS = "crates/qcu_core/src/graph_image.rs"
+GRAPH_MAGIC = b"QCUG"
 KERNEL_BIN = f"target/{TARGET_ARCH}/release/{FIRMWARE_CRATE}"
 
 def run_cmd(cmd):
@@ -22,6 +29,24 @@ def run_cmd(cmd):
         print(f"[!] Command failed: {cmd}")
         sys.exit(ret)
 
+def graph_image_stale():
+    """Returns whether the graph image must be rebuilt.
+
+    The image is stale when it is missing, older than one of GRAPH_SOURCES,
+    or its header carries another magic or format version than the
+    IMAGE_VERSION the firmware and host are built with (the firmware
+    rejects such an image at boot).
+    """
+    if not os.path.exists(GRAPH_FILE):
+        return True
+    if any(os.path.getmtime(GRAPH_FILE) < os.path.getmtime(src) for src in GRAPH_SOURCES):
+        return True
+    with open(GRAPH_IMAGE_RS) as f:
+        expected = int(re.search(r"pub const IMAGE_VERSION: u32 = (\d+);", f.read()).group(1))
+    with open(GRAPH_FILE, "rb") as f:
+        header = f.read(8)
+    return len(header) < 8 or header[:4] != GRAPH_MAGIC or struct.unpack("<I", header[4:])[0] != expected
+
 def ensure_data(size=5, shots=10000):
     if not os.path.exists(OUTPUT_DIR):
         os.makedirs(OUTPUT_DIR)
@@ -30,6 +55,10 @@ def ensure_data(size=5, shots=10000):
         print("--> Generating benchmark data (Stim)...")
         run_cmd(f"python3 scripts/generate_stim_data.py --distance {size} --shots {shots} --out_dem {DEM_FILE} --out_b8 {B8_FILE}")
 
+    if graph_image_stale():
+        print("--> Compiling decoding graph image...")
+        run_cmd(f"cargo run --release -q -p {HOST_CRATE} -- compile-graph --dem {DEM_FILE} --out {GRAPH_FILE}")
+
 def build_firmware():
     print(f"--> Building {FIRMWARE_CRATE} (RISC-V)...")
     main_rs = f"crates/{FIRMWARE_CRATE}/src/main.rs"
@@ -37,15 +66,15 @@ def build_firmware():
         os.utime(main_rs, None)
     run_cmd(f"cargo build --release -p {FIRMWARE_CRATE} --target {TARGET_ARCH} -Z build-std=core,alloc")
 
-def run_qemu():
-    print("--> Booting QEMU (SMP: 4 Cores)...")
+def run_qemu(smp=4):
+    print(f"--> Booting QEMU (SMP: {smp} Cores)...")
     if not os.path.exists(KERNEL_BIN):
         print(f"[!] Kernel binary not found.")
         sys.exit(1)
 
     qemu_cmd = (
         f"qemu-system-riscv64 "
-        f"-machine virt -m 128M -cpu rv64 -bios none -smp 4 "
+        f"-machine virt -m 128M -cpu rv64 -bios none -smp {smp} "
         f"-nographic -serial mon:stdio "
         f"-kernel {KERNEL_BIN}"
     )
@@ -55,7 +84,7 @@ def run_stream_bench(freq):
     print("--> Running Host Stream Benchmark...")
     run_cmd(f"cargo run --release -p {HOST_CRATE} -- stream --dem {DEM_FILE} --b8 {B8_FILE} --freq {freq}")
 
-def run_hil():
+def run_hil(shm=None, unix=None, port=8000, host_cmd="hil"):
     print("--> Building Hardware Simulation...")
     # This triggers the build.rs in qcu_hw which compiles the Verilog
     run_cmd("cargo build -p qcu_hw")
@@ -78,17 +107,37 @@ def run_hil():
     if not os.path.exists(OUTPUT_DIR):
         os.makedirs(OUTPUT_DIR)
 
+    # Pick the transport: shared memory, Unix socket, or TCP. With port 0 the
+    # simulator chooses a free port and reports it through the port file.
+    port_file = os.path.join(OUTPUT_DIR, "hw.port")
+    if shm:
+        hw_args, connect = ["--shm", shm], f"shm://{shm}"
+    elif unix:
+        hw_args, connect = ["--unix", unix], f"unix:{unix}"
+    else:
+        hw_args, connect = ["--bind", "127.0.0.1", "--port", str(port), "--port-file", port_file], None
+        if os.path.exists(port_file):
+            os.remove(port_file)
+
     # Start the Hardware Simulation in the background
     with open(os.path.join(OUTPUT_DIR, "hw.log"), "w") as log_file:
-        hw_proc = subprocess.Popen([bin_path], stdout=log_file, stderr=subprocess.STDOUT)
+        hw_proc = subprocess.Popen([bin_path] + hw_args, stdout=log_file, stderr=subprocess.STDOUT)
 
     try:
-        # Give the server a moment to bind port 8000
-        time.sleep(1)
+        if connect is None:
+            # Wait until the server has bound its port
+            deadline = time.time() + 10
+            while not os.path.exists(port_file) and time.time() < deadline:
+                time.sleep(0.05)
+            with open(port_file) as f:
+                connect = f"127.0.0.1:{f.read().strip()}"
+        else:
+            # Give the server a moment to create the socket or shm region
+            time.sleep(1)
         
-        print("--> Starting Host Controller...")
-        # Run the Rust Host TUI
-        subprocess.call("cargo run -q -p qcu_host -- hil", shell=True)
+        print(f"--> Starting Host Controller ({connect})...")
+        # Run the Rust Host TUI (or the accelerator benchmark)
+        subprocess.call(f"cargo run -q -p qcu_host -- {host_cmd} --connect {connect}", shell=True)
     except KeyboardInterrupt:
         print("\n[!] Interrupted")
     finally:
@@ -106,11 +155,18 @@ def main():
 
     p_kernel = subparsers.add_parser("kernel", help="Build and boot RISC-V firmware")
     p_kernel.add_argument("--size", type=int, default=5)
+    p_kernel.add_argument("--smp", type=int, default=4, help="Number of harts (the firmware uses up to 8)")
 
     p_stream = subparsers.add_parser("stream", help="Run host stream benchmark")
     p_stream.add_argument("--freq", type=int, default=80000)
 
     p_hil = subparsers.add_parser("hil", help="Run Hardware-in-the-Loop Demo")
+    p_hil.add_argument("--shm", metavar="NAME", help="Use a shared-memory link instead of TCP")
+    p_hil.add_argument("--unix", metavar="PATH", help="Use a Unix domain socket instead of TCP")
+    p_hil.add_argument("--port", type=int, default=8000, help="TCP port (0 picks a free port)")
+
+    p_accel = subparsers.add_parser("accel", help="Benchmark the union-find accelerator in the SoC")
+    p_accel.add_argument("--port", type=int, default=0, help="TCP port (0 picks a free port)")
 
     args = parser.parse_args()
 
@@ -119,12 +175,14 @@ def main():
     elif args.command == "kernel":
         ensure_data(args.size)
         build_firmware()
-        run_qemu()
+        run_qemu(args.smp)
     elif args.command == "stream":
         ensure_data()
         run_stream_bench(args.freq)
     elif args.command == "hil":
-        run_hil()
+        run_hil(args.shm, args.unix, args.port)
+    elif args.command == "accel":
+        run_hil(port=args.port, host_cmd="accel-bench")
 
 if __name__ == "__main__":
     main()